@@ -0,0 +1,149 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+/// <summary>
+/// 計算結果を使ったことにして、最適化で処理が消されないようにする
+/// </summary>
+template<class T>
+inline void DoNotOptimize(const T& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+	asm volatile("" : : "r,m"(value) : "memory");
+#else
+	const volatile char* p = reinterpret_cast<const volatile char*>(&value);
+	(void)*p;
+#endif
+}
+
+/// <summary>
+/// 1つのベンチマークの結果
+/// </summary>
+struct BenchResult final
+{
+	std::string name;
+	uint64_t iterations = 0;
+	double nsPerOp = 0.0;
+	double opsPerSecond = 0.0;
+	std::vector<std::pair<std::string, double>> metrics;	// 追加の数値（描画回数、誤差など）
+};
+
+/// <summary>
+/// ベンチマークを実行してJSONで出力する
+/// 使い方: MathBench [--filter=名前の一部] [--min-time=秒]
+/// </summary>
+class BenchRunner final
+{
+public:
+	BenchRunner(const char* suite, int argc, char** argv)
+		: suite_(suite)
+	{
+		for (int i = 1; i < argc; ++i)
+		{
+			if (std::strncmp(argv[i], "--filter=", 9) == 0)
+			{
+				filter_ = argv[i] + 9;
+			}
+			else if (std::strncmp(argv[i], "--min-time=", 11) == 0)
+			{
+				minSeconds_ = std::atof(argv[i] + 11);
+			}
+		}
+	}
+
+	/// <summary>
+	/// 最低計測時間を超えるまで回数を倍にしながら計測する
+	/// </summary>
+	/// <param name="name">名前</param>
+	/// <param name="body">1回分の処理（引数は何回目か）</param>
+	/// <returns>計測したらtrue（フィルタで除外されたらfalse）</returns>
+	template<class Body>
+	bool Run(const char* name, Body&& body)
+	{
+		if (!filter_.empty() && std::strstr(name, filter_.c_str()) == nullptr)
+		{
+			return false;
+		}
+
+		using Clock = std::chrono::steady_clock;
+		uint64_t iterations = 1;
+		double seconds = 0.0;
+		for (;;)
+		{
+			const Clock::time_point start = Clock::now();
+			for (uint64_t i = 0; i < iterations; ++i)
+			{
+				body(static_cast<size_t>(i));
+			}
+			seconds = std::chrono::duration<double>(Clock::now() - start).count();
+			if (seconds >= minSeconds_ || iterations >= (uint64_t(1) << 40))
+			{
+				break;
+			}
+			iterations *= 2;
+		}
+
+		BenchResult result;
+		result.name = name;
+		result.iterations = iterations;
+		result.nsPerOp = seconds * 1e9 / static_cast<double>(iterations);
+		result.opsPerSecond = seconds > 0.0 ? static_cast<double>(iterations) / seconds : 0.0;
+		results_.push_back(std::move(result));
+		return true;
+	}
+
+	/// <summary>
+	/// 直前に計測した結果へ数値を追加する
+	/// </summary>
+	void AddMetric(const char* name, double value)
+	{
+		if (!results_.empty())
+		{
+			results_.back().metrics.emplace_back(name, value);
+		}
+	}
+
+	/// <summary>
+	/// 計測しない結果（精度の報告など）を追加する
+	/// </summary>
+	void AddReport(const char* name)
+	{
+		if (filter_.empty() || std::strstr(name, filter_.c_str()) != nullptr)
+		{
+			BenchResult result;
+			result.name = name;
+			results_.push_back(std::move(result));
+		}
+	}
+
+	/// <summary>
+	/// 結果をJSONで出力する
+	/// </summary>
+	void PrintJson(std::FILE* out) const
+	{
+		std::fprintf(out, "{\n  \"suite\": \"%s\",\n  \"benchmarks\": [\n", suite_);
+		for (size_t i = 0; i < results_.size(); ++i)
+		{
+			const BenchResult& result = results_[i];
+			std::fprintf(out, "    { \"name\": \"%s\", \"iterations\": %llu, \"ns_per_op\": %.3f, \"ops_per_sec\": %.1f",
+				result.name.c_str(), static_cast<unsigned long long>(result.iterations), result.nsPerOp, result.opsPerSecond);
+			for (const auto& metric : result.metrics)
+			{
+				std::fprintf(out, ", \"%s\": %.9g", metric.first.c_str(), metric.second);
+			}
+			std::fprintf(out, " }%s\n", i + 1 < results_.size() ? "," : "");
+		}
+		std::fprintf(out, "  ]\n}\n");
+	}
+
+private:
+	const char* suite_;
+	std::string filter_;
+	double minSeconds_ = 0.2;
+	std::vector<BenchResult> results_;
+};
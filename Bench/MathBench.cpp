@@ -0,0 +1,1294 @@
+#include "BenchHarness.h"
+#include "Math/AlignedTypes.h"
+#include "Math/BezierPath.h"
+#include "Math/ClothSolver.h"
+#include "Math/CompactBallSoA.h"
+#include "Math/CoreLayout.h"
+#include "Math/FastTrig.h"
+#include "Math/FrameArena.h"
+#include "Math/Gjk.h"
+#include "Math/GridRenderer.h"
+#include "Math/Integrator.h"
+#include "Math/MathFunction.h"
+#include "Math/ObjLoader.h"
+#include "Math/RayPacket.h"
+#include "Math/SdfVolume.h"
+#include "Math/ThreadPool.h"
+#include "Novice.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <string>
+#include <type_traits>
+
+namespace
+{
+	MathFunction Func;
+
+	// 入力の数（2の累乗にしてマスクで回す）
+	constexpr size_t kInputCount = 1024;
+	constexpr size_t kInputMask = kInputCount - 1;
+
+	/// <summary>
+	/// ベンチマーク用の乱数入力
+	/// </summary>
+	struct Inputs
+	{
+		std::vector<Vector3ex> vectors;
+		std::vector<Matrix4x4ex> matrices;
+		std::vector<Sphere> spheres;
+		std::vector<Plane> planes;
+		std::vector<Segment> segments;
+		std::vector<PreparedSegment> preparedSegments;
+		std::vector<Triangle> triangles;
+		std::vector<AABB> aabbs;
+		std::vector<OBB> obbs;
+		std::vector<Capsule> capsules;
+	};
+
+	Inputs MakeInputs()
+	{
+		std::mt19937 engine(12345);
+		std::uniform_real_distribution<float> position(-2.0f, 2.0f);
+		std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+		std::uniform_real_distribution<float> size(0.1f, 1.0f);
+		auto randomVector = [&]() { return Vector3ex(position(engine), position(engine), position(engine)); };
+
+		Inputs inputs;
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			Vector3ex v = randomVector();
+			inputs.vectors.push_back(v);
+			inputs.matrices.push_back(Func.MakeAffineMatrix({ size(engine), size(engine), size(engine) }, { angle(engine), angle(engine), angle(engine) }, v));
+			inputs.spheres.push_back({ randomVector(), size(engine) });
+			inputs.planes.push_back({ Func.Normalize(randomVector()), position(engine) });
+			Segment segment{ randomVector(), randomVector() };
+			inputs.segments.push_back(segment);
+			inputs.preparedSegments.push_back(Func.Prepare(segment));
+			Triangle triangle{};
+			for (Vector3ex& vertex : triangle.vertices)
+			{
+				vertex = randomVector();
+			}
+			inputs.triangles.push_back(triangle);
+			Vector3ex extent(size(engine), size(engine), size(engine));
+			inputs.aabbs.push_back({ v - extent, v + extent });
+			inputs.obbs.push_back(Func.MakeOBB(randomVector(), { angle(engine), angle(engine), angle(engine) }, { size(engine), size(engine), size(engine) }));
+			inputs.capsules.push_back({ { randomVector(), randomVector() * 0.5f }, size(engine) * 0.3f });
+		}
+		return inputs;
+	}
+
+	/*----------積分法のエネルギー誤差----------*/
+
+	constexpr float kOscillatorOmega = 6.2831853f;	// 調和振動子の角振動数（周期1秒）
+	constexpr size_t kOscillatorCount = 16;			// 振幅と位相の違う振動子の数
+	constexpr float kEnergyDuration = 20.0f;		// 積分する時間（秒）
+	constexpr double kStableEnergyError = 0.01;		// エネルギーの相対誤差がこれ以下なら安定とみなす
+
+	/// <summary>
+	/// 調和振動子（a = -ω²x）を一定時間積分し、力学的エネルギーの相対誤差の最大値を返す
+	/// </summary>
+	/// <param name="cacheAcceleration">加速度の配列を渡すIntegrateを使うか</param>
+	template<class Integrator>
+	double MeasureEnergyError(float deltaTime, bool cacheAcceleration = false)
+	{
+		std::vector<Vector3ex> positions(kOscillatorCount);
+		std::vector<Vector3ex> velocities(kOscillatorCount);
+		for (size_t i = 0; i < kOscillatorCount; ++i)
+		{
+			const float phase = 6.2831853f * static_cast<float>(i) / static_cast<float>(kOscillatorCount);
+			const float amplitude = 0.5f + 0.1f * static_cast<float>(i);
+			positions[i] = { amplitude * std::cos(phase), 0.5f * amplitude * std::sin(phase), 0.0f };
+			velocities[i] = { -amplitude * kOscillatorOmega * std::sin(phase), 0.5f * amplitude * kOscillatorOmega * std::cos(phase), 0.1f };
+		}
+
+		auto energy = [](const Vector3ex& position, const Vector3ex& velocity) {
+			const double squaredSpeed = double(velocity.x) * velocity.x + double(velocity.y) * velocity.y + double(velocity.z) * velocity.z;
+			const double squaredLength = double(position.x) * position.x + double(position.y) * position.y + double(position.z) * position.z;
+			return 0.5 * squaredSpeed + 0.5 * double(kOscillatorOmega) * kOscillatorOmega * squaredLength;
+		};
+		std::vector<double> initialEnergies(kOscillatorCount);
+		for (size_t i = 0; i < kOscillatorCount; ++i)
+		{
+			initialEnergies[i] = energy(positions[i], velocities[i]);
+		}
+
+		auto acceleration = [](uint32_t, const Vector3ex& position, const Vector3ex&) { return position * (-kOscillatorOmega * kOscillatorOmega); };
+		std::vector<Vector3ex> accelerations(kOscillatorCount);
+		InitializeAccelerations(positions.data(), velocities.data(), accelerations.data(), kOscillatorCount, acceleration);
+		const int stepCount = static_cast<int>(kEnergyDuration / deltaTime + 0.5f);
+		double maxError = 0.0;
+		for (int step = 0; step < stepCount; ++step)
+		{
+			if (cacheAcceleration)
+			{
+				Integrate<Integrator>(positions.data(), velocities.data(), accelerations.data(), kOscillatorCount, deltaTime, acceleration);
+			}
+			else
+			{
+				Integrate<Integrator>(positions.data(), velocities.data(), kOscillatorCount, deltaTime, acceleration);
+			}
+			for (size_t i = 0; i < kOscillatorCount; ++i)
+			{
+				const double error = std::abs(energy(positions[i], velocities[i]) - initialEnergies[i]) / initialEnergies[i];
+				// 発散してNaNになったものも不安定として扱う
+				maxError = std::isfinite(error) ? std::max(maxError, error) : 1e30;
+			}
+		}
+		return maxError;
+	}
+
+	/*----------光線のパケットと比べるスカラー版----------*/
+	// RayPacketの各関数と同じ規則で1本ずつ求める（当たらなければ負を返す）
+
+	/// <summary>
+	/// 半直線と球の交点のt（始点が内側なら出ていく側）
+	/// </summary>
+	float IntersectRay(const Ray& ray, const Sphere& sphere)
+	{
+		const float ocx = ray.origin.x - sphere.center.x;
+		const float ocy = ray.origin.y - sphere.center.y;
+		const float ocz = ray.origin.z - sphere.center.z;
+		const float a = ray.diff.x * ray.diff.x + ray.diff.y * ray.diff.y + ray.diff.z * ray.diff.z;
+		const float b = ocx * ray.diff.x + ocy * ray.diff.y + ocz * ray.diff.z;
+		const float c = ocx * ocx + ocy * ocy + ocz * ocz - sphere.radius * sphere.radius;
+		const float discriminant = b * b - a * c;
+		if (discriminant < 0.0f)
+		{
+			return -1.0f;
+		}
+		const float root = std::sqrt(discriminant);
+		const float tNear = (-b - root) / a;
+		return tNear >= 0.0f ? tNear : (-b + root) / a;
+	}
+
+	/// <summary>
+	/// 半直線とAABBの交点のt（始点が内側なら0）
+	/// </summary>
+	float IntersectRay(const Ray& ray, const AABB& aabb)
+	{
+		float tEnter = 0.0f;
+		float tExit = std::numeric_limits<float>::infinity();
+		const float origin[3] = { ray.origin.x, ray.origin.y, ray.origin.z };
+		const float direction[3] = { ray.diff.x, ray.diff.y, ray.diff.z };
+		const float min[3] = { aabb.min.x, aabb.min.y, aabb.min.z };
+		const float max[3] = { aabb.max.x, aabb.max.y, aabb.max.z };
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (direction[axis] == 0.0f)
+			{
+				if (origin[axis] < min[axis] || origin[axis] > max[axis])
+				{
+					return -1.0f;
+				}
+				continue;
+			}
+			const float inverse = 1.0f / direction[axis];
+			const float t0 = (min[axis] - origin[axis]) * inverse;
+			const float t1 = (max[axis] - origin[axis]) * inverse;
+			tEnter = std::max(tEnter, std::min(t0, t1));
+			tExit = std::min(tExit, std::max(t0, t1));
+		}
+		return tEnter <= tExit ? tEnter : -1.0f;
+	}
+
+	/// <summary>
+	/// 半直線と平面の交点のt（平行なら当たらない）
+	/// </summary>
+	float IntersectRay(const Ray& ray, const Plane& plane)
+	{
+		const float dot = plane.normal.x * ray.diff.x + plane.normal.y * ray.diff.y + plane.normal.z * ray.diff.z;
+		if (std::abs(dot) < 1e-6f)
+		{
+			return -1.0f;
+		}
+		return (plane.distance - (plane.normal.x * ray.origin.x + plane.normal.y * ray.origin.y + plane.normal.z * ray.origin.z)) / dot;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	BenchRunner runner("MathBench", argc, argv);
+	const Inputs in = MakeInputs();
+
+	/*----------行列とベクトル----------*/
+
+	runner.Run("Multiply/Matrix4x4", [&](size_t i) {
+		DoNotOptimize(Func.Multiply(in.matrices[i & kInputMask], in.matrices[(i + 1) & kInputMask]));
+	});
+	runner.Run("Multiply/Vector4", [&](size_t i) {
+		const Vector3ex& v = in.vectors[i & kInputMask];
+		DoNotOptimize(Func.Multiply(Vector4{ v.x, v.y, v.z, 1.0f }, in.matrices[(i + 1) & kInputMask]));
+	});
+	runner.Run("Inverse", [&](size_t i) {
+		DoNotOptimize(Func.Inverse(in.matrices[i & kInputMask]));
+	});
+	runner.Run("Transform", [&](size_t i) {
+		DoNotOptimize(Func.Transform(in.vectors[i & kInputMask], in.matrices[(i + 1) & kInputMask]));
+	});
+	runner.Run("Normalize", [&](size_t i) {
+		DoNotOptimize(Func.Normalize(in.vectors[i & kInputMask]));
+	});
+	runner.Run("MakeAffineMatrix", [&](size_t i) {
+		const Vector3ex& v = in.vectors[i & kInputMask];
+		DoNotOptimize(Func.MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, v, v));
+	});
+
+	// double版はfloat版と同じカーネルのスカラー経路（精度が要る計算の比較用）
+	std::vector<Matrix4x4d> doubleMatrices;
+	for (const Matrix4x4ex& m : in.matrices)
+	{
+		doubleMatrices.push_back(Convert<double>(ToCore(m)));
+	}
+	runner.Run("Multiply/Matrix4x4d", [&](size_t i) {
+		DoNotOptimize(doubleMatrices[i & kInputMask] * doubleMatrices[(i + 1) & kInputMask]);
+	});
+	runner.Run("Inverse/Matrix4x4d", [&](size_t i) {
+		DoNotOptimize(Inverse(doubleMatrices[i & kInputMask]));
+	});
+
+	// 保存用の型（1回あたりkInputCount個の点、または64個の行列）
+	std::vector<Vec3A> alignedPoints(kInputCount);
+	std::vector<Vec3A> alignedResults(kInputCount);
+	std::vector<Vector3ex> pointResults(kInputCount);
+	ToAligned(in.vectors.data(), alignedPoints.data(), kInputCount);
+	const Mat4A alignedMatrix = Mat4A::From(in.matrices[0]);
+	runner.Run("TransformArray/Vector3ex", [&](size_t) {
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			pointResults[i] = Func.Transform(in.vectors[i], in.matrices[0]);
+		}
+		DoNotOptimize(pointResults[0]);
+	});
+	runner.Run("TransformArray/Vec3A", [&](size_t) {
+		TransformArray(alignedPoints.data(), kInputCount, alignedMatrix, alignedResults.data());
+		DoNotOptimize(alignedResults[0]);
+	});
+	runner.Run("ToAligned/Vector3ex", [&](size_t) {
+		ToAligned(in.vectors.data(), alignedPoints.data(), kInputCount);
+		DoNotOptimize(alignedPoints[0]);
+	});
+	runner.Run("FromAligned/Vec3A", [&](size_t) {
+		FromAligned(alignedPoints.data(), pointResults.data(), kInputCount);
+		DoNotOptimize(pointResults[0]);
+	});
+	// 配列を確保するだけ（Matrix4x4exはコンストラクタで0を書き込む）
+	runner.Run("Construct/Matrix4x4ex[64]", [&](size_t) {
+		Matrix4x4ex buffer[64];
+		DoNotOptimize(buffer);
+	});
+	runner.Run("Construct/Mat4A[64]", [&](size_t) {
+		Mat4A buffer[64];
+		DoNotOptimize(buffer);
+	});
+
+	/*----------三角関数（1回あたりkInputCount個の角度、誤差はdoubleのstd::sin/std::cosとの差の最大値）----------*/
+
+	std::vector<float> angles(kInputCount);
+	std::vector<float> sines(kInputCount);
+	std::vector<float> cosines(kInputCount);
+	for (size_t i = 0; i < kInputCount; ++i)
+	{
+		angles[i] = -3.2f + 6.4f * static_cast<float>(i) / static_cast<float>(kInputCount - 1);
+	}
+	auto addTrigError = [&]() {
+		double maxSinError = 0.0;
+		double maxCosError = 0.0;
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			maxSinError = std::max(maxSinError, std::abs(static_cast<double>(sines[i]) - std::sin(static_cast<double>(angles[i]))));
+			maxCosError = std::max(maxCosError, std::abs(static_cast<double>(cosines[i]) - std::cos(static_cast<double>(angles[i]))));
+		}
+		runner.AddMetric("angles_per_op", static_cast<double>(kInputCount));
+		runner.AddMetric("max_error_sin", maxSinError);
+		runner.AddMetric("max_error_cos", maxCosError);
+	};
+	if (runner.Run("SinCos/Std", [&](size_t) {
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			sines[i] = std::sin(angles[i]);
+			cosines[i] = std::cos(angles[i]);
+		}
+		DoNotOptimize(sines[0]);
+	}))
+	{
+		addTrigError();
+	}
+	if (runner.Run("SinCos/Scalar", [&](size_t) {
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			SinCos(angles[i], sines[i], cosines[i]);
+		}
+		DoNotOptimize(sines[0]);
+	}))
+	{
+		addTrigError();
+	}
+	if (runner.Run("SinCos/Float8", [&](size_t) {
+		SinCosArray(angles.data(), sines.data(), cosines.data(), kInputCount);
+		DoNotOptimize(sines[0]);
+	}))
+	{
+		addTrigError();
+	}
+	if (runner.Run("SinCos/Float8/Fast", [&](size_t) {
+		SinCosArray<TrigPrecision::Fast>(angles.data(), sines.data(), cosines.data(), kInputCount);
+		DoNotOptimize(sines[0]);
+	}))
+	{
+		addTrigError();
+	}
+
+	/*----------積分法（1回あたりkInputCount個のボールを1/60秒進める）----------*/
+	// 誤差は周期1秒の調和振動子を20秒積分した時のエネルギーの相対誤差の最大値
+	// stable_dtは誤差が1%以下に収まる最大のステップ幅（これ以下のステップ幅を選べばよい）
+
+	struct EnergyStep
+	{
+		float deltaTime;
+		const char* metricName;
+	};
+	const EnergyStep energySteps[] = {
+		{ 1.0f / 480.0f, "energy_error_dt_1/480" },
+		{ 1.0f / 240.0f, "energy_error_dt_1/240" },
+		{ 1.0f / 120.0f, "energy_error_dt_1/120" },
+		{ 1.0f / 60.0f, "energy_error_dt_1/60" },
+		{ 1.0f / 30.0f, "energy_error_dt_1/30" },
+		{ 1.0f / 15.0f, "energy_error_dt_1/15" },
+		{ 1.0f / 8.0f, "energy_error_dt_1/8" },
+	};
+	std::vector<Vector3ex> integratePositions(in.vectors.begin(), in.vectors.end());
+	std::vector<Vector3ex> integrateVelocities(kInputCount);
+	std::vector<Vector3ex> integrateAccelerations(kInputCount);
+	// Cachedは加速度の配列を渡す版（VelocityVerletは前のステップの最後の加速度を使う）
+	// evaluations_per_stepは実際に加速度を求めた回数を数えたもの
+	auto benchIntegratorWith = [&](auto policy, bool cacheAcceleration) {
+		using Integrator = decltype(policy);
+		uint32_t evaluations = 0;
+		auto acceleration = [&evaluations](uint32_t, const Vector3ex& position, const Vector3ex&) {
+			++evaluations;
+			return position * (-kOscillatorOmega * kOscillatorOmega);
+		};
+		auto step = [&]() {
+			if (cacheAcceleration)
+			{
+				Integrate<Integrator>(integratePositions.data(), integrateVelocities.data(), integrateAccelerations.data(), kInputCount, 1.0f / 60.0f, acceleration);
+			}
+			else
+			{
+				Integrate<Integrator>(integratePositions.data(), integrateVelocities.data(), kInputCount, 1.0f / 60.0f, acceleration);
+			}
+		};
+		InitializeAccelerations(integratePositions.data(), integrateVelocities.data(), integrateAccelerations.data(), kInputCount, acceleration);
+		const std::string name = std::string("Integrate/") + Integrator::kName + (cacheAcceleration ? "/Cached" : "");
+		if (!runner.Run(name.c_str(), [&](size_t) {
+			step();
+			DoNotOptimize(integratePositions[0]);
+		}))
+		{
+			return;
+		}
+		evaluations = 0;
+		step();
+		runner.AddMetric("bodies_per_op", static_cast<double>(kInputCount));
+		runner.AddMetric("evaluations_per_step", static_cast<double>(evaluations) / kInputCount);
+		float stableDeltaTime = 0.0f;
+		for (const EnergyStep& energyStep : energySteps)
+		{
+			const double error = MeasureEnergyError<Integrator>(energyStep.deltaTime, cacheAcceleration);
+			runner.AddMetric(energyStep.metricName, error);
+			if (error <= kStableEnergyError)
+			{
+				stableDeltaTime = std::max(stableDeltaTime, energyStep.deltaTime);
+			}
+		}
+		runner.AddMetric("stable_dt", stableDeltaTime);
+	};
+	auto benchIntegrator = [&](auto policy) {
+		benchIntegratorWith(policy, false);
+		if constexpr (decltype(policy)::kCachesAcceleration)
+		{
+			benchIntegratorWith(policy, true);
+		}
+	};
+	benchIntegrator(SemiImplicitEuler{});
+	benchIntegrator(VelocityVerlet{});
+	benchIntegrator(PositionVerlet{});
+	benchIntegrator(RungeKutta4{});
+
+	/*----------衝突判定----------*/
+
+	runner.Run("IsCollision/Sphere-Sphere", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.spheres[i & kInputMask], in.spheres[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Sphere-Plane", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.spheres[i & kInputMask], in.planes[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Segment-Plane", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.segments[i & kInputMask], in.planes[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Triangle-Segment", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.triangles[i & kInputMask], in.segments[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/AABB-AABB", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.aabbs[i & kInputMask], in.aabbs[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/AABB-Sphere", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.aabbs[i & kInputMask], in.spheres[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/AABB-Segment", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.aabbs[i & kInputMask], in.segments[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/AABB-PreparedSegment", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.aabbs[i & kInputMask], in.preparedSegments[(i + 1) & kInputMask]));
+	});
+	if (runner.Run("IsCollision/OBB-OBB", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.obbs[i & kInputMask], in.obbs[(i + 1) & kInputMask]));
+	}))
+	{
+		// OBBを囲むAABB同士では重なるのに、OBB同士では重ならない組の割合（AABBで粗く判定した時の無駄）
+		auto boundingAABB = [](const OBB& obb) {
+			const float size[3] = { obb.size.x, obb.size.y, obb.size.z };
+			Vector3ex extent{ 0.0f, 0.0f, 0.0f };
+			for (int i = 0; i < 3; ++i)
+			{
+				extent = extent + Vector3ex{ std::abs(obb.orientations[i].x), std::abs(obb.orientations[i].y), std::abs(obb.orientations[i].z) } * size[i];
+			}
+			return AABB{ obb.center - extent, obb.center + extent };
+		};
+		size_t aabbHits = 0;
+		size_t obbHits = 0;
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			aabbHits += Func.IsCollision(boundingAABB(in.obbs[i]), boundingAABB(in.obbs[(i + 1) & kInputMask])) ? 1 : 0;
+			obbHits += Func.IsCollision(in.obbs[i], in.obbs[(i + 1) & kInputMask]) ? 1 : 0;
+		}
+		runner.AddMetric("hit_rate", static_cast<double>(obbHits) / kInputCount);
+		runner.AddMetric("aabb_false_positive_rate", static_cast<double>(aabbHits - obbHits) / kInputCount);
+	}
+	runner.Run("IsCollision/OBB-Sphere", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.obbs[i & kInputMask], in.spheres[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/OBB-Segment", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.obbs[i & kInputMask], in.segments[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/OBB-AABB", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.obbs[i & kInputMask], in.aabbs[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Capsule-Sphere", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.capsules[i & kInputMask], in.spheres[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Capsule-Capsule", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.capsules[i & kInputMask], in.capsules[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Capsule-Plane", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.capsules[i & kInputMask], in.planes[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Capsule-AABB", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.capsules[i & kInputMask], in.aabbs[(i + 1) & kInputMask]));
+	});
+	runner.Run("IsCollision/Capsule-Triangle", [&](size_t i) {
+		DoNotOptimize(Func.IsCollision(in.capsules[i & kInputMask], in.triangles[(i + 1) & kInputMask]));
+	});
+
+	/*----------GJKとEPA----------*/
+
+	// 球と球、球とAABBは距離とめり込みが式で求まるので、GJKとEPAの結果と比べる
+	// errorは式との差の絶対値、iterations_per_queryは1回あたりの平均反復回数
+	auto sphereSphereSignedDistance = [](const Sphere& a, const Sphere& b) {
+		return Func.Length(a.center - b.center) - a.radius - b.radius;
+	};
+	// 中心が箱の外なら最近点までの距離、中では最も近い面までの距離を負にしたものから半径を引く
+	auto sphereAABBSignedDistance = [](const Sphere& sphere, const AABB& box) {
+		const Vector3ex& c = sphere.center;
+		const Vector3ex closest{ std::clamp(c.x, box.min.x, box.max.x), std::clamp(c.y, box.min.y, box.max.y), std::clamp(c.z, box.min.z, box.max.z) };
+		const Vector3ex delta = c - closest;
+		if (Func.Dot(delta, delta) > 0.0f)
+		{
+			return Func.Length(delta) - sphere.radius;
+		}
+		const float inside = std::min({ c.x - box.min.x, box.max.x - c.x, c.y - box.min.y, box.max.y - c.y, c.z - box.min.z, box.max.z - c.z });
+		return -inside - sphere.radius;
+	};
+	auto benchGjk = [&](const char* name, auto&& makeB, auto&& signedDistance) {
+		if (!runner.Run(name, [&](size_t i) {
+			const auto b = makeB((i + 1) & kInputMask);
+			DoNotOptimize(GjkDistance(MakeConvex(in.spheres[i & kInputMask]), MakeConvex(b)));
+		}))
+		{
+			return;
+		}
+		double maxError = 0.0;
+		double sumError = 0.0;
+		double iterations = 0.0;
+		size_t separated = 0;
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			const auto b = makeB((i + 1) & kInputMask);
+			const GjkResult result = GjkDistance(MakeConvex(in.spheres[i]), MakeConvex(b));
+			iterations += result.iterations;
+			const float expected = signedDistance(in.spheres[i], b);
+			if (expected <= 0.0f || result.intersecting)
+			{
+				continue;
+			}
+			const double error = std::abs(static_cast<double>(result.distance) - expected);
+			maxError = std::max(maxError, error);
+			sumError += error;
+			++separated;
+		}
+		runner.AddMetric("separated_pairs", static_cast<double>(separated));
+		runner.AddMetric("max_distance_error", maxError);
+		runner.AddMetric("mean_distance_error", separated > 0 ? sumError / static_cast<double>(separated) : 0.0);
+		runner.AddMetric("iterations_per_query", iterations / kInputCount);
+	};
+	auto benchEpa = [&](const char* name, auto&& makeB, auto&& signedDistance) {
+		if (!runner.Run(name, [&](size_t i) {
+			const auto b = makeB((i + 1) & kInputMask);
+			DoNotOptimize(GjkEpaPenetration(MakeConvex(in.spheres[i & kInputMask]), MakeConvex(b)));
+		}))
+		{
+			return;
+		}
+		double maxError = 0.0;
+		double sumError = 0.0;
+		double iterations = 0.0;
+		size_t overlapping = 0;
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			const auto b = makeB((i + 1) & kInputMask);
+			const PenetrationResult result = GjkEpaPenetration(MakeConvex(in.spheres[i]), MakeConvex(b));
+			const float expected = -signedDistance(in.spheres[i], b);
+			if (expected <= 0.0f || !result.intersecting)
+			{
+				continue;
+			}
+			const double error = std::abs(static_cast<double>(result.depth) - expected);
+			maxError = std::max(maxError, error);
+			sumError += error;
+			iterations += result.iterations;
+			++overlapping;
+		}
+		runner.AddMetric("overlapping_pairs", static_cast<double>(overlapping));
+		runner.AddMetric("max_depth_error", maxError);
+		runner.AddMetric("mean_depth_error", overlapping > 0 ? sumError / static_cast<double>(overlapping) : 0.0);
+		runner.AddMetric("epa_iterations_per_query", overlapping > 0 ? iterations / static_cast<double>(overlapping) : 0.0);
+	};
+	auto sphereAt = [&](size_t i) { return in.spheres[i]; };
+	auto aabbAt = [&](size_t i) { return in.aabbs[i]; };
+	benchGjk("Gjk/Distance/Sphere-Sphere", sphereAt, sphereSphereSignedDistance);
+	benchGjk("Gjk/Distance/Sphere-AABB", aabbAt, sphereAABBSignedDistance);
+	benchEpa("Gjk/Penetration/Sphere-Sphere", sphereAt, sphereSphereSignedDistance);
+	benchEpa("Gjk/Penetration/Sphere-AABB", aabbAt, sphereAABBSignedDistance);
+
+	// 同じ組を少しずつ動かしながら10フレーム調べる（1回で10フレーム分）
+	// Warmは前のフレームの単体をキャッシュから作り直すので、反復回数が減る
+	constexpr size_t kCoherentFrames = 10;
+	auto coherentSphere = [&](size_t i, size_t frame) {
+		Sphere sphere = in.spheres[i & kInputMask];
+		sphere.center += in.vectors[(i + 3) & kInputMask] * (0.005f * static_cast<float>(frame));
+		return sphere;
+	};
+	auto runCoherent = [&](size_t i, bool warm) {
+		GjkCache cache;
+		uint32_t iterations = 0;
+		const AABB& box = in.aabbs[(i + 1) & kInputMask];
+		for (size_t frame = 0; frame < kCoherentFrames; ++frame)
+		{
+			const Sphere sphere = coherentSphere(i, frame);
+			const GjkResult result = GjkDistance(MakeConvex(sphere), MakeConvex(box), warm ? &cache : nullptr);
+			DoNotOptimize(result);
+			iterations += result.iterations;
+		}
+		return iterations;
+	};
+	for (const bool warm : { false, true })
+	{
+		if (runner.Run(warm ? "Gjk/Coherent/Sphere-AABB/Warm" : "Gjk/Coherent/Sphere-AABB/Cold", [&](size_t i) { runCoherent(i, warm); }))
+		{
+			double iterations = 0.0;
+			for (size_t i = 0; i < kInputCount; ++i)
+			{
+				iterations += runCoherent(i, warm);
+			}
+			runner.AddMetric("queries_per_op", static_cast<double>(kCoherentFrames));
+			runner.AddMetric("iterations_per_query", iterations / static_cast<double>(kInputCount * kCoherentFrames));
+		}
+	}
+
+	/*----------光線のパケット----------*/
+
+	// kInputCount本の光線（カメラから32x32の格子へ向かう）を図形の配列に当て、各光線で最も近い交点を求める
+	// 4本、8本のパケットとスカラー版を比べ、パケットの結果をレーンごとにスカラー版と照らし合わせる
+	constexpr size_t kRayGridSize = 32;
+	constexpr float kRayTMax = 100.0f;
+	std::vector<Ray> rays;
+	for (size_t y = 0; y < kRayGridSize; ++y)
+	{
+		for (size_t x = 0; x < kRayGridSize; ++x)
+		{
+			const Vector3ex origin{ 0.0f, 0.0f, -8.0f };
+			const Vector3ex target{ -2.5f + 5.0f * static_cast<float>(x) / (kRayGridSize - 1), -2.5f + 5.0f * static_cast<float>(y) / (kRayGridSize - 1), 0.0f };
+			rays.push_back({ origin, target - origin });
+		}
+	}
+	const std::vector<Sphere> raySpheres(in.spheres.begin(), in.spheres.begin() + 64);
+	const std::vector<AABB> rayAABBs(in.aabbs.begin(), in.aabbs.begin() + 64);
+	const std::vector<Plane> rayPlanes(in.planes.begin(), in.planes.begin() + 8);
+	std::vector<float> rayT(rays.size());
+	std::vector<int32_t> rayIds(rays.size());
+
+	auto traceScalar = [&](const auto& primitives, std::vector<float>& t, std::vector<int32_t>& ids) {
+		for (size_t r = 0; r < rays.size(); ++r)
+		{
+			float best = kRayTMax;
+			int32_t id = -1;
+			for (size_t k = 0; k < primitives.size(); ++k)
+			{
+				const float hitT = IntersectRay(rays[r], primitives[k]);
+				if (hitT >= 0.0f && hitT < best)
+				{
+					best = hitT;
+					id = static_cast<int32_t>(k);
+				}
+			}
+			t[r] = best;
+			ids[r] = id;
+		}
+	};
+	auto tracePackets = [&]<int N>(std::integral_constant<int, N>, const auto& primitives, std::vector<float>& t, std::vector<int32_t>& ids) {
+		for (size_t r = 0; r < rays.size(); r += N)
+		{
+			const RayPacket<N> packet = MakeRayPacket<N>(&rays[r], kRayTMax);
+			RayPacketHit<N> hit = MakeRayPacketHit(packet);
+			using Primitive = typename std::decay_t<decltype(primitives)>::value_type;
+			if constexpr (std::is_same_v<Primitive, Sphere>)
+			{
+				IntersectSpheres(packet, primitives.data(), primitives.size(), 0, hit);
+			}
+			else if constexpr (std::is_same_v<Primitive, AABB>)
+			{
+				IntersectAABBs(packet, primitives.data(), primitives.size(), 0, hit);
+			}
+			else
+			{
+				IntersectPlanes(packet, primitives.data(), primitives.size(), 0, hit);
+			}
+			std::copy_n(hit.t, N, t.begin() + r);
+			std::copy_n(hit.primitiveId, N, ids.begin() + r);
+		}
+	};
+	auto benchRays = [&](const std::string& shape, const auto& primitives) {
+		std::vector<float> referenceT(rays.size());
+		std::vector<int32_t> referenceIds(rays.size());
+		traceScalar(primitives, referenceT, referenceIds);
+		size_t hits = 0;
+		for (int32_t id : referenceIds)
+		{
+			hits += id >= 0 ? 1 : 0;
+		}
+		auto addCommonMetrics = [&]() {
+			runner.AddMetric("rays_per_op", static_cast<double>(rays.size()));
+			runner.AddMetric("primitives", static_cast<double>(primitives.size()));
+			runner.AddMetric("hit_rate", static_cast<double>(hits) / static_cast<double>(rays.size()));
+		};
+		if (runner.Run(("RayPacket/" + shape + "/Scalar").c_str(), [&](size_t) {
+			traceScalar(primitives, rayT, rayIds);
+			DoNotOptimize(rayT[0]);
+		}))
+		{
+			addCommonMetrics();
+		}
+
+		// tの誤差は|t - 基準| / max(1, 基準)、番号が違っても基準で同じtになる図形（同着）なら一致とみなす
+		auto benchWidth = [&]<int N>(std::integral_constant<int, N> width) {
+			if (!runner.Run(("RayPacket/" + shape + "/Packet" + std::to_string(N)).c_str(), [&](size_t) {
+				tracePackets(width, primitives, rayT, rayIds);
+				DoNotOptimize(rayT[0]);
+			}))
+			{
+				return;
+			}
+			tracePackets(width, primitives, rayT, rayIds);
+			double maxError = 0.0;
+			size_t idMismatches = 0;
+			for (size_t r = 0; r < rays.size(); ++r)
+			{
+				maxError = std::max(maxError, std::abs(static_cast<double>(rayT[r]) - referenceT[r]) / std::max(1.0, static_cast<double>(referenceT[r])));
+				if (rayIds[r] == referenceIds[r])
+				{
+					continue;
+				}
+				const bool tied = rayIds[r] >= 0 && referenceIds[r] >= 0 &&
+					std::abs(IntersectRay(rays[r], primitives[rayIds[r]]) - referenceT[r]) <= 1e-5f * std::max(1.0f, referenceT[r]);
+				idMismatches += tied ? 0 : 1;
+			}
+			addCommonMetrics();
+			runner.AddMetric("max_t_error", maxError);
+			runner.AddMetric("id_mismatches", static_cast<double>(idMismatches));
+		};
+		benchWidth(std::integral_constant<int, 4>{});
+		benchWidth(std::integral_constant<int, 8>{});
+	};
+	benchRays("Sphere", raySpheres);
+	benchRays("AABB", rayAABBs);
+	benchRays("Plane", rayPlanes);
+
+	// 1つのOBBとkInputCount個のOBB（スカラー版を並べたものと比べる）
+	OBBSoA obbSoA;
+	for (const OBB& obb : in.obbs)
+	{
+		obbSoA.Add(obb);
+	}
+	std::vector<uint8_t> obbHits(kInputCount);
+	runner.Run("IsCollisionArray/OBB-OBB", [&](size_t i) {
+		const OBB& query = in.obbs[i & kInputMask];
+		for (size_t j = 0; j < kInputCount; ++j)
+		{
+			obbHits[j] = Func.IsCollision(query, in.obbs[j]) ? 1 : 0;
+		}
+		DoNotOptimize(obbHits[0]);
+	});
+	if (runner.Run("IsCollisionBatch/OBB-OBB", [&](size_t i) {
+		DoNotOptimize(Func.IsCollisionBatch(in.obbs[i & kInputMask], obbSoA, obbHits));
+	}))
+	{
+		runner.AddMetric("obbs_per_op", static_cast<double>(kInputCount));
+	}
+
+	// 2049x2049点（約400万セル）の地形でも、1回の判定で見るのは球の真下のセルだけ
+	Heightfield terrain(2049, 2049, 0.1f, { -102.4f, 0.0f, -102.4f });
+	{
+		std::vector<float> heights(static_cast<size_t>(terrain.GetSampleCountX()) * terrain.GetSampleCountZ());
+		for (uint32_t iz = 0; iz < terrain.GetSampleCountZ(); ++iz)
+		{
+			for (uint32_t ix = 0; ix < terrain.GetSampleCountX(); ++ix)
+			{
+				heights[static_cast<size_t>(iz) * terrain.GetSampleCountX() + ix] = std::sin(float(ix) * 0.05f) * std::cos(float(iz) * 0.07f) * 2.0f;
+			}
+		}
+		terrain.SetHeights(heights.data());
+	}
+	BallSoA terrainBalls;
+	{
+		std::mt19937 engine(7);
+		std::uniform_real_distribution<float> horizontal(-100.0f, 100.0f);
+		std::uniform_real_distribution<float> vertical(-2.0f, 2.0f);
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			terrainBalls.Add({ horizontal(engine), vertical(engine), horizontal(engine) }, 0.2f);
+		}
+	}
+	runner.Run("Heightfield/Collide", [&](size_t i) {
+		Vector3ex normal{};
+		float depth = 0.0f;
+		DoNotOptimize(terrain.Collide(terrainBalls.GetPosition(i & kInputMask), terrainBalls.radius[i & kInputMask], normal, depth));
+		DoNotOptimize(depth);
+	});
+	std::vector<Contact> terrainContacts;
+	if (runner.Run("Heightfield/CollideBatch", [&](size_t) {
+		terrainContacts.clear();
+		DoNotOptimize(terrain.CollideBatch(terrainBalls, terrainContacts));
+	}))
+	{
+		runner.AddMetric("balls_per_op", static_cast<double>(terrainBalls.GetCount()));
+	}
+
+	/*----------符号付き距離のボリューム（トーラスのメッシュを焼き込み、三角形を総当たりする判定と比べる）----------*/
+
+	constexpr float kTorusMajor = 1.0f;
+	constexpr float kTorusMinor = 0.35f;
+	std::vector<Triangle> torus;
+	{
+		constexpr uint32_t kMajorSegments = 48;
+		constexpr uint32_t kMinorSegments = 24;
+		auto torusPoint = [&](uint32_t i, uint32_t j) {
+			const float u = 6.2831853f * static_cast<float>(i % kMajorSegments) / kMajorSegments;
+			const float v = 6.2831853f * static_cast<float>(j % kMinorSegments) / kMinorSegments;
+			const float ring = kTorusMajor + kTorusMinor * std::cos(v);
+			return Vector3ex{ ring * std::cos(u), kTorusMinor * std::sin(v), ring * std::sin(u) };
+		};
+		for (uint32_t i = 0; i < kMajorSegments; ++i)
+		{
+			for (uint32_t j = 0; j < kMinorSegments; ++j)
+			{
+				torus.push_back({ torusPoint(i, j), torusPoint(i + 1, j), torusPoint(i + 1, j + 1) });
+				torus.push_back({ torusPoint(i, j), torusPoint(i + 1, j + 1), torusPoint(i, j + 1) });
+			}
+		}
+	}
+	SdfVolume torusVolume = SdfVolume::FromTriangles(torus, 0.05f, 0.3f, true);
+	if (runner.Run("SdfVolume/Bake", [&](size_t) {
+		torusVolume.Bake(torus, true);
+		DoNotOptimize(torusVolume.GetDistances()[0]);
+	}))
+	{
+		runner.AddMetric("triangles", static_cast<double>(torus.size()));
+		runner.AddMetric("samples", static_cast<double>(torusVolume.GetSampleCountX()) * torusVolume.GetSampleCountY() * torusVolume.GetSampleCountZ());
+	}
+	BallSoA torusBalls;
+	{
+		std::mt19937 engine(11);
+		std::uniform_real_distribution<float> horizontal(-1.5f, 1.5f);
+		std::uniform_real_distribution<float> vertical(-0.5f, 0.5f);
+		for (size_t i = 0; i < kInputCount; ++i)
+		{
+			torusBalls.Add({ horizontal(engine), vertical(engine), horizontal(engine) }, 0.1f);
+		}
+	}
+	if (runner.Run("SdfVolume/Collide", [&](size_t i) {
+		Vector3ex normal{};
+		float depth = 0.0f;
+		DoNotOptimize(torusVolume.Collide(torusBalls.GetPosition(i & kInputMask), torusBalls.radius[i & kInputMask], normal, depth));
+		DoNotOptimize(depth);
+	}))
+	{
+		// 解析的なトーラスの距離との差（メッシュの粗さと補間の誤差を合わせたもの）
+		double maxError = 0.0;
+		double sumError = 0.0;
+		for (size_t i = 0; i < torusBalls.GetCount(); ++i)
+		{
+			const Vector3ex p = torusBalls.GetPosition(i);
+			const float ring = std::sqrt(p.x * p.x + p.z * p.z) - kTorusMajor;
+			const double error = std::abs(static_cast<double>(torusVolume.Sample(p)) - (std::sqrt(ring * ring + p.y * p.y) - kTorusMinor));
+			maxError = std::max(maxError, error);
+			sumError += error;
+		}
+		runner.AddMetric("max_abs_error", maxError);
+		runner.AddMetric("mean_abs_error", sumError / static_cast<double>(torusBalls.GetCount()));
+	}
+	std::vector<Contact> torusContacts;
+	if (runner.Run("SdfVolume/CollideBatch", [&](size_t) {
+		torusContacts.clear();
+		DoNotOptimize(torusVolume.CollideBatch(torusBalls, torusContacts));
+	}))
+	{
+		runner.AddMetric("balls_per_op", static_cast<double>(torusBalls.GetCount()));
+	}
+	// 比較用：全ての三角形との最近点を調べる（符号は分からない）
+	if (runner.Run("SdfVolume/TrianglesBruteForce", [&](size_t i) {
+		const Vector3ex p = torusBalls.GetPosition(i & kInputMask);
+		float best = std::numeric_limits<float>::max();
+		for (const Triangle& triangle : torus)
+		{
+			const Vector3ex delta = p - Func.ClosestPoint(p, triangle);
+			best = std::min(best, Func.Dot(delta, delta));
+		}
+		DoNotOptimize(best);
+	}))
+	{
+		runner.AddMetric("triangles", static_cast<double>(torus.size()));
+	}
+
+	/*----------布（316x316の粒子を1/60秒進める、床と球とAABBに当たる）----------*/
+
+	auto makeCloth = []() {
+		ClothSolver cloth;
+		constexpr uint32_t kClothSide = 316;
+		const uint32_t first = cloth.AddCloth({ -2.0f, 2.5f, -2.0f }, { 4.0f, 0.0f, 0.0f }, { 0.0f, 0.0f, 4.0f }, kClothSide, kClothSide, 0.001f);
+		cloth.SetInverseMass(first, 0.0f);
+		cloth.SetInverseMass(first + kClothSide - 1, 0.0f);
+		cloth.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+		cloth.AddSphere({ { 0.0f, 1.0f, 0.0f }, 0.8f });
+		cloth.AddAABB({ { 0.8f, 0.0f, 0.8f }, { 1.6f, 0.6f, 1.6f } });
+		return cloth;
+	};
+	ClothSolver cloth = makeCloth();
+	ThreadPool clothPool;
+	auto addClothMetrics = [&](uint32_t threadCount) {
+		runner.AddMetric("particles_per_op", static_cast<double>(cloth.GetParticleCount()));
+		runner.AddMetric("constraints_per_op", static_cast<double>(cloth.GetConstraintCount()));
+		runner.AddMetric("colors", static_cast<double>(cloth.GetColorCount()));
+		runner.AddMetric("threads", static_cast<double>(threadCount));
+	};
+	if (runner.Run("Cloth/Step/100k", [&](size_t) {
+		cloth.Step(1.0f / 60.0f);
+		DoNotOptimize(cloth.GetParticles().positionY[0]);
+	}))
+	{
+		addClothMetrics(1);
+	}
+	// 同じ色の拘束を区間に分けてスレッドで分け合う
+	cloth.SetThreadPool(&clothPool);
+	if (runner.Run("Cloth/Step/100k/ThreadPool", [&](size_t) {
+		cloth.Step(1.0f / 60.0f);
+		DoNotOptimize(cloth.GetParticles().positionY[0]);
+	}))
+	{
+		addClothMetrics(clothPool.GetThreadCount());
+	}
+	cloth.SetThreadPool(nullptr);
+
+	/*----------詰めて持つボール（100万個を箱の中で1/60秒進める、floatの配列と比べる）----------*/
+
+	constexpr size_t kCompactBallCount = 1000000;	// floatで32MB、詰めて13MB（L2に収まらない大きさ）
+	constexpr size_t kCompactErrorBallCount = 100000;	// 誤差を測る数
+	constexpr float kCompactBoxHalf = 9.5f;	// 壁の平面（位置の範囲は少し広い±10）
+	const BallStepSettings ballStepSettings;
+	std::vector<Plane> boxPlanes;
+	for (int axis = 0; axis < 3; ++axis)
+	{
+		for (float sign : { 1.0f, -1.0f })
+		{
+			Vector3ex normal = { 0.0f, 0.0f, 0.0f };
+			(axis == 0 ? normal.x : axis == 1 ? normal.y : normal.z) = sign;
+			boxPlanes.push_back({ normal, -kCompactBoxHalf });
+		}
+	}
+	auto makeCompactBalls = [&](size_t count) {
+		CompactBallSoA balls({ { -10.0f, -10.0f, -10.0f }, { 10.0f, 10.0f, 10.0f } });
+		for (uint32_t i = 0; i < 4; ++i)
+		{
+			balls.AddPalette({ 0.05f + 0.05f * static_cast<float>(i), 1.0f + static_cast<float>(i), 0xFFFFFFFF });
+		}
+		std::mt19937 engine(13);
+		std::uniform_real_distribution<float> position(-9.0f, 9.0f);
+		std::uniform_real_distribution<float> speed(-5.0f, 5.0f);
+		for (size_t i = 0; i < count; ++i)
+		{
+			balls.Add({ position(engine), position(engine), position(engine) }, { speed(engine), speed(engine), speed(engine) }, static_cast<uint8_t>(engine() % 4));
+		}
+		return balls;
+	};
+	CompactBallSoA compactBalls = makeCompactBalls(kCompactBallCount);
+	// 基準は詰めた後の値から始める（差は積分中の丸めだけになる）
+	BallStateSoA floatBalls;
+	compactBalls.Decode(floatBalls);
+	if (runner.Run("CompactBalls/Step/Float/1M", [&](size_t) {
+		floatBalls.Step(1.0f / 60.0f, boxPlanes, ballStepSettings);
+		DoNotOptimize(floatBalls.positionY[0]);
+	}))
+	{
+		runner.AddMetric("balls_per_op", static_cast<double>(kCompactBallCount));
+		runner.AddMetric("bytes_per_ball", 8.0 * sizeof(float));
+	}
+	if (runner.Run("CompactBalls/Step/Compact/1M", [&](size_t) {
+		compactBalls.Step(1.0f / 60.0f, boxPlanes, ballStepSettings);
+		DoNotOptimize(compactBalls.GetPaletteIndex(0));
+	}))
+	{
+		runner.AddMetric("balls_per_op", static_cast<double>(kCompactBallCount));
+		runner.AddMetric("bytes_per_ball", static_cast<double>(CompactBallSoA::kBytesPerBall));
+		runner.AddMetric("position_step", compactBalls.GetPositionStep().x);
+
+		// 同じ状態から両方を進め、1秒後と10秒後の位置と速度の差を測る（跳ね返るステップが1つずれたボールが最大になる）
+		// 跳ね返ったステップと軸（速度の向きが逆になるか0になり、重力の分より大きく変わった軸）が基準と食い違ったボールはdivergedとして数え、
+		// _in_stepの付いた値はそれ以外のボールだけの差（詰めたことによる丸めの誤差そのもの）
+		constexpr float kBounceVelocityJump = 0.05f;
+		CompactBallSoA compact = makeCompactBalls(kCompactErrorBallCount);
+		BallStateSoA reference;
+		compact.Decode(reference);
+		BallStateSoA decoded;
+		std::vector<Vector3ex> previousCompactVelocities(kCompactErrorBallCount);
+		std::vector<Vector3ex> previousReferenceVelocities(kCompactErrorBallCount);
+		std::vector<uint8_t> diverged(kCompactErrorBallCount, 0);
+		for (size_t i = 0; i < kCompactErrorBallCount; ++i)
+		{
+			previousCompactVelocities[i] = compact.GetVelocity(i);
+			previousReferenceVelocities[i] = reference.GetVelocity(i);
+		}
+		const Vector3ex gravityStep = ballStepSettings.gravity * (1.0f / 60.0f);
+		// 反発係数は速度全体に掛かるので、変化の大きさだけでなく向きが変わった軸を調べる
+		auto bouncedAxes = [&](const Vector3ex& previous, const Vector3ex& current) {
+			auto bounced = [](float before, float after, float gravity) {
+				return before * after <= 0.0f && std::abs(after - before - gravity) > kBounceVelocityJump;
+			};
+			return (bounced(previous.x, current.x, gravityStep.x) ? 1 : 0) |
+				(bounced(previous.y, current.y, gravityStep.y) ? 2 : 0) |
+				(bounced(previous.z, current.z, gravityStep.z) ? 4 : 0);
+		};
+		uint32_t steps = 0;
+		for (uint32_t checkpoint : { 60u, 600u })
+		{
+			for (; steps < checkpoint; ++steps)
+			{
+				compact.Step(1.0f / 60.0f, boxPlanes, ballStepSettings);
+				reference.Step(1.0f / 60.0f, boxPlanes, ballStepSettings);
+				for (size_t i = 0; i < kCompactErrorBallCount; ++i)
+				{
+					const Vector3ex compactVelocity = compact.GetVelocity(i);
+					const Vector3ex referenceVelocity = reference.GetVelocity(i);
+					if (bouncedAxes(previousCompactVelocities[i], compactVelocity) != bouncedAxes(previousReferenceVelocities[i], referenceVelocity))
+					{
+						diverged[i] = 1;
+					}
+					previousCompactVelocities[i] = compactVelocity;
+					previousReferenceVelocities[i] = referenceVelocity;
+				}
+			}
+			compact.Decode(decoded);
+			double maxPositionError = 0.0;
+			double sumPositionError = 0.0;
+			double maxVelocityError = 0.0;
+			double sumVelocityError = 0.0;
+			double maxInStepPositionError = 0.0;
+			double sumInStepPositionError = 0.0;
+			double maxInStepVelocityError = 0.0;
+			double sumInStepVelocityError = 0.0;
+			size_t divergedCount = 0;
+			for (size_t i = 0; i < kCompactErrorBallCount; ++i)
+			{
+				const double positionError = Func.Length(decoded.GetPosition(i) - reference.GetPosition(i));
+				const double velocityError = Func.Length(decoded.GetVelocity(i) - reference.GetVelocity(i));
+				maxPositionError = std::max(maxPositionError, positionError);
+				sumPositionError += positionError;
+				maxVelocityError = std::max(maxVelocityError, velocityError);
+				sumVelocityError += velocityError;
+				if (diverged[i] != 0)
+				{
+					++divergedCount;
+					continue;
+				}
+				maxInStepPositionError = std::max(maxInStepPositionError, positionError);
+				sumInStepPositionError += positionError;
+				maxInStepVelocityError = std::max(maxInStepVelocityError, velocityError);
+				sumInStepVelocityError += velocityError;
+			}
+			const double inStepCount = static_cast<double>(std::max<size_t>(kCompactErrorBallCount - divergedCount, 1));
+			const std::string suffix = "_" + std::to_string(checkpoint) + "steps";
+			runner.AddMetric(("max_position_error" + suffix).c_str(), maxPositionError);
+			runner.AddMetric(("mean_position_error" + suffix).c_str(), sumPositionError / kCompactErrorBallCount);
+			runner.AddMetric(("max_velocity_error" + suffix).c_str(), maxVelocityError);
+			runner.AddMetric(("mean_velocity_error" + suffix).c_str(), sumVelocityError / kCompactErrorBallCount);
+			runner.AddMetric(("diverged_ratio" + suffix).c_str(), static_cast<double>(divergedCount) / kCompactErrorBallCount);
+			runner.AddMetric(("max_position_error_in_step" + suffix).c_str(), maxInStepPositionError);
+			runner.AddMetric(("mean_position_error_in_step" + suffix).c_str(), sumInStepPositionError / inStepCount);
+			runner.AddMetric(("max_velocity_error_in_step" + suffix).c_str(), maxInStepVelocityError);
+			runner.AddMetric(("mean_velocity_error_in_step" + suffix).c_str(), sumInStepVelocityError / inStepCount);
+		}
+	}
+
+	/*----------ベジエ曲線の経路（16本の3次曲線をつないだ輪、道のりから位置を引く）----------*/
+
+	BezierPath bezierPath;
+	{
+		constexpr uint32_t kPathSegments = 16;
+		std::mt19937 engine(17);
+		std::uniform_real_distribution<float> wobble(-1.5f, 1.5f);
+		auto ringPoint = [](uint32_t i) {
+			const float angle = 6.2831853f * static_cast<float>(i % kPathSegments) / kPathSegments;
+			return Vector3ex{ 10.0f * std::cos(angle), 0.0f, 10.0f * std::sin(angle) };
+		};
+		for (uint32_t i = 0; i < kPathSegments; ++i)
+		{
+			const Vector3ex start = ringPoint(i);
+			const Vector3ex end = ringPoint(i + 1);
+			bezierPath.AddCubic(start, start + Vector3ex{ wobble(engine), wobble(engine), wobble(engine) },
+				end + Vector3ex{ wobble(engine), wobble(engine), wobble(engine) }, end);
+		}
+	}
+	if (runner.Run("BezierPath/Build", [&](size_t) {
+		bezierPath.Build();
+		DoNotOptimize(bezierPath.GetLength());
+	}))
+	{
+		runner.AddMetric("segments", static_cast<double>(bezierPath.GetSegmentCount()));
+		runner.AddMetric("intervals", static_cast<double>(bezierPath.GetIntervalCount()));
+	}
+	bezierPath.Build();
+	std::vector<float> pathDistances(kInputCount);
+	{
+		std::mt19937 engine(19);
+		std::uniform_real_distribution<float> distance(0.0f, bezierPath.GetLength());
+		for (float& d : pathDistances)
+		{
+			d = distance(engine);
+		}
+	}
+
+	// 比較用：表を作らず、毎回曲線を64本の弦に分けて道のりを足していく
+	auto searchArcLength = [&](float distance) {
+		constexpr uint32_t kChords = 64;
+		float travelled = 0.0f;
+		Vector3ex previous = bezierPath.EvaluateSegment(0, 0.0f);
+		for (size_t segment = 0; segment < bezierPath.GetSegmentCount(); ++segment)
+		{
+			for (uint32_t i = 1; i <= kChords; ++i)
+			{
+				const Vector3ex point = bezierPath.EvaluateSegment(segment, static_cast<float>(i) / kChords);
+				const float chord = Func.Length(point - previous);
+				if (travelled + chord >= distance)
+				{
+					return Func.Lerp(point, previous, chord > 0.0f ? (distance - travelled) / chord : 0.0f);
+				}
+				travelled += chord;
+				previous = point;
+			}
+		}
+		return previous;
+	};
+	runner.Run("BezierPath/ArcLengthSearch", [&](size_t i) {
+		DoNotOptimize(searchArcLength(pathDistances[i & kInputMask]));
+	});
+	if (runner.Run("BezierPath/Evaluate", [&](size_t i) {
+		DoNotOptimize(bezierPath.Evaluate(pathDistances[i & kInputMask]));
+	}))
+	{
+		// 曲線ごとに4096本の弦で道のりを足した基準の位置との差
+		constexpr uint32_t kReferenceChords = 4096;
+		std::vector<float> referenceDistances;
+		std::vector<Vector3ex> referencePoints;
+		float travelled = 0.0f;
+		Vector3ex previous = bezierPath.EvaluateSegment(0, 0.0f);
+		for (size_t segment = 0; segment < bezierPath.GetSegmentCount(); ++segment)
+		{
+			for (uint32_t i = 1; i <= kReferenceChords; ++i)
+			{
+				const Vector3ex point = bezierPath.EvaluateSegment(segment, static_cast<float>(i) / kReferenceChords);
+				travelled += Func.Length(point - previous);
+				referenceDistances.push_back(travelled);
+				referencePoints.push_back(point);
+				previous = point;
+			}
+		}
+		double maxError = 0.0;
+		for (float d : pathDistances)
+		{
+			// 基準の点の間は弦の上で補間する
+			const size_t k = std::clamp<size_t>(std::lower_bound(referenceDistances.begin(), referenceDistances.end(), d) - referenceDistances.begin(), 1, referencePoints.size() - 1);
+			const float alpha = (d - referenceDistances[k - 1]) / (referenceDistances[k] - referenceDistances[k - 1]);
+			const Vector3ex reference = Func.Lerp(referencePoints[k], referencePoints[k - 1], std::clamp(alpha, 0.0f, 1.0f));
+			maxError = std::max(maxError, static_cast<double>(Func.Length(bezierPath.Evaluate(d) - reference)));
+		}
+		runner.AddMetric("max_position_error", maxError);
+		runner.AddMetric("length_error", std::abs(static_cast<double>(bezierPath.GetLength()) - travelled));
+	}
+	std::vector<Vector3ex> pathPositions(kInputCount);
+	std::vector<Vector3ex> pathTangents(kInputCount);
+	if (runner.Run("BezierPath/EvaluateBatch", [&](size_t) {
+		bezierPath.EvaluateBatch(pathDistances, pathPositions);
+		DoNotOptimize(pathPositions[0]);
+	}))
+	{
+		runner.AddMetric("followers_per_op", static_cast<double>(kInputCount));
+	}
+	if (runner.Run("BezierPath/EvaluateBatch/Tangents", [&](size_t) {
+		bezierPath.EvaluateBatch(pathDistances, pathPositions, pathTangents);
+		DoNotOptimize(pathTangents[0]);
+	}))
+	{
+		runner.AddMetric("followers_per_op", static_cast<double>(kInputCount));
+	}
+
+	/*----------描画（分割と座標変換のみ、1回あたりの描画呼び出し数も出す）----------*/
+
+	const Matrix4x4ex viewProjection = Func.Multiply(
+		Func.Inverse(Func.MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.26f, 0.0f, 0.0f }, { 0.0f, 1.9f, -6.49f })),
+		Func.MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f));
+	const Matrix4x4ex viewport = Func.MakeViewportMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f);
+
+	// 1回を1フレームとみなしてフレームアリーナを戻し、計測後に1回分の描画呼び出し数を記録する
+	auto runDraw = [&](const char* name, auto&& draw) {
+		if (runner.Run(name, [&](size_t i) { draw(i); FrameArena::GetFrame().Reset(); }))
+		{
+			const uint64_t before = Novice::stats.Total();
+			draw(0);
+			runner.AddMetric("draw_calls_per_op", static_cast<double>(Novice::stats.Total() - before));
+		}
+	};
+
+	runDraw("Draw/Grid", [&](size_t) {
+		Func.DrawGrid(viewProjection, viewport);
+	});
+	// カメラが動かない間は覚えた線を描くだけ
+	GridRenderer grid;
+	runDraw("Draw/GridRenderer", [&](size_t) {
+		grid.Draw(viewProjection, viewport);
+	});
+	// 1辺1000mを1000分割した大きなグリッドを、毎回カメラを動かして作り直す（視錐台の外の線は捨てる）
+	GridRenderer largeGrid({ .halfWidth{ 500.0f }, .subdivision{ 1000 }, .majorEvery{ 10 } });
+	std::vector<Matrix4x4ex> movingViewProjections;
+	for (size_t i = 0; i < kInputCount; ++i)
+	{
+		movingViewProjections.push_back(Func.Multiply(
+			Func.Inverse(Func.MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.26f, 0.001f * static_cast<float>(i), 0.0f }, { 0.0f, 1.9f, -6.49f })),
+			Func.MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f)));
+	}
+	runDraw("Draw/GridRenderer/Rebuild/Large", [&](size_t i) {
+		largeGrid.Draw(movingViewProjections[i & kInputMask], viewport);
+	});
+	runDraw("Draw/Sphere", [&](size_t i) {
+		Func.DrawSphere(in.spheres[i & kInputMask], viewProjection, viewport, WHITE);
+	});
+	// 画面内に散らばった小さな球10万個（ほとんどが円1つになる）
+	std::vector<Sphere> manySpheres;
+	{
+		std::mt19937 engine(11);
+		std::uniform_real_distribution<float> horizontal(-3.0f, 3.0f);
+		std::uniform_real_distribution<float> vertical(-1.0f, 3.0f);
+		std::uniform_real_distribution<float> radius(0.01f, 0.05f);
+		for (size_t i = 0; i < 100000; ++i)
+		{
+			manySpheres.push_back({ { horizontal(engine), vertical(engine), horizontal(engine) }, radius(engine) });
+		}
+	}
+	runDraw("Draw/Spheres/100k", [&](size_t) {
+		Func.DrawSpheres(manySpheres, viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/Plane", [&](size_t i) {
+		Func.DrawPlane(in.planes[i & kInputMask], viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/Triangle", [&](size_t i) {
+		Func.DrawTriangle(in.triangles[i & kInputMask], viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/AABB", [&](size_t i) {
+		Func.DrawAABB(in.aabbs[i & kInputMask], viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/OBB", [&](size_t i) {
+		Func.DrawOBB(in.obbs[i & kInputMask], viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/Bezier", [&](size_t i) {
+		Func.DrawBezier(in.vectors[i & kInputMask], in.vectors[(i + 1) & kInputMask], in.vectors[(i + 2) & kInputMask], viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/ControlPoint", [&](size_t i) {
+		Func.DrawControlPoint(in.vectors[i & kInputMask], viewProjection, viewport);
+	});
+	runDraw("Draw/Heightfield", [&](size_t) {
+		Func.DrawHeightfield(terrain, viewProjection, viewport, WHITE);
+	});
+	runDraw("Draw/Cloth/100k", [&](size_t) {
+		Func.DrawParticleEdges(cloth.GetParticles(), cloth.GetEdgeIndices(), viewProjection, viewport, WHITE);
+	});
+
+	/*----------読み込み----------*/
+
+	// 法線とUV付きの格子（実際の書き出しに近い行の構成）をメモリ上に作って解析する
+	std::string objText;
+	{
+		constexpr int kGrid = 256;
+		char line[128];
+		for (int i = 0; i < kGrid; ++i)
+		{
+			for (int j = 0; j < kGrid; ++j)
+			{
+				std::snprintf(line, sizeof(line), "v %.6f %.6f %.6f\nvn 0.000000 1.000000 0.000000\nvt %.6f %.6f\n",
+					i * 0.01, (i * 7 + j * 13) % 100 * 0.01, j * 0.01, i / double(kGrid), j / double(kGrid));
+				objText += line;
+			}
+		}
+		for (int i = 0; i + 1 < kGrid; ++i)
+		{
+			for (int j = 0; j + 1 < kGrid; ++j)
+			{
+				const int a = i * kGrid + j + 1;
+				const int b = a + 1;
+				const int c = a + kGrid + 1;
+				const int d = a + kGrid;
+				std::snprintf(line, sizeof(line), "f %d/%d/%d %d/%d/%d %d/%d/%d %d/%d/%d\n", a, a, a, b, b, b, c, c, c, d, d, d);
+				objText += line;
+			}
+		}
+	}
+	ObjMesh mesh;
+	if (runner.Run("ParseObj/Grid", [&](size_t) { ParseObj(objText.data(), objText.size(), mesh); }))
+	{
+		runner.AddMetric("bytes_per_op", static_cast<double>(objText.size()));
+		runner.AddMetric("triangles_per_op", static_cast<double>(mesh.GetTriangleCount()));
+	}
+
+	runner.PrintJson(stdout);
+	return 0;
+}
@@ -0,0 +1,337 @@
+#include "Math/MathFunction.h"
+#include "Math/PhysicsWorld.h"
+#include "Math/SimRecorder.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <Windows.h>
+#include <Psapi.h>
+#pragma comment(lib, "Psapi.lib")
+#else
+#include <sys/resource.h>
+#endif
+
+/*----------シーン全体のベンチマーク----------*/
+// 描画せずにPhysicsWorldだけを組み立て、決まった回数ステップを進めて1ステップの時間を測る
+// 使い方: SceneBench [--scene=drop|resting] [--balls=N] [--planes=P] [--aabbs=M] [--steps=K] [--warmup=W] [--dt=秒] [--seed=S] [--record=パス]
+// drop: 全てのボールをすり鉢に落とす（ほとんどが起きている）
+// resting: 平らな床に並べて置いたボールの上に、一部だけを落とす（ほとんどが眠っている）
+// --record: 各ステップの後にSimRecorder::RecordStepで記録し、その時間をステップとは別に測る（終わったら開き直して全フレームを読む時間も測る）
+
+namespace
+{
+	MathFunction Func;
+
+	/// <summary>
+	/// シーンの設定
+	/// </summary>
+	struct SceneOptions
+	{
+		bool resting = false;			// --scene=restingならtrue
+		uint32_t balls = 1000;			// ボールの数
+		uint32_t planes = 4;			// 傾いた平面の数（すり鉢状に並べる）
+		uint32_t aabbs = 64;			// 静的なAABBの数
+		uint32_t steps = 600;			// 計測するステップ数
+		uint32_t warmup = 60;			// 計測前に進めるステップ数
+		float deltaTime = 1.0f / 60.0f;
+		uint32_t seed = 12345;
+		const char* recordPath = nullptr;	// 記録するファイル（nullptrなら記録しない）
+	};
+
+	SceneOptions ParseOptions(int argc, char** argv)
+	{
+		SceneOptions options;
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			auto readUint = [&](const char* prefix, uint32_t& value) {
+				const size_t length = std::strlen(prefix);
+				if (std::strncmp(arg, prefix, length) == 0)
+				{
+					value = static_cast<uint32_t>(std::strtoul(arg + length, nullptr, 10));
+				}
+			};
+			readUint("--balls=", options.balls);
+			readUint("--planes=", options.planes);
+			readUint("--aabbs=", options.aabbs);
+			readUint("--steps=", options.steps);
+			readUint("--warmup=", options.warmup);
+			readUint("--seed=", options.seed);
+			if (std::strncmp(arg, "--dt=", 5) == 0)
+			{
+				options.deltaTime = static_cast<float>(std::atof(arg + 5));
+			}
+			if (std::strcmp(arg, "--scene=resting") == 0)
+			{
+				options.resting = true;
+			}
+			if (std::strncmp(arg, "--record=", 9) == 0)
+			{
+				options.recordPath = arg + 9;
+			}
+		}
+		options.deltaTime = options.deltaTime > 0.0f ? options.deltaTime : 1.0f / 60.0f;
+		return options;
+	}
+
+	/// <summary>
+	/// ボールを傾いた平面の上に落とすシーンを作る
+	/// 平面はmain.cppの平面と同じくらいの傾きで、法線を水平方向に回して並べる（全ての平面の上側がすり鉢になる）
+	/// </summary>
+	PhysicsWorld BuildScene(const SceneOptions& options)
+	{
+		constexpr float kHalfWidth = 4.0f;		// ボールとAABBを置く範囲
+		constexpr float kTilt = 0.35f;			// 法線の水平成分（main.cppの平面は約0.4）
+		std::mt19937 engine(options.seed);
+		std::uniform_real_distribution<float> horizontal(-kHalfWidth, kHalfWidth);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		PhysicsWorld world;
+		std::vector<Plane> planes;
+		for (uint32_t i = 0; i < options.planes; ++i)
+		{
+			const float angle = 6.2831853f * static_cast<float>(i) / static_cast<float>(options.planes);
+			const Vector3ex normal = Func.Normalize({ std::sin(angle) * kTilt, 1.0f, std::cos(angle) * kTilt });
+			planes.push_back({ normal, 0.0f });
+			world.AddPlane(planes.back());
+		}
+		// (x, z)でのすり鉢の面の高さ（全ての平面の上側になる一番低い高さ）
+		auto surfaceHeight = [&](float x, float z) {
+			float height = 0.0f;
+			for (const Plane& plane : planes)
+			{
+				height = std::max(height, (plane.distance - plane.normal.x * x - plane.normal.z * z) / plane.normal.y);
+			}
+			return height;
+		};
+
+		// AABBは面に半分埋めて置く
+		for (uint32_t i = 0; i < options.aabbs; ++i)
+		{
+			const float x = horizontal(engine);
+			const float z = horizontal(engine);
+			const Vector3ex extent = { 0.1f + 0.4f * unit(engine), 0.2f + 0.8f * unit(engine), 0.1f + 0.4f * unit(engine) };
+			const Vector3ex center = { x, surfaceHeight(x, z) + extent.y * 0.5f, z };
+			world.AddAABB({ center - extent, center + extent });
+		}
+
+		// ボールは面の上空に、数が多いほど高い範囲まで散らす
+		const float height = 2.0f + static_cast<float>(options.balls) / 2000.0f;
+		for (uint32_t i = 0; i < options.balls; ++i)
+		{
+			Ball ball{};
+			const float x = horizontal(engine);
+			const float z = horizontal(engine);
+			ball.position = { x, surfaceHeight(x, z) + 2.0f + height * unit(engine), z };
+			ball.velocity = { 0.0f, 0.0f, 0.0f };
+			ball.acceleration = { 0.0f, -9.8f, 0.0f };
+			ball.mass = 1.0f;
+			ball.radius = 0.05f + 0.1f * unit(engine);
+			ball.color = 0xFFFFFFFF;
+			world.AddBody(ball);
+		}
+		return world;
+	}
+
+	/// <summary>
+	/// 平らな床に格子状にボールを置き、kFallingRatioの割合だけ上から落とすシーンを作る
+	/// 置いたボールはSleepSettings::timeToSleepほどで眠り、その後は落ちてきたボールの周りだけが起きる（--planesは使わない）
+	/// </summary>
+	PhysicsWorld BuildRestingScene(const SceneOptions& options)
+	{
+		constexpr float kRadius = 0.1f;
+		constexpr float kSpacing = 0.25f;		// 置くボールの間隔（直径より広く、最初は触れ合わない）
+		constexpr float kFallingRatio = 0.02f;	// 落とすボールの割合
+		std::mt19937 engine(options.seed);
+		std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+
+		PhysicsWorld world;
+		world.AddPlane({ { 0.0f, 1.0f, 0.0f }, 0.0f });
+
+		const uint32_t fallingCount = static_cast<uint32_t>(static_cast<float>(options.balls) * kFallingRatio);
+		const uint32_t restingCount = options.balls - fallingCount;
+		const uint32_t side = static_cast<uint32_t>(std::ceil(std::sqrt(static_cast<float>(std::max<uint32_t>(restingCount, 1)))));
+		const float halfWidth = static_cast<float>(side) * kSpacing * 0.5f;
+
+		// AABBは並べたボールの外側の床に置く（ボールと重なると横に押し出され、摩擦が無いので止まらない）
+		for (uint32_t i = 0; i < options.aabbs; ++i)
+		{
+			const Vector3ex extent = { 0.1f + 0.4f * unit(engine), 0.2f + 0.8f * unit(engine), 0.1f + 0.4f * unit(engine) };
+			const float sign = unit(engine) < 0.5f ? -1.0f : 1.0f;
+			const Vector3ex center = { sign * (halfWidth + 1.0f + 2.0f * unit(engine)), extent.y, halfWidth * (2.0f * unit(engine) - 1.0f) };
+			world.AddAABB({ center - extent, center + extent });
+		}
+
+		for (uint32_t i = 0; i < options.balls; ++i)
+		{
+			Ball ball{};
+			// 落とすボールは置いたボールの真上から落とす（床に摩擦が無いので、斜めに当たると横に滑り続けて周りを起こし続ける）
+			const uint32_t cell = i < restingCount ? i : static_cast<uint32_t>((static_cast<uint64_t>(i) * 7919u) % std::max<uint32_t>(restingCount, 1));
+			const float height = i < restingCount ? kRadius : 2.0f + 3.0f * unit(engine);
+			ball.position = { static_cast<float>(cell % side) * kSpacing - halfWidth, height, static_cast<float>(cell / side) * kSpacing - halfWidth };
+			ball.velocity = { 0.0f, 0.0f, 0.0f };
+			ball.acceleration = { 0.0f, -9.8f, 0.0f };
+			ball.mass = 1.0f;
+			ball.radius = kRadius;
+			ball.color = 0xFFFFFFFF;
+			world.AddBody(ball);
+		}
+		return world;
+	}
+
+	/// <summary>
+	/// プロセスの最大の常駐メモリ（KB）
+	/// </summary>
+	size_t GetPeakMemoryKB()
+	{
+#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters{};
+		counters.cb = sizeof(counters);
+		if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		{
+			return counters.PeakWorkingSetSize / 1024;
+		}
+		return 0;
+#else
+		rusage usage{};
+		getrusage(RUSAGE_SELF, &usage);
+#if defined(__APPLE__)
+		return static_cast<size_t>(usage.ru_maxrss) / 1024;	// macOSはバイト単位
+#else
+		return static_cast<size_t>(usage.ru_maxrss);
+#endif
+#endif
+	}
+
+	/// <summary>
+	/// 並べ替え済みの値からパーセンタイルを求める（最も近い順位）
+	/// </summary>
+	double Percentile(const std::vector<double>& sorted, double percent)
+	{
+		if (sorted.empty())
+		{
+			return 0.0;
+		}
+		const size_t rank = static_cast<size_t>(std::ceil(percent / 100.0 * static_cast<double>(sorted.size())));
+		return sorted[std::clamp<size_t>(rank, 1, sorted.size()) - 1];
+	}
+}
+
+int main(int argc, char** argv)
+{
+	const SceneOptions options = ParseOptions(argc, argv);
+
+	const auto buildStart = std::chrono::steady_clock::now();
+	PhysicsWorld world = options.resting ? BuildRestingScene(options) : BuildScene(options);
+	const double buildMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - buildStart).count();
+
+	for (uint32_t i = 0; i < options.warmup; ++i)
+	{
+		world.Step(options.deltaTime);
+	}
+
+	SimRecorder recorder;
+	if (options.recordPath != nullptr && !recorder.Open(options.recordPath, options.deltaTime))
+	{
+		std::fprintf(stderr, "cannot open %s\n", options.recordPath);
+		return 1;
+	}
+
+	std::vector<double> stepMs;
+	stepMs.reserve(options.steps);
+	double recordMs = 0.0;
+	uint64_t contactCount = 0;
+	uint64_t awakeCount = 0;
+	const auto runStart = std::chrono::steady_clock::now();
+	for (uint32_t i = 0; i < options.steps; ++i)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		world.Step(options.deltaTime);
+		const auto stepEnd = std::chrono::steady_clock::now();
+		stepMs.push_back(std::chrono::duration<double, std::milli>(stepEnd - start).count());
+		if (recorder.IsRecording())
+		{
+			const std::vector<Contact>& contacts = world.GetContacts();
+			const std::vector<uint32_t>& awakeBodies = world.GetAwakeBodies();
+			recorder.RecordStep(i, world.GetBodies(), world.GetBodyCount(), awakeBodies.data(), awakeBodies.size(), contacts.data(), contacts.size());
+			recordMs += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stepEnd).count();
+		}
+		contactCount += world.GetContacts().size();
+		awakeCount += world.GetAwakeCount();
+	}
+	const double totalSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - runStart).count();
+
+	// 書き出しを終えてから開き直し、全フレームの全ボールを読む
+	const bool recorded = recorder.IsRecording();
+	const uint64_t stallCount = recorder.GetStallCount();
+	double closeMs = 0.0;
+	double replayOpenMs = 0.0;
+	double replayFrameUs = 0.0;
+	size_t replayFrames = 0;
+	if (recorded)
+	{
+		const auto closeStart = std::chrono::steady_clock::now();
+		recorder.Close();
+		const auto openStart = std::chrono::steady_clock::now();
+		SimReplayer replayer;
+		const bool opened = replayer.Open(options.recordPath);
+		const auto readStart = std::chrono::steady_clock::now();
+		float checksum = 0.0f;
+		for (size_t i = 0; opened && i < replayer.GetFrameCount(); ++i)
+		{
+			const RecordedFrameView frame = replayer.GetFrame(i);
+			for (uint32_t body = 0; body < frame.header->bodyCount; ++body)
+			{
+				checksum += frame.bodies[body].position[1];
+			}
+		}
+		const auto readEnd = std::chrono::steady_clock::now();
+		replayFrames = opened ? replayer.GetFrameCount() : 0;
+		closeMs = std::chrono::duration<double, std::milli>(openStart - closeStart).count();
+		replayOpenMs = std::chrono::duration<double, std::milli>(readStart - openStart).count();
+		replayFrameUs = replayFrames > 0 ? std::chrono::duration<double, std::micro>(readEnd - readStart).count() / static_cast<double>(replayFrames) : 0.0;
+		// 読んだ値を使って、読み出しが消されないようにする
+		if (std::isnan(checksum))
+		{
+			std::fprintf(stderr, "replay checksum is NaN\n");
+		}
+	}
+
+	std::vector<double> sorted = stepMs;
+	std::sort(sorted.begin(), sorted.end());
+	double sum = 0.0;
+	for (double ms : stepMs)
+	{
+		sum += ms;
+	}
+	const double steps = static_cast<double>(std::max<uint32_t>(options.steps, 1));
+
+	std::printf("{\n  \"suite\": \"SceneBench\",\n");
+	std::printf("  \"scene\": { \"name\": \"%s\", \"balls\": %u, \"planes\": %u, \"aabbs\": %u, \"steps\": %u, \"warmup\": %u, \"dt\": %.6g, \"seed\": %u },\n",
+		options.resting ? "resting" : "drop", options.balls, options.planes, options.aabbs, options.steps, options.warmup, options.deltaTime, options.seed);
+	std::printf("  \"results\": { \"steps_per_sec\": %.1f, \"mean_ms\": %.4f, \"p50_ms\": %.4f, \"p99_ms\": %.4f, \"max_ms\": %.4f,"
+		" \"contacts_per_step\": %.1f, \"awake_per_step\": %.1f, \"build_ms\": %.3f, \"peak_memory_kb\": %zu }%s\n",
+		totalSeconds > 0.0 ? static_cast<double>(options.steps) / totalSeconds : 0.0, sum / steps,
+		Percentile(sorted, 50.0), Percentile(sorted, 99.0), sorted.empty() ? 0.0 : sorted.back(),
+		static_cast<double>(contactCount) / steps, static_cast<double>(awakeCount) / steps, buildMs, GetPeakMemoryKB(), recorded ? "," : "");
+	// record_overhead_percentはRecordStepの時間をステップの時間で割ったもの（書き込みスレッドの影響は記録しない時のmean_msと比べる）
+	if (recorded)
+	{
+		std::printf("  \"record\": { \"record_ms\": %.4f, \"record_overhead_percent\": %.2f, \"stalls\": %llu, \"close_ms\": %.3f,"
+			" \"replay_frames\": %zu, \"replay_open_ms\": %.3f, \"replay_frame_us\": %.3f }\n",
+			recordMs / steps, sum > 0.0 ? 100.0 * recordMs / sum : 0.0, static_cast<unsigned long long>(stallCount), closeMs,
+			replayFrames, replayOpenMs, replayFrameUs);
+	}
+	std::printf("}\n");
+	return 0;
+}
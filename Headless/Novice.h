@@ -0,0 +1,50 @@
+#pragma once
+#include <cstdint>
+
+// Windows以外でMathをビルドするための最小限のNovice
+// 描画は行わず、呼ばれた回数だけを数える（ベンチマークで分割数を確かめるため）
+
+enum FillMode
+{
+	kFillModeSolid,
+	kFillModeWireFrame,
+};
+
+enum BlendMode
+{
+	kBlendModeNone,
+	kBlendModeNormal,
+};
+
+enum Color : unsigned int
+{
+	RED = 0xFF0000FF,
+	GREEN = 0x00FF00FF,
+	BLUE = 0x0000FFFF,
+	WHITE = 0xFFFFFFFF,
+	BLACK = 0x000000FF,
+};
+
+/// <summary>
+/// 描画関数が呼ばれた回数
+/// </summary>
+struct HeadlessDrawStats final
+{
+	uint64_t lines = 0;
+	uint64_t triangles = 0;
+	uint64_t ellipses = 0;
+	uint64_t boxes = 0;
+
+	uint64_t Total() const { return lines + triangles + ellipses + boxes; }
+};
+
+class Novice final
+{
+public:
+	static void DrawLine(int, int, int, int, unsigned int) { ++stats.lines; }
+	static void DrawTriangle(int, int, int, int, int, int, unsigned int, FillMode) { ++stats.triangles; }
+	static void DrawEllipse(int, int, int, int, float, unsigned int, FillMode) { ++stats.ellipses; }
+	static void DrawBox(int, int, int, int, float, unsigned int, FillMode) { ++stats.boxes; }
+
+	static inline HeadlessDrawStats stats;
+};
@@ -0,0 +1,11 @@
+#pragma once
+
+/// <summary>
+/// 3次元ベクトル（Novice付属のものと同じレイアウト）
+/// </summary>
+struct Vector3 final
+{
+	float x;
+	float y;
+	float z;
+};
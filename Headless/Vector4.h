@@ -0,0 +1,12 @@
+#pragma once
+
+/// <summary>
+/// 4次元ベクトル（Novice付属のものと同じレイアウト）
+/// </summary>
+struct Vector4 final
+{
+	float x;
+	float y;
+	float z;
+	float w;
+};
@@ -6,4 +6,19 @@ struct AABB final
 {
 	Vector3ex min; //最小値
 	Vector3ex max; //最大値
-};
\ No newline at end of file
+
+	/// <summary>
+	/// サポート写像（direction方向に最も遠い頂点）
+	/// </summary>
+	/// <param name="direction">方向</param>
+	/// <returns></returns>
+	Vector3ex Support(const Vector3ex& direction) const
+	{
+		return
+		{
+			direction.x >= 0.0f ? max.x : min.x,
+			direction.y >= 0.0f ? max.y : min.y,
+			direction.z >= 0.0f ? max.z : min.z,
+		};
+	}
+};
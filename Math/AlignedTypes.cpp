@@ -0,0 +1,76 @@
+#include "AlignedTypes.h"
+#include <cassert>
+
+static_assert(sizeof(Vector3ex) == sizeof(float) * 3, "Vector3exの配列をfloatの配列として読む");
+
+void ToAligned(const Vector3ex* source, Vec3A* destination, size_t count)
+{
+	const float* in = &source->x;
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	// 4個分（12 floats）を3回で読み、4個のxyz0に並べ替える
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 a = _mm_loadu_ps(in + i * 3);		// x0 y0 z0 x1
+		const __m128 b = _mm_loadu_ps(in + i * 3 + 4);	// y1 z1 x2 y2
+		const __m128 c = _mm_loadu_ps(in + i * 3 + 8);	// z2 x3 y3 z3
+
+		const __m128 ab = _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 0, 3, 3));	// x1 x1 y1 z1
+		_mm_store_ps(&destination[i].x, _mm_and_ps(a, xyzMask));
+		_mm_store_ps(&destination[i + 1].x, _mm_and_ps(_mm_shuffle_ps(ab, ab, _MM_SHUFFLE(3, 3, 2, 1)), xyzMask));
+		_mm_store_ps(&destination[i + 2].x, _mm_and_ps(_mm_shuffle_ps(b, c, _MM_SHUFFLE(0, 0, 3, 2)), xyzMask));
+		_mm_store_ps(&destination[i + 3].x, _mm_and_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 2, 1)), xyzMask));
+	}
+	for (; i < count; ++i)
+	{
+		destination[i] = Vec3A::From(source[i]);
+	}
+}
+
+void FromAligned(const Vec3A* source, Vector3ex* destination, size_t count)
+{
+	float* out = &destination->x;
+
+	// 4個のxyzwを読み、wを詰めて12 floatsを3回で書く
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 p0 = _mm_load_ps(&source[i].x);
+		const __m128 p1 = _mm_load_ps(&source[i + 1].x);
+		const __m128 p2 = _mm_load_ps(&source[i + 2].x);
+		const __m128 p3 = _mm_load_ps(&source[i + 3].x);
+
+		const __m128 x1z0 = _mm_shuffle_ps(p1, p0, _MM_SHUFFLE(2, 2, 0, 0));	// x1 x1 z0 z0
+		const __m128 z2x3 = _mm_shuffle_ps(p2, p3, _MM_SHUFFLE(0, 0, 2, 2));	// z2 z2 x3 x3
+		_mm_storeu_ps(out + i * 3, _mm_shuffle_ps(p0, x1z0, _MM_SHUFFLE(0, 2, 1, 0)));		// x0 y0 z0 x1
+		_mm_storeu_ps(out + i * 3 + 4, _mm_shuffle_ps(p1, p2, _MM_SHUFFLE(1, 0, 2, 1)));	// y1 z1 x2 y2
+		_mm_storeu_ps(out + i * 3 + 8, _mm_shuffle_ps(z2x3, p3, _MM_SHUFFLE(2, 1, 2, 0)));	// z2 x3 y3 z3
+	}
+	for (; i < count; ++i)
+	{
+		destination[i] = source[i].ToVector3ex();
+	}
+}
+
+void TransformArray(const Vec3A* points, size_t count, const Mat4A& matrix, Vec3A* results)
+{
+	// 行ベクトル×行列なので、結果は行列の各行を点の成分で重み付けした和
+	const Float4 row0 = matrix.LoadRow(0);
+	const Float4 row1 = matrix.LoadRow(1);
+	const Float4 row2 = matrix.LoadRow(2);
+	const Float4 row3 = matrix.LoadRow(3);
+	const __m128 xyzMask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const __m128 point = points[i].Load().v;
+		const Float4 x = { _mm_shuffle_ps(point, point, _MM_SHUFFLE(0, 0, 0, 0)) };
+		const Float4 y = { _mm_shuffle_ps(point, point, _MM_SHUFFLE(1, 1, 1, 1)) };
+		const Float4 z = { _mm_shuffle_ps(point, point, _MM_SHUFFLE(2, 2, 2, 2)) };
+		const Float4 transformed = x * row0 + y * row1 + z * row2 + row3;
+		const __m128 w = _mm_shuffle_ps(transformed.v, transformed.v, _MM_SHUFFLE(3, 3, 3, 3));
+		assert(_mm_cvtss_f32(w) != 0.0f);
+		results[i].Store({ _mm_and_ps(_mm_div_ps(transformed.v, w), xyzMask) });
+	}
+}
@@ -0,0 +1,113 @@
+#pragma once
+#include "Matrix4x4ex.h"
+#include "SimdFloat.h"
+#include "Vector3ex.h"
+#include "Vector4.h"
+#include <bit>
+#include <cstddef>
+#include <cstring>
+#include <type_traits>
+
+/*----------SIMDでそのまま読み書きできる保存用の型----------*/
+// どれもコンストラクタを持たない（配列を確保しても初期化しない）ので、値はZero/Identityか変換で作る
+// Vec3A/Vec4Aは16バイト、Mat4Aは32バイトの境界に置かれ、アラインされたロードとストアが使える
+
+/// <summary>
+/// 16バイトに揃えた3次元ベクトル（wは0のまま使う、4要素でまとめて読んでも結果に混ざらない）
+/// </summary>
+struct alignas(16) Vec3A final
+{
+	float x;
+	float y;
+	float z;
+	float w;
+
+	static Vec3A Zero() { return { 0.0f, 0.0f, 0.0f, 0.0f }; }
+	static Vec3A From(const Vector3ex& v) { return { v.x, v.y, v.z, 0.0f }; }
+	Vector3ex ToVector3ex() const { return { x, y, z }; }
+
+	Float4 Load() const { return Float4::LoadAligned(&x); }
+	void Store(Float4 value) { value.StoreAligned(&x); }
+};
+
+/// <summary>
+/// 16バイトに揃えた4次元ベクトル（Vector4と同じ並び）
+/// </summary>
+struct alignas(16) Vec4A final
+{
+	float x;
+	float y;
+	float z;
+	float w;
+
+	static Vec4A Zero() { return { 0.0f, 0.0f, 0.0f, 0.0f }; }
+	static Vec4A From(const Vector4& v) { return { v.x, v.y, v.z, v.w }; }
+	Vector4 ToVector4() const { return { x, y, z, w }; }
+
+	Float4 Load() const { return Float4::LoadAligned(&x); }
+	void Store(Float4 value) { value.StoreAligned(&x); }
+};
+
+/// <summary>
+/// 32バイトに揃えた4x4行列（Matrix4x4exと同じ並びなので、配列ごとmemcpyできる）
+/// </summary>
+struct alignas(32) Mat4A final
+{
+	float m[4][4];
+
+	static Mat4A Zero()
+	{
+		Mat4A result;
+		std::memset(result.m, 0, sizeof(result.m));
+		return result;
+	}
+	static Mat4A Identity()
+	{
+		Mat4A result = Zero();
+		result.m[0][0] = 1.0f;
+		result.m[1][1] = 1.0f;
+		result.m[2][2] = 1.0f;
+		result.m[3][3] = 1.0f;
+		return result;
+	}
+	static Mat4A From(const Matrix4x4ex& matrix) { return std::bit_cast<Mat4A>(matrix); }
+	Matrix4x4ex ToMatrix4x4ex() const { return std::bit_cast<Matrix4x4ex>(*this); }
+
+	Float4 LoadRow(int row) const { return Float4::LoadAligned(m[row]); }
+	void StoreRow(int row, Float4 value) { value.StoreAligned(m[row]); }
+};
+
+static_assert(std::is_trivially_default_constructible_v<Vec3A> && std::is_trivially_copyable_v<Vec3A> && sizeof(Vec3A) == 16 && alignof(Vec3A) == 16);
+static_assert(std::is_trivially_default_constructible_v<Vec4A> && std::is_trivially_copyable_v<Vec4A> && sizeof(Vec4A) == 16 && alignof(Vec4A) == 16);
+static_assert(std::is_trivially_default_constructible_v<Mat4A> && std::is_trivially_copyable_v<Mat4A> && sizeof(Mat4A) == 64 && alignof(Mat4A) == 32);
+static_assert(sizeof(Matrix4x4ex) == sizeof(Mat4A) && std::is_trivially_copyable_v<Matrix4x4ex>, "Mat4Aとの間はmemcpyで変換する");
+
+/*----------配列の変換----------*/
+
+/// <summary>
+/// Vector3exの配列（12バイト間隔）をVec3Aの配列（16バイト間隔）に詰め替える（4個ずつシャッフルで並べ替える）
+/// </summary>
+void ToAligned(const Vector3ex* source, Vec3A* destination, size_t count);
+/// <summary>
+/// Vec3Aの配列をVector3exの配列に戻す
+/// </summary>
+void FromAligned(const Vec3A* source, Vector3ex* destination, size_t count);
+/// <summary>
+/// Vector4とVec4Aは並びが同じなのでまとめてコピーする
+/// </summary>
+inline void ToAligned(const Vector4* source, Vec4A* destination, size_t count) { std::memcpy(destination, source, sizeof(Vec4A) * count); }
+inline void FromAligned(const Vec4A* source, Vector4* destination, size_t count) { std::memcpy(destination, source, sizeof(Vec4A) * count); }
+/// <summary>
+/// Matrix4x4exとMat4Aは並びが同じなのでまとめてコピーする
+/// </summary>
+inline void ToAligned(const Matrix4x4ex* source, Mat4A* destination, size_t count) { std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), sizeof(Mat4A) * count); }
+inline void FromAligned(const Mat4A* source, Matrix4x4ex* destination, size_t count) { std::memcpy(static_cast<void*>(destination), static_cast<const void*>(source), sizeof(Mat4A) * count); }
+
+/// <summary>
+/// 点の配列を行列で変換する（w = 1として掛けてwで割る、アラインされたロードとストアだけを使う）
+/// </summary>
+/// <param name="points">変換する点</param>
+/// <param name="count">数</param>
+/// <param name="matrix">行列</param>
+/// <param name="results">出力先（pointsと同じでもよい）</param>
+void TransformArray(const Vec3A* points, size_t count, const Mat4A& matrix, Vec3A* results);
@@ -0,0 +1,39 @@
+#pragma once
+#include "Ball.h"
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// ボールの位置と半径を成分ごとの配列で持つ（まとめて判定する時の入力）
+/// </summary>
+struct BallSoA final
+{
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> radius;
+
+	size_t GetCount() const { return positionX.size(); }
+
+	void Clear()
+	{
+		positionX.clear();
+		positionY.clear();
+		positionZ.clear();
+		radius.clear();
+	}
+
+	/// <summary>
+	/// ボールを追加する
+	/// </summary>
+	void Add(const Vector3ex& position, float r)
+	{
+		positionX.push_back(position.x);
+		positionY.push_back(position.y);
+		positionZ.push_back(position.z);
+		radius.push_back(r);
+	}
+	void Add(const Ball& ball) { Add(ball.position, ball.radius); }
+
+	Vector3ex GetPosition(size_t i) const { return { positionX[i], positionY[i], positionZ[i] }; }
+};
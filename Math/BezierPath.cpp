@@ -0,0 +1,281 @@
+#include "BezierPath.h"
+#include "MathFunction.h"
+#include "SimdFloat.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <limits>
+
+namespace
+{
+	MathFunction Func;
+
+	constexpr size_t kLanes = Float8::kWidth;
+	constexpr uint32_t kInitialSplits = 8;		// 1本の曲線を最初に分ける数（S字の中央などで誤差を見落とさないため）
+	constexpr uint32_t kMaxDepth = 16;			// それ以上は分けない深さ（初めの区間の1/65536）
+	constexpr size_t kBucketsPerInterval = 2;	// バケットを区間より細かくして、1つのバケットにまたがる区間を減らす
+
+	// 5点のガウス・ルジャンドル求積の[0, 1]での分点と重み
+	constexpr float kGaussNodes[5] = { 0.0469100770f, 0.2307653449f, 0.5f, 0.7692346551f, 0.9530899230f };
+	constexpr float kGaussWeights[5] = { 0.1184634425f, 0.2393143352f, 0.2844444444f, 0.2393143352f, 0.1184634425f };
+
+	/// <summary>
+	/// 向きを正規化する（長さ0なら0のまま）
+	/// </summary>
+	Vector3ex NormalizeOrZero(const Vector3ex& v)
+	{
+		const float length = Func.Length(v);
+		return length > 0.0f ? v * (1.0f / length) : Vector3ex{ 0.0f, 0.0f, 0.0f };
+	}
+}
+
+void BezierPath::AddQuadratic(const Vector3ex& p0, const Vector3ex& p1, const Vector3ex& p2)
+{
+	// 2次の制御点を次数上げすると、同じ曲線を表す3次の制御点になる
+	AddCubic(p0, p0 + (p1 - p0) * (2.0f / 3.0f), p2 + (p1 - p2) * (2.0f / 3.0f), p2);
+}
+
+void BezierPath::AddCubic(const Vector3ex& p0, const Vector3ex& p1, const Vector3ex& p2, const Vector3ex& p3)
+{
+	segments_.push_back({ p0, p1, p2, p3 });
+	// ベルンシュタイン基底を展開した係数
+	polynomials_.push_back({
+		p0,
+		(p1 - p0) * 3.0f,
+		(p0 - p1 * 2.0f + p2) * 3.0f,
+		p3 - p0 + (p1 - p2) * 3.0f });
+}
+
+void BezierPath::Clear()
+{
+	segments_.clear();
+	polynomials_.clear();
+	intervals_.clear();
+	intervalStarts_.clear();
+	bucketFirst_.clear();
+	inverseBucketSize_ = 0.0f;
+	length_ = 0.0f;
+}
+
+void BezierPath::Build(float tolerance)
+{
+	intervals_.clear();
+	intervalStarts_.clear();
+	bucketFirst_.clear();
+	length_ = 0.0f;
+	for (uint32_t segment = 0; segment < segments_.size(); ++segment)
+	{
+		for (uint32_t i = 0; i < kInitialSplits; ++i)
+		{
+			Subdivide(segment, static_cast<float>(i) / kInitialSplits, static_cast<float>(i + 1) / kInitialSplits, tolerance, 0);
+		}
+	}
+	if (intervals_.empty())
+	{
+		inverseBucketSize_ = 0.0f;
+		return;
+	}
+	intervalStarts_.push_back(std::numeric_limits<float>::infinity());
+
+	// 道のりを等間隔のバケットに分け、各バケットの始まりの道のりを含む区間を覚える
+	const size_t bucketCount = intervals_.size() * kBucketsPerInterval;
+	inverseBucketSize_ = length_ > 0.0f ? static_cast<float>(bucketCount) / length_ : 0.0f;
+	bucketFirst_.resize(bucketCount);
+	size_t interval = 0;
+	for (size_t bucket = 0; bucket < bucketCount; ++bucket)
+	{
+		const float start = static_cast<float>(bucket) * length_ / static_cast<float>(bucketCount);
+		while (intervalStarts_[interval + 1] <= start)
+		{
+			++interval;
+		}
+		bucketFirst_[bucket] = static_cast<uint32_t>(interval);
+	}
+}
+
+void BezierPath::Subdivide(uint32_t segment, float t0, float t1, float tolerance, uint32_t depth)
+{
+	const Polynomial& polynomial = polynomials_[segment];
+	auto arcLength = [&](float begin, float end) {
+		float sum = 0.0f;
+		for (int i = 0; i < 5; ++i)
+		{
+			const float t = begin + (end - begin) * kGaussNodes[i];
+			const Vector3ex derivative = polynomial.b + (polynomial.c * 2.0f + polynomial.d * (3.0f * t)) * t;
+			sum += kGaussWeights[i] * Func.Length(derivative);
+		}
+		return sum * (end - begin);
+	};
+
+	const float tm = (t0 + t1) * 0.5f;
+	const float left = arcLength(t0, tm);
+	const float right = arcLength(tm, t1);
+	// 弦の中点から曲線までの距離（描く折れ線の誤差）と、tを線形補間した時の中点での道のりの誤差
+	const Vector3ex chordMiddle = (EvaluateSegment(segment, t0) + EvaluateSegment(segment, t1)) * 0.5f;
+	const bool isFlat = Func.Length(EvaluateSegment(segment, tm) - chordMiddle) <= tolerance;
+	const bool isEven = std::abs(left - right) * 0.5f <= tolerance;
+	if (depth < kMaxDepth && !(isFlat && isEven))
+	{
+		Subdivide(segment, t0, tm, tolerance, depth + 1);
+		Subdivide(segment, tm, t1, tolerance, depth + 1);
+		return;
+	}
+
+	const float length = left + right;
+	intervals_.push_back({ length > 0.0f ? 1.0f / length : 0.0f, t0, t1 - t0, segment });
+	intervalStarts_.push_back(length_);
+	length_ += length;
+}
+
+size_t BezierPath::FindInterval(float distance, float& t) const
+{
+	distance = std::clamp(distance, 0.0f, length_);
+	const size_t bucket = std::min(static_cast<size_t>(distance * inverseBucketSize_), bucketFirst_.size() - 1);
+	size_t i = bucketFirst_[bucket];
+	// バケットの番号は丸めで1つ大きくなることがある
+	while (i > 0 && intervalStarts_[i] > distance)
+	{
+		--i;
+	}
+	// 最後の無限大で止まるので、端を調べずに進める
+	while (intervalStarts_[i + 1] <= distance)
+	{
+		++i;
+	}
+	const Interval& interval = intervals_[i];
+	const float alpha = std::clamp((distance - intervalStarts_[i]) * interval.inverseLength, 0.0f, 1.0f);
+	t = interval.t0 + alpha * interval.tRange;
+	return i;
+}
+
+Vector3ex BezierPath::EvaluateSegment(size_t segment, float t) const
+{
+	// Vector3exの演算子は関数呼び出しになるので、成分ごとに書く
+	const Polynomial& p = polynomials_[segment];
+	return
+	{
+		p.a.x + (p.b.x + (p.c.x + p.d.x * t) * t) * t,
+		p.a.y + (p.b.y + (p.c.y + p.d.y * t) * t) * t,
+		p.a.z + (p.b.z + (p.c.z + p.d.z * t) * t) * t,
+	};
+}
+
+Vector3ex BezierPath::Evaluate(float distance) const
+{
+	if (intervals_.empty())
+	{
+		return { 0.0f, 0.0f, 0.0f };
+	}
+	float t = 0.0f;
+	const size_t i = FindInterval(distance, t);
+	return EvaluateSegment(intervals_[i].segment, t);
+}
+
+Vector3ex BezierPath::EvaluateTangent(float distance) const
+{
+	if (intervals_.empty())
+	{
+		return { 0.0f, 0.0f, 0.0f };
+	}
+	float t = 0.0f;
+	const Polynomial& p = polynomials_[intervals_[FindInterval(distance, t)].segment];
+	const float threeT = 3.0f * t;
+	return NormalizeOrZero({
+		p.b.x + (2.0f * p.c.x + p.d.x * threeT) * t,
+		p.b.y + (2.0f * p.c.y + p.d.y * threeT) * t,
+		p.b.z + (2.0f * p.c.z + p.d.z * threeT) * t });
+}
+
+void BezierPath::EvaluateBatch(std::span<const float> distances, std::span<Vector3ex> positions, std::span<Vector3ex> tangents) const
+{
+	const size_t count = std::min(distances.size(), positions.size());
+	const bool needsTangents = !tangents.empty();
+	assert(!needsTangents || tangents.size() >= count);
+	if (intervals_.empty())
+	{
+		std::fill_n(positions.begin(), count, Vector3ex{ 0.0f, 0.0f, 0.0f });
+		if (needsTangents)
+		{
+			std::fill_n(tangents.begin(), count, Vector3ex{ 0.0f, 0.0f, 0.0f });
+		}
+		return;
+	}
+
+	const size_t simdCount = count - count % kLanes;
+	for (size_t i = 0; i < simdCount; i += kLanes)
+	{
+		// 表を引いて各レーンの係数を集める
+		alignas(32) float t[kLanes];
+		alignas(32) float coefficients[12][kLanes];
+		for (size_t lane = 0; lane < kLanes; ++lane)
+		{
+			const Polynomial& p = polynomials_[intervals_[FindInterval(distances[i + lane], t[lane])].segment];
+			const Vector3ex* terms[4] = { &p.a, &p.b, &p.c, &p.d };
+			for (size_t term = 0; term < 4; ++term)
+			{
+				coefficients[term * 3 + 0][lane] = terms[term]->x;
+				coefficients[term * 3 + 1][lane] = terms[term]->y;
+				coefficients[term * 3 + 2][lane] = terms[term]->z;
+			}
+		}
+
+		const Float8 t8 = Float8::LoadAligned(t);
+		Float8 a[3], b[3], c[3], d[3];
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			a[axis] = Float8::LoadAligned(coefficients[axis]);
+			b[axis] = Float8::LoadAligned(coefficients[3 + axis]);
+			c[axis] = Float8::LoadAligned(coefficients[6 + axis]);
+			d[axis] = Float8::LoadAligned(coefficients[9 + axis]);
+		}
+
+		alignas(32) float out[3][kLanes];
+		for (size_t axis = 0; axis < 3; ++axis)
+		{
+			(a[axis] + (b[axis] + (c[axis] + d[axis] * t8) * t8) * t8).StoreAligned(out[axis]);
+		}
+		for (size_t lane = 0; lane < kLanes; ++lane)
+		{
+			positions[i + lane] = { out[0][lane], out[1][lane], out[2][lane] };
+		}
+
+		if (needsTangents)
+		{
+			const Float8 two = Float8::Set1(2.0f);
+			const Float8 threeT = Float8::Set1(3.0f) * t8;
+			Float8 derivative[3];
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				derivative[axis] = b[axis] + (c[axis] * two + d[axis] * threeT) * t8;
+			}
+			const Float8 lengthSquared = derivative[0] * derivative[0] + derivative[1] * derivative[1] + derivative[2] * derivative[2];
+			// 長さ0のレーンは0のままにする
+			const Float8 isZero = lengthSquared == Float8::Zero();
+			const Float8 inverseLength = Select(isZero, Float8::Zero(), Float8::Set1(1.0f) / Sqrt(lengthSquared));
+			for (size_t axis = 0; axis < 3; ++axis)
+			{
+				(derivative[axis] * inverseLength).StoreAligned(out[axis]);
+			}
+			for (size_t lane = 0; lane < kLanes; ++lane)
+			{
+				tangents[i + lane] = { out[0][lane], out[1][lane], out[2][lane] };
+			}
+		}
+	}
+
+	for (size_t i = simdCount; i < count; ++i)
+	{
+		positions[i] = Evaluate(distances[i]);
+		if (needsTangents)
+		{
+			tangents[i] = EvaluateTangent(distances[i]);
+		}
+	}
+}
+
+void BezierPath::GetIntervalEnds(size_t i, Vector3ex& start, Vector3ex& end) const
+{
+	const Interval& interval = intervals_[i];
+	start = EvaluateSegment(interval.segment, interval.t0);
+	end = EvaluateSegment(interval.segment, interval.t0 + interval.tRange);
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// 3次ベジエ曲線の制御点（2次はAddQuadraticで同じ形の3次に直して持つ）
+/// </summary>
+struct BezierSegment final
+{
+	Vector3ex p0;
+	Vector3ex p1;
+	Vector3ex p2;
+	Vector3ex p3;
+};
+
+/// <summary>
+/// ベジエ曲線をつないだ経路を、始点からの道のりで引けるようにしたもの
+/// Buildで曲線をたどって区間に分け（曲がりや速さの変化が大きい所ほど細かくする）、各区間の道のりとtの範囲を表にする
+/// 道のりから区間を探すのは等間隔のバケットから始めて数個進むだけで、tは区間内で線形補間し、曲線の評価は1回
+/// </summary>
+class BezierPath final
+{
+public:
+	/// <summary>
+	/// 2次ベジエ曲線を経路の最後に追加する
+	/// </summary>
+	void AddQuadratic(const Vector3ex& p0, const Vector3ex& p1, const Vector3ex& p2);
+	/// <summary>
+	/// 3次ベジエ曲線を経路の最後に追加する
+	/// </summary>
+	void AddCubic(const Vector3ex& p0, const Vector3ex& p1, const Vector3ex& p2, const Vector3ex& p3);
+	void Clear();
+
+	/// <summary>
+	/// 道のりの表を作る（曲線を追加したら評価の前に呼ぶ）
+	/// 区間の弦の中点と曲線の距離、線形補間したtで求まる位置の道のりの誤差の両方がtolerance以下になるまで分ける
+	/// </summary>
+	/// <param name="tolerance">許す誤差（ワールドの長さ）</param>
+	void Build(float tolerance = 1e-3f);
+
+	/// <summary>
+	/// 経路の全長
+	/// </summary>
+	float GetLength() const { return length_; }
+	size_t GetSegmentCount() const { return segments_.size(); }
+	const BezierSegment& GetSegment(size_t i) const { return segments_[i]; }
+	/// <summary>
+	/// 表の区間の数（描画する線の数でもある）
+	/// </summary>
+	size_t GetIntervalCount() const { return intervals_.size(); }
+
+	/// <summary>
+	/// 道のりの位置（0〜全長に収める）
+	/// </summary>
+	Vector3ex Evaluate(float distance) const;
+	/// <summary>
+	/// 道のりの位置での進む向き（正規化済み）
+	/// </summary>
+	Vector3ex EvaluateTangent(float distance) const;
+	/// <summary>
+	/// 曲線の番号とtで直接評価する（表を使わない）
+	/// </summary>
+	Vector3ex EvaluateSegment(size_t segment, float t) const;
+
+	/// <summary>
+	/// 多くの道のりの位置をまとめて求める（表を引いた後の曲線の評価を8個ずつまとめて行う）
+	/// </summary>
+	/// <param name="distances">道のり（0〜全長に収める）</param>
+	/// <param name="positions">位置（distancesと同じ数）</param>
+	/// <param name="tangents">進む向き（空なら求めない）</param>
+	void EvaluateBatch(std::span<const float> distances, std::span<Vector3ex> positions, std::span<Vector3ex> tangents = {}) const;
+
+	/// <summary>
+	/// 表の区間の両端の点（描画用、区間を結んだ折れ線は曲線からtolerance以内）
+	/// </summary>
+	void GetIntervalEnds(size_t i, Vector3ex& start, Vector3ex& end) const;
+
+private:
+	/// <summary>
+	/// 表の1区間（道のりがintervalStarts_[i]からintervalStarts_[i + 1]までの間、tはt0からt0 + tRangeまで）
+	/// </summary>
+	struct Interval
+	{
+		float inverseLength;
+		float t0;
+		float tRange;
+		uint32_t segment;
+	};
+
+	/// <summary>
+	/// 3次式の係数（p(t) = a + t * (b + t * (c + t * d))）
+	/// </summary>
+	struct Polynomial
+	{
+		Vector3ex a;
+		Vector3ex b;
+		Vector3ex c;
+		Vector3ex d;
+	};
+
+	/// <summary>
+	/// 道のりを含む区間の番号とtを求める
+	/// </summary>
+	size_t FindInterval(float distance, float& t) const;
+	/// <summary>
+	/// [t0, t1]を誤差がtolerance以下になるまで分けながら表に追加する
+	/// </summary>
+	void Subdivide(uint32_t segment, float t0, float t1, float tolerance, uint32_t depth);
+
+	std::vector<BezierSegment> segments_;
+	std::vector<Polynomial> polynomials_;
+	std::vector<Interval> intervals_;
+	std::vector<float> intervalStarts_;	// 各区間の始まりの道のり（最後に無限大を1つ置き、探す時に端を調べなくて済むようにする）
+	std::vector<uint32_t> bucketFirst_;	// 道のりを等間隔に分けた各バケットの始まりを含む区間の番号
+	float inverseBucketSize_ = 0.0f;
+	float length_ = 0.0f;
+};
@@ -0,0 +1,28 @@
+#pragma once
+#include "Segment.h"
+#include "Vector3ex.h"
+#include <cmath>
+
+//カプセル（線分から半径以内の点の集まり）
+struct Capsule final
+{
+	Segment segment;	//!< 中心の線分
+	float radius;		//!< 半径
+
+	/// <summary>
+	/// サポート写像（direction方向に最も遠い表面上の点）
+	/// </summary>
+	/// <param name="direction">方向（正規化は不要）</param>
+	/// <returns></returns>
+	Vector3ex Support(const Vector3ex& direction) const
+	{
+		const float along = segment.diff.x * direction.x + segment.diff.y * direction.y + segment.diff.z * direction.z;
+		const Vector3ex end = along > 0.0f ? segment.origin + segment.diff : segment.origin;
+		const float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+		if (length == 0.0f)
+		{
+			return end;
+		}
+		return end + direction * (radius / length);
+	}
+};
@@ -0,0 +1,461 @@
+#include "ClothSolver.h"
+#include "Profiler.h"
+#include "SimdFloat.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace
+{
+	constexpr size_t kLanes = Float8::kWidth;
+	constexpr uint32_t kMaxParallelColors = 64;		// 粒子ごとの使用済みの色を64ビットで覚える
+	constexpr size_t kConstraintBatch = 1024;		// 1スレッドに渡す拘束の最小数
+	constexpr size_t kBlockBatch = 256;				// 1スレッドに渡す粒子のブロック（8個）の最小数
+
+	/// <summary>
+	/// 粒子8個分の配列の先頭
+	/// </summary>
+	struct ParticleLanes
+	{
+		float* positionX;
+		float* positionY;
+		float* positionZ;
+		float* previousX;
+		float* previousY;
+		float* previousZ;
+		float* inverseMass;
+	};
+
+	/// <summary>
+	/// 粒子を8個ずつkernelに渡す（端数は固定された粒子で埋めた一時領域で処理して書き戻す）
+	/// </summary>
+	template<class Kernel>
+	void ForEachBlock(ParticleSoA& particles, size_t beginBlock, size_t endBlock, Kernel&& kernel)
+	{
+		const size_t count = particles.GetCount();
+		for (size_t block = beginBlock; block < endBlock; ++block)
+		{
+			const size_t i = block * kLanes;
+			if (i + kLanes <= count)
+			{
+				kernel(ParticleLanes{ &particles.positionX[i], &particles.positionY[i], &particles.positionZ[i],
+					&particles.previousX[i], &particles.previousY[i], &particles.previousZ[i], &particles.inverseMass[i] });
+				continue;
+			}
+
+			float buffer[7][kLanes] = {};
+			std::vector<float>* arrays[7] = { &particles.positionX, &particles.positionY, &particles.positionZ,
+				&particles.previousX, &particles.previousY, &particles.previousZ, &particles.inverseMass };
+			const size_t valid = count - i;
+			for (size_t array = 0; array < 7; ++array)
+			{
+				std::copy_n(arrays[array]->data() + i, valid, buffer[array]);
+			}
+			kernel(ParticleLanes{ buffer[0], buffer[1], buffer[2], buffer[3], buffer[4], buffer[5], buffer[6] });
+			for (size_t array = 0; array < 6; ++array)
+			{
+				std::copy_n(buffer[array], valid, arrays[array]->data() + i);
+			}
+		}
+	}
+
+	/// <summary>
+	/// スレッドがあれば分け合って、なければ呼び出し元だけで実行する
+	/// </summary>
+	template<class Body>
+	void Dispatch(ThreadPool* pool, size_t count, size_t minBatch, Body&& body)
+	{
+		if (pool != nullptr)
+		{
+			pool->ParallelFor(count, minBatch, body);
+		}
+		else if (count > 0)
+		{
+			body(size_t(0), count);
+		}
+	}
+}
+
+uint32_t ClothSolver::AddParticle(const Vector3ex& position, float inverseMass)
+{
+	return particles_.Add(position, inverseMass);
+}
+
+void ClothSolver::SetParticle(uint32_t index, const Vector3ex& position)
+{
+	particles_.SetPosition(index, position);
+	particles_.previousX[index] = position.x;
+	particles_.previousY[index] = position.y;
+	particles_.previousZ[index] = position.z;
+}
+
+void ClothSolver::AddConstraint(uint32_t a, uint32_t b, float stiffness)
+{
+	const float dx = particles_.positionX[b] - particles_.positionX[a];
+	const float dy = particles_.positionY[b] - particles_.positionY[a];
+	const float dz = particles_.positionZ[b] - particles_.positionZ[a];
+	DistanceConstraint constraint;
+	constraint.a = a;
+	constraint.b = b;
+	constraint.restLength = std::sqrt(dx * dx + dy * dy + dz * dz);
+	constraint.stiffness = std::clamp(stiffness, 0.0f, 1.0f);
+	constraints_.push_back(constraint);
+	constraintsDirty_ = true;
+}
+
+void ClothSolver::AddDistanceConstraint(uint32_t a, uint32_t b, float stiffness)
+{
+	AddConstraint(a, b, stiffness);
+	edgeIndices_.push_back(a);
+	edgeIndices_.push_back(b);
+}
+
+void ClothSolver::AddBendingConstraint(uint32_t a, uint32_t b, float stiffness)
+{
+	AddConstraint(a, b, stiffness);
+}
+
+void ClothSolver::AddShearConstraint(uint32_t a, uint32_t b, float stiffness)
+{
+	AddConstraint(a, b, stiffness);
+}
+
+uint32_t ClothSolver::AddRope(const Vector3ex& start, const Vector3ex& end, uint32_t segmentCount, float particleMass)
+{
+	segmentCount = std::max(segmentCount, 1u);
+	const float inverseMass = particleMass > 0.0f ? 1.0f / particleMass : 0.0f;
+	const uint32_t first = static_cast<uint32_t>(particles_.GetCount());
+	for (uint32_t i = 0; i <= segmentCount; ++i)
+	{
+		const float t = static_cast<float>(i) / static_cast<float>(segmentCount);
+		AddParticle(start + (end - start) * t, inverseMass);
+	}
+	for (uint32_t i = 0; i < segmentCount; ++i)
+	{
+		AddDistanceConstraint(first + i, first + i + 1);
+	}
+	for (uint32_t i = 0; i + 1 < segmentCount; ++i)
+	{
+		AddBendingConstraint(first + i, first + i + 2);
+	}
+	return first;
+}
+
+uint32_t ClothSolver::AddCloth(const Vector3ex& origin, const Vector3ex& axisU, const Vector3ex& axisV, uint32_t countU, uint32_t countV, float particleMass)
+{
+	countU = std::max(countU, 2u);
+	countV = std::max(countV, 2u);
+	const float inverseMass = particleMass > 0.0f ? 1.0f / particleMass : 0.0f;
+	const uint32_t first = static_cast<uint32_t>(particles_.GetCount());
+	for (uint32_t v = 0; v < countV; ++v)
+	{
+		for (uint32_t u = 0; u < countU; ++u)
+		{
+			const float s = static_cast<float>(u) / static_cast<float>(countU - 1);
+			const float t = static_cast<float>(v) / static_cast<float>(countV - 1);
+			AddParticle(origin + axisU * s + axisV * t, inverseMass);
+		}
+	}
+
+	auto index = [&](uint32_t u, uint32_t v) { return first + u + v * countU; };
+	for (uint32_t v = 0; v < countV; ++v)
+	{
+		for (uint32_t u = 0; u < countU; ++u)
+		{
+			if (u + 1 < countU)
+			{
+				AddDistanceConstraint(index(u, v), index(u + 1, v));
+			}
+			if (v + 1 < countV)
+			{
+				AddDistanceConstraint(index(u, v), index(u, v + 1));
+			}
+			if (u + 1 < countU && v + 1 < countV)
+			{
+				AddShearConstraint(index(u, v), index(u + 1, v + 1));
+				AddShearConstraint(index(u + 1, v), index(u, v + 1));
+			}
+			if (u + 2 < countU)
+			{
+				AddBendingConstraint(index(u, v), index(u + 2, v));
+			}
+			if (v + 2 < countV)
+			{
+				AddBendingConstraint(index(u, v), index(u, v + 2));
+			}
+		}
+	}
+	return first;
+}
+
+uint32_t ClothSolver::AddPlane(const Plane& plane)
+{
+	planes_.push_back(plane);
+	return static_cast<uint32_t>(planes_.size() - 1);
+}
+
+uint32_t ClothSolver::AddSphere(const Sphere& sphere)
+{
+	spheres_.push_back(sphere);
+	return static_cast<uint32_t>(spheres_.size() - 1);
+}
+
+uint32_t ClothSolver::AddAABB(const AABB& aabb)
+{
+	aabbs_.push_back(aabb);
+	return static_cast<uint32_t>(aabbs_.size() - 1);
+}
+
+void ClothSolver::ClearColliders()
+{
+	planes_.clear();
+	spheres_.clear();
+	aabbs_.clear();
+}
+
+void ClothSolver::ColorConstraints()
+{
+	// 貪欲法で、両端の粒子がまだ使っていない一番小さい色を割り当てる
+	// 64色で足りなければ最後の色にまとめ、その色だけは並列にせず解く
+	std::vector<uint64_t> usedColors(particles_.GetCount(), 0);
+	std::vector<uint32_t> colors(constraints_.size());
+	uint32_t colorCount = 0;
+	bool hasSerial = false;
+	for (size_t i = 0; i < constraints_.size(); ++i)
+	{
+		const DistanceConstraint& constraint = constraints_[i];
+		const uint64_t used = usedColors[constraint.a] | usedColors[constraint.b];
+		uint32_t color = kMaxParallelColors;
+		if (used != ~uint64_t(0))
+		{
+			color = static_cast<uint32_t>(std::countr_one(used));
+			usedColors[constraint.a] |= uint64_t(1) << color;
+			usedColors[constraint.b] |= uint64_t(1) << color;
+			colorCount = std::max(colorCount, color + 1);
+		}
+		else
+		{
+			hasSerial = true;
+		}
+		colors[i] = color;
+	}
+	serialColor_ = UINT32_MAX;
+	if (hasSerial)
+	{
+		serialColor_ = colorCount;
+		for (uint32_t& color : colors)
+		{
+			color = std::min(color, serialColor_);
+		}
+		++colorCount;
+	}
+
+	// 色ごとに数えて並べる（同じ色の中は追加した順）
+	colorOffsets_.assign(static_cast<size_t>(colorCount) + 1, 0);
+	for (uint32_t color : colors)
+	{
+		++colorOffsets_[color + 1];
+	}
+	for (uint32_t color = 0; color < colorCount; ++color)
+	{
+		colorOffsets_[color + 1] += colorOffsets_[color];
+	}
+
+	// 反復n回でstiffnessだけ誤差が縮むように、1回あたりの硬さを1 - (1 - k)^(1/n)にする
+	const uint32_t iterations = std::max(settings.iterations, 1u);
+	const float exponent = 1.0f / static_cast<float>(iterations);
+	coloredConstraints_.resize(constraints_.size());
+	std::vector<uint32_t> cursor(colorOffsets_.begin(), colorOffsets_.end() - 1);
+	for (size_t i = 0; i < constraints_.size(); ++i)
+	{
+		DistanceConstraint constraint = constraints_[i];
+		constraint.stiffness = 1.0f - std::pow(1.0f - constraint.stiffness, exponent);
+		coloredConstraints_[cursor[colors[i]]++] = constraint;
+	}
+
+	coloredIterations_ = iterations;
+	constraintsDirty_ = false;
+}
+
+void ClothSolver::Step(float deltaTime)
+{
+	PROFILE_SCOPE("ClothStep");
+	if (particles_.GetCount() == 0 || deltaTime <= 0.0f)
+	{
+		return;
+	}
+	if (constraintsDirty_ || coloredIterations_ != std::max(settings.iterations, 1u))
+	{
+		ColorConstraints();
+	}
+
+	Predict(deltaTime);
+	const uint32_t colorCount = GetColorCount();
+	for (uint32_t iteration = 0; iteration < coloredIterations_; ++iteration)
+	{
+		for (uint32_t color = 0; color < colorCount; ++color)
+		{
+			SolveColor(color);
+		}
+		SolveCollisions();
+	}
+}
+
+void ClothSolver::Predict(float deltaTime)
+{
+	// 位置の差が前のステップ幅の速度なので、ステップ幅が変わったら比で直す
+	const float timeScale = previousDeltaTime_ > 0.0f ? deltaTime / previousDeltaTime_ : 1.0f;
+	previousDeltaTime_ = deltaTime;
+	const Float8 velocityScale = Float8::Set1((1.0f - settings.damping) * timeScale);
+	const float squaredTime = deltaTime * deltaTime;
+	const Float8 gravityX = Float8::Set1(settings.gravity.x * squaredTime);
+	const Float8 gravityY = Float8::Set1(settings.gravity.y * squaredTime);
+	const Float8 gravityZ = Float8::Set1(settings.gravity.z * squaredTime);
+
+	auto kernel = [&](const ParticleLanes& lanes) {
+		const Float8 movable = Float8::Load(lanes.inverseMass) > Float8::Zero();
+		auto advance = [&](float* position, float* previous, Float8 gravity) {
+			const Float8 current = Float8::Load(position);
+			const Float8 next = current + (current - Float8::Load(previous)) * velocityScale + gravity;
+			current.Store(previous);
+			Select(movable, next, current).Store(position);
+		};
+		advance(lanes.positionX, lanes.previousX, gravityX);
+		advance(lanes.positionY, lanes.previousY, gravityY);
+		advance(lanes.positionZ, lanes.previousZ, gravityZ);
+	};
+	const size_t blockCount = (particles_.GetCount() + kLanes - 1) / kLanes;
+	Dispatch(pool_, blockCount, kBlockBatch, [&](size_t begin, size_t end) { ForEachBlock(particles_, begin, end, kernel); });
+}
+
+void ClothSolver::SolveColor(uint32_t color)
+{
+	const DistanceConstraint* constraints = coloredConstraints_.data() + colorOffsets_[color];
+	const size_t count = colorOffsets_[color + 1] - colorOffsets_[color];
+	float* positionX = particles_.positionX.data();
+	float* positionY = particles_.positionY.data();
+	float* positionZ = particles_.positionZ.data();
+	const float* inverseMass = particles_.inverseMass.data();
+
+	// 同じ色の拘束は粒子を共有しないので、区間ごとに別のスレッドが書いても重ならない
+	auto solve = [=](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; ++i)
+		{
+			const DistanceConstraint& constraint = constraints[i];
+			const uint32_t a = constraint.a;
+			const uint32_t b = constraint.b;
+			const float weightSum = inverseMass[a] + inverseMass[b];
+			if (weightSum == 0.0f)
+			{
+				continue;
+			}
+			const float dx = positionX[b] - positionX[a];
+			const float dy = positionY[b] - positionY[a];
+			const float dz = positionZ[b] - positionZ[a];
+			const float length = std::sqrt(dx * dx + dy * dy + dz * dz);
+			if (length < 1e-7f)
+			{
+				continue;
+			}
+			// 誤差を質量の逆数の比で両端に配る
+			const float scale = constraint.stiffness * (length - constraint.restLength) / (length * weightSum);
+			const float scaleA = scale * inverseMass[a];
+			const float scaleB = scale * inverseMass[b];
+			positionX[a] += dx * scaleA;
+			positionY[a] += dy * scaleA;
+			positionZ[a] += dz * scaleA;
+			positionX[b] -= dx * scaleB;
+			positionY[b] -= dy * scaleB;
+			positionZ[b] -= dz * scaleB;
+		}
+	};
+
+	if (color == serialColor_)
+	{
+		solve(0, count);
+		return;
+	}
+	Dispatch(pool_, count, kConstraintBatch, solve);
+}
+
+void ClothSolver::SolveCollisions()
+{
+	if (planes_.empty() && spheres_.empty() && aabbs_.empty())
+	{
+		return;
+	}
+	const float radius = settings.particleRadius;
+	const Float8 zero = Float8::Zero();
+
+	auto kernel = [&](const ParticleLanes& lanes) {
+		const Float8 movable = Float8::Load(lanes.inverseMass) > zero;
+		Float8 x = Float8::Load(lanes.positionX);
+		Float8 y = Float8::Load(lanes.positionY);
+		Float8 z = Float8::Load(lanes.positionZ);
+		const Float8 startX = x;
+		const Float8 startY = y;
+		const Float8 startZ = z;
+
+		// 平面: 裏側に入った分だけ法線方向に戻す
+		for (const Plane& plane : planes_)
+		{
+			const Float8 normalX = Float8::Set1(plane.normal.x);
+			const Float8 normalY = Float8::Set1(plane.normal.y);
+			const Float8 normalZ = Float8::Set1(plane.normal.z);
+			const Float8 depth = Min(x * normalX + y * normalY + z * normalZ - Float8::Set1(plane.distance + radius), zero);
+			x = x - normalX * depth;
+			y = y - normalY * depth;
+			z = z - normalZ * depth;
+		}
+
+		// 球: 中心から外へ表面まで押し出す
+		for (const Sphere& sphere : spheres_)
+		{
+			const Float8 dx = x - Float8::Set1(sphere.center.x);
+			const Float8 dy = y - Float8::Set1(sphere.center.y);
+			const Float8 dz = z - Float8::Set1(sphere.center.z);
+			const Float8 length = Sqrt(dx * dx + dy * dy + dz * dz);
+			const Float8 penetration = Float8::Set1(sphere.radius + radius) - length;
+			const Float8 hit = (penetration > zero) & (length > Float8::Set1(1e-7f));
+			const Float8 scale = Select(hit, penetration / Max(length, Float8::Set1(1e-7f)), zero);
+			x = x + dx * scale;
+			y = y + dy * scale;
+			z = z + dz * scale;
+		}
+
+		// AABB: 中に入った粒子を一番近い面から外へ出す
+		for (const AABB& aabb : aabbs_)
+		{
+			const Float8 toMinX = x - Float8::Set1(aabb.min.x - radius);
+			const Float8 toMaxX = Float8::Set1(aabb.max.x + radius) - x;
+			const Float8 toMinY = y - Float8::Set1(aabb.min.y - radius);
+			const Float8 toMaxY = Float8::Set1(aabb.max.y + radius) - y;
+			const Float8 toMinZ = z - Float8::Set1(aabb.min.z - radius);
+			const Float8 toMaxZ = Float8::Set1(aabb.max.z + radius) - z;
+			const Float8 inside = (Min(Min(toMinX, toMaxX), Min(Min(toMinY, toMaxY), Min(toMinZ, toMaxZ)))) > zero;
+			if (inside.MoveMask() == 0)
+			{
+				continue;
+			}
+			const Float8 pushX = Select(toMinX < toMaxX, -toMinX, toMaxX);
+			const Float8 pushY = Select(toMinY < toMaxY, -toMinY, toMaxY);
+			const Float8 pushZ = Select(toMinZ < toMaxZ, -toMinZ, toMaxZ);
+			const Float8 distanceX = Min(toMinX, toMaxX);
+			const Float8 distanceY = Min(toMinY, toMaxY);
+			const Float8 distanceZ = Min(toMinZ, toMaxZ);
+			const Float8 useX = inside & (distanceX <= distanceY) & (distanceX <= distanceZ);
+			const Float8 useY = inside & (distanceY < distanceX) & (distanceY <= distanceZ);
+			const Float8 useZ = inside & (distanceZ < distanceX) & (distanceZ < distanceY);
+			x = x + Select(useX, pushX, zero);
+			y = y + Select(useY, pushY, zero);
+			z = z + Select(useZ, pushZ, zero);
+		}
+
+		Select(movable, x, startX).Store(lanes.positionX);
+		Select(movable, y, startY).Store(lanes.positionY);
+		Select(movable, z, startZ).Store(lanes.positionZ);
+	};
+	const size_t blockCount = (particles_.GetCount() + kLanes - 1) / kLanes;
+	Dispatch(pool_, blockCount, kBlockBatch, [&](size_t begin, size_t end) { ForEachBlock(particles_, begin, end, kernel); });
+}
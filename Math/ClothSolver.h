@@ -0,0 +1,169 @@
+#pragma once
+#include "AABB.h"
+#include "ParticleSoA.h"
+#include "Plane.h"
+#include "Sphereh.h"
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+/// <summary>
+/// 2つの粒子の距離を保つ拘束
+/// </summary>
+struct DistanceConstraint final
+{
+	uint32_t a = 0;				// 粒子の番号
+	uint32_t b = 0;				// 粒子の番号
+	float restLength = 0.0f;	// 保つ距離
+	float stiffness = 1.0f;		// 1ステップで誤差を解消する割合（0〜1、反復回数によらない）
+};
+
+/// <summary>
+/// 布とロープのシミュレーションの設定
+/// </summary>
+struct ClothSettings final
+{
+	Vector3ex gravity = { 0.0f, -9.8f, 0.0f };	// 重力加速度
+	uint32_t iterations = 8;					// 拘束を解く反復回数
+	float damping = 0.01f;						// 1ステップで失う速度の割合
+	float particleRadius = 0.01f;				// 衝突判定に使う粒子の半径
+};
+
+/// <summary>
+/// 位置ベースの布とロープのシミュレーション（粒子はベルレ積分、距離と曲げの拘束を反復で解く）
+/// 拘束は同じ粒子を共有しないもの同士を同じ色にまとめ、色ごとに並列で解く（書き込みが重ならないのでアトミック不要）
+/// 衝突は平面、球、AABBに対して粒子8個ずつまとめて押し出す
+/// </summary>
+class ClothSolver final
+{
+public:
+	/// <summary>
+	/// 粒子を追加する
+	/// </summary>
+	/// <param name="position">位置</param>
+	/// <param name="inverseMass">質量の逆数（0なら固定）</param>
+	/// <returns>粒子の番号</returns>
+	uint32_t AddParticle(const Vector3ex& position, float inverseMass);
+	/// <summary>
+	/// 粒子の質量の逆数を変える（0にすると固定される）
+	/// </summary>
+	void SetInverseMass(uint32_t index, float inverseMass) { particles_.inverseMass[index] = inverseMass; }
+	/// <summary>
+	/// 粒子を動かす（速度は0になる）
+	/// </summary>
+	void SetParticle(uint32_t index, const Vector3ex& position);
+
+	/// <summary>
+	/// 距離の拘束を追加する（今の距離を保つ、描画する辺にもなる）
+	/// </summary>
+	void AddDistanceConstraint(uint32_t a, uint32_t b, float stiffness = 1.0f);
+	/// <summary>
+	/// 曲げの拘束を追加する（1つ飛ばしの粒子の距離を弱く保ち、折れ曲がりにくくする、描画はしない）
+	/// </summary>
+	void AddBendingConstraint(uint32_t a, uint32_t b, float stiffness = 0.1f);
+	/// <summary>
+	/// 斜めの拘束を追加する（布のせん断を防ぐ、描画はしない）
+	/// </summary>
+	void AddShearConstraint(uint32_t a, uint32_t b, float stiffness = 1.0f);
+
+	/// <summary>
+	/// ロープを追加する（端から端まで等間隔に粒子を並べ、隣同士を距離で、1つ飛ばしを曲げでつなぐ）
+	/// </summary>
+	/// <param name="start">始点</param>
+	/// <param name="end">終点</param>
+	/// <param name="segmentCount">区間の数（粒子はsegmentCount + 1個）</param>
+	/// <param name="particleMass">粒子1個の質量</param>
+	/// <returns>始点の粒子の番号（以降の粒子は連番）</returns>
+	uint32_t AddRope(const Vector3ex& start, const Vector3ex& end, uint32_t segmentCount, float particleMass);
+	/// <summary>
+	/// 布を追加する（origin + axisU * u + axisV * vの格子に粒子を並べ、縦横と斜めを距離で、1つ飛ばしを曲げでつなぐ）
+	/// </summary>
+	/// <param name="origin">格子の角</param>
+	/// <param name="axisU">u方向の辺</param>
+	/// <param name="axisV">v方向の辺</param>
+	/// <param name="countU">u方向の粒子の数</param>
+	/// <param name="countV">v方向の粒子の数</param>
+	/// <param name="particleMass">粒子1個の質量</param>
+	/// <returns>角の粒子の番号（u + v * countUを足すと各粒子の番号になる）</returns>
+	uint32_t AddCloth(const Vector3ex& origin, const Vector3ex& axisU, const Vector3ex& axisV, uint32_t countU, uint32_t countV, float particleMass);
+
+	/// <summary>
+	/// 衝突する形を追加する（番号を返すので、動く形はSet〜で更新する）
+	/// </summary>
+	uint32_t AddPlane(const Plane& plane);
+	uint32_t AddSphere(const Sphere& sphere);
+	uint32_t AddAABB(const AABB& aabb);
+	void SetPlane(uint32_t index, const Plane& plane) { planes_[index] = plane; }
+	void SetSphere(uint32_t index, const Sphere& sphere) { spheres_[index] = sphere; }
+	void SetAABB(uint32_t index, const AABB& aabb) { aabbs_[index] = aabb; }
+	/// <summary>
+	/// 衝突する形を全て外す
+	/// </summary>
+	void ClearColliders();
+
+	/// <summary>
+	/// 並列に解く時に使うスレッドを設定する（nullptrで呼び出し元だけで解く、所有はしないので呼び出し側で保持すること）
+	/// </summary>
+	void SetThreadPool(ThreadPool* pool) { pool_ = pool; }
+
+	/// <summary>
+	/// 1ステップ進める
+	/// </summary>
+	/// <param name="deltaTime">時間</param>
+	void Step(float deltaTime);
+
+	const ParticleSoA& GetParticles() const { return particles_; }
+	size_t GetParticleCount() const { return particles_.GetCount(); }
+	size_t GetConstraintCount() const { return constraints_.size(); }
+	/// <summary>
+	/// 描画する辺の粒子の番号（2つで1本）
+	/// </summary>
+	const std::vector<uint32_t>& GetEdgeIndices() const { return edgeIndices_; }
+	/// <summary>
+	/// 拘束の色の数（直前のStepで塗り分けた結果）
+	/// </summary>
+	uint32_t GetColorCount() const { return colorOffsets_.empty() ? 0 : static_cast<uint32_t>(colorOffsets_.size() - 1); }
+
+	ClothSettings settings;
+
+private:
+	/// <summary>
+	/// 今の距離を保つ拘束を追加する
+	/// </summary>
+	void AddConstraint(uint32_t a, uint32_t b, float stiffness);
+	/// <summary>
+	/// 拘束を色ごとに並べ替え、反復1回あたりの硬さを求める
+	/// </summary>
+	void ColorConstraints();
+	/// <summary>
+	/// 重力と慣性で位置を進める
+	/// </summary>
+	void Predict(float deltaTime);
+	/// <summary>
+	/// 1色分の拘束を解く
+	/// </summary>
+	void SolveColor(uint32_t color);
+	/// <summary>
+	/// 衝突する形から粒子を押し出す
+	/// </summary>
+	void SolveCollisions();
+
+	ParticleSoA particles_;
+	std::vector<DistanceConstraint> constraints_;		// 追加した順
+	std::vector<DistanceConstraint> coloredConstraints_;	// 色ごとに並べ、硬さを反復1回あたりに直したもの
+	std::vector<uint32_t> colorOffsets_;				// 色ごとの先頭（最後は拘束の数）
+	uint32_t coloredIterations_ = 0;					// 硬さを直した時の反復回数
+	uint32_t serialColor_ = UINT32_MAX;					// 塗り分けきれなかった拘束の色（これだけは並列にしない）
+	bool constraintsDirty_ = true;
+	std::vector<uint32_t> edgeIndices_;
+
+	std::vector<Plane> planes_;
+	std::vector<Sphere> spheres_;
+	std::vector<AABB> aabbs_;
+
+	ThreadPool* pool_ = nullptr;
+	float previousDeltaTime_ = 0.0f;
+};
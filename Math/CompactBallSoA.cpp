@@ -0,0 +1,303 @@
+#include "CompactBallSoA.h"
+#include "SimdFloat.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <type_traits>
+
+namespace
+{
+	constexpr size_t kLanes = Float8::kWidth;
+	constexpr float kMaxFixed = 65535.0f;	// 16ビット固定小数点の最大値
+
+	/// <summary>
+	/// ボール8個分の作業用の値
+	/// </summary>
+	struct BallLanes
+	{
+		Float8 positionX;
+		Float8 positionY;
+		Float8 positionZ;
+		Float8 velocityX;
+		Float8 velocityY;
+		Float8 velocityZ;
+		Float8 radius;
+	};
+
+	/// <summary>
+	/// 8個のボールを重力で進めて平面に当てる（CompactBallSoAとBallStateSoAで同じ計算にするため共通にする）
+	/// </summary>
+	void StepLanes(BallLanes& lanes, float deltaTime, std::span<const Plane> planes, const BallStepSettings& settings)
+	{
+		const Float8 dt = Float8::Set1(deltaTime);
+		lanes.velocityX = lanes.velocityX + Float8::Set1(settings.gravity.x * deltaTime);
+		lanes.velocityY = lanes.velocityY + Float8::Set1(settings.gravity.y * deltaTime);
+		lanes.velocityZ = lanes.velocityZ + Float8::Set1(settings.gravity.z * deltaTime);
+		lanes.positionX = lanes.positionX + lanes.velocityX * dt;
+		lanes.positionY = lanes.positionY + lanes.velocityY * dt;
+		lanes.positionZ = lanes.positionZ + lanes.velocityZ * dt;
+
+		const Float8 zero = Float8::Zero();
+		const Float8 restitution = Float8::Set1(settings.restitution);
+		const Float8 negativeRestingSpeed = Float8::Set1(-settings.restingSpeed);
+		for (const Plane& plane : planes)
+		{
+			const Float8 nx = Float8::Set1(plane.normal.x);
+			const Float8 ny = Float8::Set1(plane.normal.y);
+			const Float8 nz = Float8::Set1(plane.normal.z);
+			const Float8 distanceToPlane = nx * lanes.positionX + ny * lanes.positionY + nz * lanes.positionZ - Float8::Set1(plane.distance);
+			const Float8 hit = distanceToPlane < lanes.radius;
+			if (hit.MoveMask() == 0)
+			{
+				continue;
+			}
+
+			// 衝突面の外へ押し出す
+			const Float8 depth = (lanes.radius - distanceToPlane) & hit;
+			lanes.positionX = lanes.positionX + nx * depth;
+			lanes.positionY = lanes.positionY + ny * depth;
+			lanes.positionZ = lanes.positionZ + nz * depth;
+
+			// 面に向かっている時だけ、ゆっくりなら法線方向の速度を消し、速ければ反射して反発係数を掛ける
+			const Float8 normalSpeed = lanes.velocityX * nx + lanes.velocityY * ny + lanes.velocityZ * nz;
+			const Float8 approaching = hit & (normalSpeed < zero);
+			const Float8 resting = normalSpeed > negativeRestingSpeed;
+			const Float8 twice = normalSpeed + normalSpeed;
+			auto resolve = [&](Float8 velocity, Float8 n) {
+				const Float8 stopped = velocity - n * normalSpeed;
+				const Float8 reflected = (velocity - n * twice) * restitution;
+				return Select(approaching, Select(resting, stopped, reflected), velocity);
+			};
+			lanes.velocityX = resolve(lanes.velocityX, nx);
+			lanes.velocityY = resolve(lanes.velocityY, ny);
+			lanes.velocityZ = resolve(lanes.velocityZ, nz);
+		}
+	}
+
+	/// <summary>
+	/// 16ビット固定小数点の位置を1つ詰める（範囲外は端に寄せる）
+	/// </summary>
+	uint16_t EncodePosition(float value, float min, float inverseStep)
+	{
+		const float fixed = std::clamp((value - min) * inverseStep, 0.0f, kMaxFixed);
+		return static_cast<uint16_t>(std::lround(fixed));
+	}
+
+	// 速度の持ち方（半精度かfloat）に合わせて読み書きする（型で選ぶので、使わない方の変換はビルドされない）
+	template<class T>
+	Float8 LoadVelocity(const T* p)
+	{
+		if constexpr (std::is_same_v<T, uint16_t>)
+		{
+			return LoadHalf(p);
+		}
+		else
+		{
+			return Float8::Load(p);
+		}
+	}
+
+	template<class T>
+	void StoreVelocity(Float8 value, T* p)
+	{
+		if constexpr (std::is_same_v<T, uint16_t>)
+		{
+			StoreHalf(value, p);
+		}
+		else
+		{
+			value.Store(p);
+		}
+	}
+
+	template<class T>
+	T EncodeVelocity(float value)
+	{
+		if constexpr (std::is_same_v<T, uint16_t>)
+		{
+			return FloatToHalf(value);
+		}
+		else
+		{
+			return value;
+		}
+	}
+
+	template<class T>
+	float DecodeVelocity(T value)
+	{
+		if constexpr (std::is_same_v<T, uint16_t>)
+		{
+			return HalfToFloat(value);
+		}
+		else
+		{
+			return value;
+		}
+	}
+}
+
+void BallStateSoA::Step(float deltaTime, std::span<const Plane> planes, const BallStepSettings& settings)
+{
+	const size_t count = GetCount();
+	std::vector<float>* arrays[7] = { &positionX, &positionY, &positionZ, &velocityX, &velocityY, &velocityZ, &radius };
+	for (size_t i = 0; i < count; i += kLanes)
+	{
+		// 端数は一時領域に写して同じ計算をする
+		float buffer[7][kLanes] = {};
+		const bool isTail = i + kLanes > count;
+		const size_t valid = isTail ? count - i : kLanes;
+		float* lanePointers[7];
+		for (size_t array = 0; array < 7; ++array)
+		{
+			lanePointers[array] = isTail ? buffer[array] : arrays[array]->data() + i;
+			if (isTail)
+			{
+				std::copy_n(arrays[array]->data() + i, valid, buffer[array]);
+			}
+		}
+
+		BallLanes lanes = {
+			Float8::Load(lanePointers[0]), Float8::Load(lanePointers[1]), Float8::Load(lanePointers[2]),
+			Float8::Load(lanePointers[3]), Float8::Load(lanePointers[4]), Float8::Load(lanePointers[5]),
+			Float8::Load(lanePointers[6]) };
+		StepLanes(lanes, deltaTime, planes, settings);
+		lanes.positionX.Store(lanePointers[0]);
+		lanes.positionY.Store(lanePointers[1]);
+		lanes.positionZ.Store(lanePointers[2]);
+		lanes.velocityX.Store(lanePointers[3]);
+		lanes.velocityY.Store(lanePointers[4]);
+		lanes.velocityZ.Store(lanePointers[5]);
+
+		if (isTail)
+		{
+			for (size_t array = 0; array < 6; ++array)
+			{
+				std::copy_n(buffer[array], valid, arrays[array]->data() + i);
+			}
+		}
+	}
+}
+
+CompactBallSoA::CompactBallSoA(const AABB& bounds)
+	: bounds_(bounds)
+{
+	const Vector3ex extent = bounds.max - bounds.min;
+	assert(extent.x > 0.0f && extent.y > 0.0f && extent.z > 0.0f);
+	positionStep_ = { extent.x / kMaxFixed, extent.y / kMaxFixed, extent.z / kMaxFixed };
+	inversePositionStep_ = { kMaxFixed / extent.x, kMaxFixed / extent.y, kMaxFixed / extent.z };
+}
+
+uint8_t CompactBallSoA::AddPalette(const BallPaletteEntry& entry)
+{
+	assert(paletteCount_ < kMaxPaletteCount);
+	palette_[paletteCount_] = entry;
+	paletteRadius_[paletteCount_] = entry.radius;
+	return static_cast<uint8_t>(paletteCount_++);
+}
+
+uint32_t CompactBallSoA::Add(const Vector3ex& position, const Vector3ex& velocity, uint8_t paletteIndex)
+{
+	assert(paletteIndex < paletteCount_);
+	if (count_ == positionX_.size())
+	{
+		// 8個分まとめて伸ばし、使っていない分は0のままにする
+		const size_t size = count_ + kLanes;
+		for (std::vector<uint16_t>* array : { &positionX_, &positionY_, &positionZ_ })
+		{
+			array->resize(size, uint16_t(0));
+		}
+		for (std::vector<VelocityType>* array : { &velocityX_, &velocityY_, &velocityZ_ })
+		{
+			array->resize(size, VelocityType(0));
+		}
+		paletteIndices_.resize(size, uint8_t(0));
+	}
+
+	const size_t i = count_++;
+	positionX_[i] = EncodePosition(position.x, bounds_.min.x, inversePositionStep_.x);
+	positionY_[i] = EncodePosition(position.y, bounds_.min.y, inversePositionStep_.y);
+	positionZ_[i] = EncodePosition(position.z, bounds_.min.z, inversePositionStep_.z);
+	velocityX_[i] = EncodeVelocity<VelocityType>(velocity.x);
+	velocityY_[i] = EncodeVelocity<VelocityType>(velocity.y);
+	velocityZ_[i] = EncodeVelocity<VelocityType>(velocity.z);
+	paletteIndices_[i] = paletteIndex;
+	return static_cast<uint32_t>(i);
+}
+
+void CompactBallSoA::Clear()
+{
+	count_ = 0;
+	positionX_.clear();
+	positionY_.clear();
+	positionZ_.clear();
+	velocityX_.clear();
+	velocityY_.clear();
+	velocityZ_.clear();
+	paletteIndices_.clear();
+}
+
+Vector3ex CompactBallSoA::GetPosition(size_t i) const
+{
+	return
+	{
+		bounds_.min.x + static_cast<float>(positionX_[i]) * positionStep_.x,
+		bounds_.min.y + static_cast<float>(positionY_[i]) * positionStep_.y,
+		bounds_.min.z + static_cast<float>(positionZ_[i]) * positionStep_.z,
+	};
+}
+
+Vector3ex CompactBallSoA::GetVelocity(size_t i) const
+{
+	return { DecodeVelocity(velocityX_[i]), DecodeVelocity(velocityY_[i]), DecodeVelocity(velocityZ_[i]) };
+}
+
+void CompactBallSoA::Decode(BallStateSoA& out) const
+{
+	out.Clear();
+	for (size_t i = 0; i < count_; ++i)
+	{
+		const BallPaletteEntry& entry = palette_[paletteIndices_[i]];
+		out.Add(GetPosition(i), GetVelocity(i), entry.radius, entry.mass);
+	}
+}
+
+void CompactBallSoA::Step(float deltaTime, std::span<const Plane> planes, const BallStepSettings& settings)
+{
+	const Float8 minX = Float8::Set1(bounds_.min.x);
+	const Float8 minY = Float8::Set1(bounds_.min.y);
+	const Float8 minZ = Float8::Set1(bounds_.min.z);
+	const Float8 stepX = Float8::Set1(positionStep_.x);
+	const Float8 stepY = Float8::Set1(positionStep_.y);
+	const Float8 stepZ = Float8::Set1(positionStep_.z);
+	const Float8 inverseStepX = Float8::Set1(inversePositionStep_.x);
+	const Float8 inverseStepY = Float8::Set1(inversePositionStep_.y);
+	const Float8 inverseStepZ = Float8::Set1(inversePositionStep_.z);
+
+	// 配列の長さは8の倍数なので端数の処理は要らない（余りのボールも計算するが読まれない）
+	const size_t paddedCount = positionX_.size();
+	for (size_t i = 0; i < paddedCount; i += kLanes)
+	{
+		float radius[kLanes];
+		for (size_t lane = 0; lane < kLanes; ++lane)
+		{
+			radius[lane] = paletteRadius_[paletteIndices_[i + lane]];
+		}
+
+		BallLanes lanes = {
+			minX + LoadUint16(&positionX_[i]) * stepX,
+			minY + LoadUint16(&positionY_[i]) * stepY,
+			minZ + LoadUint16(&positionZ_[i]) * stepZ,
+			LoadVelocity(&velocityX_[i]),
+			LoadVelocity(&velocityY_[i]),
+			LoadVelocity(&velocityZ_[i]),
+			Float8::Load(radius) };
+		StepLanes(lanes, deltaTime, planes, settings);
+		StoreUint16((lanes.positionX - minX) * inverseStepX, &positionX_[i]);
+		StoreUint16((lanes.positionY - minY) * inverseStepY, &positionY_[i]);
+		StoreUint16((lanes.positionZ - minZ) * inverseStepZ, &positionZ_[i]);
+		StoreVelocity(lanes.velocityX, &velocityX_[i]);
+		StoreVelocity(lanes.velocityY, &velocityY_[i]);
+		StoreVelocity(lanes.velocityZ, &velocityZ_[i]);
+	}
+}
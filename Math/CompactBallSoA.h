@@ -0,0 +1,179 @@
+#pragma once
+#include "AABB.h"
+#include "Plane.h"
+#include "SimdFloat.h"
+#include "Vector3ex.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// ボールを重力で動かし、平面に当てる時の設定（CompactBallSoAとBallStateSoAで共通）
+/// 平面との衝突はPhysicsWorld::ResolveStaticContactと同じ規則（押し出し、速度を反射して反発係数を掛ける）
+/// </summary>
+struct BallStepSettings final
+{
+	Vector3ex gravity = { 0.0f, -9.8f, 0.0f };	// 重力加速度
+	float restitution = 0.8f;					// 反発係数
+	float restingSpeed = 0.3f;					// 衝突時の法線方向の速さがこれ未満なら反発させない
+};
+
+/// <summary>
+/// ボールの位置、速度、半径、質量をfloatの配列で持つ（CompactBallSoAの誤差を測る時の基準）
+/// </summary>
+struct BallStateSoA final
+{
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> velocityX;
+	std::vector<float> velocityY;
+	std::vector<float> velocityZ;
+	std::vector<float> radius;
+	std::vector<float> mass;
+
+	size_t GetCount() const { return positionX.size(); }
+
+	void Clear()
+	{
+		positionX.clear();
+		positionY.clear();
+		positionZ.clear();
+		velocityX.clear();
+		velocityY.clear();
+		velocityZ.clear();
+		radius.clear();
+		mass.clear();
+	}
+
+	/// <summary>
+	/// ボールを追加する
+	/// </summary>
+	/// <returns>ボールの番号</returns>
+	uint32_t Add(const Vector3ex& position, const Vector3ex& velocity, float r, float m)
+	{
+		positionX.push_back(position.x);
+		positionY.push_back(position.y);
+		positionZ.push_back(position.z);
+		velocityX.push_back(velocity.x);
+		velocityY.push_back(velocity.y);
+		velocityZ.push_back(velocity.z);
+		radius.push_back(r);
+		mass.push_back(m);
+		return static_cast<uint32_t>(positionX.size() - 1);
+	}
+
+	Vector3ex GetPosition(size_t i) const { return { positionX[i], positionY[i], positionZ[i] }; }
+	Vector3ex GetVelocity(size_t i) const { return { velocityX[i], velocityY[i], velocityZ[i] }; }
+
+	/// <summary>
+	/// 重力で1ステップ進め（半陰的オイラー法）、平面に当てる（8個ずつまとめて計算する）
+	/// </summary>
+	/// <param name="deltaTime">時間の刻み</param>
+	/// <param name="planes">平面</param>
+	/// <param name="settings">重力と反発の設定</param>
+	void Step(float deltaTime, std::span<const Plane> planes, const BallStepSettings& settings);
+};
+
+/// <summary>
+/// 半径、質量、色の組（CompactBallSoAはボールごとにこの番号だけを持つ）
+/// </summary>
+struct BallPaletteEntry final
+{
+	float radius = 0.0f;
+	float mass = 0.0f;
+	uint32_t color = 0xFFFFFFFF;
+};
+
+/// <summary>
+/// ボールを小さく詰めて持つ（F16Cがあれば1個13バイト、無ければ19バイト、BallStateSoAは32バイト、Ballは48バイト）
+/// 位置は範囲を65535等分した16ビット固定小数点、半径と質量と色はパレットの番号
+/// 速度はF16Cがあれば半精度浮動小数点、無ければfloat（SSE2だけで半精度を変換すると、floatの配列を読み書きするより遅くなるため）
+/// Stepは8個ずつ読んでfloatに戻し、積分と平面との衝突を計算してその場で詰め直す（floatの作業用配列を持たない）
+/// 範囲の外に出た位置は範囲の端に寄せられるので、範囲は壁の平面より少し広く取ること
+/// </summary>
+class CompactBallSoA final
+{
+public:
+	static constexpr size_t kMaxPaletteCount = 256;
+	static constexpr bool kHalfVelocity = MT_SIMD_F16C != 0;	// 速度を半精度で持つか（ビルドで決まる）
+	using VelocityType = std::conditional_t<kHalfVelocity, uint16_t, float>;
+	static constexpr size_t kBytesPerBall = 3 * sizeof(uint16_t) + 3 * sizeof(VelocityType) + sizeof(uint8_t);
+
+	/// <summary>
+	/// 位置を表せる範囲を決めて作る
+	/// </summary>
+	/// <param name="bounds">位置の範囲（各軸の幅は0より大きいこと）</param>
+	explicit CompactBallSoA(const AABB& bounds);
+
+	/// <summary>
+	/// パレットに半径、質量、色の組を追加する（256個まで）
+	/// </summary>
+	/// <returns>パレットの番号</returns>
+	uint8_t AddPalette(const BallPaletteEntry& entry);
+	const BallPaletteEntry& GetPalette(uint8_t index) const { return palette_[index]; }
+	size_t GetPaletteCount() const { return paletteCount_; }
+
+	/// <summary>
+	/// ボールを追加する（位置は最も近い格子点に、速度は半精度で持つ時は最も近い半精度の値に丸める）
+	/// </summary>
+	/// <param name="position">位置</param>
+	/// <param name="velocity">速度</param>
+	/// <param name="paletteIndex">パレットの番号</param>
+	/// <returns>ボールの番号</returns>
+	uint32_t Add(const Vector3ex& position, const Vector3ex& velocity, uint8_t paletteIndex);
+	void Clear();
+
+	size_t GetCount() const { return count_; }
+	Vector3ex GetPosition(size_t i) const;
+	Vector3ex GetVelocity(size_t i) const;
+	uint8_t GetPaletteIndex(size_t i) const { return paletteIndices_[i]; }
+	float GetRadius(size_t i) const { return palette_[paletteIndices_[i]].radius; }
+	float GetMass(size_t i) const { return palette_[paletteIndices_[i]].mass; }
+
+	/// <summary>
+	/// floatの配列に展開する（BallSoAを受け取る判定に渡す時や、誤差を測る時に使う）
+	/// </summary>
+	void Decode(BallStateSoA& out) const;
+
+	/// <summary>
+	/// 重力で1ステップ進め（半陰的オイラー法）、平面に当てる
+	/// 計算はBallStateSoA::Stepと同じで、違うのは読み書きの時の丸めだけ
+	/// </summary>
+	/// <param name="deltaTime">時間の刻み</param>
+	/// <param name="planes">平面</param>
+	/// <param name="settings">重力と反発の設定</param>
+	void Step(float deltaTime, std::span<const Plane> planes, const BallStepSettings& settings);
+
+	const AABB& GetBounds() const { return bounds_; }
+	/// <summary>
+	/// 位置の格子の間隔（丸めの誤差は各軸でこの半分まで）
+	/// </summary>
+	const Vector3ex& GetPositionStep() const { return positionStep_; }
+	/// <summary>
+	/// ボールの配列が使うバイト数（8個単位に切り上げた分を含む）
+	/// </summary>
+	size_t GetMemoryBytes() const { return positionX_.size() * kBytesPerBall; }
+
+private:
+	AABB bounds_;
+	Vector3ex positionStep_;
+	Vector3ex inversePositionStep_;
+
+	// 8個ずつ読めるように、配列の長さは常に8の倍数にしておく（余りは速度0、パレット0のボール）
+	size_t count_ = 0;
+	std::vector<uint16_t> positionX_;
+	std::vector<uint16_t> positionY_;
+	std::vector<uint16_t> positionZ_;
+	std::vector<VelocityType> velocityX_;
+	std::vector<VelocityType> velocityY_;
+	std::vector<VelocityType> velocityZ_;
+	std::vector<uint8_t> paletteIndices_;
+
+	std::array<BallPaletteEntry, kMaxPaletteCount> palette_{};
+	std::array<float, kMaxPaletteCount> paletteRadius_{};	// Stepで8個分を集める時に読む
+	size_t paletteCount_ = 0;
+};
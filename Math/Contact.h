@@ -0,0 +1,27 @@
+#pragma once
+#include "Vector3ex.h"
+#include <cstdint>
+
+/// <summary>
+/// 接触相手の種類
+/// </summary>
+enum class ContactTarget : uint32_t
+{
+	Body,	// 他のボール
+	Plane,	// 平面
+	AABB,	// 静的なAABB
+	Heightfield,	// 地形
+	SdfVolume,		// 符号付き距離のボリューム
+};
+
+/// <summary>
+/// 接触情報
+/// </summary>
+struct Contact final
+{
+	uint32_t bodyIndex;		// 接触したボールの番号
+	uint32_t otherIndex;	// 接触相手の番号
+	ContactTarget target;	// 接触相手の種類
+	Vector3ex normal;		// 接触法線（相手からボールへ向く）
+	float depth;			// めり込み量
+};
@@ -0,0 +1,61 @@
+#pragma once
+#include "AlignedTypes.h"
+#include "MatrixN.h"
+#include "Matrix4x4ex.h"
+#include "Vector3ex.h"
+#include "Vector3.h"
+#include "Vector4.h"
+#include <bit>
+
+/// <summary>
+/// 既存の型と同じ並びのVector/Matrix（特殊化がある型だけToCore/FromCoreで行き来できる）
+/// </summary>
+template<class U>
+struct CoreLayout;
+
+template<>
+struct CoreLayout<Vector3ex> { using Type = Vector3f; };
+template<>
+struct CoreLayout<Vector3> { using Type = Vector3f; };
+template<>
+struct CoreLayout<Vector4> { using Type = Vector4f; };
+template<>
+struct CoreLayout<Matrix4x4ex> { using Type = Matrix4x4f; };
+template<>
+struct CoreLayout<Vec4A> { using Type = Vector4f; };
+template<>
+struct CoreLayout<Mat4A> { using Type = Matrix4x4f; };
+
+template<class U>
+using CoreType = typename CoreLayout<U>::Type;
+
+/// <summary>
+/// 既存の型をVector/Matrixとして読む
+/// 並びが同じなのでbit_castはコピー1回になり、最適化でレジスタの受け渡しだけになる
+/// </summary>
+template<class U>
+inline CoreType<U> ToCore(const U& value)
+{
+	static_assert(sizeof(U) == sizeof(CoreType<U>) && std::is_trivially_copyable_v<U>, "並びが同じ型だけ変換できる");
+	return std::bit_cast<CoreType<U>>(value);
+}
+
+/// <summary>
+/// Vector/Matrixを既存の型に戻す
+/// </summary>
+template<class U>
+inline U FromCore(const CoreType<U>& value)
+{
+	static_assert(sizeof(U) == sizeof(CoreType<U>) && std::is_trivially_copyable_v<U>, "並びが同じ型だけ変換できる");
+	return std::bit_cast<U>(value);
+}
+
+/// <summary>
+/// 並びが同じ型同士の変換（Vector3exとVector3など）
+/// </summary>
+template<class To, class From>
+inline To LayoutCast(const From& value)
+{
+	static_assert(std::is_same_v<CoreType<To>, CoreType<From>>, "同じVector/Matrixに対応する型同士だけ変換できる");
+	return FromCore<To>(ToCore(value));
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "SimdFloat.h"
+#include <cstddef>
+
+/*----------floatのsin/cos----------*/
+// xをπ/2の倍数qと余りr（|r| <= π/4）に分け、rのsinとcosを多項式で求めてからqの象限で入れ替えと符号を決める
+// 余りはπ/2を3つに分けた定数で引く（|x| <= 1e3なら下の誤差のまま、1e5で1e-6程度まで増える）
+// 多項式の係数は[-π/4, π/4]のミニマックス近似（Remez法）
+
+/// <summary>
+/// 多項式の次数（最大誤差はstd::sinとの差の絶対値）
+/// </summary>
+enum class TrigPrecision
+{
+	Fast,		// sinは5次、cosは4次（最大誤差1.3e-5、描画の分割向け）
+	Accurate,	// sinは7次、cosは8次（最大誤差1e-7、floatの丸め誤差と同程度）
+};
+
+namespace FastTrigDetail
+{
+	constexpr float kTwoOverPi = 0.636619772367581343f;
+	// π/2 = kPiOver2Hi + kPiOver2Mid + kPiOver2Lo（Hiは8ビットなのでq * Hiは|q| < 2^16まで誤差なく計算できる）
+	constexpr float kPiOver2Hi = 1.5703125f;
+	constexpr float kPiOver2Mid = 4.837512969970703125e-4f;
+	constexpr float kPiOver2Lo = 7.54978995489188216e-8f;
+	constexpr float kRoundMagic = 12582912.0f;	// 1.5 * 2^23を足して引くと最も近い整数に丸まる
+
+	template<class F> inline F Splat(float value) { return F::Set1(value); }
+	template<> inline float Splat<float>(float value) { return value; }
+
+	/// <summary>
+	/// |r| <= π/4のsin（r2はrの2乗）
+	/// </summary>
+	template<TrigPrecision P, class F>
+	inline F SinPolynomial(F r, F r2)
+	{
+		if constexpr (P == TrigPrecision::Fast)
+		{
+			return r + r * r2 * (Splat<F>(-0.16662833806931746f) + r2 * Splat<F>(0.008152992341813778f));
+		}
+		else
+		{
+			return r + r * r2 * (Splat<F>(-0.1666665066929431f) + r2 * (Splat<F>(0.0083319786631606f) + r2 * Splat<F>(-0.0001949563623788698f)));
+		}
+	}
+
+	/// <summary>
+	/// |r| <= π/4のcos（r2はrの2乗）
+	/// </summary>
+	template<TrigPrecision P, class F>
+	inline F CosPolynomial(F r2)
+	{
+		if constexpr (P == TrigPrecision::Fast)
+		{
+			return Splat<F>(1.0f) + r2 * (Splat<F>(-0.49977630707616877f) + r2 * Splat<F>(0.04048893584359353f));
+		}
+		else
+		{
+			return Splat<F>(1.0f) + r2 * (Splat<F>(-0.4999999972510836f) + r2 * (Splat<F>(0.04166662332435889f) +
+				r2 * (Splat<F>(-0.0013886763794769181f) + r2 * Splat<F>(2.439045073585632e-05f))));
+		}
+	}
+
+	/// <summary>
+	/// π/2の倍数qと余りrに分ける（qは整数値のfloat）
+	/// </summary>
+	template<class F>
+	inline F Reduce(F x, F& q)
+	{
+		q = (x * Splat<F>(kTwoOverPi) + Splat<F>(kRoundMagic)) - Splat<F>(kRoundMagic);
+		return ((x - q * Splat<F>(kPiOver2Hi)) - q * Splat<F>(kPiOver2Mid)) - q * Splat<F>(kPiOver2Lo);
+	}
+
+	/// <summary>
+	/// SIMD版の本体（象限の判定も整数命令を使わずにfloatで行うので、AVX2が無くても8レーンで動く）
+	/// </summary>
+	template<TrigPrecision P, class F>
+	inline void SinCosSimd(F x, F& sine, F& cosine)
+	{
+		F q;
+		const F r = Reduce(x, q);
+		const F r2 = r * r;
+		const F sinR = SinPolynomial<P>(r, r2);
+		const F cosR = CosPolynomial<P>(r2);
+
+		// 象限k = q mod 4（0〜3）をfloatのまま求める
+		const F quarter = q * Splat<F>(0.25f);
+		F floorQuarter = (quarter + Splat<F>(kRoundMagic)) - Splat<F>(kRoundMagic);
+		floorQuarter = floorQuarter - (Splat<F>(1.0f) & (floorQuarter > quarter));
+		const F k = (quarter - floorQuarter) * Splat<F>(4.0f);
+
+		const F one = Splat<F>(1.0f);
+		const F two = Splat<F>(2.0f);
+		const F three = Splat<F>(3.0f);
+		const F swap = (k == one) | (k == three);
+		const F sinNegative = k >= two;
+		const F cosNegative = (k == one) | (k == two);
+		const F s = Select(swap, cosR, sinR);
+		const F c = Select(swap, sinR, cosR);
+		sine = Select(sinNegative, -s, s);
+		cosine = Select(cosNegative, -c, c);
+	}
+}
+
+/// <summary>
+/// sinとcosを同時に求める
+/// </summary>
+/// <typeparam name="P">精度</typeparam>
+/// <param name="x">角度（ラジアン）</param>
+/// <param name="sine">sin(x)</param>
+/// <param name="cosine">cos(x)</param>
+template<TrigPrecision P = TrigPrecision::Accurate>
+inline void SinCos(float x, float& sine, float& cosine)
+{
+	float q;
+	const float r = FastTrigDetail::Reduce(x, q);
+	const float r2 = r * r;
+	const float sinR = FastTrigDetail::SinPolynomial<P>(r, r2);
+	const float cosR = FastTrigDetail::CosPolynomial<P>(r2);
+
+	const int quadrant = static_cast<int>(q) & 3;
+	const float s = (quadrant & 1) ? cosR : sinR;
+	const float c = (quadrant & 1) ? sinR : cosR;
+	sine = (quadrant & 2) ? -s : s;
+	cosine = (quadrant == 1 || quadrant == 2) ? -c : c;
+}
+
+/// <summary>
+/// 4レーンのsinとcos
+/// </summary>
+template<TrigPrecision P = TrigPrecision::Accurate>
+inline void SinCos(Float4 x, Float4& sine, Float4& cosine) { FastTrigDetail::SinCosSimd<P>(x, sine, cosine); }
+
+/// <summary>
+/// 8レーンのsinとcos（AVXが無い場合はSSEを2本並べる）
+/// </summary>
+template<TrigPrecision P = TrigPrecision::Accurate>
+inline void SinCos(Float8 x, Float8& sine, Float8& cosine) { FastTrigDetail::SinCosSimd<P>(x, sine, cosine); }
+
+/// <summary>
+/// 配列の角度をまとめて変換する（8個ずつSIMDで求め、端数はスカラーで求める）
+/// </summary>
+/// <param name="angles">角度（ラジアン）</param>
+/// <param name="sines">sinの出力先（不要ならnullptr）</param>
+/// <param name="cosines">cosの出力先（不要ならnullptr）</param>
+/// <param name="count">数</param>
+template<TrigPrecision P = TrigPrecision::Accurate>
+inline void SinCosArray(const float* angles, float* sines, float* cosines, size_t count)
+{
+	const size_t simdCount = count - count % Float8::kWidth;
+	for (size_t i = 0; i < simdCount; i += Float8::kWidth)
+	{
+		Float8 sine;
+		Float8 cosine;
+		SinCos<P>(Float8::Load(angles + i), sine, cosine);
+		if (sines != nullptr)
+		{
+			sine.Store(sines + i);
+		}
+		if (cosines != nullptr)
+		{
+			cosine.Store(cosines + i);
+		}
+	}
+	for (size_t i = simdCount; i < count; ++i)
+	{
+		float sine;
+		float cosine;
+		SinCos<P>(angles[i], sine, cosine);
+		if (sines != nullptr)
+		{
+			sines[i] = sine;
+		}
+		if (cosines != nullptr)
+		{
+			cosines[i] = cosine;
+		}
+	}
+}
@@ -0,0 +1,153 @@
+#include "FrameArena.h"
+#include <algorithm>
+#include <cassert>
+
+namespace
+{
+	/// <summary>
+	/// スレッドが今使っているチャンク
+	/// </summary>
+	struct ThreadChunk
+	{
+		const FrameArena* owner = nullptr;
+		uint64_t generation = 0;
+		uintptr_t cursor = 0;
+		uintptr_t end = 0;
+	};
+
+	thread_local ThreadChunk threadChunk;
+
+	// 世代は全てのアリーナで通し番号にする（同じアドレスに作り直されても古いチャンクを使わない）
+	std::atomic<uint64_t> nextGeneration{ 1 };
+
+	uintptr_t AlignUp(uintptr_t value, size_t alignment)
+	{
+		return (value + alignment - 1) & ~static_cast<uintptr_t>(alignment - 1);
+	}
+
+	std::byte* AllocateBuffer(size_t capacity)
+	{
+		return static_cast<std::byte*>(::operator new(capacity, std::align_val_t(FrameArena::kChunkAlignment)));
+	}
+
+	void FreeBuffer(std::byte* buffer)
+	{
+		::operator delete(buffer, std::align_val_t(FrameArena::kChunkAlignment));
+	}
+}
+
+FrameArena::FrameArena(size_t capacity, size_t chunkSize)
+	: capacity_(capacity), chunkSize_(chunkSize)
+{
+	assert(chunkSize_ % kChunkAlignment == 0);
+	buffer_ = AllocateBuffer(capacity_);
+	generation_.store(nextGeneration.fetch_add(1, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+FrameArena::~FrameArena()
+{
+	for (void* p : overflow_)
+	{
+		::operator delete(p, std::align_val_t(kChunkAlignment));
+	}
+	FreeBuffer(buffer_);
+}
+
+FrameArena& FrameArena::GetFrame()
+{
+	static FrameArena arena;
+	return arena;
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment)
+{
+	assert(alignment <= kChunkAlignment && (alignment & (alignment - 1)) == 0);
+
+	// 自分のチャンクに収まればポインタを進めるだけ
+	ThreadChunk& chunk = threadChunk;
+	if (chunk.owner == this && chunk.generation == generation_.load(std::memory_order_relaxed))
+	{
+		const uintptr_t aligned = AlignUp(chunk.cursor, alignment);
+		if (aligned + size <= chunk.end)
+		{
+			chunk.cursor = aligned + size;
+			return reinterpret_cast<void*>(aligned);
+		}
+	}
+	return AllocateSlow(size, alignment);
+}
+
+void* FrameArena::AllocateSlow(size_t size, size_t alignment)
+{
+	// チャンクの1/4を超える大きさは、チャンクを無駄にしないよう共有バッファから直接切り出す
+	if (size > chunkSize_ / 4)
+	{
+		const size_t rounded = static_cast<size_t>(AlignUp(size, kChunkAlignment));
+		if (void* p = AllocateShared(rounded))
+		{
+			return p;
+		}
+		return AllocateOverflow(size, alignment);
+	}
+
+	// 新しいチャンクを切り出す（容量が足りなければチャンクごとヒープから取る）
+	std::byte* p = static_cast<std::byte*>(AllocateShared(chunkSize_));
+	if (p == nullptr)
+	{
+		p = static_cast<std::byte*>(AllocateOverflow(chunkSize_, kChunkAlignment));
+	}
+	ThreadChunk& chunk = threadChunk;
+	chunk.owner = this;
+	chunk.generation = generation_.load(std::memory_order_relaxed);
+	chunk.cursor = reinterpret_cast<uintptr_t>(p) + size;
+	chunk.end = reinterpret_cast<uintptr_t>(p) + chunkSize_;
+	return p;
+}
+
+void* FrameArena::AllocateShared(size_t size)
+{
+	const size_t offset = used_.fetch_add(size, std::memory_order_relaxed);
+	if (offset + size > capacity_)
+	{
+		return nullptr;
+	}
+	return buffer_ + offset;
+}
+
+void* FrameArena::AllocateOverflow(size_t size, size_t alignment)
+{
+	std::lock_guard<std::mutex> lock(overflowMutex_);
+	void* p = ::operator new(std::max<size_t>(size, 1), std::align_val_t(std::max(alignment, kChunkAlignment)));
+	overflow_.push_back(p);
+	return p;
+}
+
+void FrameArena::Reset()
+{
+	// 容量を超えて切り出そうとした分もusedに入っているので、そのまま必要量になる
+	lastFrameBytes_ = used_.load(std::memory_order_relaxed);
+	highWaterMark_ = std::max(highWaterMark_, lastFrameBytes_);
+
+	if (!overflow_.empty())
+	{
+		for (void* p : overflow_)
+		{
+			::operator delete(p, std::align_val_t(kChunkAlignment));
+		}
+		overflow_.clear();
+		++overflowFrames_;
+
+		// 次のフレームからヒープを使わないように、必要量の2倍まで広げる
+		size_t capacity = capacity_;
+		while (capacity < lastFrameBytes_ * 2)
+		{
+			capacity *= 2;
+		}
+		FreeBuffer(buffer_);
+		buffer_ = AllocateBuffer(capacity);
+		capacity_ = capacity;
+	}
+
+	used_.store(0, std::memory_order_relaxed);
+	generation_.store(nextGeneration.fetch_add(1, std::memory_order_relaxed), std::memory_order_release);
+}
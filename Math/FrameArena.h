@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// フレームごとに使い捨てるメモリの線形アロケータ
+/// Resetまでは個別に解放できない代わりに、確保はポインタを進めるだけで済む
+/// スレッドごとにチャンクを切り出して渡すので、確保の高速経路ではロックも原子操作も使わない
+/// </summary>
+class FrameArena final
+{
+public:
+	static constexpr size_t kDefaultCapacity = 4 << 20;	// 4MB
+	static constexpr size_t kDefaultChunkSize = 64 << 10;	// 64KB
+	static constexpr size_t kChunkAlignment = 64;
+
+	/// <summary>
+	/// 容量を確保する
+	/// </summary>
+	/// <param name="capacity">最初に確保する容量（足りなければResetで広げる）</param>
+	/// <param name="chunkSize">スレッドに切り出すチャンクの大きさ</param>
+	explicit FrameArena(size_t capacity = kDefaultCapacity, size_t chunkSize = kDefaultChunkSize);
+	~FrameArena();
+
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	/// <summary>
+	/// アプリ全体で使うフレームアリーナ（Novice::BeginFrameの直後にResetする）
+	/// </summary>
+	static FrameArena& GetFrame();
+
+	/// <summary>
+	/// 確保する（容量を超えた分はヒープから確保し、次のResetで容量を広げる）
+	/// </summary>
+	/// <param name="size">大きさ</param>
+	/// <param name="alignment">アラインメント（2の累乗、kChunkAlignment以下）</param>
+	/// <returns></returns>
+	void* Allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+	/// <summary>
+	/// 初期化しない配列を確保する（デストラクタは呼ばれないので自明な型だけ）
+	/// </summary>
+	template<class T>
+	T* AllocateArray(size_t count)
+	{
+		static_assert(std::is_trivially_destructible_v<T>, "FrameArenaはデストラクタを呼ばない");
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	/// <summary>
+	/// このフレームで確保したものを全て捨てる
+	/// 他のスレッドが確保していない時に呼ぶこと
+	/// </summary>
+	void Reset();
+
+	/// <summary>
+	/// 現在のフレームで切り出した量（チャンク単位）
+	/// </summary>
+	size_t GetUsedBytes() const { return used_.load(std::memory_order_relaxed); }
+	/// <summary>
+	/// 直前のフレームで使った量
+	/// </summary>
+	size_t GetLastFrameBytes() const { return lastFrameBytes_; }
+	/// <summary>
+	/// これまでで最も多く使ったフレームの量
+	/// </summary>
+	size_t GetHighWaterMark() const { return highWaterMark_; }
+	size_t GetCapacity() const { return capacity_; }
+	/// <summary>
+	/// 容量が足りずヒープから確保したフレームの数
+	/// </summary>
+	uint64_t GetOverflowFrameCount() const { return overflowFrames_; }
+
+private:
+	/// <summary>
+	/// スレッドのチャンクに収まらない時の確保
+	/// </summary>
+	void* AllocateSlow(size_t size, size_t alignment);
+	/// <summary>
+	/// 共有のバッファから切り出す（足りなければnullptr）
+	/// </summary>
+	void* AllocateShared(size_t size);
+	/// <summary>
+	/// ヒープから確保してResetで解放する
+	/// </summary>
+	void* AllocateOverflow(size_t size, size_t alignment);
+
+	std::byte* buffer_ = nullptr;
+	size_t capacity_ = 0;
+	size_t chunkSize_ = 0;
+	std::atomic<size_t> used_{ 0 };		// 切り出した量（容量を超えても要求分を数える）
+	std::atomic<uint64_t> generation_{ 0 };	// Resetのたびに進め、スレッドのチャンクを無効にする
+
+	std::mutex overflowMutex_;
+	std::vector<void*> overflow_;
+	uint64_t overflowFrames_ = 0;
+
+	size_t lastFrameBytes_ = 0;
+	size_t highWaterMark_ = 0;
+};
+
+/// <summary>
+/// FrameArenaから確保するSTLアロケータ（解放は何もしない）
+/// 標準ライブラリが継承して使うのでfinalにはしない
+/// </summary>
+template<class T>
+class FrameAllocator
+{
+public:
+	using value_type = T;
+
+	FrameAllocator() noexcept : arena_(&FrameArena::GetFrame()) {}
+	explicit FrameAllocator(FrameArena& arena) noexcept : arena_(&arena) {}
+	template<class U>
+	FrameAllocator(const FrameAllocator<U>& other) noexcept : arena_(other.GetArena()) {}
+
+	T* allocate(size_t count) { return static_cast<T*>(arena_->Allocate(sizeof(T) * count, alignof(T))); }
+	void deallocate(T*, size_t) noexcept {}
+
+	FrameArena* GetArena() const noexcept { return arena_; }
+
+	template<class U>
+	bool operator==(const FrameAllocator<U>& other) const noexcept { return arena_ == other.GetArena(); }
+	template<class U>
+	bool operator!=(const FrameAllocator<U>& other) const noexcept { return arena_ != other.GetArena(); }
+
+private:
+	FrameArena* arena_;
+};
+
+/// <summary>
+/// フレームアリーナ上の可変長配列（フレームをまたいで持ち越さないこと）
+/// </summary>
+template<class T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
@@ -0,0 +1,753 @@
+#include "Gjk.h"
+#include "MathFunction.h"
+#include <cmath>
+
+namespace
+{
+	MathFunction Func;
+
+	constexpr uint32_t kGjkMaxIterations = 64;
+	constexpr float kGjkTolerance = 1e-5f;		// 距離の収束判定（相対）
+	constexpr float kGjkOriginTolerance = 1e-12f;	// 原点に触れているとみなす距離の2乗
+
+	constexpr uint32_t kEpaMaxIterations = 64;
+	constexpr uint32_t kEpaMaxVertices = 4 + kEpaMaxIterations;
+	constexpr uint32_t kEpaMaxFaces = 4 + kEpaMaxIterations * 4;
+	constexpr uint32_t kEpaMaxEdges = 64;
+	constexpr float kEpaTolerance = 1e-4f;
+
+	/// <summary>
+	/// ミンコフスキー差A-B上の点と、それを作ったA、B上の点
+	/// </summary>
+	struct SupportPoint
+	{
+		Vector3ex w;			// a - b
+		Vector3ex a;
+		Vector3ex b;
+		Vector3ex direction;	// この点を得た探索方向（キャッシュ用）
+	};
+
+	/// <summary>
+	/// 単体と、原点に最も近い点の重心座標
+	/// </summary>
+	struct Simplex
+	{
+		SupportPoint points[4];
+		float weights[4];
+		uint32_t count;
+	};
+
+	SupportPoint ComputeSupport(const ConvexShape& a, const ConvexShape& b, const Vector3ex& direction)
+	{
+		SupportPoint point;
+		point.a = a.Support(direction);
+		point.b = b.Support(-direction);
+		point.w = point.a - point.b;
+		point.direction = direction;
+		return point;
+	}
+
+	/// <summary>
+	/// 単体を指定した頂点だけに縮める
+	/// </summary>
+	void Reduce(Simplex& simplex, const uint32_t* indices, const float* weights, uint32_t count)
+	{
+		SupportPoint points[4];
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			points[i] = simplex.points[indices[i]];
+		}
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			simplex.points[i] = points[i];
+			simplex.weights[i] = weights[i];
+		}
+		simplex.count = count;
+	}
+
+	/// <summary>
+	/// 線分abで原点に最も近い点（結果は単体の番号と重み）
+	/// </summary>
+	uint32_t SolveSegment(const Vector3ex& a, const Vector3ex& b, uint32_t ia, uint32_t ib, uint32_t* indices, float* weights)
+	{
+		Vector3ex ab = b - a;
+		float lengthSquared = Func.Dot(ab, ab);
+		float t = lengthSquared > 0.0f ? -Func.Dot(a, ab) / lengthSquared : 0.0f;
+		if (t <= 0.0f)
+		{
+			indices[0] = ia;
+			weights[0] = 1.0f;
+			return 1;
+		}
+		if (t >= 1.0f)
+		{
+			indices[0] = ib;
+			weights[0] = 1.0f;
+			return 1;
+		}
+		indices[0] = ia;
+		indices[1] = ib;
+		weights[0] = 1.0f - t;
+		weights[1] = t;
+		return 2;
+	}
+
+	/// <summary>
+	/// 三角形abcで原点に最も近い点（ボロノイ領域で場合分け）
+	/// </summary>
+	uint32_t SolveTriangle(const Vector3ex& a, const Vector3ex& b, const Vector3ex& c, uint32_t ia, uint32_t ib, uint32_t ic, uint32_t* indices, float* weights)
+	{
+		Vector3ex ab = b - a;
+		Vector3ex ac = c - a;
+
+		// 頂点aの領域
+		float d1 = -Func.Dot(ab, a);
+		float d2 = -Func.Dot(ac, a);
+		if (d1 <= 0.0f && d2 <= 0.0f)
+		{
+			indices[0] = ia;
+			weights[0] = 1.0f;
+			return 1;
+		}
+
+		// 頂点bの領域
+		float d3 = -Func.Dot(ab, b);
+		float d4 = -Func.Dot(ac, b);
+		if (d3 >= 0.0f && d4 <= d3)
+		{
+			indices[0] = ib;
+			weights[0] = 1.0f;
+			return 1;
+		}
+
+		// 辺abの領域
+		float vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			float v = d1 / (d1 - d3);
+			indices[0] = ia;
+			indices[1] = ib;
+			weights[0] = 1.0f - v;
+			weights[1] = v;
+			return 2;
+		}
+
+		// 頂点cの領域
+		float d5 = -Func.Dot(ab, c);
+		float d6 = -Func.Dot(ac, c);
+		if (d6 >= 0.0f && d5 <= d6)
+		{
+			indices[0] = ic;
+			weights[0] = 1.0f;
+			return 1;
+		}
+
+		// 辺acの領域
+		float vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			float w = d2 / (d2 - d6);
+			indices[0] = ia;
+			indices[1] = ic;
+			weights[0] = 1.0f - w;
+			weights[1] = w;
+			return 2;
+		}
+
+		// 辺bcの領域
+		float va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			float w = (d4 - d3) / ((d4 - d3) + (d5 - d6));
+			indices[0] = ib;
+			indices[1] = ic;
+			weights[0] = 1.0f - w;
+			weights[1] = w;
+			return 2;
+		}
+
+		// 面の内側
+		float sum = va + vb + vc;
+		if (!(sum > 0.0f))
+		{
+			// 潰れた三角形は3辺のうち最も近いもので代用する
+			const Vector3ex* corners[3] = { &a, &b, &c };
+			const uint32_t cornerIndices[3] = { ia, ib, ic };
+			static constexpr uint32_t kEdges[3][2] = { { 0, 1 }, { 0, 2 }, { 1, 2 } };
+			float bestDistance = INFINITY;
+			uint32_t bestCount = 0;
+			for (const uint32_t* edge : kEdges)
+			{
+				uint32_t edgeIndices[2];
+				float edgeWeights[2];
+				uint32_t edgeCount = SolveSegment(*corners[edge[0]], *corners[edge[1]], edge[0], edge[1], edgeIndices, edgeWeights);
+				Vector3ex closest(0.0f, 0.0f, 0.0f);
+				for (uint32_t i = 0; i < edgeCount; ++i)
+				{
+					closest += *corners[edgeIndices[i]] * edgeWeights[i];
+				}
+				float distance = Func.Dot(closest, closest);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					bestCount = edgeCount;
+					for (uint32_t i = 0; i < edgeCount; ++i)
+					{
+						indices[i] = cornerIndices[edgeIndices[i]];
+						weights[i] = edgeWeights[i];
+					}
+				}
+			}
+			return bestCount;
+		}
+
+		float denominator = 1.0f / sum;
+		float v = vb * denominator;
+		float w = vc * denominator;
+		indices[0] = ia;
+		indices[1] = ib;
+		indices[2] = ic;
+		weights[0] = 1.0f - v - w;
+		weights[1] = v;
+		weights[2] = w;
+		return 3;
+	}
+
+	/// <summary>
+	/// 単体の中で原点に最も近い点を求め、その点を含む最小の面まで単体を縮める
+	/// </summary>
+	/// <returns>原点が四面体の内側ならtrue</returns>
+	bool SolveSimplex(Simplex& simplex)
+	{
+		uint32_t indices[4];
+		float weights[4];
+		uint32_t count = 0;
+		const SupportPoint* p = simplex.points;
+
+		switch (simplex.count)
+		{
+		case 1:
+			simplex.weights[0] = 1.0f;
+			return false;
+
+		case 2:
+			count = SolveSegment(p[0].w, p[1].w, 0, 1, indices, weights);
+			break;
+
+		case 3:
+			count = SolveTriangle(p[0].w, p[1].w, p[2].w, 0, 1, 2, indices, weights);
+			break;
+
+		default:
+		{
+			// 各面について、原点が反対側の頂点と逆側にあれば、その面が候補になる
+			static constexpr uint32_t kFaces[4][4] = { { 0, 1, 2, 3 }, { 0, 3, 1, 2 }, { 0, 2, 3, 1 }, { 1, 3, 2, 0 } };
+			const float volume = Func.Dot(p[3].w - p[0].w, Func.Cross(p[1].w - p[0].w, p[2].w - p[0].w));
+			const bool degenerate = std::fabs(volume) <= 1e-12f;
+
+			float bestDistance = INFINITY;
+			bool outside = false;
+			for (const uint32_t* face : kFaces)
+			{
+				const Vector3ex& a = p[face[0]].w;
+				const Vector3ex& b = p[face[1]].w;
+				const Vector3ex& c = p[face[2]].w;
+				Vector3ex normal = Func.Cross(b - a, c - a);
+				float signOrigin = -Func.Dot(a, normal);
+				float signOpposite = Func.Dot(p[face[3]].w - a, normal);
+				if (!degenerate && signOrigin * signOpposite >= 0.0f)
+				{
+					continue;
+				}
+				outside = true;
+
+				uint32_t faceIndices[3];
+				float faceWeights[3];
+				uint32_t faceCount = SolveTriangle(a, b, c, face[0], face[1], face[2], faceIndices, faceWeights);
+				Vector3ex closest(0.0f, 0.0f, 0.0f);
+				for (uint32_t i = 0; i < faceCount; ++i)
+				{
+					closest += p[faceIndices[i]].w * faceWeights[i];
+				}
+				float distance = Func.Dot(closest, closest);
+				if (distance < bestDistance)
+				{
+					bestDistance = distance;
+					count = faceCount;
+					for (uint32_t i = 0; i < faceCount; ++i)
+					{
+						indices[i] = faceIndices[i];
+						weights[i] = faceWeights[i];
+					}
+				}
+			}
+
+			if (!outside)
+			{
+				// 原点を内側に含む
+				return true;
+			}
+			break;
+		}
+		}
+
+		Reduce(simplex, indices, weights, count);
+		return false;
+	}
+
+	Vector3ex ClosestPoint(const Simplex& simplex)
+	{
+		Vector3ex closest(0.0f, 0.0f, 0.0f);
+		for (uint32_t i = 0; i < simplex.count; ++i)
+		{
+			closest += simplex.points[i].w * simplex.weights[i];
+		}
+		return closest;
+	}
+
+	/// <summary>
+	/// GJK本体（終了時の単体も返す）
+	/// </summary>
+	GjkResult RunGjk(const ConvexShape& a, const ConvexShape& b, GjkCache* cache, Simplex& simplex)
+	{
+		GjkResult result{};
+		simplex.count = 0;
+
+		// 前回の単体を、同じ探索方向で作り直す
+		if (cache != nullptr)
+		{
+			for (uint32_t i = 0; i < cache->count && i < 4; ++i)
+			{
+				const Vector3ex& direction = cache->directions[i];
+				if (Func.Dot(direction, direction) == 0.0f)
+				{
+					continue;
+				}
+				SupportPoint point = ComputeSupport(a, b, direction);
+				bool duplicate = false;
+				for (uint32_t j = 0; j < simplex.count; ++j)
+				{
+					Vector3ex delta = simplex.points[j].w - point.w;
+					duplicate = duplicate || Func.Dot(delta, delta) <= kGjkOriginTolerance;
+				}
+				if (!duplicate)
+				{
+					simplex.points[simplex.count++] = point;
+				}
+			}
+		}
+		if (simplex.count == 0)
+		{
+			simplex.points[0] = ComputeSupport(a, b, Vector3ex(1.0f, 0.0f, 0.0f));
+			simplex.count = 1;
+		}
+
+		bool intersecting = false;
+		bool solved = false;
+		float previousDistanceSquared = INFINITY;
+		for (result.iterations = 1; result.iterations <= kGjkMaxIterations; ++result.iterations)
+		{
+			if (SolveSimplex(simplex))
+			{
+				intersecting = true;
+				break;
+			}
+
+			Vector3ex closest = ClosestPoint(simplex);
+			float distanceSquared = Func.Dot(closest, closest);
+			if (distanceSquared <= kGjkOriginTolerance)
+			{
+				intersecting = true;
+				break;
+			}
+			// 差集合が平たいと、足した点がすぐ捨てられて同じ単体に戻る（近づかなくなったら収束とみなす）
+			if (distanceSquared >= previousDistanceSquared)
+			{
+				solved = true;
+				break;
+			}
+			previousDistanceSquared = distanceSquared;
+
+			// 原点へ向かってこれ以上近づけなければ収束
+			SupportPoint point = ComputeSupport(a, b, -closest);
+			if (distanceSquared - Func.Dot(closest, point.w) <= kGjkTolerance * distanceSquared)
+			{
+				solved = true;
+				break;
+			}
+
+			bool duplicate = false;
+			for (uint32_t i = 0; i < simplex.count; ++i)
+			{
+				Vector3ex delta = simplex.points[i].w - point.w;
+				duplicate = duplicate || Func.Dot(delta, delta) <= kGjkOriginTolerance;
+			}
+			if (duplicate)
+			{
+				solved = true;
+				break;
+			}
+			simplex.points[simplex.count++] = point;
+		}
+		if (result.iterations > kGjkMaxIterations)
+		{
+			result.iterations = kGjkMaxIterations;
+		}
+		// 回数切れの時は最後に足した点の重みがまだ無いので、単体を解き直す
+		if (!intersecting && !solved)
+		{
+			intersecting = SolveSimplex(simplex);
+		}
+
+		result.intersecting = intersecting;
+		if (!intersecting)
+		{
+			result.distance = Func.Length(ClosestPoint(simplex));
+		}
+		else
+		{
+			result.distance = 0.0f;
+			if (simplex.count == 4)
+			{
+				// 内側に含む場合は重みが無いので、重心を代わりに入れておく
+				for (float& weight : simplex.weights)
+				{
+					weight = 0.25f;
+				}
+			}
+		}
+		result.pointA = Vector3ex(0.0f, 0.0f, 0.0f);
+		result.pointB = Vector3ex(0.0f, 0.0f, 0.0f);
+		for (uint32_t i = 0; i < simplex.count; ++i)
+		{
+			result.pointA += simplex.points[i].a * simplex.weights[i];
+			result.pointB += simplex.points[i].b * simplex.weights[i];
+		}
+
+		if (cache != nullptr)
+		{
+			cache->count = simplex.count;
+			for (uint32_t i = 0; i < simplex.count; ++i)
+			{
+				cache->directions[i] = simplex.points[i].direction;
+			}
+		}
+		return result;
+	}
+
+	/// <summary>
+	/// 原点に触れただけの単体を、体積のある四面体まで膨らませる
+	/// </summary>
+	/// <returns>形状が平たくて四面体にできなければfalse</returns>
+	bool BlowUpSimplex(const ConvexShape& a, const ConvexShape& b, Simplex& simplex)
+	{
+		static const Vector3ex kAxes[6] = {
+			{ 1.0f, 0.0f, 0.0f }, { -1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+			{ 0.0f, -1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f }, { 0.0f, 0.0f, -1.0f },
+		};
+		constexpr float kMinimumSize = 1e-10f;
+
+		if (simplex.count == 1)
+		{
+			for (const Vector3ex& axis : kAxes)
+			{
+				SupportPoint point = ComputeSupport(a, b, axis);
+				Vector3ex delta = point.w - simplex.points[0].w;
+				if (Func.Dot(delta, delta) > kMinimumSize)
+				{
+					simplex.points[simplex.count++] = point;
+					break;
+				}
+			}
+			if (simplex.count == 1)
+			{
+				return false;
+			}
+		}
+
+		if (simplex.count == 2)
+		{
+			// 線分に垂直な方向を60度ずつ回して探す
+			Vector3ex edge = simplex.points[1].w - simplex.points[0].w;
+			Vector3ex axis = std::fabs(edge.x) < std::fabs(edge.y) ? (std::fabs(edge.x) < std::fabs(edge.z) ? kAxes[0] : kAxes[4]) :
+				(std::fabs(edge.y) < std::fabs(edge.z) ? kAxes[2] : kAxes[4]);
+			Vector3ex u = Func.Normalize(Func.Cross(edge, axis));
+			Vector3ex v = Func.Normalize(Func.Cross(edge, u));
+			for (int i = 0; i < 6; ++i)
+			{
+				float angle = static_cast<float>(i) * 1.04719755f;
+				SupportPoint point = ComputeSupport(a, b, u * std::cos(angle) + v * std::sin(angle));
+				Vector3ex normal = Func.Cross(edge, point.w - simplex.points[0].w);
+				if (Func.Dot(normal, normal) > kMinimumSize)
+				{
+					simplex.points[simplex.count++] = point;
+					break;
+				}
+			}
+			if (simplex.count == 2)
+			{
+				return false;
+			}
+		}
+
+		if (simplex.count == 3)
+		{
+			Vector3ex normal = Func.Cross(simplex.points[1].w - simplex.points[0].w, simplex.points[2].w - simplex.points[0].w);
+			SupportPoint point = ComputeSupport(a, b, normal);
+			if (std::fabs(Func.Dot(point.w - simplex.points[0].w, normal)) <= kMinimumSize)
+			{
+				point = ComputeSupport(a, b, -normal);
+			}
+			if (std::fabs(Func.Dot(point.w - simplex.points[0].w, normal)) <= kMinimumSize)
+			{
+				return false;
+			}
+			simplex.points[simplex.count++] = point;
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// EPAの多面体の面（法線は外向きの単位ベクトル）
+	/// </summary>
+	struct EpaFace
+	{
+		uint32_t indices[3];
+		Vector3ex normal;
+		float distance;
+	};
+
+	/// <summary>
+	/// 面を作る（内部点から外を向くように頂点の順番をそろえる）
+	/// </summary>
+	/// <returns>潰れた面ならfalse</returns>
+	bool MakeFace(const SupportPoint* vertices, const Vector3ex& interior, uint32_t i0, uint32_t i1, uint32_t i2, EpaFace& face)
+	{
+		const Vector3ex& a = vertices[i0].w;
+		Vector3ex normal = Func.Cross(vertices[i1].w - a, vertices[i2].w - a);
+		float length = Func.Length(normal);
+		if (!(length > 0.0f))
+		{
+			return false;
+		}
+		normal /= length;
+		if (Func.Dot(normal, a - interior) < 0.0f)
+		{
+			normal = -normal;
+			face.indices[0] = i0;
+			face.indices[1] = i2;
+			face.indices[2] = i1;
+		}
+		else
+		{
+			face.indices[0] = i0;
+			face.indices[1] = i1;
+			face.indices[2] = i2;
+		}
+		face.normal = normal;
+		face.distance = Func.Dot(normal, a);
+		return true;
+	}
+
+	/// <summary>
+	/// 原点に一番近い面の番号
+	/// </summary>
+	uint32_t FindClosestFace(const EpaFace* faces, uint32_t faceCount)
+	{
+		uint32_t closest = 0;
+		for (uint32_t i = 1; i < faceCount; ++i)
+		{
+			if (faces[i].distance < faces[closest].distance)
+			{
+				closest = i;
+			}
+		}
+		return closest;
+	}
+
+	/// <summary>
+	/// 地平線の辺を追加する（逆向きの辺が既にあれば両方の面が消えるので打ち消す）
+	/// </summary>
+	bool AddHorizonEdge(uint32_t (*edges)[2], uint32_t& edgeCount, uint32_t from, uint32_t to)
+	{
+		for (uint32_t i = 0; i < edgeCount; ++i)
+		{
+			if (edges[i][0] == to && edges[i][1] == from)
+			{
+				edges[i][0] = edges[edgeCount - 1][0];
+				edges[i][1] = edges[edgeCount - 1][1];
+				--edgeCount;
+				return true;
+			}
+		}
+		if (edgeCount >= kEpaMaxEdges)
+		{
+			return false;
+		}
+		edges[edgeCount][0] = from;
+		edges[edgeCount][1] = to;
+		++edgeCount;
+		return true;
+	}
+}
+
+GjkResult GjkDistance(const ConvexShape& a, const ConvexShape& b, GjkCache* cache)
+{
+	Simplex simplex;
+	return RunGjk(a, b, cache, simplex);
+}
+
+PenetrationResult GjkEpaPenetration(const ConvexShape& a, const ConvexShape& b, GjkCache* cache)
+{
+	PenetrationResult result{};
+	Simplex simplex;
+	GjkResult gjk = RunGjk(a, b, cache, simplex);
+	if (!gjk.intersecting)
+	{
+		result.intersecting = false;
+		result.pointA = gjk.pointA;
+		result.pointB = gjk.pointB;
+		return result;
+	}
+	result.intersecting = true;
+
+	if (!BlowUpSimplex(a, b, simplex))
+	{
+		// 平たい差集合（同一平面上の三角形同士など）はめり込みを0とする
+		result.normal = Vector3ex(0.0f, 1.0f, 0.0f);
+		result.depth = 0.0f;
+		result.pointA = gjk.pointA;
+		result.pointB = gjk.pointB;
+		return result;
+	}
+
+	// 多面体は固定長の配列で持つ（ヒープを使わない）
+	SupportPoint vertices[kEpaMaxVertices];
+	EpaFace faces[kEpaMaxFaces];
+	uint32_t edges[kEpaMaxEdges][2];
+	uint32_t vertexCount = 4;
+	uint32_t faceCount = 0;
+
+	Vector3ex interior(0.0f, 0.0f, 0.0f);
+	for (uint32_t i = 0; i < 4; ++i)
+	{
+		vertices[i] = simplex.points[i];
+		interior += vertices[i].w * 0.25f;
+	}
+	static constexpr uint32_t kTetrahedron[4][3] = { { 0, 1, 2 }, { 0, 3, 1 }, { 0, 2, 3 }, { 1, 3, 2 } };
+	for (const uint32_t* face : kTetrahedron)
+	{
+		if (MakeFace(vertices, interior, face[0], face[1], face[2], faces[faceCount]))
+		{
+			++faceCount;
+		}
+	}
+
+	uint32_t closest = 0;
+	for (result.iterations = 1; result.iterations <= kEpaMaxIterations; ++result.iterations)
+	{
+		closest = FindClosestFace(faces, faceCount);
+
+		// 一番近い面の外にもう点が無ければ、その面がめり込みの境界
+		const EpaFace& nearest = faces[closest];
+		SupportPoint point = ComputeSupport(a, b, nearest.normal);
+		float gain = Func.Dot(point.w, nearest.normal) - nearest.distance;
+		if (gain <= kEpaTolerance * (1.0f + std::fabs(nearest.distance)) || vertexCount >= kEpaMaxVertices)
+		{
+			break;
+		}
+
+		// 新しい点から見える面と地平線の辺を集める（面や辺が足りなければ、面を消す前にやめる）
+		bool visible[kEpaMaxFaces];
+		uint32_t keptCount = 0;
+		uint32_t edgeCount = 0;
+		bool overflow = false;
+		for (uint32_t i = 0; i < faceCount; ++i)
+		{
+			const EpaFace& face = faces[i];
+			visible[i] = Func.Dot(face.normal, point.w - vertices[face.indices[0]].w) > 0.0f;
+			if (!visible[i])
+			{
+				++keptCount;
+				continue;
+			}
+			overflow = overflow || !AddHorizonEdge(edges, edgeCount, face.indices[0], face.indices[1]);
+			overflow = overflow || !AddHorizonEdge(edges, edgeCount, face.indices[1], face.indices[2]);
+			overflow = overflow || !AddHorizonEdge(edges, edgeCount, face.indices[2], face.indices[0]);
+		}
+		if (overflow || keptCount + edgeCount > kEpaMaxFaces)
+		{
+			break;
+		}
+
+		// 見える面を消し、地平線の辺と新しい点で面を張る
+		uint32_t write = 0;
+		for (uint32_t i = 0; i < faceCount; ++i)
+		{
+			if (!visible[i])
+			{
+				faces[write++] = faces[i];
+			}
+		}
+		faceCount = write;
+		const uint32_t newIndex = vertexCount;
+		vertices[vertexCount++] = point;
+		for (uint32_t i = 0; i < edgeCount; ++i)
+		{
+			if (MakeFace(vertices, interior, edges[i][0], edges[i][1], newIndex, faces[faceCount]))
+			{
+				++faceCount;
+			}
+		}
+		if (faceCount == 0)
+		{
+			break;
+		}
+	}
+	if (result.iterations > kEpaMaxIterations)
+	{
+		// 回数の上限まで広げて抜けた時は、closestの面が最後の広げ方で消えているかもしれないので選び直す
+		result.iterations = kEpaMaxIterations;
+		closest = FindClosestFace(faces, faceCount);
+	}
+
+	if (faceCount == 0)
+	{
+		result.normal = Vector3ex(0.0f, 1.0f, 0.0f);
+		result.depth = 0.0f;
+		result.pointA = gjk.pointA;
+		result.pointB = gjk.pointB;
+		return result;
+	}
+
+	// 原点を最も近い面に投影した点の重心座標から、A、B上の点を求める
+	const EpaFace& face = faces[closest];
+	const SupportPoint& p0 = vertices[face.indices[0]];
+	const SupportPoint& p1 = vertices[face.indices[1]];
+	const SupportPoint& p2 = vertices[face.indices[2]];
+	Vector3ex projected = face.normal * face.distance;
+	Vector3ex v0 = p1.w - p0.w;
+	Vector3ex v1 = p2.w - p0.w;
+	Vector3ex v2 = projected - p0.w;
+	float d00 = Func.Dot(v0, v0);
+	float d01 = Func.Dot(v0, v1);
+	float d11 = Func.Dot(v1, v1);
+	float d20 = Func.Dot(v2, v0);
+	float d21 = Func.Dot(v2, v1);
+	float denominator = d00 * d11 - d01 * d01;
+	float u = 1.0f;
+	float v = 0.0f;
+	float w = 0.0f;
+	if (denominator != 0.0f)
+	{
+		v = (d11 * d20 - d01 * d21) / denominator;
+		w = (d00 * d21 - d01 * d20) / denominator;
+		u = 1.0f - v - w;
+	}
+
+	result.normal = face.normal;
+	result.depth = face.distance > 0.0f ? face.distance : 0.0f;
+	result.pointA = p0.a * u + p1.a * v + p2.a * w;
+	result.pointB = p0.b * u + p1.b * v + p2.b * w;
+	return result;
+}
@@ -0,0 +1,79 @@
+#pragma once
+#include "Vector3ex.h"
+#include <cstdint>
+
+/// <summary>
+/// Support(direction)を持つ凸形状への参照
+/// Sphere、AABB、Triangleのほか、Supportを実装した形状なら何でも渡せる
+/// </summary>
+struct ConvexShape final
+{
+	const void* shape;										// 形状
+	Vector3ex(*support)(const void*, const Vector3ex&);	// サポート写像
+
+	Vector3ex Support(const Vector3ex& direction) const { return support(shape, direction); }
+};
+
+/// <summary>
+/// 凸形状への参照を作る
+/// </summary>
+/// <param name="shape">Supportを持つ形状（呼び出し中は生存している必要がある）</param>
+/// <returns></returns>
+template<class Shape>
+ConvexShape MakeConvex(const Shape& shape)
+{
+	return { &shape, [](const void* p, const Vector3ex& direction) { return static_cast<const Shape*>(p)->Support(direction); } };
+}
+
+/// <summary>
+/// 前のフレームの単体（シンプレックス）を覚えておくキャッシュ
+/// 同じ組み合わせで毎フレーム渡すと、前回の探索方向から始めるので1～2回で収束する
+/// </summary>
+struct GjkCache final
+{
+	Vector3ex directions[4];	// 単体の各頂点を得た探索方向
+	uint32_t count = 0;			// 頂点の数（0なら未使用）
+};
+
+/// <summary>
+/// GJKの結果
+/// </summary>
+struct GjkResult final
+{
+	bool intersecting;		// 重なっているか
+	float distance;			// 重なっていない時の最短距離
+	Vector3ex pointA;		// A上の最近接点
+	Vector3ex pointB;		// B上の最近接点
+	uint32_t iterations;	// 反復回数
+};
+
+/// <summary>
+/// EPAの結果
+/// </summary>
+struct PenetrationResult final
+{
+	bool intersecting;		// 重なっているか
+	Vector3ex normal;		// AからBへ向く単位法線（Bをnormal*depthだけ動かすと離れる）
+	float depth;			// めり込み量
+	Vector3ex pointA;		// A上の最深点
+	Vector3ex pointB;		// B上の最深点
+	uint32_t iterations;	// EPAの反復回数
+};
+
+/// <summary>
+/// GJKで2つの凸形状の距離と重なりを求める
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="cache">ウォームスタート用のキャッシュ（nullptrなら使わない）</param>
+/// <returns></returns>
+GjkResult GjkDistance(const ConvexShape& a, const ConvexShape& b, GjkCache* cache = nullptr);
+
+/// <summary>
+/// 重なっていればEPAでめり込みの深さと向きを求める
+/// </summary>
+/// <param name="a">形状A</param>
+/// <param name="b">形状B</param>
+/// <param name="cache">ウォームスタート用のキャッシュ（nullptrなら使わない）</param>
+/// <returns></returns>
+PenetrationResult GjkEpaPenetration(const ConvexShape& a, const ConvexShape& b, GjkCache* cache = nullptr);
@@ -0,0 +1,165 @@
+#include "GridRenderer.h"
+#include "MathFunction.h"
+#include "Novice.h"
+#include "Profiler.h"
+
+namespace
+{
+	MathFunction Func;
+
+	constexpr float kMinW = 1e-5f;	// クリップ後の点のwの下限（0除算を防ぐ）
+
+	bool Equals(const Matrix4x4ex& a, const Matrix4x4ex& b)
+	{
+		for (int row = 0; row < 4; ++row)
+		{
+			for (int column = 0; column < 4; ++column)
+			{
+				if (a.m[row][column] != b.m[row][column])
+				{
+					return false;
+				}
+			}
+		}
+		return true;
+	}
+
+	/// <summary>
+	/// クリップ座標の線分を視錐台（-w <= x, y <= w、0 <= z <= w）で切り詰める
+	/// 射影は線形なので、クリップ座標で切ってから割れば正しい位置になる
+	/// </summary>
+	/// <returns>視錐台と交わらなければfalse</returns>
+	bool ClipSegment(Vector4& a, Vector4& b)
+	{
+		const float distancesA[6] = { a.w + a.x, a.w - a.x, a.w + a.y, a.w - a.y, a.z, a.w - a.z };
+		const float distancesB[6] = { b.w + b.x, b.w - b.x, b.w + b.y, b.w - b.y, b.z, b.w - b.z };
+
+		float tStart = 0.0f;
+		float tEnd = 1.0f;
+		for (int plane = 0; plane < 6; ++plane)
+		{
+			const float distanceA = distancesA[plane];
+			const float distanceB = distancesB[plane];
+			if (distanceA < 0.0f && distanceB < 0.0f)
+			{
+				return false;
+			}
+			if (distanceA < 0.0f)
+			{
+				tStart = std::max(tStart, distanceA / (distanceA - distanceB));
+			}
+			else if (distanceB < 0.0f)
+			{
+				tEnd = std::min(tEnd, distanceA / (distanceA - distanceB));
+			}
+		}
+		if (tStart > tEnd)
+		{
+			return false;
+		}
+
+		const Vector4 start = a;
+		const Vector4 delta = { b.x - a.x, b.y - a.y, b.z - a.z, b.w - a.w };
+		a = { start.x + delta.x * tStart, start.y + delta.y * tStart, start.z + delta.z * tStart, start.w + delta.w * tStart };
+		b = { start.x + delta.x * tEnd, start.y + delta.y * tEnd, start.z + delta.z * tEnd, start.w + delta.w * tEnd };
+		return true;
+	}
+}
+
+void GridRenderer::SetSettings(const GridSettings& settings)
+{
+	settings_ = settings;
+	cacheValid_ = false;
+}
+
+uint32_t GridRenderer::Draw(const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix)
+{
+	wasRebuilt_ = false;
+	if (!cacheValid_ || !Equals(viewProjectionMatrix, cachedViewProjection_) || !Equals(viewportMatrix, cachedViewport_))
+	{
+		Rebuild(viewProjectionMatrix, viewportMatrix);
+		wasRebuilt_ = true;
+	}
+
+	for (const ScreenLine& line : lines_)
+	{
+		Novice::DrawLine(line.x0, line.y0, line.x1, line.y1, line.color);
+	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, lines_.size());
+	return static_cast<uint32_t>(lines_.size());
+}
+
+void GridRenderer::Rebuild(const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix)
+{
+	cachedViewProjection_ = viewProjectionMatrix;
+	cachedViewport_ = viewportMatrix;
+	cacheValid_ = true;
+	lines_.clear();
+
+	const uint32_t subdivision = std::max(settings_.subdivision, 1u);
+	const float halfWidth = settings_.halfWidth;
+	const float spacing = halfWidth * 2.0f / static_cast<float>(subdivision);
+	const Vector3ex& center = settings_.center;
+
+	// 線の端点は外周の格子点だけなので、4辺の点を1回ずつクリップ座標へ変換する
+	// 辺0: z = -halfWidth、辺1: z = +halfWidth（xが一定の線の両端）
+	// 辺2: x = -halfWidth、辺3: x = +halfWidth（zが一定の線の両端）
+	const uint32_t pointCount = subdivision + 1;
+	edgePoints_.resize(static_cast<size_t>(pointCount) * 4);
+	Vector4* edges[4] = { edgePoints_.data(), edgePoints_.data() + pointCount, edgePoints_.data() + pointCount * 2, edgePoints_.data() + pointCount * 3 };
+	for (uint32_t index = 0; index < pointCount; ++index)
+	{
+		const float offset = -halfWidth + spacing * static_cast<float>(index);
+		edges[0][index] = Func.Multiply(Vector4{ center.x + offset, center.y, center.z - halfWidth, 1.0f }, viewProjectionMatrix);
+		edges[1][index] = Func.Multiply(Vector4{ center.x + offset, center.y, center.z + halfWidth, 1.0f }, viewProjectionMatrix);
+		edges[2][index] = Func.Multiply(Vector4{ center.x - halfWidth, center.y, center.z + offset, 1.0f }, viewProjectionMatrix);
+		edges[3][index] = Func.Multiply(Vector4{ center.x + halfWidth, center.y, center.z + offset, 1.0f }, viewProjectionMatrix);
+	}
+
+	// 線の種類（0: 副線、1: 主線、2: 中心の線）
+	// 分割数が偶数なら中心から数えて、奇数なら端から数えてmajorEvery本ごとに主線にする
+	auto classify = [&](uint32_t index) {
+		if (index * 2 == subdivision)
+		{
+			return 2;
+		}
+		if (settings_.majorEvery == 0)
+		{
+			return 0;
+		}
+		uint32_t count = index;
+		if (subdivision % 2 == 0)
+		{
+			count = index * 2 > subdivision ? index - subdivision / 2 : subdivision / 2 - index;
+		}
+		return count % settings_.majorEvery == 0 ? 1 : 0;
+	};
+
+	// 主線と中心の線が副線に隠れないように、副線、主線、中心の線の順に並べる
+	const uint32_t colors[3] = { settings_.minorColor, settings_.majorColor, settings_.axisColor };
+
+	for (int pass = 0; pass < 3; ++pass)
+	{
+		for (uint32_t index = 0; index < pointCount; ++index)
+		{
+			if (classify(index) != pass)
+			{
+				continue;
+			}
+			for (int direction = 0; direction < 2; ++direction)
+			{
+				Vector4 start = edges[direction * 2][index];
+				Vector4 end = edges[direction * 2 + 1][index];
+				if (!ClipSegment(start, end))
+				{
+					continue;
+				}
+				const float startW = std::max(start.w, kMinW);
+				const float endW = std::max(end.w, kMinW);
+				const Vector3ex screenStart = Func.Transform({ start.x / startW, start.y / startW, start.z / startW }, viewportMatrix);
+				const Vector3ex screenEnd = Func.Transform({ end.x / endW, end.y / endW, end.z / endW }, viewportMatrix);
+				lines_.push_back({ static_cast<int>(screenStart.x), static_cast<int>(screenStart.y), static_cast<int>(screenEnd.x), static_cast<int>(screenEnd.y), colors[pass] });
+			}
+		}
+	}
+}
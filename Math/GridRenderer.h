@@ -0,0 +1,82 @@
+#pragma once
+#include "Matrix4x4ex.h"
+#include "Vector3ex.h"
+#include "Vector4.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// y = 0の平面に引くグリッドの設定
+/// </summary>
+struct GridSettings final
+{
+	Vector3ex center = { 0.0f, 0.0f, 0.0f };	// グリッドの中心（yは平面の高さ）
+	float halfWidth = 2.0f;						// 中心から端までの長さ
+	uint32_t subdivision = 10;					// 1辺の分割数
+	uint32_t majorEvery = 5;					// この本数ごとに主線にする（0なら主線なし）
+	uint32_t minorColor = 0x6F6F6FFF;			// 副線の色
+	uint32_t majorColor = 0x9F9F9FFF;			// 主線の色
+	uint32_t axisColor = 0xDFDFDFFF;			// 中心を通る線の色
+};
+
+/// <summary>
+/// グリッドを描画するクラス
+/// 格子の端点を1回ずつクリップ座標へ変換し、視錐台でクリップした線をスクリーン座標で覚えておく
+/// カメラ（行列）と設定が変わらない間は覚えた線をそのまま描く
+/// </summary>
+class GridRenderer final
+{
+public:
+	GridRenderer() = default;
+	explicit GridRenderer(const GridSettings& settings) : settings_(settings) {}
+
+	/// <summary>
+	/// 設定を変える（次のDrawで線を作り直す）
+	/// </summary>
+	void SetSettings(const GridSettings& settings);
+	const GridSettings& GetSettings() const { return settings_; }
+
+	/// <summary>
+	/// グリッドを描画する
+	/// </summary>
+	/// <param name="viewProjectionMatrix">ビュー射影行列</param>
+	/// <param name="viewportMatrix">ビューポート行列</param>
+	/// <returns>描いた線の数</returns>
+	uint32_t Draw(const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix);
+
+	/// <summary>
+	/// 直前のDrawで線を作り直したか
+	/// </summary>
+	bool WasRebuilt() const { return wasRebuilt_; }
+	/// <summary>
+	/// 覚えている線の数（視錐台の外の線は含まない）
+	/// </summary>
+	size_t GetLineCount() const { return lines_.size(); }
+
+private:
+	/// <summary>
+	/// スクリーン座標の線
+	/// </summary>
+	struct ScreenLine
+	{
+		int x0;
+		int y0;
+		int x1;
+		int y1;
+		uint32_t color;
+	};
+
+	/// <summary>
+	/// 格子を変換・クリップして線を作り直す
+	/// </summary>
+	void Rebuild(const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix);
+
+	GridSettings settings_;
+	std::vector<ScreenLine> lines_;
+	std::vector<Vector4> edgePoints_;	// 外周の格子点のクリップ座標（作り直す時の作業領域）
+	Matrix4x4ex cachedViewProjection_{};
+	Matrix4x4ex cachedViewport_{};
+	bool cacheValid_ = false;
+	bool wasRebuilt_ = false;
+};
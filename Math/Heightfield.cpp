@@ -0,0 +1,432 @@
+#include "Heightfield.h"
+#include "MathFunction.h"
+#include "SimdFloat.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	MathFunction Func;
+
+	/// <summary>
+	/// 高さの傾きから上向きの法線を作る
+	/// </summary>
+	Vector3ex NormalFromSlope(float slopeX, float slopeZ)
+	{
+		return Func.Normalize({ -slopeX, 1.0f, -slopeZ });
+	}
+}
+
+Heightfield::Heightfield(uint32_t sampleCountX, uint32_t sampleCountZ, float cellSize, const Vector3ex& origin)
+	: sampleCountX_(sampleCountX), sampleCountZ_(sampleCountZ), cellSize_(cellSize), inverseCellSize_(1.0f / cellSize), origin_(origin)
+{
+	assert(sampleCountX >= 2 && sampleCountZ >= 2 && cellSize > 0.0f);
+	heights_.assign(static_cast<size_t>(sampleCountX_) * sampleCountZ_, 0.0f);
+	blockCountX_ = (sampleCountX_ - 1 + kBlockCells - 1) / kBlockCells;
+	blockCountZ_ = (sampleCountZ_ - 1 + kBlockCells - 1) / kBlockCells;
+	blockMin_.assign(static_cast<size_t>(blockCountX_) * blockCountZ_, 0.0f);
+	blockMax_.assign(static_cast<size_t>(blockCountX_) * blockCountZ_, 0.0f);
+}
+
+void Heightfield::SetHeight(uint32_t ix, uint32_t iz, float height)
+{
+	heights_[static_cast<size_t>(iz) * sampleCountX_ + ix] = height;
+	minHeight_ = std::min(minHeight_, height);
+	maxHeight_ = std::max(maxHeight_, height);
+
+	// ブロックの境界上の格子点は隣のブロックにも含まれる
+	const uint32_t blockX = std::min(ix / kBlockCells, blockCountX_ - 1);
+	const uint32_t blockZ = std::min(iz / kBlockCells, blockCountZ_ - 1);
+	const uint32_t firstX = ix % kBlockCells == 0 && blockX > 0 && ix / kBlockCells == blockX ? blockX - 1 : blockX;
+	const uint32_t firstZ = iz % kBlockCells == 0 && blockZ > 0 && iz / kBlockCells == blockZ ? blockZ - 1 : blockZ;
+	for (uint32_t bz = firstZ; bz <= blockZ; ++bz)
+	{
+		for (uint32_t bx = firstX; bx <= blockX; ++bx)
+		{
+			const size_t block = static_cast<size_t>(bz) * blockCountX_ + bx;
+			blockMin_[block] = std::min(blockMin_[block], height);
+			blockMax_[block] = std::max(blockMax_[block], height);
+		}
+	}
+
+	// この格子点を角に持つセル（最大4つ）の傾き
+	float steepest = 0.0f;
+	for (uint32_t cz = iz > 0 ? iz - 1 : 0; cz <= std::min(iz, sampleCountZ_ - 2); ++cz)
+	{
+		for (uint32_t cx = ix > 0 ? ix - 1 : 0; cx <= std::min(ix, sampleCountX_ - 2); ++cx)
+		{
+			steepest = std::max(steepest, GetCellSlopeSquared(cx, cz));
+		}
+	}
+	maxSlope_ = std::max(maxSlope_, std::sqrt(steepest) * inverseCellSize_);
+}
+
+void Heightfield::SetHeights(const float* heights)
+{
+	std::copy(heights, heights + heights_.size(), heights_.begin());
+	RebuildBlockBounds();
+}
+
+void Heightfield::RebuildBlockBounds()
+{
+	minHeight_ = heights_[0];
+	maxHeight_ = heights_[0];
+	for (uint32_t bz = 0; bz < blockCountZ_; ++bz)
+	{
+		for (uint32_t bx = 0; bx < blockCountX_; ++bx)
+		{
+			const uint32_t x0 = bx * kBlockCells;
+			const uint32_t z0 = bz * kBlockCells;
+			const uint32_t x1 = std::min(x0 + kBlockCells, sampleCountX_ - 1);
+			const uint32_t z1 = std::min(z0 + kBlockCells, sampleCountZ_ - 1);
+			float low = GetHeight(x0, z0);
+			float high = low;
+			for (uint32_t iz = z0; iz <= z1; ++iz)
+			{
+				const float* row = heights_.data() + static_cast<size_t>(iz) * sampleCountX_;
+				for (uint32_t ix = x0; ix <= x1; ++ix)
+				{
+					low = std::min(low, row[ix]);
+					high = std::max(high, row[ix]);
+				}
+			}
+			const size_t block = static_cast<size_t>(bz) * blockCountX_ + bx;
+			blockMin_[block] = low;
+			blockMax_[block] = high;
+			minHeight_ = std::min(minHeight_, low);
+			maxHeight_ = std::max(maxHeight_, high);
+		}
+	}
+
+	float steepest = 0.0f;
+	for (uint32_t iz = 0; iz + 1 < sampleCountZ_; ++iz)
+	{
+		for (uint32_t ix = 0; ix + 1 < sampleCountX_; ++ix)
+		{
+			steepest = std::max(steepest, GetCellSlopeSquared(ix, iz));
+		}
+	}
+	maxSlope_ = std::sqrt(steepest) * inverseCellSize_;
+}
+
+float Heightfield::GetCellSlopeSquared(uint32_t ix, uint32_t iz) const
+{
+	const float h00 = GetHeight(ix, iz);
+	const float h10 = GetHeight(ix + 1, iz);
+	const float h01 = GetHeight(ix, iz + 1);
+	const float h11 = GetHeight(ix + 1, iz + 1);
+	const float lowerX = h10 - h00;
+	const float lowerZ = h11 - h10;
+	const float upperX = h11 - h01;
+	const float upperZ = h01 - h00;
+	return std::max(lowerX * lowerX + lowerZ * lowerZ, upperX * upperX + upperZ * upperZ);
+}
+
+Vector3ex Heightfield::GetSamplePosition(uint32_t ix, uint32_t iz) const
+{
+	return { origin_.x + static_cast<float>(ix) * cellSize_, origin_.y + GetHeight(ix, iz), origin_.z + static_cast<float>(iz) * cellSize_ };
+}
+
+bool Heightfield::SampleHeight(float x, float z, float& height) const
+{
+	const float fx = (x - origin_.x) * inverseCellSize_;
+	const float fz = (z - origin_.z) * inverseCellSize_;
+	if (!(fx >= 0.0f && fz >= 0.0f && fx <= static_cast<float>(sampleCountX_ - 1) && fz <= static_cast<float>(sampleCountZ_ - 1)))
+	{
+		return false;
+	}
+
+	// 右端と奥端は1つ手前のセルに含める
+	const uint32_t ix = std::min(static_cast<uint32_t>(fx), sampleCountX_ - 2);
+	const uint32_t iz = std::min(static_cast<uint32_t>(fz), sampleCountZ_ - 2);
+	const float u = fx - static_cast<float>(ix);
+	const float v = fz - static_cast<float>(iz);
+	const float h00 = GetHeight(ix, iz);
+	const float h10 = GetHeight(ix + 1, iz);
+	const float h01 = GetHeight(ix, iz + 1);
+	const float h11 = GetHeight(ix + 1, iz + 1);
+	if (u >= v)
+	{
+		// (00, 10, 11)の三角形
+		height = origin_.y + h00 + (h10 - h00) * u + (h11 - h10) * v;
+	}
+	else
+	{
+		// (00, 11, 01)の三角形
+		height = origin_.y + h00 + (h11 - h01) * u + (h01 - h00) * v;
+	}
+	return true;
+}
+
+Vector3ex Heightfield::SampleNormal(float x, float z) const
+{
+	const float fx = (x - origin_.x) * inverseCellSize_;
+	const float fz = (z - origin_.z) * inverseCellSize_;
+	if (!(fx >= 0.0f && fz >= 0.0f && fx <= static_cast<float>(sampleCountX_ - 1) && fz <= static_cast<float>(sampleCountZ_ - 1)))
+	{
+		return { 0.0f, 1.0f, 0.0f };
+	}
+
+	const uint32_t ix = std::min(static_cast<uint32_t>(fx), sampleCountX_ - 2);
+	const uint32_t iz = std::min(static_cast<uint32_t>(fz), sampleCountZ_ - 2);
+	const float h00 = GetHeight(ix, iz);
+	const float h10 = GetHeight(ix + 1, iz);
+	const float h01 = GetHeight(ix, iz + 1);
+	const float h11 = GetHeight(ix + 1, iz + 1);
+	if (fx - static_cast<float>(ix) >= fz - static_cast<float>(iz))
+	{
+		return NormalFromSlope((h10 - h00) * inverseCellSize_, (h11 - h10) * inverseCellSize_);
+	}
+	return NormalFromSlope((h11 - h01) * inverseCellSize_, (h01 - h00) * inverseCellSize_);
+}
+
+bool Heightfield::Collide(const Vector3ex& center, float radius, Vector3ex& normal, float& depth) const
+{
+	// 地形全体より上にあれば調べない
+	if (center.y - radius > origin_.y + maxHeight_)
+	{
+		return false;
+	}
+
+	// 中心が地面より下なら、中心を含む三角形の面から押し出す（最も深い場合）
+	float surface = 0.0f;
+	if (SampleHeight(center.x, center.z, surface) && center.y < surface)
+	{
+		normal = SampleNormal(center.x, center.z);
+		depth = radius + (surface - center.y) * normal.y;
+		return true;
+	}
+
+	const float localX = (center.x - origin_.x) * inverseCellSize_;
+	const float localZ = (center.z - origin_.z) * inverseCellSize_;
+	const float bottom = center.y - radius - origin_.y;
+	const float height = center.y - origin_.y;
+	const float inverseCellSquared = inverseCellSize_ * inverseCellSize_;
+	float bestDistanceSquared = radius * radius;
+	Vector3ex bestDelta{};
+	Vector3ex bestFaceNormal{};
+	bool hit = false;
+
+	// セルの2つの三角形と比べ、今の最短より近ければ置き換える
+	auto testCell = [&](uint32_t ix, uint32_t iz) {
+		const float h00 = GetHeight(ix, iz);
+		const float h10 = GetHeight(ix + 1, iz);
+		const float h01 = GetHeight(ix, iz + 1);
+		const float h11 = GetHeight(ix + 1, iz + 1);
+		if (bottom > std::max(std::max(h00, h10), std::max(h01, h11)))
+		{
+			return;
+		}
+
+		const Vector3ex p00 = GetSamplePosition(ix, iz);
+		const Vector3ex p10 = GetSamplePosition(ix + 1, iz);
+		const Vector3ex p01 = GetSamplePosition(ix, iz + 1);
+		const Vector3ex p11 = GetSamplePosition(ix + 1, iz + 1);
+		const Triangle triangles[2] = { { p00, p10, p11 }, { p00, p11, p01 } };
+		const float riseX[2] = { h10 - h00, h11 - h01 };
+		const float riseZ[2] = { h11 - h10, h01 - h00 };
+		const float u = localX - static_cast<float>(ix);
+		const float v = localZ - static_cast<float>(iz);
+		for (int t = 0; t < 2; ++t)
+		{
+			// 三角形までの距離は面を延ばした平面までの距離以上なので、平面が今の最短より遠ければ最近点を求めない
+			const float gap = height - (h00 + riseX[t] * u + riseZ[t] * v);
+			const float slopeSquared = (riseX[t] * riseX[t] + riseZ[t] * riseZ[t]) * inverseCellSquared;
+			if (gap * gap >= bestDistanceSquared * (1.0f + slopeSquared))
+			{
+				continue;
+			}
+
+			const Vector3ex closest = Func.ClosestPoint(center, triangles[t]);
+			const Vector3ex delta = center - closest;
+			const float distanceSquared = Func.Dot(delta, delta);
+			if (distanceSquared < bestDistanceSquared)
+			{
+				bestDistanceSquared = distanceSquared;
+				bestDelta = delta;
+				bestFaceNormal = NormalFromSlope(riseX[t] * inverseCellSize_, riseZ[t] * inverseCellSize_);
+				hit = true;
+			}
+		}
+	};
+
+	// 中心の真下のセルを先に調べ、見つかった最短距離まで足元を狭める
+	// （水平に最短距離より離れた三角形は、それより近くならない）
+	const float maxCellX = static_cast<float>(sampleCountX_ - 2);
+	const float maxCellZ = static_cast<float>(sampleCountZ_ - 2);
+	uint32_t centerX = UINT32_MAX;
+	uint32_t centerZ = UINT32_MAX;
+	if (localX >= 0.0f && localZ >= 0.0f && localX <= maxCellX + 1.0f && localZ <= maxCellZ + 1.0f)
+	{
+		centerX = std::min(static_cast<uint32_t>(localX), sampleCountX_ - 2);
+		centerZ = std::min(static_cast<uint32_t>(localZ), sampleCountZ_ - 2);
+		testCell(centerX, centerZ);
+	}
+	const float reach = hit ? std::sqrt(bestDistanceSquared) : radius;
+
+	// 足元（xz平面に投影した正方形）にかかるセルだけを調べる
+	const float fx0 = std::floor((center.x - reach - origin_.x) * inverseCellSize_);
+	const float fz0 = std::floor((center.z - reach - origin_.z) * inverseCellSize_);
+	const float fx1 = std::floor((center.x + reach - origin_.x) * inverseCellSize_);
+	const float fz1 = std::floor((center.z + reach - origin_.z) * inverseCellSize_);
+	if (fx1 >= 0.0f && fz1 >= 0.0f && fx0 <= maxCellX && fz0 <= maxCellZ)
+	{
+		const uint32_t ix0 = static_cast<uint32_t>(std::max(fx0, 0.0f));
+		const uint32_t iz0 = static_cast<uint32_t>(std::max(fz0, 0.0f));
+		const uint32_t ix1 = static_cast<uint32_t>(std::min(fx1, maxCellX));
+		const uint32_t iz1 = static_cast<uint32_t>(std::min(fz1, maxCellZ));
+		for (uint32_t iz = iz0; iz <= iz1; ++iz)
+		{
+			for (uint32_t ix = ix0; ix <= ix1; ++ix)
+			{
+				if (ix != centerX || iz != centerZ)
+				{
+					testCell(ix, iz);
+				}
+			}
+		}
+	}
+	if (!hit)
+	{
+		return false;
+	}
+
+	// 中心が面のすぐ上にある時は、差の向きが不安定なので面の法線を使う
+	const float distance = std::sqrt(bestDistanceSquared);
+	normal = distance > radius * 1e-4f ? bestDelta / distance : bestFaceNormal;
+	depth = radius - distance;
+	return true;
+}
+
+size_t Heightfield::CollideBatch(const BallSoA& balls, std::vector<Contact>& contacts) const
+{
+	const size_t before = contacts.size();
+	const size_t count = balls.GetCount();
+	const size_t simdCount = count - count % Float8::kWidth;
+
+	const Float8 originX = Float8::Set1(origin_.x);
+	const Float8 originY = Float8::Set1(origin_.y);
+	const Float8 originZ = Float8::Set1(origin_.z);
+	const Float8 inverseCell = Float8::Set1(inverseCellSize_);
+	const Float8 zero = Float8::Zero();
+	const Float8 one = Float8::Set1(1.0f);
+	const Float8 maxX = Float8::Set1(static_cast<float>(sampleCountX_ - 1));
+	const Float8 maxZ = Float8::Set1(static_cast<float>(sampleCountZ_ - 1));
+	const Float8 maxCellX = Float8::Set1(static_cast<float>(sampleCountX_ - 2));
+	const Float8 maxCellZ = Float8::Set1(static_cast<float>(sampleCountZ_ - 2));
+	const Float8 top = Float8::Set1(origin_.y + maxHeight_);
+	const Float8 slope = Float8::Set1(maxSlope_);
+
+	alignas(32) int32_t cellX[8];
+	alignas(32) int32_t cellZ[8];
+	alignas(32) float corners[4][8];
+	alignas(32) float normalX[8];
+	alignas(32) float normalY[8];
+	alignas(32) float normalZ[8];
+	alignas(32) float depths[8];
+	for (size_t i = 0; i < simdCount; i += Float8::kWidth)
+	{
+		// 地形より上のボールは配列を読むだけで除外する
+		const Float8 y = Float8::Load(balls.positionY.data() + i);
+		const Float8 radius = Float8::Load(balls.radius.data() + i);
+		const int candidateMask = (y - radius <= top).MoveMask();
+		if (candidateMask == 0)
+		{
+			continue;
+		}
+
+		// 中心を含むセルの4つの高さを集める（範囲外は端のセルを読み、Collideに回す）
+		const Float8 gx = (Float8::Load(balls.positionX.data() + i) - originX) * inverseCell;
+		const Float8 gz = (Float8::Load(balls.positionZ.data() + i) - originZ) * inverseCell;
+		const int insideMask = ((gx >= zero) & (gz >= zero) & (gx <= maxX) & (gz <= maxZ)).MoveMask();
+		const Float8 cx = Min(Max(gx, zero), maxX);
+		const Float8 cz = Min(Max(gz, zero), maxZ);
+		const Float8 fx = Min(ToFloat(TruncateToInt(cx)), maxCellX);
+		const Float8 fz = Min(ToFloat(TruncateToInt(cz)), maxCellZ);
+		TruncateToInt(fx).Store(cellX);
+		TruncateToInt(fz).Store(cellZ);
+		for (int lane = 0; lane < Float8::kWidth; ++lane)
+		{
+			const float* row = heights_.data() + static_cast<size_t>(cellZ[lane]) * sampleCountX_ + cellX[lane];
+			corners[0][lane] = row[0];
+			corners[1][lane] = row[1];
+			corners[2][lane] = row[sampleCountX_];
+			corners[3][lane] = row[sampleCountX_ + 1];
+		}
+		const Float8 h00 = Float8::LoadAligned(corners[0]);
+		const Float8 h10 = Float8::LoadAligned(corners[1]);
+		const Float8 h01 = Float8::LoadAligned(corners[2]);
+		const Float8 h11 = Float8::LoadAligned(corners[3]);
+
+		// SampleHeightとSampleNormalと同じ三角形の分け方で、中心の真下の高さと面の法線を求める
+		const Float8 u = cx - fx;
+		const Float8 v = cz - fz;
+		const Float8 lower = u >= v;
+		const Float8 riseX = Select(lower, h10 - h00, h11 - h01);
+		const Float8 riseZ = Select(lower, h11 - h10, h01 - h00);
+		const Float8 surface = originY + h00 + riseX * u + riseZ * v;
+		const Float8 slopeX = riseX * inverseCell;
+		const Float8 slopeZ = riseZ * inverseCell;
+		const Float8 inverseLength = one / Sqrt(slopeX * slopeX + slopeZ * slopeZ + one);
+
+		// 中心が地面より下なら、Collideと同じくその面から押し出す
+		// 足元の地面は中心の真下より一番急な傾き×半径までしか高くならないので、それより上なら当たらない
+		const int deepMask = candidateMask & insideMask & (y < surface).MoveMask();
+		const int clearMask = insideMask & (y - radius > surface + slope * radius).MoveMask();
+		const int nearMask = candidateMask & ~(deepMask | clearMask);
+		if (deepMask != 0)
+		{
+			(-slopeX * inverseLength).StoreAligned(normalX);
+			inverseLength.StoreAligned(normalY);
+			(-slopeZ * inverseLength).StoreAligned(normalZ);
+			(radius + (surface - y) * inverseLength).StoreAligned(depths);
+		}
+		for (int lane = 0; lane < Float8::kWidth; ++lane)
+		{
+			if ((deepMask >> lane) & 1)
+			{
+				contacts.push_back({ static_cast<uint32_t>(i + lane), 0, ContactTarget::Heightfield,
+					{ normalX[lane], normalY[lane], normalZ[lane] }, depths[lane] });
+				continue;
+			}
+			if (((nearMask >> lane) & 1) == 0)
+			{
+				continue;
+			}
+
+			// 地面の近くだけ、足元のセルの三角形との最近点を調べる
+			const size_t index = i + lane;
+			Vector3ex normal;
+			float depth = 0.0f;
+			if (Collide(balls.GetPosition(index), balls.radius[index], normal, depth))
+			{
+				contacts.push_back({ static_cast<uint32_t>(index), 0, ContactTarget::Heightfield, normal, depth });
+			}
+		}
+	}
+	for (size_t i = simdCount; i < count; ++i)
+	{
+		Vector3ex normal;
+		float depth = 0.0f;
+		if (Collide(balls.GetPosition(i), balls.radius[i], normal, depth))
+		{
+			contacts.push_back({ static_cast<uint32_t>(i), 0, ContactTarget::Heightfield, normal, depth });
+		}
+	}
+	return contacts.size() - before;
+}
+
+AABB Heightfield::GetBlockBounds(uint32_t blockX, uint32_t blockZ) const
+{
+	const uint32_t x0 = blockX * kBlockCells;
+	const uint32_t z0 = blockZ * kBlockCells;
+	const uint32_t x1 = std::min(x0 + kBlockCells, sampleCountX_ - 1);
+	const uint32_t z1 = std::min(z0 + kBlockCells, sampleCountZ_ - 1);
+	const size_t block = static_cast<size_t>(blockZ) * blockCountX_ + blockX;
+	return
+	{
+		{ origin_.x + static_cast<float>(x0) * cellSize_, origin_.y + blockMin_[block], origin_.z + static_cast<float>(z0) * cellSize_ },
+		{ origin_.x + static_cast<float>(x1) * cellSize_, origin_.y + blockMax_[block], origin_.z + static_cast<float>(z1) * cellSize_ },
+	};
+}
@@ -0,0 +1,108 @@
+#pragma once
+#include "AABB.h"
+#include "BallSoA.h"
+#include "Contact.h"
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 等間隔の格子に高さを持つ地形
+/// 格子点(ix, iz)のワールド座標は origin + (ix * cellSize, height, iz * cellSize)
+/// 各セルは(ix, iz)から(ix+1, iz+1)への対角線で2つの三角形に分ける
+/// </summary>
+class Heightfield final
+{
+public:
+	static constexpr uint32_t kBlockCells = 32;	// 描画の視錐台カリングと高さの範囲をまとめる単位（セル数）
+
+	/// <summary>
+	/// 高さ0の地形を作る
+	/// </summary>
+	/// <param name="sampleCountX">x方向の格子点の数（2以上）</param>
+	/// <param name="sampleCountZ">z方向の格子点の数（2以上）</param>
+	/// <param name="cellSize">格子の間隔</param>
+	/// <param name="origin">格子点(0, 0)の位置（yは高さの基準）</param>
+	Heightfield(uint32_t sampleCountX, uint32_t sampleCountZ, float cellSize, const Vector3ex& origin = {});
+
+	/// <summary>
+	/// 格子点の高さを変える（ブロックの高さの範囲は広げるだけなので、下げた時は保守的になる）
+	/// </summary>
+	void SetHeight(uint32_t ix, uint32_t iz, float height);
+	float GetHeight(uint32_t ix, uint32_t iz) const { return heights_[static_cast<size_t>(iz) * sampleCountX_ + ix]; }
+	/// <summary>
+	/// 高さをまとめて書き換える（z行ごとにsampleCountX個並べた配列）
+	/// </summary>
+	void SetHeights(const float* heights);
+	const float* GetHeights() const { return heights_.data(); }
+
+	/// <summary>
+	/// 地形の上の高さ（範囲外ならfalse）
+	/// </summary>
+	bool SampleHeight(float x, float z, float& height) const;
+	/// <summary>
+	/// (x, z)を含む三角形の法線（範囲外なら真上）
+	/// </summary>
+	Vector3ex SampleNormal(float x, float z) const;
+
+	/// <summary>
+	/// 球との接触を調べる（球の真下のセルだけを見るので、地形の大きさによらない）
+	/// </summary>
+	/// <param name="center">球の中心</param>
+	/// <param name="radius">球の半径</param>
+	/// <param name="normal">接触法線（地形から球へ向く）</param>
+	/// <param name="depth">めり込み量</param>
+	/// <returns>接触していればtrue</returns>
+	bool Collide(const Vector3ex& center, float radius, Vector3ex& normal, float& depth) const;
+	/// <summary>
+	/// ボールをまとめて調べ、接触したものをcontactsに追加する（bodyIndexはballsの番号）
+	/// 8個ずつ中心の真下の高さを求め、中心が地面より下のものはその面で押し出し、
+	/// 一番急な傾きで見積もった足元の高さより上のものは除外する。残った地面の近くのものだけCollideで調べる
+	/// </summary>
+	/// <returns>接触の数</returns>
+	size_t CollideBatch(const BallSoA& balls, std::vector<Contact>& contacts) const;
+
+	/// <summary>
+	/// ブロックの範囲（描画のカリング用）
+	/// </summary>
+	AABB GetBlockBounds(uint32_t blockX, uint32_t blockZ) const;
+	uint32_t GetBlockCountX() const { return blockCountX_; }
+	uint32_t GetBlockCountZ() const { return blockCountZ_; }
+
+	uint32_t GetSampleCountX() const { return sampleCountX_; }
+	uint32_t GetSampleCountZ() const { return sampleCountZ_; }
+	float GetCellSize() const { return cellSize_; }
+	const Vector3ex& GetOrigin() const { return origin_; }
+	float GetMinHeight() const { return minHeight_; }
+	float GetMaxHeight() const { return maxHeight_; }
+
+private:
+	/// <summary>
+	/// 格子点のワールド座標
+	/// </summary>
+	Vector3ex GetSamplePosition(uint32_t ix, uint32_t iz) const;
+	/// <summary>
+	/// 全ブロックの高さの範囲と、一番急な傾きを計算し直す
+	/// </summary>
+	void RebuildBlockBounds();
+	/// <summary>
+	/// セルの2つの三角形のうち急な方の、高さの差の2乗（xとzの差を足したもの）
+	/// </summary>
+	float GetCellSlopeSquared(uint32_t ix, uint32_t iz) const;
+
+	uint32_t sampleCountX_;
+	uint32_t sampleCountZ_;
+	float cellSize_;
+	float inverseCellSize_;
+	Vector3ex origin_;
+	std::vector<float> heights_;
+
+	uint32_t blockCountX_;
+	uint32_t blockCountZ_;
+	std::vector<float> blockMin_;	// ブロックごとの最低の高さ
+	std::vector<float> blockMax_;	// ブロックごとの最高の高さ
+	float minHeight_ = 0.0f;
+	float maxHeight_ = 0.0f;
+	float maxSlope_ = 0.0f;	// 一番急な三角形の傾き（水平に1進んだ時の高さの変化。SetHeightでは大きくするだけ）
+};
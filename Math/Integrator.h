@@ -0,0 +1,217 @@
+#pragma once
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+
+/*----------時間積分----------*/
+// 積分法はポリシー（Stepを持つ構造体）で選び、テンプレート引数で渡すのでループの中で分岐しない
+// 加速度はaccelerationFunction(番号, 位置, 速度)で求める（ステップの途中の位置と速度でも呼ばれる）
+// 他のボールに依存する力は、ステップの最初の状態で求めたものを使うこと
+// kCachesAccelerationの積分法は、加速度の配列を渡すIntegrateで前のステップの最後の加速度を使い回せる（求める回数が1回減る）
+
+/// <summary>
+/// 積分法の種類（実行時に選ぶ時に使う）
+/// </summary>
+enum class IntegratorType : uint32_t
+{
+	SemiImplicitEuler,	// 半陰的オイラー法（1次、シンプレクティック）
+	VelocityVerlet,		// 速度ベルレ法（2次、シンプレクティック）
+	PositionVerlet,		// 位置ベルレ法（2次、シンプレクティック）
+	RungeKutta4,		// 4次のルンゲ・クッタ法（4次、エネルギーは少しずつ減る）
+	Count,
+};
+
+/// <summary>
+/// 半陰的オイラー法（速度を進めてから、新しい速度で位置を進める）
+/// </summary>
+struct SemiImplicitEuler final
+{
+	static constexpr IntegratorType kType = IntegratorType::SemiImplicitEuler;
+	static constexpr const char* kName = "SemiImplicitEuler";
+	static constexpr uint32_t kEvaluations = 1;	// 1ステップで加速度を求める回数
+	static constexpr bool kCachesAcceleration = false;	// 最後に求めた加速度を次のステップで使えるか
+
+	template<class AccelerationFunction>
+	static void Step(uint32_t index, Vector3ex& position, Vector3ex& velocity, float deltaTime, const AccelerationFunction& accelerationFunction)
+	{
+		velocity += accelerationFunction(index, position, velocity) * deltaTime;
+		position += velocity * deltaTime;
+	}
+};
+
+/// <summary>
+/// 速度ベルレ法（速度を半分進め、位置を進め、新しい位置の加速度で残りの速度を進める）
+/// 始めの加速度は前のステップの終わりの加速度と同じなので、覚えておけば1ステップ1回で済む
+/// 覚えない版は2回求めるので、同じステップ幅なら半陰的オイラー法の2倍の計算になる
+/// </summary>
+struct VelocityVerlet final
+{
+	static constexpr IntegratorType kType = IntegratorType::VelocityVerlet;
+	static constexpr const char* kName = "VelocityVerlet";
+	static constexpr uint32_t kEvaluations = 2;
+	static constexpr bool kCachesAcceleration = true;
+
+	template<class AccelerationFunction>
+	static void Step(uint32_t index, Vector3ex& position, Vector3ex& velocity, float deltaTime, const AccelerationFunction& accelerationFunction)
+	{
+		const float halfTime = deltaTime * 0.5f;
+		velocity += accelerationFunction(index, position, velocity) * halfTime;
+		position += velocity * deltaTime;
+		velocity += accelerationFunction(index, position, velocity) * halfTime;
+	}
+
+	/// <summary>
+	/// 覚えておいた加速度で始め、新しい位置で求めた加速度に置き換える（加速度を求めるのは1回）
+	/// </summary>
+	/// <param name="acceleration">前のステップの終わりの加速度（終わると今のステップの終わりの加速度になる）</param>
+	template<class AccelerationFunction>
+	static void Step(uint32_t index, Vector3ex& position, Vector3ex& velocity, Vector3ex& acceleration, float deltaTime, const AccelerationFunction& accelerationFunction)
+	{
+		const float halfTime = deltaTime * 0.5f;
+		velocity += acceleration * halfTime;
+		position += velocity * deltaTime;
+		acceleration = accelerationFunction(index, position, velocity);
+		velocity += acceleration * halfTime;
+	}
+};
+
+/// <summary>
+/// 位置ベルレ法（位置を半分進め、その位置の加速度で速度を進め、残りの位置を進める）
+/// </summary>
+struct PositionVerlet final
+{
+	static constexpr IntegratorType kType = IntegratorType::PositionVerlet;
+	static constexpr const char* kName = "PositionVerlet";
+	static constexpr uint32_t kEvaluations = 1;
+	static constexpr bool kCachesAcceleration = false;
+
+	template<class AccelerationFunction>
+	static void Step(uint32_t index, Vector3ex& position, Vector3ex& velocity, float deltaTime, const AccelerationFunction& accelerationFunction)
+	{
+		const float halfTime = deltaTime * 0.5f;
+		position += velocity * halfTime;
+		velocity += accelerationFunction(index, position, velocity) * deltaTime;
+		position += velocity * halfTime;
+	}
+};
+
+/// <summary>
+/// 4次のルンゲ・クッタ法
+/// </summary>
+struct RungeKutta4 final
+{
+	static constexpr IntegratorType kType = IntegratorType::RungeKutta4;
+	static constexpr const char* kName = "RungeKutta4";
+	static constexpr uint32_t kEvaluations = 4;
+	static constexpr bool kCachesAcceleration = false;
+
+	template<class AccelerationFunction>
+	static void Step(uint32_t index, Vector3ex& position, Vector3ex& velocity, float deltaTime, const AccelerationFunction& accelerationFunction)
+	{
+		const float halfTime = deltaTime * 0.5f;
+		const Vector3ex velocity1 = velocity;
+		const Vector3ex acceleration1 = accelerationFunction(index, position, velocity1);
+		const Vector3ex velocity2 = velocity + acceleration1 * halfTime;
+		const Vector3ex acceleration2 = accelerationFunction(index, position + velocity1 * halfTime, velocity2);
+		const Vector3ex velocity3 = velocity + acceleration2 * halfTime;
+		const Vector3ex acceleration3 = accelerationFunction(index, position + velocity2 * halfTime, velocity3);
+		const Vector3ex velocity4 = velocity + acceleration3 * deltaTime;
+		const Vector3ex acceleration4 = accelerationFunction(index, position + velocity3 * deltaTime, velocity4);
+
+		const float sixthTime = deltaTime / 6.0f;
+		position += (velocity1 + (velocity2 + velocity3) * 2.0f + velocity4) * sixthTime;
+		velocity += (acceleration1 + (acceleration2 + acceleration3) * 2.0f + acceleration4) * sixthTime;
+	}
+};
+
+/// <summary>
+/// 位置と速度の配列をまとめて1ステップ進める
+/// </summary>
+/// <typeparam name="Integrator">積分法のポリシー</typeparam>
+/// <param name="positions">位置</param>
+/// <param name="velocities">速度</param>
+/// <param name="count">数</param>
+/// <param name="deltaTime">時間</param>
+/// <param name="accelerationFunction">加速度を返す関数（番号, 位置, 速度）</param>
+template<class Integrator, class AccelerationFunction>
+inline void Integrate(Vector3ex* positions, Vector3ex* velocities, size_t count, float deltaTime, const AccelerationFunction& accelerationFunction)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		Integrator::Step(static_cast<uint32_t>(i), positions[i], velocities[i], deltaTime, accelerationFunction);
+	}
+}
+
+/// <summary>
+/// 加速度を覚えておく配列を渡して、位置と速度の配列をまとめて1ステップ進める
+/// kCachesAccelerationの積分法は加速度を求める回数が1回減り、それ以外はaccelerationsを使わずにIntegrateと同じ計算をする
+/// </summary>
+/// <typeparam name="Integrator">積分法のポリシー</typeparam>
+/// <param name="positions">位置</param>
+/// <param name="velocities">速度</param>
+/// <param name="accelerations">各ボールの前のステップの終わりの加速度（最初はInitializeAccelerationsで求める。位置や速度を外から書き換えたら求め直す）</param>
+/// <param name="count">数</param>
+/// <param name="deltaTime">時間</param>
+/// <param name="accelerationFunction">加速度を返す関数（番号, 位置, 速度）</param>
+template<class Integrator, class AccelerationFunction>
+inline void Integrate(Vector3ex* positions, Vector3ex* velocities, Vector3ex* accelerations, size_t count, float deltaTime, const AccelerationFunction& accelerationFunction)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		if constexpr (Integrator::kCachesAcceleration)
+		{
+			Integrator::Step(static_cast<uint32_t>(i), positions[i], velocities[i], accelerations[i], deltaTime, accelerationFunction);
+		}
+		else
+		{
+			Integrator::Step(static_cast<uint32_t>(i), positions[i], velocities[i], deltaTime, accelerationFunction);
+		}
+	}
+}
+
+/// <summary>
+/// 加速度を覚えておく配列を今の位置と速度で求める
+/// </summary>
+template<class AccelerationFunction>
+inline void InitializeAccelerations(const Vector3ex* positions, const Vector3ex* velocities, Vector3ex* accelerations, size_t count, const AccelerationFunction& accelerationFunction)
+{
+	for (size_t i = 0; i < count; ++i)
+	{
+		accelerations[i] = accelerationFunction(static_cast<uint32_t>(i), positions[i], velocities[i]);
+	}
+}
+
+/// <summary>
+/// 積分法のポリシーを実行時の種類から選んで呼ぶ（分岐は呼び出しごとに1回だけ）
+/// </summary>
+/// <param name="type">積分法の種類</param>
+/// <param name="function">ポリシーの型を受け取る関数（function(SemiImplicitEuler{})のように呼ばれる）</param>
+template<class Function>
+inline void VisitIntegrator(IntegratorType type, Function&& function)
+{
+	switch (type)
+	{
+	case IntegratorType::VelocityVerlet:
+		function(VelocityVerlet{});
+		break;
+	case IntegratorType::PositionVerlet:
+		function(PositionVerlet{});
+		break;
+	case IntegratorType::RungeKutta4:
+		function(RungeKutta4{});
+		break;
+	default:
+		function(SemiImplicitEuler{});
+		break;
+	}
+}
+
+/// <summary>
+/// 積分法の名前
+/// </summary>
+inline const char* GetIntegratorName(IntegratorType type)
+{
+	const char* name = SemiImplicitEuler::kName;
+	VisitIntegrator(type, [&](auto integrator) { name = decltype(integrator)::kName; });
+	return name;
+}
@@ -1,9 +1,9 @@
 #pragma once
-#include "Vector3.h"
+#include "Vector3ex.h"
 
 //直線
 struct Line final
 {
-	Vector3 origin;		//始点
-	Vector3 diff;		//終点からの差分
-};
\ No newline at end of file
+	Vector3ex origin;		//始点
+	Vector3ex diff;		//終点からの差分
+};
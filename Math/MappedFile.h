@@ -0,0 +1,39 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// 読み込み専用のメモリマップドファイル
+/// </summary>
+class MappedFile final
+{
+public:
+	MappedFile() = default;
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	/// <summary>
+	/// ファイルをマップする
+	/// </summary>
+	/// <param name="path">ファイルパス</param>
+	/// <returns>成功したらtrue</returns>
+	bool Open(const char* path);
+	/// <summary>
+	/// マップを解除する
+	/// </summary>
+	void Close();
+
+	const uint8_t* GetData() const { return data_; }
+	size_t GetSize() const { return size_; }
+	bool IsOpen() const { return data_ != nullptr; }
+
+private:
+	const uint8_t* data_ = nullptr;	// 先頭アドレス
+	size_t size_ = 0;				// バイト数
+#ifdef _WIN32
+	void* fileHandle_ = nullptr;	// ファイルハンドル
+	void* mappingHandle_ = nullptr;	// マッピングハンドル
+#endif
+};
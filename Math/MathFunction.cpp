@@ -1,82 +1,97 @@
 #include "MathFunction.h"
+#include "CoreLayout.h"
+#include "FastTrig.h"
+#include "FrameArena.h"
+#include "Gjk.h"
 #include "Novice.h"
+#include "Profiler.h"
+#include "SimdFloat.h"
+
+namespace
+{
+	/// <summary>
+	/// 求めておいたsinとcosから各軸の回転行列を作る
+	/// </summary>
+	Matrix4x4ex MakeRotateXMatrix(float sine, float cosine)
+	{
+		Matrix4x4ex result{};
+		result.m[0][0] = 1.0f;
+		result.m[1][1] = cosine;
+		result.m[1][2] = sine;
+		result.m[2][1] = -sine;
+		result.m[2][2] = cosine;
+		result.m[3][3] = 1.0f;
+		return result;
+	}
+
+	Matrix4x4ex MakeRotateYMatrix(float sine, float cosine)
+	{
+		Matrix4x4ex result{};
+		result.m[0][0] = cosine;
+		result.m[0][2] = -sine;
+		result.m[1][1] = 1.0f;
+		result.m[2][0] = sine;
+		result.m[2][2] = cosine;
+		result.m[3][3] = 1.0f;
+		return result;
+	}
+
+	Matrix4x4ex MakeRotateZMatrix(float sine, float cosine)
+	{
+		Matrix4x4ex result{};
+		result.m[0][0] = cosine;
+		result.m[0][1] = sine;
+		result.m[1][0] = -sine;
+		result.m[1][1] = cosine;
+		result.m[2][2] = 1.0f;
+		result.m[3][3] = 1.0f;
+		return result;
+	}
+}
 
 Vector4 MathFunction::Multiply(const Vector4& v, const Matrix4x4ex& m)
 {
-	Vector4 result{};
-	result.x = v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0] + v.w * m.m[3][0];
-	result.y = v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1] + v.w * m.m[3][1];
-	result.z = v.x * m.m[0][2] + v.y * m.m[1][2] + v.z * m.m[2][2] + v.w * m.m[3][2];
-	result.w = v.x * m.m[0][3] + v.y * m.m[1][3] + v.z * m.m[2][3] + v.w * m.m[3][3];
-	return result;
+	return FromCore<Vector4>(ToCore(v) * ToCore(m));
 }
 
 Vector3ex MathFunction::Add(const Vector3ex& v1, const Vector3ex& v2)
 {
-	return Vector3ex(v1.x + v2.x, v1.y + v2.y, v1.z + v2.z);
+	return FromCore<Vector3ex>(ToCore(v1) + ToCore(v2));
 }
 
 Vector3ex MathFunction::Subtract(const Vector3ex& v1, const Vector3ex& v2)
 {
-	Vector3ex result{};
-	result.x = v1.x - v2.x;
-	result.y = v1.y - v2.y;
-	result.z = v1.z - v2.z;
-	return result;
+	return FromCore<Vector3ex>(ToCore(v1) - ToCore(v2));
 }
 
 Vector3ex MathFunction::Multiply(float scalar, const Vector3ex& v)
 {
-	Vector3ex result{};
-	result.x = scalar * v.x;
-	result.y = scalar * v.y;
-	result.z = scalar * v.z;
-	return result;
+	return FromCore<Vector3ex>(scalar * ToCore(v));
 }
 
 float MathFunction::Dot(const Vector3ex& v1, const Vector3ex& v2)
 {
-	return v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	return ::Dot(ToCore(v1), ToCore(v2));
 }
 
 float MathFunction::Length(const Vector3ex& v)
 {
-	return sqrtf(powf(v.x, 2) + powf(v.y, 2) + powf(v.z, 2));
+	return ::Length(ToCore(v));
 }
 
 Vector3ex MathFunction::Normalize(const Vector3ex& v)
 {
-	float length = Length(v);
-	Vector3ex result{};
-	if (length != 0.0) {
-		result.x = v.x / length;
-		result.y = v.y / length;
-		result.z = v.z / length;
-	}
-	return result;
+	return FromCore<Vector3ex>(::Normalize(ToCore(v)));
 }
 
 Vector3ex MathFunction::Transform(const Vector3ex& vector, const Matrix4x4ex& matrix)
 {
-	Vector3ex result{};
-	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] + 1.0f * matrix.m[3][0];
-	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] + 1.0f * matrix.m[3][1];
-	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] + 1.0f * matrix.m[3][2];
-	float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] + 1.0f * matrix.m[3][3];
-	assert(w != 0.0f);
-	result.x /= w;
-	result.y /= w;
-	result.z /= w;
-	return result;
+	return FromCore<Vector3ex>(TransformPoint(ToCore(vector), ToCore(matrix)));
 }
 
 Vector3ex MathFunction::Cross(const Vector3ex& v1, const Vector3ex& v2)
 {
-	Vector3ex result{};
-	result.x = v1.y * v2.z - v1.z * v2.y;
-	result.y = v1.z * v2.x - v1.x * v2.z;
-	result.z = v1.x * v2.y - v1.y * v2.x;
-	return result;
+	return FromCore<Vector3ex>(::Cross(ToCore(v1), ToCore(v2)));
 }
 
 Vector3ex MathFunction::Project(const Vector3ex& v1, const Vector3ex& v2)
@@ -92,8 +107,10 @@ Vector3ex MathFunction::ClosestPoint(const Vector3ex& point, const Segment& segm
 	// 線分の始点からpointへのベクトル
 	Vector3ex pointToOrigin = Subtract(point, segment.origin);
 
-	// 線分の始点からpointへのベクトルを、線分の方向ベクトルに投影し、線分上の点を求める
-	float t = Dot(pointToOrigin, segmentVec) / Dot(segmentVec, segmentVec);
+	// 線分の始点からpointへのベクトルを、線分の方向ベクトルに投影する（線分の外に出た分は端に寄せる）
+	const float lengthSquared = Dot(segmentVec, segmentVec);
+	float t = lengthSquared > 0.0f ? Dot(pointToOrigin, segmentVec) / lengthSquared : 0.0f;
+	t = std::clamp(t, 0.0f, 1.0f);
 
 	// 線分上の最近接点
 	Vector3ex closestPointOnSegment = Add(segment.origin, Multiply(t, segmentVec));
@@ -101,6 +118,113 @@ Vector3ex MathFunction::ClosestPoint(const Vector3ex& point, const Segment& segm
 	return closestPointOnSegment;
 }
 
+void MathFunction::ClosestPoints(const Segment& segment1, const Segment& segment2, Vector3ex& point1, Vector3ex& point2)
+{
+	// 2つの線分のパラメータs、tを、片方を決めてもう片方を区間に収める順で求める
+	const Vector3ex& d1 = segment1.diff;
+	const Vector3ex& d2 = segment2.diff;
+	const Vector3ex r = Subtract(segment1.origin, segment2.origin);
+	const float a = Dot(d1, d1);
+	const float e = Dot(d2, d2);
+	const float f = Dot(d2, r);
+
+	float s = 0.0f;
+	float t = 0.0f;
+	if (a <= 0.0f && e <= 0.0f)
+	{
+		// どちらも点
+	}
+	else if (a <= 0.0f)
+	{
+		t = std::clamp(f / e, 0.0f, 1.0f);
+	}
+	else
+	{
+		const float c = Dot(d1, r);
+		if (e <= 0.0f)
+		{
+			s = std::clamp(-c / a, 0.0f, 1.0f);
+		}
+		else
+		{
+			const float b = Dot(d1, d2);
+			const float denominator = a * e - b * b;
+			// 平行なら始点側の任意の点でよい
+			s = denominator > 0.0f ? std::clamp((b * f - c * e) / denominator, 0.0f, 1.0f) : 0.0f;
+			t = (b * s + f) / e;
+			// tが区間から出たら端に寄せ、sを求め直す
+			if (t < 0.0f)
+			{
+				t = 0.0f;
+				s = std::clamp(-c / a, 0.0f, 1.0f);
+			}
+			else if (t > 1.0f)
+			{
+				t = 1.0f;
+				s = std::clamp((b - c) / a, 0.0f, 1.0f);
+			}
+		}
+	}
+	point1 = Add(segment1.origin, Multiply(s, d1));
+	point2 = Add(segment2.origin, Multiply(t, d2));
+}
+
+Vector3ex MathFunction::ClosestPoint(const Vector3ex& point, const Triangle& triangle)
+{
+	// 点がどの領域（頂点、辺、面）にあるかを内積で順に調べる
+	const Vector3ex& a = triangle.vertices[0];
+	const Vector3ex& b = triangle.vertices[1];
+	const Vector3ex& c = triangle.vertices[2];
+	const Vector3ex ab = b - a;
+	const Vector3ex ac = c - a;
+
+	const Vector3ex ap = point - a;
+	const float d1 = Dot(ab, ap);
+	const float d2 = Dot(ac, ap);
+	if (d1 <= 0.0f && d2 <= 0.0f)
+	{
+		return a;
+	}
+
+	const Vector3ex bp = point - b;
+	const float d3 = Dot(ab, bp);
+	const float d4 = Dot(ac, bp);
+	if (d3 >= 0.0f && d4 <= d3)
+	{
+		return b;
+	}
+
+	const float vc = d1 * d4 - d3 * d2;
+	if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+	{
+		return a + ab * (d1 / (d1 - d3));
+	}
+
+	const Vector3ex cp = point - c;
+	const float d5 = Dot(ab, cp);
+	const float d6 = Dot(ac, cp);
+	if (d6 >= 0.0f && d5 <= d6)
+	{
+		return c;
+	}
+
+	const float vb = d5 * d2 - d1 * d6;
+	if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+	{
+		return a + ac * (d2 / (d2 - d6));
+	}
+
+	const float va = d3 * d6 - d5 * d4;
+	if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+	{
+		return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+	}
+
+	// 面の内側（重心座標で求める）
+	const float denominator = 1.0f / (va + vb + vc);
+	return a + ab * (vb * denominator) + ac * (vc * denominator);
+}
+
 Vector3ex MathFunction::Perpendicular(const Vector3ex& vector)
 {
 	if (vector.x != 0.0f || vector.z != 0.0f)
@@ -112,7 +236,7 @@ Vector3ex MathFunction::Perpendicular(const Vector3ex& vector)
 
 Vector3ex MathFunction::Lerp(const Vector3ex& v1, const Vector3ex& v2, float t)
 {
-	return Vector3ex(t * v1.x + (1.0f - t) * v2.x, t * v1.y + (1.0f - t) * v2.y, t * v1.z + (1.0f - t) * v2.z);
+	return FromCore<Vector3ex>(t * ToCore(v1) + (1.0f - t) * ToCore(v2));
 }
 
 Vector3ex MathFunction::ProjectToScreen(const Vector3ex& point, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix)
@@ -130,147 +254,56 @@ Vector3ex MathFunction::Reflect(const Vector3ex& input, const Vector3ex& normal)
 	return reflection;
 }
 
-Matrix4x4ex MathFunction::Add(const Matrix4x4ex& m1, const Matrix4x4ex& m2)
+PreparedSegment MathFunction::Prepare(const Segment& segment)
 {
-	Matrix4x4ex result;
-	for (int i = 0; i < 4; ++i)
-	{
-		for (int j = 0; j < 4; ++j)
-		{
-			result.m[i][j] = m1.m[i][j] + m2.m[i][j];
-		}
-	}
+	PreparedSegment result{};
+	result.origin = segment.origin;
+	// 0で割るとIEEE754では±infになり、スラブ判定ではそのまま正しく働く
+	result.inverseDiff = { 1.0f / segment.diff.x, 1.0f / segment.diff.y, 1.0f / segment.diff.z };
+	result.sign[0] = std::signbit(result.inverseDiff.x) ? 1 : 0;
+	result.sign[1] = std::signbit(result.inverseDiff.y) ? 1 : 0;
+	result.sign[2] = std::signbit(result.inverseDiff.z) ? 1 : 0;
+	result.tMin = 0.0f;
+	result.tMax = 1.0f;
 	return result;
 }
 
-Matrix4x4ex MathFunction::Subtract(const Matrix4x4ex& m1, const Matrix4x4ex& m2)
+PreparedSegment MathFunction::Prepare(const Ray& ray)
 {
-	Matrix4x4ex result{};
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			result.m[i][j] = m1.m[i][j] - m2.m[i][j];
-		}
-	}
+	PreparedSegment result = Prepare(Segment{ ray.origin, ray.diff });
+	result.tMax = std::numeric_limits<float>::infinity();
 	return result;
 }
 
-Matrix4x4ex MathFunction::Multiply(const Matrix4x4ex& m1, const Matrix4x4ex& m2)
+Matrix4x4ex MathFunction::Add(const Matrix4x4ex& m1, const Matrix4x4ex& m2)
 {
-	Matrix4x4ex result{};
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			for (int k = 0; k < 4; k++)
-			{
-				result.m[i][j] += m1.m[i][k] * m2.m[k][j];
-			}
-		}
-	}
-	return result;
+	return FromCore<Matrix4x4ex>(ToCore(m1) + ToCore(m2));
 }
 
-Matrix4x4ex MathFunction::Inverse(const Matrix4x4ex& matrix)
+Matrix4x4ex MathFunction::Subtract(const Matrix4x4ex& m1, const Matrix4x4ex& m2)
 {
-	Matrix4x4ex result{};
+	return FromCore<Matrix4x4ex>(ToCore(m1) - ToCore(m2));
+}
 
-	float det = matrix.m[0][0] * (matrix.m[1][1] * matrix.m[2][2] * matrix.m[3][3] + matrix.m[1][2] * matrix.m[2][3] * matrix.m[3][1] + matrix.m[1][3] * matrix.m[2][1] * matrix.m[3][2] -
-		matrix.m[1][3] * matrix.m[2][2] * matrix.m[3][1] - matrix.m[1][2] * matrix.m[2][1] * matrix.m[3][3] - matrix.m[1][1] * matrix.m[2][3] * matrix.m[3][2]) -
-		matrix.m[0][1] * (matrix.m[1][0] * matrix.m[2][2] * matrix.m[3][3] + matrix.m[1][2] * matrix.m[2][3] * matrix.m[3][0] + matrix.m[1][3] * matrix.m[2][0] * matrix.m[3][2] -
-			matrix.m[1][3] * matrix.m[2][2] * matrix.m[3][0] - matrix.m[1][2] * matrix.m[2][0] * matrix.m[3][3] - matrix.m[1][0] * matrix.m[2][3] * matrix.m[3][2]) +
-		matrix.m[0][2] * (matrix.m[1][0] * matrix.m[2][1] * matrix.m[3][3] + matrix.m[1][1] * matrix.m[2][3] * matrix.m[3][0] + matrix.m[1][3] * matrix.m[2][0] * matrix.m[3][1] -
-			matrix.m[1][3] * matrix.m[2][1] * matrix.m[3][0] - matrix.m[1][1] * matrix.m[2][0] * matrix.m[3][3] - matrix.m[1][0] * matrix.m[2][3] * matrix.m[3][1]) -
-		matrix.m[0][3] * (matrix.m[1][0] * matrix.m[2][1] * matrix.m[3][2] + matrix.m[1][1] * matrix.m[2][2] * matrix.m[3][0] + matrix.m[1][2] * matrix.m[2][0] * matrix.m[3][1] -
-			matrix.m[1][2] * matrix.m[2][1] * matrix.m[3][0] - matrix.m[1][1] * matrix.m[2][0] * matrix.m[3][2] - matrix.m[1][0] * matrix.m[2][2] * matrix.m[3][1]);
-
-	result.m[0][0] = (matrix.m[1][1] * matrix.m[2][2] * matrix.m[3][3] + matrix.m[1][2] * matrix.m[2][3] * matrix.m[3][1] + matrix.m[1][3] * matrix.m[2][1] * matrix.m[3][2] -
-		matrix.m[1][3] * matrix.m[2][2] * matrix.m[3][1] - matrix.m[1][2] * matrix.m[2][1] * matrix.m[3][3] - matrix.m[1][1] * matrix.m[2][3] * matrix.m[3][2]) /
-		det;
-	result.m[0][1] = (-matrix.m[0][1] * matrix.m[2][2] * matrix.m[3][3] - matrix.m[0][2] * matrix.m[2][3] * matrix.m[3][1] - matrix.m[0][3] * matrix.m[2][1] * matrix.m[3][2] +
-		matrix.m[0][3] * matrix.m[2][2] * matrix.m[3][1] + matrix.m[0][2] * matrix.m[2][1] * matrix.m[3][3] + matrix.m[0][1] * matrix.m[2][3] * matrix.m[3][2]) /
-		det;
-	result.m[0][2] = (matrix.m[0][1] * matrix.m[1][2] * matrix.m[3][3] + matrix.m[0][2] * matrix.m[1][3] * matrix.m[3][1] + matrix.m[0][3] * matrix.m[1][1] * matrix.m[3][2] -
-		matrix.m[0][3] * matrix.m[1][2] * matrix.m[3][1] - matrix.m[0][2] * matrix.m[1][1] * matrix.m[3][3] - matrix.m[0][1] * matrix.m[1][3] * matrix.m[3][2]) /
-		det;
-	result.m[0][3] = (-matrix.m[0][1] * matrix.m[1][2] * matrix.m[2][3] - matrix.m[0][2] * matrix.m[1][3] * matrix.m[2][1] - matrix.m[0][3] * matrix.m[1][1] * matrix.m[2][2] +
-		matrix.m[0][3] * matrix.m[1][2] * matrix.m[2][1] + matrix.m[0][2] * matrix.m[1][1] * matrix.m[2][3] + matrix.m[0][1] * matrix.m[1][3] * matrix.m[2][2]) /
-		det;
-
-	result.m[1][0] = (-matrix.m[1][0] * matrix.m[2][2] * matrix.m[3][3] - matrix.m[1][2] * matrix.m[2][3] * matrix.m[3][0] - matrix.m[1][3] * matrix.m[2][0] * matrix.m[3][2] +
-		matrix.m[1][3] * matrix.m[2][2] * matrix.m[3][0] + matrix.m[1][2] * matrix.m[2][0] * matrix.m[3][3] + matrix.m[1][0] * matrix.m[2][3] * matrix.m[3][2]) /
-		det;
-	result.m[1][1] = (matrix.m[0][0] * matrix.m[2][2] * matrix.m[3][3] + matrix.m[0][2] * matrix.m[2][3] * matrix.m[3][0] + matrix.m[0][3] * matrix.m[2][0] * matrix.m[3][2] -
-		matrix.m[0][3] * matrix.m[2][2] * matrix.m[3][0] - matrix.m[0][2] * matrix.m[2][0] * matrix.m[3][3] - matrix.m[0][0] * matrix.m[2][3] * matrix.m[3][2]) /
-		det;
-	result.m[1][2] = (-matrix.m[0][0] * matrix.m[1][2] * matrix.m[3][3] - matrix.m[0][2] * matrix.m[1][3] * matrix.m[3][0] - matrix.m[0][3] * matrix.m[1][0] * matrix.m[3][2] +
-		matrix.m[0][3] * matrix.m[1][2] * matrix.m[3][0] + matrix.m[0][2] * matrix.m[1][0] * matrix.m[3][3] + matrix.m[0][0] * matrix.m[1][3] * matrix.m[3][2]) /
-		det;
-	result.m[1][3] = (matrix.m[0][0] * matrix.m[1][2] * matrix.m[2][3] + matrix.m[0][2] * matrix.m[1][3] * matrix.m[2][0] + matrix.m[0][3] * matrix.m[1][0] * matrix.m[2][2] -
-		matrix.m[0][3] * matrix.m[1][2] * matrix.m[2][0] - matrix.m[0][2] * matrix.m[1][0] * matrix.m[2][3] - matrix.m[0][0] * matrix.m[1][3] * matrix.m[2][2]) /
-		det;
-
-	result.m[2][0] = (matrix.m[1][0] * matrix.m[2][1] * matrix.m[3][3] + matrix.m[1][1] * matrix.m[2][3] * matrix.m[3][0] + matrix.m[1][3] * matrix.m[2][0] * matrix.m[3][1] -
-		matrix.m[1][3] * matrix.m[2][1] * matrix.m[3][0] - matrix.m[1][1] * matrix.m[2][0] * matrix.m[3][3] - matrix.m[1][0] * matrix.m[2][3] * matrix.m[3][1]) /
-		det;
-	result.m[2][1] = (-matrix.m[0][0] * matrix.m[2][1] * matrix.m[3][3] - matrix.m[0][1] * matrix.m[2][3] * matrix.m[3][0] - matrix.m[0][3] * matrix.m[2][0] * matrix.m[3][1] +
-		matrix.m[0][3] * matrix.m[2][1] * matrix.m[3][0] + matrix.m[0][1] * matrix.m[2][0] * matrix.m[3][3] + matrix.m[0][0] * matrix.m[2][3] * matrix.m[3][1]) /
-		det;
-	result.m[2][2] = (matrix.m[0][0] * matrix.m[1][1] * matrix.m[3][3] + matrix.m[0][1] * matrix.m[1][3] * matrix.m[3][0] + matrix.m[0][3] * matrix.m[1][0] * matrix.m[3][1] -
-		matrix.m[0][3] * matrix.m[1][1] * matrix.m[3][0] - matrix.m[0][1] * matrix.m[1][0] * matrix.m[3][3] - matrix.m[0][0] * matrix.m[1][3] * matrix.m[3][1]) /
-		det;
-	result.m[2][3] = (-matrix.m[0][0] * matrix.m[1][1] * matrix.m[2][3] - matrix.m[0][1] * matrix.m[1][3] * matrix.m[2][0] - matrix.m[0][3] * matrix.m[1][0] * matrix.m[2][1] +
-		matrix.m[0][3] * matrix.m[1][1] * matrix.m[2][0] + matrix.m[0][1] * matrix.m[1][0] * matrix.m[2][3] + matrix.m[0][0] * matrix.m[1][3] * matrix.m[2][1]) /
-		det;
-
-	result.m[3][0] = (-matrix.m[1][0] * matrix.m[2][1] * matrix.m[3][2] - matrix.m[1][1] * matrix.m[2][2] * matrix.m[3][0] - matrix.m[1][2] * matrix.m[2][0] * matrix.m[3][1] +
-		matrix.m[1][2] * matrix.m[2][1] * matrix.m[3][0] + matrix.m[1][1] * matrix.m[2][0] * matrix.m[3][2] + matrix.m[1][0] * matrix.m[2][2] * matrix.m[3][1]) /
-		det;
-	result.m[3][1] = (matrix.m[0][0] * matrix.m[2][1] * matrix.m[3][2] + matrix.m[0][1] * matrix.m[2][2] * matrix.m[3][0] + matrix.m[0][2] * matrix.m[2][0] * matrix.m[3][1] -
-		matrix.m[0][2] * matrix.m[2][1] * matrix.m[3][0] - matrix.m[0][1] * matrix.m[2][0] * matrix.m[3][2] - matrix.m[0][0] * matrix.m[2][2] * matrix.m[3][1]) /
-		det;
-	result.m[3][2] = (-matrix.m[0][0] * matrix.m[1][1] * matrix.m[3][2] - matrix.m[0][1] * matrix.m[1][2] * matrix.m[3][0] - matrix.m[0][2] * matrix.m[1][0] * matrix.m[3][1] +
-		matrix.m[0][2] * matrix.m[1][1] * matrix.m[3][0] + matrix.m[0][1] * matrix.m[1][0] * matrix.m[3][2] + matrix.m[0][0] * matrix.m[1][2] * matrix.m[3][1]) /
-		det;
-	result.m[3][3] = (matrix.m[0][0] * matrix.m[1][1] * matrix.m[2][2] + matrix.m[0][1] * matrix.m[1][2] * matrix.m[2][0] + matrix.m[0][2] * matrix.m[1][0] * matrix.m[2][1] -
-		matrix.m[0][2] * matrix.m[1][1] * matrix.m[2][0] - matrix.m[0][1] * matrix.m[1][0] * matrix.m[2][2] - matrix.m[0][0] * matrix.m[1][2] * matrix.m[2][1]) /
-		det;
+Matrix4x4ex MathFunction::Multiply(const Matrix4x4ex& m1, const Matrix4x4ex& m2)
+{
+	PROFILE_COUNT(ProfileCounter::MatrixMultiplies, 1);
+	return FromCore<Matrix4x4ex>(ToCore(m1) * ToCore(m2));
+}
 
-	return result;
+Matrix4x4ex MathFunction::Inverse(const Matrix4x4ex& matrix)
+{
+	return FromCore<Matrix4x4ex>(::Inverse(ToCore(matrix)));
 }
 
 Matrix4x4ex MathFunction::Transpose(const Matrix4x4ex& m)
 {
-	Matrix4x4ex result{};
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			result.m[i][j] = m.m[j][i];
-		}
-	}
-	return result;
+	return FromCore<Matrix4x4ex>(::Transpose(ToCore(m)));
 }
 
 Matrix4x4ex MathFunction::MakeIdentity()
 {
-	Matrix4x4ex result{};
-	for (int i = 0; i < 4; i++)
-	{
-		for (int j = 0; j < 4; j++)
-		{
-			if (i == j)
-			{
-				result.m[i][j] = 1.0f;
-			}
-			else
-			{
-				result.m[i][j] = 0.0f;
-			}
-		}
-	}
-	return result;
+	return FromCore<Matrix4x4ex>(Identity<float, 4>());
 }
 
 Matrix4x4ex MathFunction::MakeScaleMatrix(const Vector3ex& scale)
@@ -285,38 +318,26 @@ Matrix4x4ex MathFunction::MakeScaleMatrix(const Vector3ex& scale)
 
 Matrix4x4ex MathFunction::MakeRotateXMatrix(float radian)
 {
-	Matrix4x4ex result{};
-	result.m[0][0] = 1.0f;
-	result.m[1][1] = std::cos(radian);
-	result.m[1][2] = std::sin(radian);
-	result.m[2][1] = -std::sin(radian);
-	result.m[2][2] = std::cos(radian);
-	result.m[3][3] = 1.0f;
-	return result;
+	float sine;
+	float cosine;
+	SinCos(radian, sine, cosine);
+	return ::MakeRotateXMatrix(sine, cosine);
 }
 
 Matrix4x4ex MathFunction::MakeRotateYMatrix(float radian)
 {
-	Matrix4x4ex result{};
-	result.m[0][0] = std::cos(radian);
-	result.m[0][2] = -std::sin(radian);
-	result.m[1][1] = 1.0f;
-	result.m[2][0] = std::sin(radian);
-	result.m[2][2] = std::cos(radian);
-	result.m[3][3] = 1.0f;
-	return result;
+	float sine;
+	float cosine;
+	SinCos(radian, sine, cosine);
+	return ::MakeRotateYMatrix(sine, cosine);
 }
 
 Matrix4x4ex MathFunction::MakeRotateZMatrix(float radian)
 {
-	Matrix4x4ex result{};
-	result.m[0][0] = std::cos(radian);
-	result.m[0][1] = std::sin(radian);
-	result.m[1][0] = -std::sin(radian);
-	result.m[1][1] = std::cos(radian);
-	result.m[2][2] = 1.0f;
-	result.m[3][3] = 1.0f;
-	return result;
+	float sine;
+	float cosine;
+	SinCos(radian, sine, cosine);
+	return ::MakeRotateZMatrix(sine, cosine);
 }
 
 Matrix4x4ex MathFunction::MakeTranslateMatrix(const Vector3ex& translate)
@@ -337,7 +358,55 @@ Matrix4x4ex MathFunction::MakeTranslateMatrix(const Vector3ex& translate)
 
 Matrix4x4ex MathFunction::MakeAffineMatrix(const Vector3ex& scale, const Vector3ex& radian, const Vector3ex& translate)
 {
-	return Multiply(MakeScaleMatrix(scale), Multiply(Multiply(MakeRotateXMatrix(radian.x), Multiply(MakeRotateYMatrix(radian.y), MakeRotateZMatrix(radian.z))), MakeTranslateMatrix(translate)));
+	// 3軸の角度のsinとcosは4レーンで1回に求める
+	Float4 sines;
+	Float4 cosines;
+	SinCos(Float4{ _mm_setr_ps(radian.x, radian.y, radian.z, 0.0f) }, sines, cosines);
+	float s[4];
+	float c[4];
+	sines.Store(s);
+	cosines.Store(c);
+	return Multiply(MakeScaleMatrix(scale), Multiply(Multiply(::MakeRotateXMatrix(s[0], c[0]), Multiply(::MakeRotateYMatrix(s[1], c[1]), ::MakeRotateZMatrix(s[2], c[2]))), MakeTranslateMatrix(translate)));
+}
+
+OBB MathFunction::MakeOBB(const Vector3ex& center, const Vector3ex& radian, const Vector3ex& size)
+{
+	const Matrix4x4ex rotate = MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, radian, { 0.0f, 0.0f, 0.0f });
+	OBB obb{};
+	obb.center = center;
+	for (int i = 0; i < 3; ++i)
+	{
+		obb.orientations[i] = { rotate.m[i][0], rotate.m[i][1], rotate.m[i][2] };
+	}
+	obb.size = size;
+	return obb;
+}
+
+Capsule MathFunction::MakeSweptCapsule(const Vector3ex& start, const Vector3ex& end, float radius)
+{
+	return { { start, Subtract(end, start) }, radius };
+}
+
+Capsule MathFunction::MakeSweptCapsule(const Ball& ball, float deltaTime)
+{
+	return { { ball.position, Multiply(deltaTime, ball.velocity) }, ball.radius };
+}
+
+Matrix4x4ex MathFunction::MakeOBBWorldMatrix(const OBB& obb)
+{
+	const float size[3] = { obb.size.x, obb.size.y, obb.size.z };
+	Matrix4x4ex result{};
+	for (int i = 0; i < 3; ++i)
+	{
+		result.m[i][0] = obb.orientations[i].x * size[i];
+		result.m[i][1] = obb.orientations[i].y * size[i];
+		result.m[i][2] = obb.orientations[i].z * size[i];
+	}
+	result.m[3][0] = obb.center.x;
+	result.m[3][1] = obb.center.y;
+	result.m[3][2] = obb.center.z;
+	result.m[3][3] = 1.0f;
+	return result;
 }
 
 Matrix4x4ex MathFunction::MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip)
@@ -384,40 +453,26 @@ void MathFunction::DrawGrid(const Matrix4x4ex& ViewProjectionMatrix, const Matri
 	const uint32_t kSubdivision = 10;										//分割数
 	const float kGridEvery = (kGridHalfWidth * 2.0f) / float(kSubdivision);	//1つ分の長さ
 
-	//水平方向の線を描画
-	for (uint32_t xIndex = 0; xIndex <= kSubdivision; xIndex++)
+	// ワールド座標系 -> スクリーン座標系の行列は1回だけ作る
+	const Matrix4x4ex viewProjectionViewportMatrix = Multiply(ViewProjectionMatrix, ViewportMatrix);
+
+	// x方向とz方向の線を1本ずつ描く（各端点は1回だけ変換する）
+	for (uint32_t index = 0; index <= kSubdivision; index++)
 	{
 		//上の情報を使ってワールド座標系上の始点と終点を求める
-		//X軸上の座標
-		float posX = -kGridHalfWidth + kGridEvery * xIndex;
-
-		//始点と終点
-		Vector3ex start = { posX, 0.0f, -kGridHalfWidth };
-		Vector3ex end = { posX, 0.0f, kGridHalfWidth };
-		//// ワールド座標系 -> スクリーン座標系まで変換をかける
-		start = Transform(start, Multiply(ViewProjectionMatrix, ViewportMatrix));
-		end = Transform(end, Multiply(ViewProjectionMatrix, ViewportMatrix));
-
-		//左から右も同じように順々に引いていく
-		for (uint32_t zIndex = 0; zIndex <= kSubdivision; zIndex++)
-		{
-			//奥から手前が左右に代わるだけ
-			//上の情報を使ってワールド座標系上の始点と終点を求める
-			//Z軸上の座標
-			float posZ = -kGridHalfWidth + kGridEvery * zIndex;
-
-			//始点と終点
-			Vector3ex startZ = { -kGridHalfWidth, 0.0f, posZ };
-			Vector3ex endZ = { kGridHalfWidth, 0.0f, posZ };
-			//// ワールド座標系 -> スクリーン座標系まで変換をかける
-			startZ = Transform(startZ, Multiply(ViewProjectionMatrix, ViewportMatrix));
-			endZ = Transform(endZ, Multiply(ViewProjectionMatrix, ViewportMatrix));
-
-			//変換した画像を使って表示。色は薄い灰色(0xAAAAAAFF)、原点は黒ぐらいがいいが、なんでもいい
-			Novice::DrawLine((int)start.x, (int)start.y, (int)end.x, (int)end.y, 0x6F6F6FFF);
-			Novice::DrawLine((int)startZ.x, (int)startZ.y, (int)endZ.x, (int)endZ.y, 0x6F6F6FFF);
-		}
+		float pos = -kGridHalfWidth + kGridEvery * index;
+
+		//奥から手前（xが一定）と左から右（zが一定）の線の始点と終点
+		Vector3ex startX = Transform({ pos, 0.0f, -kGridHalfWidth }, viewProjectionViewportMatrix);
+		Vector3ex endX = Transform({ pos, 0.0f, kGridHalfWidth }, viewProjectionViewportMatrix);
+		Vector3ex startZ = Transform({ -kGridHalfWidth, 0.0f, pos }, viewProjectionViewportMatrix);
+		Vector3ex endZ = Transform({ kGridHalfWidth, 0.0f, pos }, viewProjectionViewportMatrix);
+
+		//変換した画像を使って表示。色は薄い灰色(0xAAAAAAFF)、原点は黒ぐらいがいいが、なんでもいい
+		Novice::DrawLine((int)startX.x, (int)startX.y, (int)endX.x, (int)endX.y, 0x6F6F6FFF);
+		Novice::DrawLine((int)startZ.x, (int)startZ.y, (int)endZ.x, (int)endZ.y, 0x6F6F6FFF);
 	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, (kSubdivision + 1) * 2);
 }
 
 void MathFunction::DrawSphere(const Sphere& sphere, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
@@ -427,55 +482,126 @@ void MathFunction::DrawSphere(const Sphere& sphere, const Matrix4x4ex& viewProje
 	const float kLatStep = (float)M_PI / kSubdivision;						//緯度のステップ
 	const float kLonStep = 2.0f * (float)M_PI / kSubdivision;				//経度のステップ
 
-	// 緯度のループ
-	for (uint32_t latIndex = 0; latIndex < kSubdivision; ++latIndex)
+	// 格子点は隣り合う線分で共有されるので、先に1回ずつスクリーン座標へ変換しておく
+	// （一時的な頂点はフレームアリーナに置き、毎フレームのヒープ確保をしない）
+	const Matrix4x4ex viewProjectionViewportMatrix = Multiply(viewProjectionMatrix, viewportMatrix);
+	Vector3ex* screenPoints = FrameArena::GetFrame().AllocateArray<Vector3ex>((kSubdivision + 1) * kSubdivision);
+
+	// 緯度と経度のsinとcosは格子点ごとではなく、角度ごとに1回ずつまとめて求める
+	float latAngles[kSubdivision + 1];
+	float sinLats[kSubdivision + 1];
+	float cosLats[kSubdivision + 1];
+	float lonAngles[kSubdivision];
+	float sinLons[kSubdivision];
+	float cosLons[kSubdivision];
+	for (uint32_t latIndex = 0; latIndex <= kSubdivision; ++latIndex)
+	{
+		latAngles[latIndex] = -0.5f * (float)M_PI + latIndex * kLatStep;	//緯度
+	}
+	for (uint32_t lonIndex = 0; lonIndex < kSubdivision; ++lonIndex)
 	{
-		float lat = -0.5f * (float)M_PI + latIndex * kLatStep;	//現在の緯度
+		lonAngles[lonIndex] = lonIndex * kLonStep;	//経度
+	}
+	SinCosArray<TrigPrecision::Fast>(latAngles, sinLats, cosLats, kSubdivision + 1);
+	SinCosArray<TrigPrecision::Fast>(lonAngles, sinLons, cosLons, kSubdivision);
 
-		//次の緯度
-		float nextLat = lat + kLatStep;
+	// 緯度のループ
+	for (uint32_t latIndex = 0; latIndex <= kSubdivision; ++latIndex)
+	{
+		float cosLat = cosLats[latIndex];
+		float sinLat = sinLats[latIndex];
 
 		//経度のループ
 		for (uint32_t lonIndex = 0; lonIndex < kSubdivision; ++lonIndex)
 		{
-			//現在の経度
-			float lon = lonIndex * kLonStep;
-
-			//次の経度
-			float nextLon = lon + kLonStep;
-
 			// 球面座標の計算
-			Vector3ex pointA
-			{
-				sphere.center.x + sphere.radius * cos(lat) * cos(lon),
-				sphere.center.y + sphere.radius * sin(lat),
-				sphere.center.z + sphere.radius * cos(lat) * sin(lon)
-			};
-
-			Vector3ex pointB
+			Vector3ex point
 			{
-				sphere.center.x + sphere.radius * cos(nextLat) * cos(lon),
-				sphere.center.y + sphere.radius * sin(nextLat),
-				sphere.center.z + sphere.radius * cos(nextLat) * sin(lon)
-			};
-
-			Vector3ex pointC
-			{
-				sphere.center.x + sphere.radius * cos(lat) * cos(nextLon),
-				sphere.center.y + sphere.radius * sin(lat),
-				sphere.center.z + sphere.radius * cos(lat) * sin(nextLon)
+				sphere.center.x + sphere.radius * cosLat * cosLons[lonIndex],
+				sphere.center.y + sphere.radius * sinLat,
+				sphere.center.z + sphere.radius * cosLat * sinLons[lonIndex]
 			};
 
 			// スクリーン座標に変換
-			pointA = Transform(pointA, Multiply(viewProjectionMatrix, viewportMatrix));
-			pointB = Transform(pointB, Multiply(viewProjectionMatrix, viewportMatrix));
-			pointC = Transform(pointC, Multiply(viewProjectionMatrix, viewportMatrix));
+			screenPoints[latIndex * kSubdivision + lonIndex] = Transform(point, viewProjectionViewportMatrix);
+		}
+	}
+
+	for (uint32_t latIndex = 0; latIndex < kSubdivision; ++latIndex)
+	{
+		for (uint32_t lonIndex = 0; lonIndex < kSubdivision; ++lonIndex)
+		{
+			// Aから次の緯度（B）と次の経度（C）へ線を引く（最後の経度は最初に戻る）
+			const Vector3ex& pointA = screenPoints[latIndex * kSubdivision + lonIndex];
+			const Vector3ex& pointB = screenPoints[(latIndex + 1) * kSubdivision + lonIndex];
+			const Vector3ex& pointC = screenPoints[latIndex * kSubdivision + (lonIndex + 1) % kSubdivision];
 
 			// 線分の描画
 			Novice::DrawLine((int)pointA.x, (int)pointA.y, (int)pointB.x, (int)pointB.y, color);
 			Novice::DrawLine((int)pointA.x, (int)pointA.y, (int)pointC.x, (int)pointC.y, color);
 		}
 	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, kSubdivision * kSubdivision * 2);
+}
+
+uint32_t MathFunction::DrawSpheres(std::span<const Sphere> spheres, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color, bool filled, float wireframeRadius)
+{
+	// ビューが回転と平行移動だけなら、ビュー射影行列のx列とy列の長さ（上3行）は射影行列の拡大率になる
+	// 画面上の半径はそれに半径を掛けてwで割り、ビューポートの拡大率を掛ければ求まる
+	const float projectionScaleX = Length({ viewProjectionMatrix.m[0][0], viewProjectionMatrix.m[1][0], viewProjectionMatrix.m[2][0] });
+	const float projectionScaleY = Length({ viewProjectionMatrix.m[0][1], viewProjectionMatrix.m[1][1], viewProjectionMatrix.m[2][1] });
+	const float pixelScaleX = projectionScaleX * std::abs(viewportMatrix.m[0][0]);
+	const float pixelScaleY = projectionScaleY * std::abs(viewportMatrix.m[1][1]);
+
+	// ビューポートの範囲（画面外の球を捨てる）
+	const float screenLeft = viewportMatrix.m[3][0] - std::abs(viewportMatrix.m[0][0]);
+	const float screenRight = viewportMatrix.m[3][0] + std::abs(viewportMatrix.m[0][0]);
+	const float screenTop = viewportMatrix.m[3][1] - std::abs(viewportMatrix.m[1][1]);
+	const float screenBottom = viewportMatrix.m[3][1] + std::abs(viewportMatrix.m[1][1]);
+
+	const Matrix4x4ex viewProjectionViewportMatrix = Multiply(viewProjectionMatrix, viewportMatrix);
+	const FillMode fillMode = filled ? kFillModeSolid : kFillModeWireFrame;
+	uint32_t drawnCount = 0;
+	uint32_t impostorCount = 0;
+
+	for (const Sphere& sphere : spheres)
+	{
+		const Vector4 screen = Multiply(Vector4{ sphere.center.x, sphere.center.y, sphere.center.z, 1.0f }, viewProjectionViewportMatrix);
+
+		// wはカメラからの奥行きなので、半径より近い球はカメラの後ろにあるか、カメラが中に入っている
+		if (screen.w + sphere.radius <= 0.0f)
+		{
+			continue;
+		}
+		if (screen.w <= sphere.radius)
+		{
+			DrawSphere(sphere, viewProjectionMatrix, viewportMatrix, color);
+			++drawnCount;
+			continue;
+		}
+
+		const float inverseW = 1.0f / screen.w;
+		const float x = screen.x * inverseW;
+		const float y = screen.y * inverseW;
+		const float radiusX = sphere.radius * pixelScaleX * inverseW;
+		const float radiusY = sphere.radius * pixelScaleY * inverseW;
+		if (x + radiusX < screenLeft || x - radiusX > screenRight || y + radiusY < screenTop || y - radiusY > screenBottom)
+		{
+			continue;
+		}
+
+		++drawnCount;
+		if (std::max(radiusX, radiusY) >= wireframeRadius)
+		{
+			DrawSphere(sphere, viewProjectionMatrix, viewportMatrix, color);
+			continue;
+		}
+		// 1ピクセル未満でも点として見えるように半径は1以上にする
+		Novice::DrawEllipse(static_cast<int>(x), static_cast<int>(y), std::max(1, static_cast<int>(radiusX + 0.5f)), std::max(1, static_cast<int>(radiusY + 0.5f)), 0.0f, color, fillMode);
+		++impostorCount;
+	}
+	PROFILE_COUNT(ProfileCounter::ImpostorsSubmitted, impostorCount);
+	return drawnCount;
 }
 
 void MathFunction::DrawPlane(const Plane& plane, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
@@ -500,6 +626,7 @@ void MathFunction::DrawPlane(const Plane& plane, const Matrix4x4ex& viewProjecti
 	Novice::DrawLine((int)points[1].x, (int)points[1].y, (int)points[3].x, (int)points[3].y, color);
 	Novice::DrawLine((int)points[2].x, (int)points[2].y, (int)points[1].x, (int)points[1].y, color);
 	Novice::DrawLine((int)points[3].x, (int)points[3].y, (int)points[0].x, (int)points[0].y, color);
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, 4);
 }
 
 void MathFunction::DrawTriangle(const Triangle& triangle, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
@@ -513,6 +640,7 @@ void MathFunction::DrawTriangle(const Triangle& triangle, const Matrix4x4ex& vie
 		(int)screenVertices[1].x, (int)screenVertices[1].y,
 		(int)screenVertices[2].x, (int)screenVertices[2].y,
 		color, kFillModeWireFrame);
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, 3);
 }
 
 void MathFunction::DrawAABB(const AABB& aabb, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
@@ -544,6 +672,26 @@ void MathFunction::DrawAABB(const AABB& aabb, const Matrix4x4ex& viewProjectionM
 	Novice::DrawLine((int)vertices[4].x, (int)vertices[4].y, (int)vertices[6].x, (int)vertices[6].y, color);
 	Novice::DrawLine((int)vertices[5].x, (int)vertices[5].y, (int)vertices[7].x, (int)vertices[7].y, color);
 	Novice::DrawLine((int)vertices[6].x, (int)vertices[6].y, (int)vertices[7].x, (int)vertices[7].y, color);
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, 12);
+}
+
+void MathFunction::DrawOBB(const OBB& obb, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
+{
+	// 立方体の頂点の並びはDrawAABBと同じ（ビット0がx、1がy、2がz）
+	const Matrix4x4ex worldViewProjectionViewport = Multiply(MakeOBBWorldMatrix(obb), Multiply(viewProjectionMatrix, viewportMatrix));
+	Vector3ex vertices[8];
+	for (int i = 0; i < 8; ++i)
+	{
+		const Vector3ex corner = { (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : -1.0f };
+		vertices[i] = Transform(corner, worldViewProjectionViewport);
+	}
+
+	static constexpr int kEdges[12][2] = { { 0, 1 }, { 0, 2 }, { 0, 4 }, { 1, 3 }, { 1, 5 }, { 2, 3 }, { 2, 6 }, { 3, 7 }, { 4, 5 }, { 4, 6 }, { 5, 7 }, { 6, 7 } };
+	for (const auto& edge : kEdges)
+	{
+		Novice::DrawLine((int)vertices[edge[0]].x, (int)vertices[edge[0]].y, (int)vertices[edge[1]].x, (int)vertices[edge[1]].y, color);
+	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, 12);
 }
 
 void MathFunction::DrawBezier(const Vector3ex& controlPoint0, const Vector3ex& controlPoint1, const Vector3ex& controlPoint2, const Matrix4x4ex& viewProjection, const Matrix4x4ex& viewportMatrix, uint32_t color)
@@ -565,6 +713,7 @@ void MathFunction::DrawBezier(const Vector3ex& controlPoint0, const Vector3ex& c
 		screenPoint2 = Transform(screenPoint2, viewportMatrix);
 
 		Novice::DrawLine((int)screenPoint1.x, (int)screenPoint1.y, (int)screenPoint2.x, (int)screenPoint2.y, color);
+		PROFILE_COUNT(ProfileCounter::LinesSubmitted, 1);
 	}
 }
 
@@ -574,8 +723,211 @@ void MathFunction::DrawControlPoint(const Vector3ex& controlPoint, const Matrix4
 	DrawSphere(sphere, viewProjection, viewportMatrix, 0x000000);	// 黒色で描画
 }
 
+uint32_t MathFunction::DrawBezierPath(const BezierPath& path, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
+{
+	const Matrix4x4ex viewProjectionViewport = Multiply(viewProjectionMatrix, viewportMatrix);
+	const uint32_t count = static_cast<uint32_t>(path.GetIntervalCount());
+	for (uint32_t i = 0; i < count; ++i)
+	{
+		Vector3ex start;
+		Vector3ex end;
+		path.GetIntervalEnds(i, start, end);
+		start = Transform(start, viewProjectionViewport);
+		end = Transform(end, viewProjectionViewport);
+		Novice::DrawLine((int)start.x, (int)start.y, (int)end.x, (int)end.y, color);
+	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, count);
+	return count;
+}
+
+uint32_t MathFunction::DrawHeightfield(const Heightfield& heightfield, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
+{
+	constexpr uint32_t kBlockCells = Heightfield::kBlockCells;
+	constexpr float kMinLinePixels = 6.0f;	// 格子の線の間隔がこれより狭くなるブロックは間引く
+	constexpr float kNearW = 1e-3f;			// これより手前（カメラの後ろ）の点を結ぶ線は描かない
+
+	/// <summary>
+	/// 変換済みの格子点
+	/// </summary>
+	struct ScreenPoint
+	{
+		float x;
+		float y;
+		bool visible;
+	};
+
+	// ビューポートの変換はwを変えないので、まとめた行列で掛ければクリップ座標のwとスクリーン座標が両方得られる
+	const Matrix4x4ex viewProjectionViewportMatrix = Multiply(viewProjectionMatrix, viewportMatrix);
+	ScreenPoint* points = FrameArena::GetFrame().AllocateArray<ScreenPoint>((kBlockCells + 1) * (kBlockCells + 1));
+	uint32_t lineCount = 0;
+
+	for (uint32_t blockZ = 0; blockZ < heightfield.GetBlockCountZ(); ++blockZ)
+	{
+		for (uint32_t blockX = 0; blockX < heightfield.GetBlockCountX(); ++blockX)
+		{
+			// ブロックのAABBの8頂点が全て同じクリップ面の外にあれば描かない
+			const AABB bounds = heightfield.GetBlockBounds(blockX, blockZ);
+			uint32_t outsideAll = 0x3F;
+			bool behindCamera = false;
+			Vector3ex floorCorners[4]{};	// 底面の4隅のスクリーン座標（(minX,minZ), (maxX,minZ), (minX,maxZ), (maxX,maxZ)の順）
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				const Vector4 local
+				{
+					(corner & 1) ? bounds.max.x : bounds.min.x,
+					(corner & 2) ? bounds.max.y : bounds.min.y,
+					(corner & 4) ? bounds.max.z : bounds.min.z,
+					1.0f,
+				};
+				const Vector4 clip = Multiply(local, viewProjectionMatrix);
+				uint32_t outside = 0;
+				outside |= clip.x < -clip.w ? 0x01u : 0u;
+				outside |= clip.x > clip.w ? 0x02u : 0u;
+				outside |= clip.y < -clip.w ? 0x04u : 0u;
+				outside |= clip.y > clip.w ? 0x08u : 0u;
+				outside |= clip.z < 0.0f ? 0x10u : 0u;
+				outside |= clip.z > clip.w ? 0x20u : 0u;
+				outsideAll &= outside;
+
+				if (clip.w <= kNearW)
+				{
+					behindCamera = true;
+				}
+				else if ((corner & 2) == 0)
+				{
+					const Vector4 screen = Multiply(local, viewProjectionViewportMatrix);
+					floorCorners[(corner & 1) | ((corner & 4) >> 1)] = { screen.x / screen.w, screen.y / screen.w, 0.0f };
+				}
+			}
+			if (outsideAll != 0)
+			{
+				continue;
+			}
+
+			const uint32_t x0 = blockX * kBlockCells;
+			const uint32_t z0 = blockZ * kBlockCells;
+			const uint32_t x1 = std::min(x0 + kBlockCells, heightfield.GetSampleCountX() - 1);
+			const uint32_t z1 = std::min(z0 + kBlockCells, heightfield.GetSampleCountZ() - 1);
+
+			// 画面上の線の間隔から間引く間隔を決める（カメラをまたぐブロックは間引かない）
+			// x方向の線はz方向の辺の長さ、z方向の線はx方向の辺の長さで並ぶので、詰まって見える方に合わせる
+			uint32_t stride = 1;
+			if (!behindCamera)
+			{
+				const float edgeX = std::max(Length(floorCorners[1] - floorCorners[0]), Length(floorCorners[3] - floorCorners[2]));
+				const float edgeZ = std::max(Length(floorCorners[2] - floorCorners[0]), Length(floorCorners[3] - floorCorners[1]));
+				const float pixelsPerCell = std::min(edgeX / static_cast<float>(x1 - x0), edgeZ / static_cast<float>(z1 - z0));
+				while (stride < kBlockCells && pixelsPerCell * static_cast<float>(stride) < kMinLinePixels)
+				{
+					stride *= 2;
+				}
+			}
+
+			// 間引いた格子点（端は必ず含める）を1回ずつ変換する
+			const uint32_t columns = (x1 - x0 + stride - 1) / stride + 1;
+			const uint32_t rows = (z1 - z0 + stride - 1) / stride + 1;
+			const float cellSize = heightfield.GetCellSize();
+			const Vector3ex& origin = heightfield.GetOrigin();
+			for (uint32_t row = 0; row < rows; ++row)
+			{
+				const uint32_t iz = std::min(z0 + row * stride, z1);
+				for (uint32_t column = 0; column < columns; ++column)
+				{
+					const uint32_t ix = std::min(x0 + column * stride, x1);
+					const Vector4 screen = Multiply(Vector4{ origin.x + static_cast<float>(ix) * cellSize, origin.y + heightfield.GetHeight(ix, iz), origin.z + static_cast<float>(iz) * cellSize, 1.0f }, viewProjectionViewportMatrix);
+					ScreenPoint& point = points[row * columns + column];
+					point.visible = screen.w > kNearW;
+					point.x = point.visible ? screen.x / screen.w : 0.0f;
+					point.y = point.visible ? screen.y / screen.w : 0.0f;
+				}
+			}
+
+			auto drawLine = [&](const ScreenPoint& a, const ScreenPoint& b) {
+				if (a.visible && b.visible)
+				{
+					Novice::DrawLine(static_cast<int>(a.x), static_cast<int>(a.y), static_cast<int>(b.x), static_cast<int>(b.y), color);
+					++lineCount;
+				}
+			};
+			for (uint32_t row = 0; row < rows; ++row)
+			{
+				for (uint32_t column = 0; column < columns; ++column)
+				{
+					const ScreenPoint& point = points[row * columns + column];
+					if (column + 1 < columns)
+					{
+						drawLine(point, points[row * columns + column + 1]);
+					}
+					if (row + 1 < rows)
+					{
+						drawLine(point, points[(row + 1) * columns + column]);
+					}
+				}
+			}
+		}
+	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, lineCount);
+	return lineCount;
+}
+
+uint32_t MathFunction::DrawParticleEdges(const ParticleSoA& particles, std::span<const uint32_t> edgeIndices, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color)
+{
+	constexpr float kNearW = 1e-3f;	// これより手前（カメラの後ろ）の粒子を結ぶ辺は描かない
+
+	const size_t count = particles.GetCount();
+	if (count == 0 || edgeIndices.size() < 2)
+	{
+		return 0;
+	}
+
+	// 1つの粒子は何本もの辺で共有されるので、辺ごとではなく粒子ごとに1回だけ変換しておく
+	const Matrix4x4ex m = Multiply(viewProjectionMatrix, viewportMatrix);
+	FrameArena& arena = FrameArena::GetFrame();
+	float* screenX = arena.AllocateArray<float>(count);
+	float* screenY = arena.AllocateArray<float>(count);
+	float* screenW = arena.AllocateArray<float>(count);
+
+	auto transformColumn = [&](int column, Float8 x, Float8 y, Float8 z) {
+		return x * Float8::Set1(m.m[0][column]) + y * Float8::Set1(m.m[1][column]) + z * Float8::Set1(m.m[2][column]) + Float8::Set1(m.m[3][column]);
+	};
+	const size_t simdCount = count - count % Float8::kWidth;
+	for (size_t i = 0; i < simdCount; i += Float8::kWidth)
+	{
+		const Float8 x = Float8::Load(&particles.positionX[i]);
+		const Float8 y = Float8::Load(&particles.positionY[i]);
+		const Float8 z = Float8::Load(&particles.positionZ[i]);
+		const Float8 w = transformColumn(3, x, y, z);
+		const Float8 inverseW = Float8::Set1(1.0f) / w;
+		(transformColumn(0, x, y, z) * inverseW).Store(screenX + i);
+		(transformColumn(1, x, y, z) * inverseW).Store(screenY + i);
+		w.Store(screenW + i);
+	}
+	for (size_t i = simdCount; i < count; ++i)
+	{
+		const Vector4 screen = Multiply(Vector4{ particles.positionX[i], particles.positionY[i], particles.positionZ[i], 1.0f }, m);
+		screenX[i] = screen.x / screen.w;
+		screenY[i] = screen.y / screen.w;
+		screenW[i] = screen.w;
+	}
+
+	uint32_t lineCount = 0;
+	for (size_t edge = 0; edge + 1 < edgeIndices.size(); edge += 2)
+	{
+		const uint32_t a = edgeIndices[edge];
+		const uint32_t b = edgeIndices[edge + 1];
+		if (screenW[a] > kNearW && screenW[b] > kNearW)
+		{
+			Novice::DrawLine(static_cast<int>(screenX[a]), static_cast<int>(screenY[a]), static_cast<int>(screenX[b]), static_cast<int>(screenY[b]), color);
+			++lineCount;
+		}
+	}
+	PROFILE_COUNT(ProfileCounter::LinesSubmitted, lineCount);
+	return lineCount;
+}
+
 bool MathFunction::IsCollision(const Sphere& s1, const Sphere& s2)
 {
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
 	//2つの球の中心点間の距離を求める
 	float distance = Length(Subtract(s2.center, s1.center));
 	// 半径の合計よりも短ければ衝突
@@ -584,6 +936,7 @@ bool MathFunction::IsCollision(const Sphere& s1, const Sphere& s2)
 
 bool MathFunction::IsCollision(const Sphere& sphere, const Plane& plane)
 {
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
 	// 平面の法線ベクトルと球の中心点との距離
 	float distance = Dot(plane.normal, sphere.center) - plane.distance;
 	// その距離が球の半径以下なら衝突している
@@ -592,6 +945,7 @@ bool MathFunction::IsCollision(const Sphere& sphere, const Plane& plane)
 
 bool MathFunction::IsCollision(const Segment& segment, const Plane& plane)
 {
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
 	//まず垂直判定を行うために、法線と線の内積を求める
 	float dot = Dot(plane.normal, segment.diff);
 
@@ -612,6 +966,7 @@ bool MathFunction::IsCollision(const Segment& segment, const Plane& plane)
 
 bool MathFunction::IsCollision(const Triangle& triangle, const Segment& segment)
 {
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
 	// 三角形の辺
 	Vector3ex edge1 = Subtract(triangle.vertices[1], triangle.vertices[0]);
 	Vector3ex edge2 = Subtract(triangle.vertices[2], triangle.vertices[0]);
@@ -659,6 +1014,7 @@ bool MathFunction::IsCollision(const Triangle& triangle, const Segment& segment)
 
 bool MathFunction::IsCollision(const AABB& aabb1, const AABB& aabb2)
 {
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
 	return (aabb1.min.x <= aabb2.max.x && aabb1.max.x >= aabb2.min.x) && //x軸
 		(aabb1.min.y <= aabb2.max.y && aabb1.max.y >= aabb2.min.y) &&
 		(aabb1.min.z <= aabb2.max.z && aabb1.max.z >= aabb2.min.z);
@@ -666,6 +1022,7 @@ bool MathFunction::IsCollision(const AABB& aabb1, const AABB& aabb2)
 
 bool MathFunction::IsCollision(const AABB& aabb, const Sphere& sphere)
 {
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
 	//最近接点を求める
 	Vector3ex clossestPoint
 	{
@@ -681,25 +1038,328 @@ bool MathFunction::IsCollision(const AABB& aabb, const Sphere& sphere)
 
 bool MathFunction::IsCollision(const AABB& aabb, const Segment& segment)
 {
-	float tNearX = (aabb.min.x - segment.origin.x) / segment.diff.x;
-	float tFarX = (aabb.max.x - segment.origin.x) / segment.diff.x;
-	if (tNearX > tFarX) std::swap(tNearX, tFarX);
+	return IsCollision(aabb, Prepare(segment));
+}
+
+bool MathFunction::IsCollision(const AABB& aabb, const PreparedSegment& segment)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	float tEnter;
+	float tExit;
+	return IntersectSlab(aabb, segment, tEnter, tExit);
+}
+
+bool MathFunction::IntersectSlab(const AABB& aabb, const PreparedSegment& segment, float& tEnter, float& tExit)
+{
+	// 丸め誤差で接している面を取りこぼさないように、奥側を少しだけ広げる（1 + 2γ3）
+	const float kRobustFactor = 1.0f + 2.0f * 3.0f * std::numeric_limits<float>::epsilon() * 0.5f;
+
+	// 符号で手前と奥の面を選ぶので、std::swapの分岐が要らない
+	const Vector3ex* bounds[2] = { &aabb.min, &aabb.max };
+
+	float nearX = (bounds[segment.sign[0]]->x - segment.origin.x) * segment.inverseDiff.x;
+	float farX = (bounds[1 - segment.sign[0]]->x - segment.origin.x) * segment.inverseDiff.x * kRobustFactor;
+	float nearY = (bounds[segment.sign[1]]->y - segment.origin.y) * segment.inverseDiff.y;
+	float farY = (bounds[1 - segment.sign[1]]->y - segment.origin.y) * segment.inverseDiff.y * kRobustFactor;
+	float nearZ = (bounds[segment.sign[2]]->z - segment.origin.z) * segment.inverseDiff.z;
+	float farZ = (bounds[1 - segment.sign[2]]->z - segment.origin.z) * segment.inverseDiff.z * kRobustFactor;
+
+	// 始点が面上で差分が0の軸は0*inf=NaNになる
+	// NaNとの比較は常にfalseなので、この書き方ならその軸は区間を狭めない（maxss/minssになる）
+	float enter = segment.tMin;
+	enter = nearX > enter ? nearX : enter;
+	enter = nearY > enter ? nearY : enter;
+	enter = nearZ > enter ? nearZ : enter;
+	float exit = segment.tMax;
+	exit = farX < exit ? farX : exit;
+	exit = farY < exit ? farY : exit;
+	exit = farZ < exit ? farZ : exit;
+
+	tEnter = enter;
+	tExit = exit;
+	return enter <= exit;
+}
+
+bool MathFunction::IsCollision(const OBB& obb1, const OBB& obb2)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	// 平行な辺の外積が0になっても判定を誤らないように、軸の成分の絶対値を少し大きくしておく
+	const float kEpsilon = 1e-5f;
+
+	const float size1[3] = { obb1.size.x, obb1.size.y, obb1.size.z };
+	const float size2[3] = { obb2.size.x, obb2.size.y, obb2.size.z };
+	// obb2の軸をobb1の座標系で表した回転と、中心の差
+	float rotate[3][3];
+	float absRotate[3][3];
+	for (int i = 0; i < 3; ++i)
+	{
+		for (int j = 0; j < 3; ++j)
+		{
+			rotate[i][j] = Dot(obb1.orientations[i], obb2.orientations[j]);
+			absRotate[i][j] = std::abs(rotate[i][j]) + kEpsilon;
+		}
+	}
+	const Vector3ex difference = Subtract(obb2.center, obb1.center);
+	const float t[3] = { Dot(difference, obb1.orientations[0]), Dot(difference, obb1.orientations[1]), Dot(difference, obb1.orientations[2]) };
+
+	// obb1の面の軸
+	for (int i = 0; i < 3; ++i)
+	{
+		const float radius2 = size2[0] * absRotate[i][0] + size2[1] * absRotate[i][1] + size2[2] * absRotate[i][2];
+		if (std::abs(t[i]) > size1[i] + radius2)
+		{
+			return false;
+		}
+	}
+	// obb2の面の軸
+	for (int j = 0; j < 3; ++j)
+	{
+		const float radius1 = size1[0] * absRotate[0][j] + size1[1] * absRotate[1][j] + size1[2] * absRotate[2][j];
+		const float distance = t[0] * rotate[0][j] + t[1] * rotate[1][j] + t[2] * rotate[2][j];
+		if (std::abs(distance) > radius1 + size2[j])
+		{
+			return false;
+		}
+	}
+	// 辺同士の外積の軸（obb1のi番目の軸 × obb2のj番目の軸）
+	for (int i = 0; i < 3; ++i)
+	{
+		const int i1 = (i + 1) % 3;
+		const int i2 = (i + 2) % 3;
+		for (int j = 0; j < 3; ++j)
+		{
+			const int j1 = (j + 1) % 3;
+			const int j2 = (j + 2) % 3;
+			const float radius1 = size1[i1] * absRotate[i2][j] + size1[i2] * absRotate[i1][j];
+			const float radius2 = size2[j1] * absRotate[i][j2] + size2[j2] * absRotate[i][j1];
+			const float distance = t[i2] * rotate[i1][j] - t[i1] * rotate[i2][j];
+			if (std::abs(distance) > radius1 + radius2)
+			{
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+bool MathFunction::IsCollision(const OBB& obb, const Sphere& sphere)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	// OBBの座標系での球の中心を箱の中に寄せたものが最近接点
+	const Vector3ex difference = Subtract(sphere.center, obb.center);
+	const float size[3] = { obb.size.x, obb.size.y, obb.size.z };
+	float distanceSquared = 0.0f;
+	for (int i = 0; i < 3; ++i)
+	{
+		const float local = Dot(difference, obb.orientations[i]);
+		const float outside = local - std::clamp(local, -size[i], size[i]);
+		distanceSquared += outside * outside;
+	}
+	return distanceSquared <= sphere.radius * sphere.radius;
+}
+
+bool MathFunction::IsCollision(const OBB& obb, const Segment& segment)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	// 軸は正規直交なので、軸との内積がそのままOBBの座標系の成分になる
+	const Vector3ex difference = Subtract(segment.origin, obb.center);
+	const Segment localSegment
+	{
+		{ Dot(difference, obb.orientations[0]), Dot(difference, obb.orientations[1]), Dot(difference, obb.orientations[2]) },
+		{ Dot(segment.diff, obb.orientations[0]), Dot(segment.diff, obb.orientations[1]), Dot(segment.diff, obb.orientations[2]) },
+	};
+	const AABB localBox{ { -obb.size.x, -obb.size.y, -obb.size.z }, obb.size };
+	float tEnter;
+	float tExit;
+	return IntersectSlab(localBox, Prepare(localSegment), tEnter, tExit);
+}
 
-	float tNearY = (aabb.min.y - segment.origin.y) / segment.diff.y;
-	float tFarY = (aabb.max.y - segment.origin.y) / segment.diff.y;
-	if (tNearY > tFarY) std::swap(tNearY, tFarY);
+bool MathFunction::IsCollision(const OBB& obb, const AABB& aabb)
+{
+	OBB box{};
+	box.center = Multiply(0.5f, Add(aabb.min, aabb.max));
+	box.orientations[0] = { 1.0f, 0.0f, 0.0f };
+	box.orientations[1] = { 0.0f, 1.0f, 0.0f };
+	box.orientations[2] = { 0.0f, 0.0f, 1.0f };
+	box.size = Multiply(0.5f, Subtract(aabb.max, aabb.min));
+	return IsCollision(obb, box);
+}
 
-	float tNearZ = (aabb.min.z - segment.origin.z) / segment.diff.z;
-	float tFarZ = (aabb.max.z - segment.origin.z) / segment.diff.z;
-	if (tNearZ > tFarZ) std::swap(tNearZ, tFarZ);
+bool MathFunction::IsCollision(const Capsule& capsule, const Sphere& sphere)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	const Vector3ex delta = Subtract(sphere.center, ClosestPoint(sphere.center, capsule.segment));
+	const float radius = capsule.radius + sphere.radius;
+	return Dot(delta, delta) <= radius * radius;
+}
 
-	// 線分がAABBを貫通しているかどうかを判定
-	float tmin = std::max(std::max(tNearX, tNearY), tNearZ);
-	float tmax = std::min(std::min(tFarX, tFarY), tFarZ);
+bool MathFunction::IsCollision(const Capsule& capsule1, const Capsule& capsule2)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	Vector3ex point1;
+	Vector3ex point2;
+	ClosestPoints(capsule1.segment, capsule2.segment, point1, point2);
+	const Vector3ex delta = Subtract(point2, point1);
+	const float radius = capsule1.radius + capsule2.radius;
+	return Dot(delta, delta) <= radius * radius;
+}
+
+bool MathFunction::IsCollision(const Capsule& capsule, const Plane& plane)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	const float distance1 = Dot(plane.normal, capsule.segment.origin) - plane.distance;
+	const float distance2 = distance1 + Dot(plane.normal, capsule.segment.diff);
+	if (distance1 * distance2 <= 0.0f)
+	{
+		return true;
+	}
+	return std::min(std::fabs(distance1), std::fabs(distance2)) <= capsule.radius;
+}
+
+bool MathFunction::IsCollision(const Capsule& capsule, const AABB& aabb)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	// 線分が箱を通る場合はスラブ判定で決まる（重なっている時のGJKは反復が多い）
+	float tEnter;
+	float tExit;
+	if (IntersectSlab(aabb, Prepare(capsule.segment), tEnter, tExit))
+	{
+		return true;
+	}
+	// 離れていれば、半径0のカプセル（線分）と箱の距離をGJKで求める（角のある形同士なので正確に収束する）
+	const Capsule core{ capsule.segment, 0.0f };
+	const GjkResult result = GjkDistance(MakeConvex(core), MakeConvex(aabb));
+	return result.intersecting || result.distance <= capsule.radius;
+}
 
-	// 衝突しているかどうかの判定
-	if (tmin <= tmax && tmax >= 0.0f && tmin <= 1.0f) {
+bool MathFunction::IsCollision(const Capsule& capsule, const Triangle& triangle)
+{
+	PROFILE_COUNT(ProfileCounter::CollisionTests, 1);
+	if (IsCollision(triangle, capsule.segment))
+	{
 		return true;
 	}
+	// 交わらなければ、最も近い点の組は線分の端と三角形の組か、線分と三角形の辺の組のどちらか
+	const float radiusSquared = capsule.radius * capsule.radius;
+	const Vector3ex ends[2] = { capsule.segment.origin, Add(capsule.segment.origin, capsule.segment.diff) };
+	for (const Vector3ex& end : ends)
+	{
+		const Vector3ex delta = Subtract(end, ClosestPoint(end, triangle));
+		if (Dot(delta, delta) <= radiusSquared)
+		{
+			return true;
+		}
+	}
+	for (int i = 0; i < 3; ++i)
+	{
+		const Vector3ex& start = triangle.vertices[i];
+		const Segment edge{ start, Subtract(triangle.vertices[(i + 1) % 3], start) };
+		Vector3ex onSegment;
+		Vector3ex onEdge;
+		ClosestPoints(capsule.segment, edge, onSegment, onEdge);
+		const Vector3ex delta = Subtract(onSegment, onEdge);
+		if (Dot(delta, delta) <= radiusSquared)
+		{
+			return true;
+		}
+	}
 	return false;
 }
+
+size_t MathFunction::IsCollisionBatch(const OBB& obb, const OBBSoA& obbs, std::span<uint8_t> hits)
+{
+	const size_t count = obbs.GetCount();
+	assert(hits.size() >= count);
+	PROFILE_COUNT(ProfileCounter::CollisionTests, count);
+	const Float8 epsilon = Float8::Set1(1e-5f);
+
+	// 1つ目のOBBの軸と大きさは全レーンで共通
+	Float8 axis1[3][3];
+	Float8 size1[3];
+	const float sizes1[3] = { obb.size.x, obb.size.y, obb.size.z };
+	for (int i = 0; i < 3; ++i)
+	{
+		axis1[i][0] = Float8::Set1(obb.orientations[i].x);
+		axis1[i][1] = Float8::Set1(obb.orientations[i].y);
+		axis1[i][2] = Float8::Set1(obb.orientations[i].z);
+		size1[i] = Float8::Set1(sizes1[i]);
+	}
+	const Float8 centerX = Float8::Set1(obb.center.x);
+	const Float8 centerY = Float8::Set1(obb.center.y);
+	const Float8 centerZ = Float8::Set1(obb.center.z);
+
+	size_t hitCount = 0;
+	const size_t simdCount = count - count % Float8::kWidth;
+	for (size_t index = 0; index < simdCount; index += Float8::kWidth)
+	{
+		Float8 size2[3];
+		Float8 rotate[3][3];
+		Float8 absRotate[3][3];
+		for (int j = 0; j < 3; ++j)
+		{
+			const Float8 x = Float8::Load(&obbs.axisX[j][index]);
+			const Float8 y = Float8::Load(&obbs.axisY[j][index]);
+			const Float8 z = Float8::Load(&obbs.axisZ[j][index]);
+			for (int i = 0; i < 3; ++i)
+			{
+				rotate[i][j] = axis1[i][0] * x + axis1[i][1] * y + axis1[i][2] * z;
+				absRotate[i][j] = Abs(rotate[i][j]) + epsilon;
+			}
+			size2[j] = Float8::Load(&obbs.size[j][index]);
+		}
+		const Float8 dx = Float8::Load(&obbs.centerX[index]) - centerX;
+		const Float8 dy = Float8::Load(&obbs.centerY[index]) - centerY;
+		const Float8 dz = Float8::Load(&obbs.centerZ[index]) - centerZ;
+		Float8 t[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			t[i] = dx * axis1[i][0] + dy * axis1[i][1] + dz * axis1[i][2];
+		}
+
+		// スカラー版と同じ軸の順に、分離したレーンのビットを立てていく（0.0fは全ビット0なので全レーン未分離から始まる）
+		Float8 separated = Float8::Zero();
+		for (int i = 0; i < 3; ++i)
+		{
+			const Float8 radius2 = size2[0] * absRotate[i][0] + size2[1] * absRotate[i][1] + size2[2] * absRotate[i][2];
+			separated = separated | (Abs(t[i]) > size1[i] + radius2);
+		}
+		for (int j = 0; j < 3; ++j)
+		{
+			const Float8 radius1 = size1[0] * absRotate[0][j] + size1[1] * absRotate[1][j] + size1[2] * absRotate[2][j];
+			const Float8 distance = t[0] * rotate[0][j] + t[1] * rotate[1][j] + t[2] * rotate[2][j];
+			separated = separated | (Abs(distance) > radius1 + size2[j]);
+		}
+		// 8個とも面の軸で分離していれば辺の軸は調べない
+		if (separated.MoveMask() != 0xFF)
+		{
+			for (int i = 0; i < 3; ++i)
+			{
+				const int i1 = (i + 1) % 3;
+				const int i2 = (i + 2) % 3;
+				for (int j = 0; j < 3; ++j)
+				{
+					const int j1 = (j + 1) % 3;
+					const int j2 = (j + 2) % 3;
+					const Float8 radius1 = size1[i1] * absRotate[i2][j] + size1[i2] * absRotate[i1][j];
+					const Float8 radius2 = size2[j1] * absRotate[i][j2] + size2[j2] * absRotate[i][j1];
+					const Float8 distance = t[i2] * rotate[i1][j] - t[i1] * rotate[i2][j];
+					separated = separated | (Abs(distance) > radius1 + radius2);
+				}
+			}
+		}
+		const int mask = separated.MoveMask();
+		for (int lane = 0; lane < Float8::kWidth; ++lane)
+		{
+			const uint8_t hit = ((mask >> lane) & 1) == 0 ? 1 : 0;
+			hits[index + lane] = hit;
+			hitCount += hit;
+		}
+	}
+	for (size_t index = simdCount; index < count; ++index)
+	{
+		const uint8_t hit = IsCollision(obb, obbs.Get(index)) ? 1 : 0;
+		hits[index] = hit;
+		hitCount += hit;
+	}
+	return hitCount;
+}
@@ -4,17 +4,30 @@
 #define NOMINMAX
 #include "AABB.h"
 #include "Ball.h"
+#include "BezierPath.h"
+#include "Capsule.h"
+#include "Heightfield.h"
+#include "OBB.h"
+#include "OBBSoA.h"
+#include "ParticleSoA.h"
 #include "Math/Vector3ex.h"
 #include "Math/Matrix4x4ex.h"
 #include "Vector4.h"
 #include "Segment.h"
+#include "PreparedSegment.h"
+#include "Ray.h"
 #include "Sphereh.h"
 #include "Plane.h"
 #include "Triangle.h"
 #include <algorithm>
 #include <assert.h>
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <span>
+#ifdef _MSC_VER
 #include <corecrt_math_defines.h>
+#endif
 
 /// <summary>
 /// ベクトルと行列を合わせたクラス
@@ -91,13 +104,28 @@ public:
 	/// <returns></returns>
 	Vector3ex Project(const Vector3ex& v1, const Vector3ex& v2);
 	/// <summary>
-	/// 最近接点
+	/// 線分上の最近接点（tは0〜1に収める、長さ0の線分は始点）
 	/// </summary>
 	/// <param name="point"></param>
 	/// <param name="segment"></param>
 	/// <returns></returns>
 	Vector3ex ClosestPoint(const Vector3ex& point, const Segment& segment);
 	/// <summary>
+	/// 2つの線分の最近接点の組
+	/// </summary>
+	/// <param name="segment1">線分1</param>
+	/// <param name="segment2">線分2</param>
+	/// <param name="point1">線分1上の最近接点</param>
+	/// <param name="point2">線分2上の最近接点</param>
+	void ClosestPoints(const Segment& segment1, const Segment& segment2, Vector3ex& point1, Vector3ex& point2);
+	/// <summary>
+	/// 三角形上の最近接点
+	/// </summary>
+	/// <param name="point">点</param>
+	/// <param name="triangle">三角形</param>
+	/// <returns></returns>
+	Vector3ex ClosestPoint(const Vector3ex& point, const Triangle& triangle);
+	/// <summary>
 	/// 与えられたベクトルに垂直なベクトルを計算
 	/// </summary>
 	/// <param name="vector"></param>
@@ -127,6 +155,19 @@ public:
 	/// <returns></returns>
 	Vector3ex Reflect(const Vector3ex& input, const Vector3ex& normal);
 
+	/// <summary>
+	/// 線分をスラブ判定用に前処理する
+	/// </summary>
+	/// <param name="segment">線分</param>
+	/// <returns></returns>
+	PreparedSegment Prepare(const Segment& segment);
+	/// <summary>
+	/// 半直線をスラブ判定用に前処理する
+	/// </summary>
+	/// <param name="ray">半直線</param>
+	/// <returns></returns>
+	PreparedSegment Prepare(const Ray& ray);
+
 	/*----------Matrix型の関数----------*/
 
 	/// <summary>
@@ -206,6 +247,35 @@ public:
 	/// <returns></returns>
 	Matrix4x4ex MakeAffineMatrix(const Vector3ex& scale, const Vector3ex& radian, const Vector3ex& translate);
 	/// <summary>
+	/// 回転角からOBBを作る（軸はMakeAffineMatrixと同じ回転の各行）
+	/// </summary>
+	/// <param name="center">中心</param>
+	/// <param name="radian">回転角</param>
+	/// <param name="size">座標軸方向の長さの半分</param>
+	/// <returns></returns>
+	OBB MakeOBB(const Vector3ex& center, const Vector3ex& radian, const Vector3ex& size);
+	/// <summary>
+	/// 球がstartからendまで動いた軌跡のカプセル
+	/// </summary>
+	/// <param name="start">動く前の中心</param>
+	/// <param name="end">動いた後の中心</param>
+	/// <param name="radius">半径</param>
+	/// <returns></returns>
+	Capsule MakeSweptCapsule(const Vector3ex& start, const Vector3ex& end, float radius);
+	/// <summary>
+	/// ボールが今の速度でdeltaTimeだけ進む軌跡のカプセル
+	/// </summary>
+	/// <param name="ball">ボール</param>
+	/// <param name="deltaTime">時間</param>
+	/// <returns></returns>
+	Capsule MakeSweptCapsule(const Ball& ball, float deltaTime);
+	/// <summary>
+	/// -1〜1の立方体をOBBに写す行列（軸に長さを掛けたものを行に並べ、中心へ平行移動する）
+	/// </summary>
+	/// <param name="obb">OBB</param>
+	/// <returns></returns>
+	Matrix4x4ex MakeOBBWorldMatrix(const OBB& obb);
+	/// <summary>
 	/// 透視投影行列
 	/// </summary>
 	/// <param name="fovY"></param>
@@ -254,6 +324,19 @@ public:
 	/// <param name="color"></param>
 	void DrawSphere(const Sphere& sphere, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color);
 	/// <summary>
+	/// 多数の球体をまとめて描画
+	/// 中心だけを変換して画面上の半径を求め、小さい球は円（インポスター）1つで描く
+	/// 画面上の半径がwireframeRadius以上の球だけDrawSphereで分割して描く
+	/// </summary>
+	/// <param name="spheres">球体の配列</param>
+	/// <param name="viewProjectionMatrix">ビュー射影行列（ビューは回転と平行移動だけであること）</param>
+	/// <param name="viewportMatrix">ビューポート行列</param>
+	/// <param name="color">色</param>
+	/// <param name="filled">円を塗りつぶすならtrue</param>
+	/// <param name="wireframeRadius">分割して描く画面上の半径（ピクセル）</param>
+	/// <returns>描いた球の数（画面外とカメラの後ろを除く）</returns>
+	uint32_t DrawSpheres(std::span<const Sphere> spheres, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color, bool filled = false, float wireframeRadius = 24.0f);
+	/// <summary>
 	/// 平面を描画
 	/// </summary>
 	/// <param name="plane"></param>
@@ -278,6 +361,14 @@ public:
 	/// <param name="color"></param>
 	void DrawAABB(const AABB& aabb, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color);
 	/// <summary>
+	/// OBBを描画（ワールド、ビュー射影、ビューポートを1つの行列にまとめてから8頂点を変換する）
+	/// </summary>
+	/// <param name="obb"></param>
+	/// <param name="viewProjectionMatrix"></param>
+	/// <param name="viewportMatrix"></param>
+	/// <param name="color"></param>
+	void DrawOBB(const OBB& obb, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color);
+	/// <summary>
 	/// ベジエ曲線を描画
 	/// </summary>
 	/// <param name="controlPoint0"></param>
@@ -294,6 +385,34 @@ public:
 	/// <param name="viewProjection"></param>
 	/// <param name="viewportMatrix"></param>
 	void DrawControlPoint(const Vector3ex& controlPoint, const Matrix4x4ex& viewProjection, const Matrix4x4ex& viewportMatrix);
+	/// <summary>
+	/// ベジエ曲線の経路を描画（Buildで作った表の区間ごとに1本、曲がりの小さい所は長い線になる）
+	/// </summary>
+	/// <param name="path">Build済みの経路</param>
+	/// <param name="viewProjectionMatrix"></param>
+	/// <param name="viewportMatrix"></param>
+	/// <param name="color"></param>
+	/// <returns>描画した線の数</returns>
+	uint32_t DrawBezierPath(const BezierPath& path, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color);
+	/// <summary>
+	/// 地形をワイヤーフレームで描画（視錐台の外のブロックは描かず、遠いブロックは格子を間引く）
+	/// </summary>
+	/// <param name="heightfield">地形</param>
+	/// <param name="viewProjectionMatrix"></param>
+	/// <param name="viewportMatrix"></param>
+	/// <param name="color"></param>
+	/// <returns>描画した線の数</returns>
+	uint32_t DrawHeightfield(const Heightfield& heightfield, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color);
+	/// <summary>
+	/// 粒子を辺でつないだワイヤーフレームを描画（粒子は8個ずつまとめて1回だけ変換し、辺はその結果を結ぶ）
+	/// </summary>
+	/// <param name="particles">粒子</param>
+	/// <param name="edgeIndices">辺の両端の粒子の番号（2つで1本）</param>
+	/// <param name="viewProjectionMatrix"></param>
+	/// <param name="viewportMatrix"></param>
+	/// <param name="color"></param>
+	/// <returns>描画した線の数</returns>
+	uint32_t DrawParticleEdges(const ParticleSoA& particles, std::span<const uint32_t> edgeIndices, const Matrix4x4ex& viewProjectionMatrix, const Matrix4x4ex& viewportMatrix, uint32_t color);
 
 	/*----------衝突判定を取る関数----------*/
 
@@ -346,5 +465,94 @@ public:
 	/// <param name="segment">セグメント</param>
 	/// <returns></returns>
 	bool IsCollision(const AABB& aabb, const Segment& segment);
+	/// <summary>
+	/// AABBと前処理した線分の衝突判定（分岐なしのスラブ判定）
+	/// </summary>
+	/// <param name="aabb">AABB</param>
+	/// <param name="segment">前処理した線分</param>
+	/// <returns></returns>
+	bool IsCollision(const AABB& aabb, const PreparedSegment& segment);
+	/// <summary>
+	/// AABBと前処理した線分の交差区間を求める
+	/// </summary>
+	/// <param name="aabb">AABB</param>
+	/// <param name="segment">前処理した線分</param>
+	/// <param name="tEnter">入るt</param>
+	/// <param name="tExit">出るt</param>
+	/// <returns>交差していればtrue</returns>
+	bool IntersectSlab(const AABB& aabb, const PreparedSegment& segment, float& tEnter, float& tExit);
+	/// <summary>
+	/// OBBとOBBの衝突判定（15軸の分離軸判定）
+	/// 分離しやすく安い面の軸（Aの3軸、Bの3軸）を先に調べ、辺同士の9軸は最後に調べる
+	/// </summary>
+	/// <param name="obb1">OBB1</param>
+	/// <param name="obb2">OBB2</param>
+	/// <returns></returns>
+	bool IsCollision(const OBB& obb1, const OBB& obb2);
+	/// <summary>
+	/// OBBと球の衝突判定（球の中心をOBBの座標系に移して最近接点を求める）
+	/// </summary>
+	/// <param name="obb">OBB</param>
+	/// <param name="sphere">球</param>
+	/// <returns></returns>
+	bool IsCollision(const OBB& obb, const Sphere& sphere);
+	/// <summary>
+	/// OBBと線の衝突判定（線をOBBの座標系に移してスラブ判定）
+	/// </summary>
+	/// <param name="obb">OBB</param>
+	/// <param name="segment">セグメント</param>
+	/// <returns></returns>
+	bool IsCollision(const OBB& obb, const Segment& segment);
+	/// <summary>
+	/// OBBとAABBの衝突判定（AABBを軸が揃ったOBBとして分離軸判定）
+	/// </summary>
+	/// <param name="obb">OBB</param>
+	/// <param name="aabb">AABB</param>
+	/// <returns></returns>
+	bool IsCollision(const OBB& obb, const AABB& aabb);
+	/// <summary>
+	/// 1つのOBBと多数のOBBの衝突判定（8個ずつまとめて分離軸判定し、8個とも面の軸で分離したら辺の軸を省く）
+	/// </summary>
+	/// <param name="obb">OBB</param>
+	/// <param name="obbs">判定するOBBの配列</param>
+	/// <param name="hits">結果（衝突していれば1、obbsと同じ数）</param>
+	/// <returns>衝突した数</returns>
+	size_t IsCollisionBatch(const OBB& obb, const OBBSoA& obbs, std::span<uint8_t> hits);
+	/// <summary>
+	/// カプセルと球の衝突判定
+	/// </summary>
+	/// <param name="capsule">カプセル</param>
+	/// <param name="sphere">球</param>
+	/// <returns></returns>
+	bool IsCollision(const Capsule& capsule, const Sphere& sphere);
+	/// <summary>
+	/// カプセルとカプセルの衝突判定（中心の線分同士の距離を半径の和と比べる）
+	/// </summary>
+	/// <param name="capsule1">カプセル1</param>
+	/// <param name="capsule2">カプセル2</param>
+	/// <returns></returns>
+	bool IsCollision(const Capsule& capsule1, const Capsule& capsule2);
+	/// <summary>
+	/// カプセルと平面の衝突判定（両端が平面をまたぐか、近い方の端が半径以内なら衝突）
+	/// </summary>
+	/// <param name="capsule">カプセル</param>
+	/// <param name="plane">平面</param>
+	/// <returns></returns>
+	bool IsCollision(const Capsule& capsule, const Plane& plane);
+	/// <summary>
+	/// カプセルとAABBの衝突判定（中心の線分とAABBの距離をGJKで求めて半径と比べる）
+	/// </summary>
+	/// <param name="capsule">カプセル</param>
+	/// <param name="aabb">AABB</param>
+	/// <returns></returns>
+	bool IsCollision(const Capsule& capsule, const AABB& aabb);
+	/// <summary>
+	/// カプセルと三角形の衝突判定（中心の線分が三角形と交われば当たり。交わらなければ、線分の両端と三角形の最近点、
+	/// 線分と三角形の3辺の最近点の組の距離を半径と比べる）
+	/// </summary>
+	/// <param name="capsule">カプセル</param>
+	/// <param name="triangle">三角形</param>
+	/// <returns></returns>
+	bool IsCollision(const Capsule& capsule, const Triangle& triangle);
 };
 #endif // MATHFUNCTION_H
\ No newline at end of file
@@ -0,0 +1,227 @@
+#pragma once
+#include "VectorN.h"
+#include <cassert>
+
+/// <summary>
+/// 行と列の数を固定した行列（T m[R][C]だけを持ち、Matrix4x4exと同じ並び）
+/// ベクトルは行ベクトルとして左から掛ける
+/// </summary>
+template<class T, int R, int C>
+struct Matrix final
+{
+	T m[R][C];
+};
+
+using Matrix3x3f = Matrix<float, 3, 3>;
+using Matrix4x4f = Matrix<float, 4, 4>;
+using Matrix3x3d = Matrix<double, 3, 3>;
+using Matrix4x4d = Matrix<double, 4, 4>;
+
+static_assert(std::is_trivially_copyable_v<Matrix4x4f> && std::is_standard_layout_v<Matrix4x4f>, "Matrix4x4fは配列と同じ並び");
+static_assert(sizeof(Matrix4x4f) == sizeof(float) * 16, "Matrix4x4fに詰め物があってはいけない");
+
+template<class T, int R, int C>
+inline Matrix<T, R, C> operator+(const Matrix<T, R, C>& a, const Matrix<T, R, C>& b)
+{
+	Matrix<T, R, C> result;
+	for (int i = 0; i < R; ++i)
+	{
+		for (int j = 0; j < C; ++j)
+		{
+			result.m[i][j] = a.m[i][j] + b.m[i][j];
+		}
+	}
+	return result;
+}
+
+template<class T, int R, int C>
+inline Matrix<T, R, C> operator-(const Matrix<T, R, C>& a, const Matrix<T, R, C>& b)
+{
+	Matrix<T, R, C> result;
+	for (int i = 0; i < R; ++i)
+	{
+		for (int j = 0; j < C; ++j)
+		{
+			result.m[i][j] = a.m[i][j] - b.m[i][j];
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// 行列の積
+/// </summary>
+template<class T, int R, int K, int C>
+inline Matrix<T, R, C> operator*(const Matrix<T, R, K>& a, const Matrix<T, K, C>& b)
+{
+	Matrix<T, R, C> result;
+	if constexpr (std::is_same_v<T, float> && R == 4 && K == 4 && C == 4)
+	{
+		// 結果のi行目 = Σk a[i][k] * (bのk行目)
+		const __m128 row0 = _mm_loadu_ps(b.m[0]);
+		const __m128 row1 = _mm_loadu_ps(b.m[1]);
+		const __m128 row2 = _mm_loadu_ps(b.m[2]);
+		const __m128 row3 = _mm_loadu_ps(b.m[3]);
+		for (int i = 0; i < 4; ++i)
+		{
+			__m128 sum = _mm_mul_ps(_mm_set1_ps(a.m[i][0]), row0);
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a.m[i][1]), row1));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a.m[i][2]), row2));
+			sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(a.m[i][3]), row3));
+			_mm_storeu_ps(result.m[i], sum);
+		}
+	}
+	else
+	{
+		for (int i = 0; i < R; ++i)
+		{
+			for (int j = 0; j < C; ++j)
+			{
+				T sum = a.m[i][0] * b.m[0][j];
+				for (int k = 1; k < K; ++k)
+				{
+					sum += a.m[i][k] * b.m[k][j];
+				}
+				result.m[i][j] = sum;
+			}
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// 行ベクトルと行列の積（v * M）
+/// </summary>
+template<class T, int N>
+inline Vector<T, N> operator*(const Vector<T, N>& v, const Matrix<T, N, N>& m)
+{
+	Vector<T, N> result;
+	if constexpr (std::is_same_v<T, float> && N == 4)
+	{
+		__m128 sum = _mm_mul_ps(_mm_set1_ps(v.v[0]), _mm_loadu_ps(m.m[0]));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(v.v[1]), _mm_loadu_ps(m.m[1])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(v.v[2]), _mm_loadu_ps(m.m[2])));
+		sum = _mm_add_ps(sum, _mm_mul_ps(_mm_set1_ps(v.v[3]), _mm_loadu_ps(m.m[3])));
+		VectorSimd::Store(result, sum);
+	}
+	else
+	{
+		for (int j = 0; j < N; ++j)
+		{
+			T sum = v.v[0] * m.m[0][j];
+			for (int k = 1; k < N; ++k)
+			{
+				sum += v.v[k] * m.m[k][j];
+			}
+			result.v[j] = sum;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// 点を同次座標(x, y, z, 1)として変換し、wで割る
+/// </summary>
+template<class T>
+inline Vector<T, 3> TransformPoint(const Vector<T, 3>& point, const Matrix<T, 4, 4>& m)
+{
+	const Vector<T, 4> h = Vector<T, 4>{ { point.v[0], point.v[1], point.v[2], T(1) } } * m;
+	const T w = h.v[3];
+	assert(w != T(0));
+	return Vector<T, 3>{ { h.v[0] / w, h.v[1] / w, h.v[2] / w } };
+}
+
+/// <summary>
+/// 転置
+/// </summary>
+template<class T, int R, int C>
+inline Matrix<T, C, R> Transpose(const Matrix<T, R, C>& a)
+{
+	Matrix<T, C, R> result;
+	for (int i = 0; i < R; ++i)
+	{
+		for (int j = 0; j < C; ++j)
+		{
+			result.m[j][i] = a.m[i][j];
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// 単位行列
+/// </summary>
+template<class T, int N>
+inline Matrix<T, N, N> Identity()
+{
+	Matrix<T, N, N> result{};
+	for (int i = 0; i < N; ++i)
+	{
+		result.m[i][i] = T(1);
+	}
+	return result;
+}
+
+/// <summary>
+/// 4x4の逆行列
+/// 上2行と下2行の2x2小行列式を6個ずつ先に求め、余因子をそれらの組み合わせで作る
+/// </summary>
+template<class T>
+inline Matrix<T, 4, 4> Inverse(const Matrix<T, 4, 4>& a)
+{
+	const T s0 = a.m[0][0] * a.m[1][1] - a.m[1][0] * a.m[0][1];
+	const T s1 = a.m[0][0] * a.m[1][2] - a.m[1][0] * a.m[0][2];
+	const T s2 = a.m[0][0] * a.m[1][3] - a.m[1][0] * a.m[0][3];
+	const T s3 = a.m[0][1] * a.m[1][2] - a.m[1][1] * a.m[0][2];
+	const T s4 = a.m[0][1] * a.m[1][3] - a.m[1][1] * a.m[0][3];
+	const T s5 = a.m[0][2] * a.m[1][3] - a.m[1][2] * a.m[0][3];
+
+	const T c5 = a.m[2][2] * a.m[3][3] - a.m[3][2] * a.m[2][3];
+	const T c4 = a.m[2][1] * a.m[3][3] - a.m[3][1] * a.m[2][3];
+	const T c3 = a.m[2][1] * a.m[3][2] - a.m[3][1] * a.m[2][2];
+	const T c2 = a.m[2][0] * a.m[3][3] - a.m[3][0] * a.m[2][3];
+	const T c1 = a.m[2][0] * a.m[3][2] - a.m[3][0] * a.m[2][2];
+	const T c0 = a.m[2][0] * a.m[3][1] - a.m[3][0] * a.m[2][1];
+
+	const T det = s0 * c5 - s1 * c4 + s2 * c3 + s3 * c2 - s4 * c1 + s5 * c0;
+	const T inv = T(1) / det;
+
+	Matrix<T, 4, 4> result;
+	result.m[0][0] = (a.m[1][1] * c5 - a.m[1][2] * c4 + a.m[1][3] * c3) * inv;
+	result.m[0][1] = (-a.m[0][1] * c5 + a.m[0][2] * c4 - a.m[0][3] * c3) * inv;
+	result.m[0][2] = (a.m[3][1] * s5 - a.m[3][2] * s4 + a.m[3][3] * s3) * inv;
+	result.m[0][3] = (-a.m[2][1] * s5 + a.m[2][2] * s4 - a.m[2][3] * s3) * inv;
+
+	result.m[1][0] = (-a.m[1][0] * c5 + a.m[1][2] * c2 - a.m[1][3] * c1) * inv;
+	result.m[1][1] = (a.m[0][0] * c5 - a.m[0][2] * c2 + a.m[0][3] * c1) * inv;
+	result.m[1][2] = (-a.m[3][0] * s5 + a.m[3][2] * s2 - a.m[3][3] * s1) * inv;
+	result.m[1][3] = (a.m[2][0] * s5 - a.m[2][2] * s2 + a.m[2][3] * s1) * inv;
+
+	result.m[2][0] = (a.m[1][0] * c4 - a.m[1][1] * c2 + a.m[1][3] * c0) * inv;
+	result.m[2][1] = (-a.m[0][0] * c4 + a.m[0][1] * c2 - a.m[0][3] * c0) * inv;
+	result.m[2][2] = (a.m[3][0] * s4 - a.m[3][1] * s2 + a.m[3][3] * s0) * inv;
+	result.m[2][3] = (-a.m[2][0] * s4 + a.m[2][1] * s2 - a.m[2][3] * s0) * inv;
+
+	result.m[3][0] = (-a.m[1][0] * c3 + a.m[1][1] * c1 - a.m[1][2] * c0) * inv;
+	result.m[3][1] = (a.m[0][0] * c3 - a.m[0][1] * c1 + a.m[0][2] * c0) * inv;
+	result.m[3][2] = (-a.m[3][0] * s3 + a.m[3][1] * s1 - a.m[3][2] * s0) * inv;
+	result.m[3][3] = (a.m[2][0] * s3 - a.m[2][1] * s1 + a.m[2][2] * s0) * inv;
+	return result;
+}
+
+/// <summary>
+/// 要素の型を変える（floatとdoubleの行き来）
+/// </summary>
+template<class To, class From, int R, int C>
+inline Matrix<To, R, C> Convert(const Matrix<From, R, C>& a)
+{
+	Matrix<To, R, C> result;
+	for (int i = 0; i < R; ++i)
+	{
+		for (int j = 0; j < C; ++j)
+		{
+			result.m[i][j] = static_cast<To>(a.m[i][j]);
+		}
+	}
+	return result;
+}
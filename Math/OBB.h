@@ -0,0 +1,29 @@
+#pragma once
+#include "Vector3ex.h"
+
+//OBB（回転できる直方体）
+struct OBB final
+{
+	Vector3ex center;			//!< 中心
+	Vector3ex orientations[3];	//!< 座標軸（正規化済み、互いに直交）
+	Vector3ex size;				//!< 座標軸方向の長さの半分
+
+	/// <summary>
+	/// サポート写像（direction方向に最も遠い頂点）
+	/// </summary>
+	/// <param name="direction">方向</param>
+	/// <returns></returns>
+	Vector3ex Support(const Vector3ex& direction) const
+	{
+		const float half[3] = { size.x, size.y, size.z };
+		Vector3ex result = center;
+		for (int i = 0; i < 3; ++i)
+		{
+			const Vector3ex& axis = orientations[i];
+			const float dot = axis.x * direction.x + axis.y * direction.y + axis.z * direction.z;
+			const float extent = dot >= 0.0f ? half[i] : -half[i];
+			result = { result.x + axis.x * extent, result.y + axis.y * extent, result.z + axis.z * extent };
+		}
+		return result;
+	}
+};
@@ -0,0 +1,81 @@
+#pragma once
+#include "OBB.h"
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// OBBを成分ごとの配列で持つ（i番目の軸のx成分はaxisX[i][OBBの番号]）
+/// 1つのOBBと多数のOBBの分離軸判定を、8個ずつまとめてSIMDで行うための形
+/// </summary>
+struct OBBSoA final
+{
+	std::vector<float> centerX;
+	std::vector<float> centerY;
+	std::vector<float> centerZ;
+	std::vector<float> axisX[3];
+	std::vector<float> axisY[3];
+	std::vector<float> axisZ[3];
+	std::vector<float> size[3];
+
+	/// <summary>
+	/// OBBの数を変える（増えた分は0になる）
+	/// </summary>
+	void Resize(size_t count)
+	{
+		centerX.resize(count);
+		centerY.resize(count);
+		centerZ.resize(count);
+		for (int i = 0; i < 3; ++i)
+		{
+			axisX[i].resize(count);
+			axisY[i].resize(count);
+			axisZ[i].resize(count);
+			size[i].resize(count);
+		}
+	}
+
+	size_t GetCount() const { return centerX.size(); }
+
+	/// <summary>
+	/// 末尾に追加する
+	/// </summary>
+	void Add(const OBB& obb)
+	{
+		Resize(GetCount() + 1);
+		Set(GetCount() - 1, obb);
+	}
+
+	/// <summary>
+	/// i番目のOBBを取り出す
+	/// </summary>
+	OBB Get(size_t i) const
+	{
+		OBB obb{};
+		obb.center = Vector3ex(centerX[i], centerY[i], centerZ[i]);
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			obb.orientations[axis] = Vector3ex(axisX[axis][i], axisY[axis][i], axisZ[axis][i]);
+		}
+		obb.size = Vector3ex(size[0][i], size[1][i], size[2][i]);
+		return obb;
+	}
+
+	/// <summary>
+	/// i番目のOBBを書き込む
+	/// </summary>
+	void Set(size_t i, const OBB& obb)
+	{
+		centerX[i] = obb.center.x;
+		centerY[i] = obb.center.y;
+		centerZ[i] = obb.center.z;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			axisX[axis][i] = obb.orientations[axis].x;
+			axisY[axis][i] = obb.orientations[axis].y;
+			axisZ[axis][i] = obb.orientations[axis].z;
+		}
+		size[0][i] = obb.size.x;
+		size[1][i] = obb.size.y;
+		size[2][i] = obb.size.z;
+	}
+};
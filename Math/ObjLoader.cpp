@@ -0,0 +1,483 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+
+namespace
+{
+	/// <summary>
+	/// 改行の位置で区切った解析の単位（解析結果はチャンクごとに持ち、最後に1つへまとめる）
+	/// </summary>
+	struct Chunk
+	{
+		const char* begin = nullptr;
+		const char* end = nullptr;
+		std::vector<Vector3ex> positions;
+		std::vector<uint32_t> indices;			// 正の番号は0始まりの絶対番号、負の番号はこのチャンクの先頭からの位置
+		std::vector<size_t> relativeIndices;	// 負の番号で書かれた要素の位置（まとめる時にvertexBaseを足す）
+		size_t lineCount = 0;
+		int64_t maxIndex = -1;					// 正の番号の最大（頂点数が揃ってから範囲を調べる）
+		size_t maxIndexLine = 0;
+		int64_t minRelative = 0;				// 負の番号が指す位置の最小（前のチャンクの頂点数で範囲を調べる）
+		size_t minRelativeLine = 0;
+		size_t lineBase = 0;					// 前のチャンクまでの行数
+		size_t vertexBase = 0;					// 前のチャンクまでの頂点数
+		size_t triangleBase = 0;				// 前のチャンクまでの三角形数
+		const char* error = nullptr;
+		size_t errorLine = 0;					// チャンク内で0始まり
+	};
+
+	/// <summary>
+	/// 0からcount-1までをthreadCount本のスレッドで分け合って実行する（呼び出し元のスレッドも働く）
+	/// </summary>
+	template<class Body>
+	void ParallelFor(size_t count, uint32_t threadCount, Body&& body)
+	{
+		if (count == 0)
+		{
+			return;
+		}
+		std::atomic<size_t> next{ 0 };
+		auto work = [&]() {
+			for (size_t i = next.fetch_add(1, std::memory_order_relaxed); i < count; i = next.fetch_add(1, std::memory_order_relaxed))
+			{
+				body(i);
+			}
+		};
+
+		const size_t helperCount = std::min<size_t>(threadCount, count) - 1;
+		std::vector<std::thread> helpers;
+		helpers.reserve(helperCount);
+		for (size_t i = 0; i < helperCount; ++i)
+		{
+			helpers.emplace_back(work);
+		}
+		work();
+		for (std::thread& helper : helpers)
+		{
+			helper.join();
+		}
+	}
+
+	bool IsSpace(char c) { return c == ' ' || c == '\t'; }
+	bool IsDigit(char c) { return static_cast<unsigned char>(c - '0') < 10; }
+
+	/// <summary>
+	/// 次の行の終わり（改行の位置、無ければend）
+	/// </summary>
+	const char* FindLineEnd(const char* p, const char* end)
+	{
+		const void* newline = std::memchr(p, '\n', static_cast<size_t>(end - p));
+		return newline != nullptr ? static_cast<const char*>(newline) : end;
+	}
+
+	/// <summary>
+	/// 空白を飛ばす
+	/// </summary>
+	const char* SkipSpace(const char* p, const char* end)
+	{
+		while (p < end && IsSpace(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	/// <summary>
+	/// 空白以外を飛ばす
+	/// </summary>
+	const char* SkipToken(const char* p, const char* end)
+	{
+		while (p < end && !IsSpace(*p))
+		{
+			++p;
+		}
+		return p;
+	}
+
+	/// <summary>
+	/// 行の種類（先頭の単語が1文字でkeywordと一致するか）
+	/// </summary>
+	bool IsKeyword(const char* p, const char* end, char keyword)
+	{
+		return p < end && *p == keyword && (p + 1 == end || IsSpace(p[1]));
+	}
+
+	/// <summary>
+	/// 10の累乗（doubleで正確に表せる範囲）
+	/// </summary>
+	constexpr double kPow10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+	constexpr int kMaxExactPow10 = 22;
+
+	/// <summary>
+	/// 小数を読む（[+-]digits[.digits][(e|E)[+-]digits]）
+	/// 有効数字19桁までを整数として集め、10の累乗を1回だけ掛ける
+	/// </summary>
+	/// <param name="p">読み始める位置（成功したら読み終えた位置に進む）</param>
+	/// <param name="end">行の終わり</param>
+	/// <param name="out">値</param>
+	/// <returns>数字が1つも無ければfalse</returns>
+	bool ParseFloat(const char*& p, const char* end, float& out)
+	{
+		const char* s = p;
+		bool negative = false;
+		if (s < end && (*s == '-' || *s == '+'))
+		{
+			negative = *s == '-';
+			++s;
+		}
+
+		uint64_t mantissa = 0;
+		int digits = 0;		// mantissaに入れた有効数字の桁数
+		int exponent = 0;
+		bool any = false;
+		for (; s < end && IsDigit(*s); ++s)
+		{
+			any = true;
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+				digits += mantissa != 0 ? 1 : 0;
+			}
+			else
+			{
+				++exponent;
+			}
+		}
+		if (s < end && *s == '.')
+		{
+			for (++s; s < end && IsDigit(*s); ++s)
+			{
+				any = true;
+				if (digits < 19)
+				{
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*s - '0');
+					digits += mantissa != 0 ? 1 : 0;
+					--exponent;
+				}
+			}
+		}
+		if (!any)
+		{
+			return false;
+		}
+
+		// 指数部（eの後に数字が無ければ指数ではないとみなす）
+		if (s < end && (*s == 'e' || *s == 'E'))
+		{
+			const char* e = s + 1;
+			bool negativeExponent = false;
+			if (e < end && (*e == '-' || *e == '+'))
+			{
+				negativeExponent = *e == '-';
+				++e;
+			}
+			if (e < end && IsDigit(*e))
+			{
+				int value = 0;
+				for (; e < end && IsDigit(*e); ++e)
+				{
+					value = std::min(value * 10 + (*e - '0'), 100000);
+				}
+				exponent += negativeExponent ? -value : value;
+				s = e;
+			}
+		}
+
+		double value = static_cast<double>(mantissa);
+		if (mantissa != 0 && exponent != 0)
+		{
+			if (exponent > 0 && exponent <= kMaxExactPow10)
+			{
+				value *= kPow10[exponent];
+			}
+			else if (exponent < 0 && exponent >= -kMaxExactPow10)
+			{
+				value /= kPow10[-exponent];
+			}
+			else
+			{
+				value *= std::pow(10.0, exponent);
+			}
+		}
+		out = static_cast<float>(negative ? -value : value);
+		p = s;
+		return true;
+	}
+
+	/// <summary>
+	/// 面の頂点番号を読む（"v"、"v/vt"、"v//vn"、"v/vt/vn"の先頭だけ）
+	/// </summary>
+	bool ParseIndex(const char*& p, const char* end, int64_t& out)
+	{
+		const char* s = p;
+		bool negative = false;
+		if (s < end && *s == '-')
+		{
+			negative = true;
+			++s;
+		}
+		if (s == end || !IsDigit(*s))
+		{
+			return false;
+		}
+		int64_t value = 0;
+		for (; s < end && IsDigit(*s); ++s)
+		{
+			value = std::min<int64_t>(value * 10 + (*s - '0'), std::numeric_limits<uint32_t>::max());
+		}
+		out = negative ? -value : value;
+		p = s;
+		return true;
+	}
+
+	/// <summary>
+	/// チャンクを解析する（頂点番号の範囲は全体の頂点数が分かってから調べる）
+	/// </summary>
+	void ParseChunk(Chunk& chunk)
+	{
+		// 1行あたりの大きさはおよそ30～60バイトなので、再確保が数回で済む程度に見積もる
+		const size_t bytes = static_cast<size_t>(chunk.end - chunk.begin);
+		chunk.positions.reserve(bytes / 64);
+		chunk.indices.reserve(bytes / 16);
+
+		size_t& line = chunk.lineCount;
+		for (const char* p = chunk.begin; p < chunk.end; ++line)
+		{
+			const char* lineEnd = FindLineEnd(p, chunk.end);
+			const char* s = SkipSpace(p, lineEnd);
+			if (IsKeyword(s, lineEnd, 'v'))
+			{
+				float xyz[3];
+				s = SkipSpace(s + 1, lineEnd);
+				for (float& value : xyz)
+				{
+					if (!ParseFloat(s, lineEnd, value))
+					{
+						chunk.error = "頂点の座標が読めない";
+						chunk.errorLine = line;
+						return;
+					}
+					s = SkipSpace(s, lineEnd);
+				}
+				chunk.positions.emplace_back(xyz[0], xyz[1], xyz[2]);
+			}
+			else if (IsKeyword(s, lineEnd, 'f'))
+			{
+				// 負の番号はこの行までに出てきた頂点からの相対位置
+				const int64_t seen = static_cast<int64_t>(chunk.positions.size());
+				uint32_t first = 0;
+				uint32_t previous = 0;
+				bool firstRelative = false;
+				bool previousRelative = false;
+				size_t corner = 0;
+				for (s = SkipSpace(s + 1, lineEnd); s < lineEnd && *s != '\r'; s = SkipSpace(SkipToken(s, lineEnd), lineEnd), ++corner)
+				{
+					int64_t value = 0;
+					if (!ParseIndex(s, lineEnd, value) || value == 0)
+					{
+						chunk.error = "面の頂点番号が読めない";
+						chunk.errorLine = line;
+						return;
+					}
+
+					uint32_t current = 0;
+					const bool relative = value < 0;
+					if (relative)
+					{
+						const int64_t local = seen + value;
+						if (local < chunk.minRelative)
+						{
+							chunk.minRelative = local;
+							chunk.minRelativeLine = line;
+						}
+						// 負になっても2の補数で持ち、vertexBaseを足せば正しい番号に戻る
+						current = static_cast<uint32_t>(local);
+					}
+					else
+					{
+						if (value - 1 > chunk.maxIndex)
+						{
+							chunk.maxIndex = value - 1;
+							chunk.maxIndexLine = line;
+						}
+						current = static_cast<uint32_t>(value - 1);
+					}
+
+					// 扇形に分割する（0, i-1, i）
+					if (corner == 0)
+					{
+						first = current;
+						firstRelative = relative;
+					}
+					else if (corner >= 2)
+					{
+						const size_t base = chunk.indices.size();
+						chunk.indices.insert(chunk.indices.end(), { first, previous, current });
+						if (firstRelative)
+						{
+							chunk.relativeIndices.push_back(base);
+						}
+						if (previousRelative)
+						{
+							chunk.relativeIndices.push_back(base + 1);
+						}
+						if (relative)
+						{
+							chunk.relativeIndices.push_back(base + 2);
+						}
+					}
+					previous = current;
+					previousRelative = relative;
+				}
+				if (corner < 3)
+				{
+					chunk.error = "面の頂点が3つ未満";
+					chunk.errorLine = line;
+					return;
+				}
+			}
+			p = lineEnd < chunk.end ? lineEnd + 1 : chunk.end;
+		}
+	}
+
+	void SetError(ObjLoadError* error, const char* message, size_t line)
+	{
+		if (error != nullptr)
+		{
+			error->message = message;
+			error->line = line;
+		}
+	}
+}
+
+bool LoadObj(const char* path, ObjMesh& mesh, const ObjLoadOptions& options, ObjLoadError* error)
+{
+	MappedFile file;
+	if (!file.Open(path))
+	{
+		mesh = ObjMesh{};
+		SetError(error, "ファイルを開けない", 0);
+		return false;
+	}
+	return ParseObj(reinterpret_cast<const char*>(file.GetData()), file.GetSize(), mesh, options, error);
+}
+
+bool ParseObj(const char* data, size_t size, ObjMesh& mesh, const ObjLoadOptions& options, ObjLoadError* error)
+{
+	mesh = ObjMesh{};
+	const uint32_t threadCount = options.threadCount != 0 ? options.threadCount : std::max(1u, std::thread::hardware_concurrency());
+
+	// 改行の直後で区切る（スレッド数の4倍まで分けて、行の偏りがあっても負荷をならす）
+	const size_t wanted = std::clamp<size_t>(size / std::max<size_t>(options.minChunkBytes, 1), 1, static_cast<size_t>(threadCount) * 4);
+	std::vector<Chunk> chunks;
+	chunks.reserve(wanted);
+	const char* const end = data + size;
+	const char* begin = data;
+	for (size_t i = 1; i <= wanted && begin < end; ++i)
+	{
+		const char* split = i == wanted ? end : std::max(begin, data + size / wanted * i);
+		if (split < end)
+		{
+			split = FindLineEnd(split, end);
+			split = split < end ? split + 1 : end;
+		}
+		Chunk& chunk = chunks.emplace_back();
+		chunk.begin = begin;
+		chunk.end = split;
+		begin = split;
+	}
+
+	// 1段目：チャンクごとに解析する
+	ParallelFor(chunks.size(), threadCount, [&](size_t i) { ParseChunk(chunks[i]); });
+
+	size_t lines = 0;
+	size_t vertices = 0;
+	size_t triangles = 0;
+	for (Chunk& chunk : chunks)
+	{
+		chunk.lineBase = lines;
+		chunk.vertexBase = vertices;
+		chunk.triangleBase = triangles;
+		lines += chunk.lineCount;
+		vertices += chunk.positions.size();
+		triangles += chunk.indices.size() / 3;
+	}
+	if (vertices > std::numeric_limits<uint32_t>::max())
+	{
+		SetError(error, "頂点が多すぎる", 0);
+		return false;
+	}
+
+	// 解析の誤りを先に返す（途中で止まったチャンクがあると頂点数が揃わない）
+	for (const Chunk& chunk : chunks)
+	{
+		if (chunk.error != nullptr)
+		{
+			SetError(error, chunk.error, chunk.lineBase + chunk.errorLine + 1);
+			return false;
+		}
+	}
+
+	// 頂点数が揃ったので番号の範囲を調べる
+	for (const Chunk& chunk : chunks)
+	{
+		size_t line = 0;
+		if (chunk.maxIndex >= static_cast<int64_t>(vertices))
+		{
+			line = chunk.maxIndexLine;
+		}
+		else if (chunk.minRelative + static_cast<int64_t>(chunk.vertexBase) < 0)
+		{
+			line = chunk.minRelativeLine;
+		}
+		else
+		{
+			continue;
+		}
+		SetError(error, "面の頂点番号が範囲外", chunk.lineBase + line + 1);
+		return false;
+	}
+
+	// 2段目：頂点をまとめる
+	mesh.positions.resize(vertices);
+	ParallelFor(chunks.size(), threadCount, [&](size_t i) {
+		const Chunk& chunk = chunks[i];
+		std::copy(chunk.positions.begin(), chunk.positions.end(), mesh.positions.begin() + static_cast<ptrdiff_t>(chunk.vertexBase));
+	});
+
+	// 3段目：頂点番号をまとめながら、番号を引いて成分ごとの配列を作る
+	mesh.indices.resize(triangles * 3);
+	mesh.triangles.Resize(triangles);
+	ParallelFor(chunks.size(), threadCount, [&](size_t i) {
+		Chunk& chunk = chunks[i];
+		for (size_t relative : chunk.relativeIndices)
+		{
+			chunk.indices[relative] += static_cast<uint32_t>(chunk.vertexBase);
+		}
+		std::copy(chunk.indices.begin(), chunk.indices.end(), mesh.indices.begin() + static_cast<ptrdiff_t>(chunk.triangleBase * 3));
+
+		const size_t count = chunk.indices.size() / 3;
+		for (int v = 0; v < 3; ++v)
+		{
+			float* x = mesh.triangles.x[v].data() + chunk.triangleBase;
+			float* y = mesh.triangles.y[v].data() + chunk.triangleBase;
+			float* z = mesh.triangles.z[v].data() + chunk.triangleBase;
+			for (size_t t = 0; t < count; ++t)
+			{
+				const Vector3ex& position = mesh.positions[chunk.indices[t * 3 + v]];
+				x[t] = position.x;
+				y[t] = position.y;
+				z[t] = position.z;
+			}
+		}
+	});
+	return true;
+}
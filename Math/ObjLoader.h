@@ -0,0 +1,58 @@
+#pragma once
+#include "TriangleSoA.h"
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// OBJから読み込んだ形状（位置と面だけ、多角形は扇形に三角形へ分割する）
+/// </summary>
+struct ObjMesh final
+{
+	std::vector<Vector3ex> positions;	// 頂点の位置
+	std::vector<uint32_t> indices;		// 三角形ごとに3つの頂点番号（0始まり）
+	TriangleSoA triangles;				// 頂点番号を引いた後の三角形
+
+	size_t GetTriangleCount() const { return indices.size() / 3; }
+};
+
+/// <summary>
+/// 読み込みの設定
+/// </summary>
+struct ObjLoadOptions final
+{
+	uint32_t threadCount = 0;				// 解析に使うスレッド数（0ならハードウェアの数）
+	size_t minChunkBytes = 1 << 20;			// これより小さくは分割しない（小さいファイルは1スレッドで読む）
+};
+
+/// <summary>
+/// 読み込みに失敗した理由
+/// </summary>
+struct ObjLoadError final
+{
+	const char* message = nullptr;	// 理由（静的な文字列）
+	size_t line = 0;				// 1始まりの行番号（ファイルを開けなかった時は0）
+};
+
+/// <summary>
+/// OBJファイルをメモリマップして読み込む
+/// </summary>
+/// <param name="path">ファイルパス</param>
+/// <param name="mesh">出力先（失敗したら空になる）</param>
+/// <param name="options">設定</param>
+/// <param name="error">失敗した理由（不要ならnullptr）</param>
+/// <returns>成功したらtrue</returns>
+bool LoadObj(const char* path, ObjMesh& mesh, const ObjLoadOptions& options = {}, ObjLoadError* error = nullptr);
+
+/// <summary>
+/// メモリ上のOBJテキストを解析する
+/// 改行の位置でチャンクに分けて並列に解析し、頂点と面をまとめて三角形を組み立てるところも並列に行う
+/// </summary>
+/// <param name="data">テキストの先頭（終端文字は不要）</param>
+/// <param name="size">バイト数</param>
+/// <param name="mesh">出力先（失敗したら空になる）</param>
+/// <param name="options">設定</param>
+/// <param name="error">失敗した理由（不要ならnullptr）</param>
+/// <returns>成功したらtrue</returns>
+bool ParseObj(const char* data, size_t size, ObjMesh& mesh, const ObjLoadOptions& options = {}, ObjLoadError* error = nullptr);
@@ -1,5 +1,6 @@
 #include "Matrix4x4ex.h"
 #include "Vector3ex.h"
+#include "CoreLayout.h"
 
 
 
@@ -22,33 +23,17 @@ Matrix4x4ex::Matrix4x4ex(float elements[4][4]) {
 }
 
 Matrix4x4ex& Matrix4x4ex::operator+=(const Matrix4x4ex& other) {
-	// 加算の実装
-	for (int i = 0; i < 4; ++i)
-		for (int j = 0; j < 4; ++j)
-			m[i][j] += other.m[i][j];
+	*this = FromCore<Matrix4x4ex>(ToCore(*this) + ToCore(other));
 	return *this;
 }
 
 Matrix4x4ex& Matrix4x4ex::operator-=(const Matrix4x4ex& other) {
-	// 減算の実装
-	for (int i = 0; i < 4; ++i)
-		for (int j = 0; j < 4; ++j)
-			m[i][j] -= other.m[i][j];
+	*this = FromCore<Matrix4x4ex>(ToCore(*this) - ToCore(other));
 	return *this;
 }
 
 Matrix4x4ex& Matrix4x4ex::operator*=(const Matrix4x4ex& other) {
-	// 乗算の実装
-	Matrix4x4ex result;
-	for (int i = 0; i < 4; ++i) {
-		for (int j = 0; j < 4; ++j) {
-			result.m[i][j] = 0;
-			for (int k = 0; k < 4; ++k) {
-				result.m[i][j] += m[i][k] * other.m[k][j];
-			}
-		}
-	}
-	*this = result;
+	*this = FromCore<Matrix4x4ex>(ToCore(*this) * ToCore(other));
 	return *this;
 }
 
@@ -79,23 +64,17 @@ Vector3ex Vector3ex::operator-() const { return Vector3ex(-x, -y, -z); }
 Vector3ex Vector3ex::operator+() const { return *this; }
 
 Vector3ex& Vector3ex::operator+=(const Vector3ex& other) {
-	x += other.x;
-	y += other.y;
-	z += other.z;
+	*this = FromCore<Vector3ex>(ToCore(*this) + ToCore(other));
 	return *this;
 }
 
 Vector3ex& Vector3ex::operator-=(const Vector3ex& other) {
-	x -= other.x;
-	y -= other.y;
-	z -= other.z;
+	*this = FromCore<Vector3ex>(ToCore(*this) - ToCore(other));
 	return *this;
 }
 
 Vector3ex& Vector3ex::operator*=(float s) {
-	x *= s;
-	y *= s;
-	z *= s;
+	*this = FromCore<Vector3ex>(ToCore(*this) * s);
 	return *this;
 }
 
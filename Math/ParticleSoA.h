@@ -0,0 +1,56 @@
+#pragma once
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// 粒子の現在と1ステップ前の位置、質量の逆数を成分ごとの配列で持つ（ベルレ積分で速度は位置の差から求める）
+/// </summary>
+struct ParticleSoA final
+{
+	std::vector<float> positionX;
+	std::vector<float> positionY;
+	std::vector<float> positionZ;
+	std::vector<float> previousX;
+	std::vector<float> previousY;
+	std::vector<float> previousZ;
+	std::vector<float> inverseMass;	// 0なら固定された粒子
+
+	size_t GetCount() const { return positionX.size(); }
+
+	void Clear()
+	{
+		positionX.clear();
+		positionY.clear();
+		positionZ.clear();
+		previousX.clear();
+		previousY.clear();
+		previousZ.clear();
+		inverseMass.clear();
+	}
+
+	/// <summary>
+	/// 静止した粒子を追加する
+	/// </summary>
+	/// <returns>粒子の番号</returns>
+	uint32_t Add(const Vector3ex& position, float invMass)
+	{
+		positionX.push_back(position.x);
+		positionY.push_back(position.y);
+		positionZ.push_back(position.z);
+		previousX.push_back(position.x);
+		previousY.push_back(position.y);
+		previousZ.push_back(position.z);
+		inverseMass.push_back(invMass);
+		return static_cast<uint32_t>(positionX.size() - 1);
+	}
+
+	Vector3ex GetPosition(size_t i) const { return { positionX[i], positionY[i], positionZ[i] }; }
+	void SetPosition(size_t i, const Vector3ex& position)
+	{
+		positionX[i] = position.x;
+		positionY[i] = position.y;
+		positionZ[i] = position.z;
+	}
+};
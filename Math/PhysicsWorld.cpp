@@ -0,0 +1,559 @@
+#include "PhysicsWorld.h"
+#include "MathFunction.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+namespace
+{
+	MathFunction Func;
+
+	/// <summary>
+	/// startからmotionだけ動く点が、半径だけ広げたAABBに入る時刻と面の法線を求める
+	/// 角の丸みは無視するので、角の近くでは本当の球より少し早く当たる
+	/// </summary>
+	/// <returns>0より後、1以内に外から入るならtrue（最初から中にある時はfalse）</returns>
+	bool EnterExpandedAABB(const Vector3ex& start, const Vector3ex& motion, const AABB& aabb, float radius, float& time, Vector3ex& normal)
+	{
+		const float origins[3] = { start.x, start.y, start.z };
+		const float directions[3] = { motion.x, motion.y, motion.z };
+		const float mins[3] = { aabb.min.x - radius, aabb.min.y - radius, aabb.min.z - radius };
+		const float maxs[3] = { aabb.max.x + radius, aabb.max.y + radius, aabb.max.z + radius };
+		float enter = -INFINITY;
+		float exit = INFINITY;
+		int enterAxis = 0;
+		for (int axis = 0; axis < 3; ++axis)
+		{
+			if (directions[axis] == 0.0f)
+			{
+				// この軸に動かないなら、最初から板の間にいなければ当たらない
+				if (origins[axis] < mins[axis] || origins[axis] > maxs[axis])
+				{
+					return false;
+				}
+				continue;
+			}
+			const float inverse = 1.0f / directions[axis];
+			float nearTime = (mins[axis] - origins[axis]) * inverse;
+			float farTime = (maxs[axis] - origins[axis]) * inverse;
+			if (nearTime > farTime)
+			{
+				std::swap(nearTime, farTime);
+			}
+			if (nearTime > enter)
+			{
+				enter = nearTime;
+				enterAxis = axis;
+			}
+			exit = std::min(exit, farTime);
+		}
+		if (enter <= 0.0f || enter > exit || enter > 1.0f)
+		{
+			return false;
+		}
+		float normalComponents[3] = { 0.0f, 0.0f, 0.0f };
+		normalComponents[enterAxis] = directions[enterAxis] > 0.0f ? -1.0f : 1.0f;
+		normal = { normalComponents[0], normalComponents[1], normalComponents[2] };
+		time = enter;
+		return true;
+	}
+}
+
+uint32_t PhysicsWorld::AddBody(const Ball& ball)
+{
+	const uint32_t index = static_cast<uint32_t>(bodies_.size());
+	bodies_.push_back(ball);
+	sleepTimers_.push_back(0.0f);
+	previousPositions_.push_back(ball.position);
+	sleeping_.push_back(0);
+	sweepOrder_.push_back(index);
+	awakeListDirty_ = true;
+	return index;
+}
+
+uint32_t PhysicsWorld::AddPlane(const Plane& plane)
+{
+	planes_.push_back(plane);
+	WakeAll();
+	return static_cast<uint32_t>(planes_.size() - 1);
+}
+
+uint32_t PhysicsWorld::AddAABB(const AABB& aabb)
+{
+	const uint32_t index = static_cast<uint32_t>(aabbs_.size());
+	aabbs_.push_back(aabb);
+	maxAabbWidthX_ = std::max(maxAabbWidthX_, aabb.max.x - aabb.min.x);
+
+	// min.xの順を保って差し込む
+	const auto position = std::upper_bound(aabbOrder_.begin(), aabbOrder_.end(), aabb.min.x,
+		[this](float minX, uint32_t other) { return minX < aabbs_[other].min.x; });
+	aabbOrder_.insert(position, index);
+	WakeAll();
+	return index;
+}
+
+void PhysicsWorld::SetPlane(uint32_t index, const Plane& plane)
+{
+	Plane& current = planes_[index];
+	if (current.normal.x == plane.normal.x && current.normal.y == plane.normal.y && current.normal.z == plane.normal.z &&
+		current.distance == plane.distance)
+	{
+		return;
+	}
+
+	// 足場が動いたので、上に乗っているボールを起こす
+	current = plane;
+	WakeAll();
+}
+
+void PhysicsWorld::SetHeightfield(const Heightfield* heightfield)
+{
+	if (heightfield_ != heightfield)
+	{
+		heightfield_ = heightfield;
+		WakeAll();
+	}
+}
+
+void PhysicsWorld::SetSdfVolume(const SdfVolume* volume)
+{
+	if (sdfVolume_ != volume)
+	{
+		sdfVolume_ = volume;
+		WakeAll();
+	}
+}
+
+void PhysicsWorld::ResetBody(uint32_t index, const Vector3ex& position, const Vector3ex& velocity)
+{
+	bodies_[index].position = position;
+	bodies_[index].velocity = velocity;
+	WakeBody(index);
+}
+
+void PhysicsWorld::WakeBody(uint32_t index)
+{
+	sleepTimers_[index] = 0.0f;
+	if (sleeping_[index] != 0)
+	{
+		sleeping_[index] = 0;
+		awakeListDirty_ = true;
+	}
+}
+
+void PhysicsWorld::WakeAll()
+{
+	for (uint32_t i = 0; i < bodies_.size(); ++i)
+	{
+		WakeBody(i);
+	}
+}
+
+void PhysicsWorld::RebuildAwakeList()
+{
+	awakeBodies_.clear();
+	for (uint32_t i = 0; i < bodies_.size(); ++i)
+	{
+		if (sleeping_[i] == 0)
+		{
+			awakeBodies_.push_back(i);
+		}
+	}
+	awakeListDirty_ = false;
+
+	// 各ボールはsweepOrder_かsleepingOrder_のどちらか一方にある
+	// 状態が変わったボールだけを抜き出して並べ、もう一方の並びに合わせる（残りの順番は崩さない）
+	auto minX = [this](uint32_t index) { return bodies_[index].position.x - bodies_[index].radius; };
+	auto byMinX = [&](uint32_t a, uint32_t b) { return minX(a) < minX(b); };
+	auto moveChanged = [&](std::vector<uint32_t>& from, std::vector<uint32_t>& to, uint8_t leavingState) {
+		const auto stay = std::stable_partition(from.begin(), from.end(), [&](uint32_t index) { return sleeping_[index] != leavingState; });
+		if (stay == from.end())
+		{
+			return false;
+		}
+		std::sort(stay, from.end(), byMinX);
+		const size_t middle = to.size();
+		to.insert(to.end(), stay, from.end());
+		from.erase(stay, from.end());
+		std::inplace_merge(to.begin(), to.begin() + middle, to.end(), byMinX);
+		return true;
+	};
+	const bool woke = moveChanged(sleepingOrder_, sweepOrder_, 0);
+	const bool slept = moveChanged(sweepOrder_, sleepingOrder_, 1);
+	if (!woke && !slept)
+	{
+		return;
+	}
+
+	sleepingMinX_.resize(sleepingOrder_.size());
+	maxSleepingWidthX_ = 0.0f;
+	for (size_t i = 0; i < sleepingOrder_.size(); ++i)
+	{
+		const Ball& ball = bodies_[sleepingOrder_[i]];
+		sleepingMinX_[i] = ball.position.x - ball.radius;
+		maxSleepingWidthX_ = std::max(maxSleepingWidthX_, ball.radius * 2.0f);
+	}
+}
+
+void PhysicsWorld::Step(float deltaTime)
+{
+	if (awakeListDirty_)
+	{
+		RebuildAwakeList();
+	}
+
+	contacts_.clear();
+
+	// 全て眠っていれば何もしない
+	if (awakeBodies_.empty())
+	{
+		return;
+	}
+
+	// 積分法の選択はステップごとに1回だけ
+	VisitIntegrator(integrator, [&](auto policy) { IntegrateAwake<decltype(policy)>(deltaTime); });
+
+	SolvePlanes();
+	SolveAABBs();
+	SolveHeightfield();
+	SolveSdfVolume();
+	SolveBodyPairs();
+	UpdateSleep(deltaTime);
+
+	// 眠った・起こされたボールをここで一覧に反映し、GetAwakeBodiesがこのステップで動いたボールを返すようにする
+	if (awakeListDirty_)
+	{
+		RebuildAwakeList();
+	}
+}
+
+template<class Integrator>
+void PhysicsWorld::IntegrateAwake(float deltaTime)
+{
+	// ボールの加速度は外から与えた一定の値（重力など）
+	auto accelerationFunction = [this](uint32_t index, const Vector3ex&, const Vector3ex&) { return bodies_[index].acceleration; };
+	for (uint32_t index : awakeBodies_)
+	{
+		Ball& ball = bodies_[index];
+		previousPositions_[index] = ball.position;
+		Integrator::Step(index, ball.position, ball.velocity, deltaTime, accelerationFunction);
+	}
+}
+
+void PhysicsWorld::SolvePlanes()
+{
+	for (uint32_t index : awakeBodies_)
+	{
+		Ball& ball = bodies_[index];
+		for (uint32_t planeIndex = 0; planeIndex < planes_.size(); ++planeIndex)
+		{
+			const Plane& plane = planes_[planeIndex];
+
+			// 平面との衝突判定
+			float distanceToPlane = Func.Dot(plane.normal, ball.position) - plane.distance;
+			if (distanceToPlane >= ball.radius)
+			{
+				continue;
+			}
+
+			const float depth = ball.radius - distanceToPlane;
+			contacts_.push_back({ index, planeIndex, ContactTarget::Plane, plane.normal, depth });
+
+			ResolveStaticContact(ball, plane.normal, depth);
+		}
+	}
+}
+
+void PhysicsWorld::SolveAABBs()
+{
+	if (aabbs_.empty())
+	{
+		return;
+	}
+
+	for (uint32_t index : awakeBodies_)
+	{
+		Ball& ball = bodies_[index];
+
+		// 1ステップで半径より長く動いたボールは、薄い箱を飛び越えていないか先に調べる
+		const Vector3ex start = previousPositions_[index];
+		const Vector3ex motion = ball.position - start;
+		if (Func.Dot(motion, motion) > ball.radius * ball.radius)
+		{
+			SweepAABBs(index, start);
+		}
+
+		// min.xがこの範囲にあるAABBだけがx方向でボールと重なりうる
+		const float lowest = ball.position.x - ball.radius - maxAabbWidthX_;
+		const float highest = ball.position.x + ball.radius;
+		auto it = std::lower_bound(aabbOrder_.begin(), aabbOrder_.end(), lowest,
+			[this](uint32_t other, float minX) { return aabbs_[other].min.x < minX; });
+		for (; it != aabbOrder_.end() && aabbs_[*it].min.x <= highest; ++it)
+		{
+			const AABB& aabb = aabbs_[*it];
+			const Vector3ex closest =
+			{
+				std::clamp(ball.position.x, aabb.min.x, aabb.max.x),
+				std::clamp(ball.position.y, aabb.min.y, aabb.max.y),
+				std::clamp(ball.position.z, aabb.min.z, aabb.max.z),
+			};
+			const Vector3ex delta = ball.position - closest;
+			const float distanceSquared = Func.Dot(delta, delta);
+			if (distanceSquared >= ball.radius * ball.radius)
+			{
+				continue;
+			}
+
+			Vector3ex normal;
+			float depth = 0.0f;
+			if (distanceSquared > 0.0f)
+			{
+				const float distance = std::sqrt(distanceSquared);
+				normal = delta / distance;
+				depth = ball.radius - distance;
+			}
+			else
+			{
+				// 中心が箱の中にあるので、一番近い面から外へ出す
+				const float faceDistances[6] =
+				{
+					ball.position.x - aabb.min.x, aabb.max.x - ball.position.x,
+					ball.position.y - aabb.min.y, aabb.max.y - ball.position.y,
+					ball.position.z - aabb.min.z, aabb.max.z - ball.position.z,
+				};
+				const Vector3ex faceNormals[6] =
+				{
+					{ -1.0f, 0.0f, 0.0f }, { 1.0f, 0.0f, 0.0f },
+					{ 0.0f, -1.0f, 0.0f }, { 0.0f, 1.0f, 0.0f },
+					{ 0.0f, 0.0f, -1.0f }, { 0.0f, 0.0f, 1.0f },
+				};
+				const int face = static_cast<int>(std::min_element(faceDistances, faceDistances + 6) - faceDistances);
+				normal = faceNormals[face];
+				depth = faceDistances[face] + ball.radius;
+			}
+			contacts_.push_back({ index, *it, ContactTarget::AABB, normal, depth });
+			ResolveStaticContact(ball, normal, depth);
+		}
+	}
+}
+
+void PhysicsWorld::SweepAABBs(uint32_t index, const Vector3ex& start)
+{
+	Ball& ball = bodies_[index];
+	const Capsule sweep = Func.MakeSweptCapsule(start, ball.position, ball.radius);
+	const Vector3ex& motion = sweep.segment.diff;
+
+	// 軌跡のx方向の範囲と重なりうるAABBだけを調べ、最初に当たるものを探す
+	const float lowest = std::min(start.x, ball.position.x) - ball.radius - maxAabbWidthX_;
+	const float highest = std::max(start.x, ball.position.x) + ball.radius;
+	auto it = std::lower_bound(aabbOrder_.begin(), aabbOrder_.end(), lowest,
+		[this](uint32_t other, float minX) { return aabbs_[other].min.x < minX; });
+	float firstTime = 1.0f;
+	Vector3ex firstNormal;
+	uint32_t firstAabb = UINT32_MAX;
+	for (; it != aabbOrder_.end() && aabbs_[*it].min.x <= highest; ++it)
+	{
+		const AABB& aabb = aabbs_[*it];
+		if (!Func.IsCollision(sweep, aabb))
+		{
+			continue;
+		}
+		float time = 0.0f;
+		Vector3ex normal;
+		if (EnterExpandedAABB(start, motion, aabb, ball.radius, time, normal) && time < firstTime)
+		{
+			firstTime = time;
+			firstNormal = normal;
+			firstAabb = *it;
+		}
+	}
+	if (firstAabb == UINT32_MAX)
+	{
+		return;
+	}
+
+	// 当たった時点まで戻す（残りの時間は進めないので、正確な衝突時刻を求めるより安い）
+	ball.position = start + motion * firstTime;
+	contacts_.push_back({ index, firstAabb, ContactTarget::AABB, firstNormal, 0.0f });
+	ResolveStaticContact(ball, firstNormal, 0.0f);
+}
+
+void PhysicsWorld::SolveHeightfield()
+{
+	if (heightfield_ == nullptr)
+	{
+		return;
+	}
+
+	for (uint32_t index : awakeBodies_)
+	{
+		Ball& ball = bodies_[index];
+		Vector3ex normal;
+		float depth = 0.0f;
+		if (heightfield_->Collide(ball.position, ball.radius, normal, depth))
+		{
+			contacts_.push_back({ index, 0, ContactTarget::Heightfield, normal, depth });
+			ResolveStaticContact(ball, normal, depth);
+		}
+	}
+}
+
+void PhysicsWorld::SolveSdfVolume()
+{
+	if (sdfVolume_ == nullptr)
+	{
+		return;
+	}
+
+	for (uint32_t index : awakeBodies_)
+	{
+		Ball& ball = bodies_[index];
+		Vector3ex normal;
+		float depth = 0.0f;
+		if (sdfVolume_->Collide(ball.position, ball.radius, normal, depth))
+		{
+			contacts_.push_back({ index, 0, ContactTarget::SdfVolume, normal, depth });
+			ResolveStaticContact(ball, normal, depth);
+		}
+	}
+}
+
+void PhysicsWorld::ResolveStaticContact(Ball& ball, const Vector3ex& normal, float depth) const
+{
+	// 衝突面の外へ押し出す（法線は正規化済みなので1回で足りる）
+	ball.position += normal * depth;
+
+	// 面に向かっている時だけ速度を反射
+	float normalSpeed = Func.Dot(ball.velocity, normal);
+	if (normalSpeed < 0.0f)
+	{
+		if (-normalSpeed < sleepSettings.restingSpeed)
+		{
+			// ゆっくり当たった場合は跳ねさせず、法線方向の速度だけ消す
+			ball.velocity -= normal * normalSpeed;
+		}
+		else
+		{
+			ball.velocity = Func.Reflect(ball.velocity, normal) * restitution;
+		}
+	}
+}
+
+void PhysicsWorld::SolveBodyPairs()
+{
+	if (bodies_.size() < 2)
+	{
+		return;
+	}
+
+	// 前のステップの並びからの挿入ソートなので、動きが少なければほぼO(N)（起きているボールだけ）
+	for (size_t i = 1; i < sweepOrder_.size(); ++i)
+	{
+		const uint32_t key = sweepOrder_[i];
+		const float keyMin = bodies_[key].position.x - bodies_[key].radius;
+		size_t j = i;
+		while (j > 0 && bodies_[sweepOrder_[j - 1]].position.x - bodies_[sweepOrder_[j - 1]].radius > keyMin)
+		{
+			sweepOrder_[j] = sweepOrder_[j - 1];
+			--j;
+		}
+		sweepOrder_[j] = key;
+	}
+
+	for (size_t i = 0; i < sweepOrder_.size(); ++i)
+	{
+		const uint32_t a = sweepOrder_[i];
+		const float minX = bodies_[a].position.x - bodies_[a].radius;
+		const float maxX = bodies_[a].position.x + bodies_[a].radius;
+
+		// 起きているボール同士
+		for (size_t j = i + 1; j < sweepOrder_.size(); ++j)
+		{
+			const uint32_t b = sweepOrder_[j];
+			if (bodies_[b].position.x - bodies_[b].radius > maxX)
+			{
+				break;
+			}
+			ResolveBodyPair(a, b);
+		}
+
+		// min.xがこの範囲にある眠っているボールだけがx方向で重なりうる
+		auto it = std::lower_bound(sleepingMinX_.begin(), sleepingMinX_.end(), minX - maxSleepingWidthX_);
+		for (; it != sleepingMinX_.end() && *it <= maxX; ++it)
+		{
+			ResolveBodyPair(a, sleepingOrder_[it - sleepingMinX_.begin()]);
+		}
+	}
+}
+
+void PhysicsWorld::ResolveBodyPair(uint32_t a, uint32_t b)
+{
+	Ball& ballA = bodies_[a];
+	Ball& ballB = bodies_[b];
+	Vector3ex delta = ballA.position - ballB.position;
+	float radiusSum = ballA.radius + ballB.radius;
+	float distanceSquared = Func.Dot(delta, delta);
+	if (distanceSquared >= radiusSum * radiusSum || distanceSquared == 0.0f)
+	{
+		return;
+	}
+
+	// 眠っている側は、相手がしきい値より速くぶつかってきた時だけ起こす
+	const float wakeSpeedSquared = sleepSettings.linearThreshold * sleepSettings.linearThreshold;
+	if (sleeping_[a] != 0 && Func.Dot(ballB.velocity, ballB.velocity) >= wakeSpeedSquared)
+	{
+		WakeBody(a);
+	}
+	if (sleeping_[b] != 0 && Func.Dot(ballA.velocity, ballA.velocity) >= wakeSpeedSquared)
+	{
+		WakeBody(b);
+	}
+
+	float distance = std::sqrt(distanceSquared);
+	Vector3ex normal = delta / distance;
+	float depth = radiusSum - distance;
+	contacts_.push_back({ a, b, ContactTarget::Body, normal, depth });
+
+	// 質量の逆数で押し出し量と力積を配分する（眠ったままの側は動かない）
+	float inverseMassA = ballA.mass > 0.0f && sleeping_[a] == 0 ? 1.0f / ballA.mass : 0.0f;
+	float inverseMassB = ballB.mass > 0.0f && sleeping_[b] == 0 ? 1.0f / ballB.mass : 0.0f;
+	float inverseMassSum = inverseMassA + inverseMassB;
+	if (inverseMassSum == 0.0f)
+	{
+		return;
+	}
+	ballA.position += normal * (depth * inverseMassA / inverseMassSum);
+	ballB.position -= normal * (depth * inverseMassB / inverseMassSum);
+
+	float normalSpeed = Func.Dot(ballA.velocity - ballB.velocity, normal);
+	if (normalSpeed < 0.0f)
+	{
+		float bounce = -normalSpeed < sleepSettings.restingSpeed ? 0.0f : restitution;
+		float impulse = -(1.0f + bounce) * normalSpeed / inverseMassSum;
+		ballA.velocity += normal * (impulse * inverseMassA);
+		ballB.velocity -= normal * (impulse * inverseMassB);
+	}
+}
+
+void PhysicsWorld::UpdateSleep(float deltaTime)
+{
+	const float thresholdSquared = sleepSettings.linearThreshold * sleepSettings.linearThreshold;
+	for (uint32_t index : awakeBodies_)
+	{
+		Ball& ball = bodies_[index];
+		if (Func.Dot(ball.velocity, ball.velocity) >= thresholdSquared)
+		{
+			sleepTimers_[index] = 0.0f;
+			continue;
+		}
+
+		// 一定時間ずっと遅ければスリープ
+		sleepTimers_[index] += deltaTime;
+		if (sleepTimers_[index] >= sleepSettings.timeToSleep)
+		{
+			ball.velocity = { 0.0f, 0.0f, 0.0f };
+			sleeping_[index] = 1;
+			awakeListDirty_ = true;
+		}
+	}
+}
@@ -0,0 +1,179 @@
+#pragma once
+#include "AABB.h"
+#include "Ball.h"
+#include "Contact.h"
+#include "Heightfield.h"
+#include "Integrator.h"
+#include "Plane.h"
+#include "SdfVolume.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// スリープ判定の設定
+/// </summary>
+struct SleepSettings final
+{
+	float linearThreshold = 0.05f;	// この速さ未満を静止とみなす
+	float timeToSleep = 0.5f;		// 静止がこの時間続いたらスリープさせる
+	float restingSpeed = 0.3f;		// 衝突時の法線方向の速さがこれ未満なら反発させない
+};
+
+/// <summary>
+/// ボールと平面の物理シミュレーション
+/// 静止が続いたボールはスリープさせ、積分と衝突判定の対象から外す
+/// </summary>
+class PhysicsWorld final
+{
+public:
+	/// <summary>
+	/// ボールを追加する
+	/// </summary>
+	/// <param name="ball">ボール</param>
+	/// <returns>ボールの番号</returns>
+	uint32_t AddBody(const Ball& ball);
+	/// <summary>
+	/// 平面を追加する
+	/// </summary>
+	/// <param name="plane">平面</param>
+	/// <returns>平面の番号</returns>
+	uint32_t AddPlane(const Plane& plane);
+	/// <summary>
+	/// 平面を変更する（変化があれば全てのボールを起こす）
+	/// </summary>
+	/// <param name="index">平面の番号</param>
+	/// <param name="plane">平面</param>
+	void SetPlane(uint32_t index, const Plane& plane);
+	/// <summary>
+	/// 動かないAABBを追加する
+	/// </summary>
+	/// <param name="aabb">AABB</param>
+	/// <returns>AABBの番号</returns>
+	uint32_t AddAABB(const AABB& aabb);
+	/// <summary>
+	/// 地形を設定する（nullptrで外す、所有はしないので呼び出し側で保持すること）
+	/// </summary>
+	/// <param name="heightfield">地形</param>
+	void SetHeightfield(const Heightfield* heightfield);
+	const Heightfield* GetHeightfield() const { return heightfield_; }
+	/// <summary>
+	/// 符号付き距離のボリュームを設定する（nullptrで外す、所有はしないので呼び出し側で保持すること）
+	/// </summary>
+	/// <param name="volume">ボリューム</param>
+	void SetSdfVolume(const SdfVolume* volume);
+	const SdfVolume* GetSdfVolume() const { return sdfVolume_; }
+	/// <summary>
+	/// ボールの位置と速度を設定して起こす
+	/// </summary>
+	/// <param name="index">ボールの番号</param>
+	/// <param name="position">位置</param>
+	/// <param name="velocity">速度</param>
+	void ResetBody(uint32_t index, const Vector3ex& position, const Vector3ex& velocity);
+
+	/// <summary>
+	/// 1ステップ進める
+	/// </summary>
+	/// <param name="deltaTime">時間</param>
+	void Step(float deltaTime);
+
+	/// <summary>
+	/// ボールを起こす
+	/// </summary>
+	/// <param name="index">ボールの番号</param>
+	void WakeBody(uint32_t index);
+	/// <summary>
+	/// 全てのボールを起こす
+	/// </summary>
+	void WakeAll();
+
+	const Ball& GetBody(uint32_t index) const { return bodies_[index]; }
+	const Ball* GetBodies() const { return bodies_.data(); }
+	size_t GetBodyCount() const { return bodies_.size(); }
+	const Plane& GetPlane(uint32_t index) const { return planes_[index]; }
+	size_t GetPlaneCount() const { return planes_.size(); }
+	const AABB& GetAABB(uint32_t index) const { return aabbs_[index]; }
+	size_t GetAABBCount() const { return aabbs_.size(); }
+	bool IsSleeping(uint32_t index) const { return sleeping_[index] != 0; }
+	/// <summary>
+	/// 起きているボールの番号（昇順、ステップの途中で起こされたボールも含む）
+	/// </summary>
+	const std::vector<uint32_t>& GetAwakeBodies() const { return awakeBodies_; }
+	size_t GetAwakeCount() const { return awakeBodies_.size(); }
+	/// <summary>
+	/// 直前のステップで見つかった接触
+	/// </summary>
+	const std::vector<Contact>& GetContacts() const { return contacts_; }
+
+	float restitution = 0.8f;	// 反発係数
+	IntegratorType integrator = IntegratorType::SemiImplicitEuler;	// 積分法
+	SleepSettings sleepSettings;
+
+private:
+	/// <summary>
+	/// 起きているボールの一覧を作り直し、眠った・起きたボールをスイープの並びの間で移す
+	/// </summary>
+	void RebuildAwakeList();
+	/// <summary>
+	/// 起きているボールを積分する（積分法ごとに実体化されるので、ループの中で分岐しない）
+	/// </summary>
+	template<class Integrator>
+	void IntegrateAwake(float deltaTime);
+	/// <summary>
+	/// ボール同士の接触を探して解決する（起きている同士のスイープと、起きているボールごとに眠っているボールの範囲を引くだけで、眠っている同士は調べない）
+	/// </summary>
+	void SolveBodyPairs();
+	/// <summary>
+	/// 2つのボールが重なっていれば押し出して速度を解決する（眠っている側は、相手が速ければ起こす）
+	/// </summary>
+	void ResolveBodyPair(uint32_t a, uint32_t b);
+	/// <summary>
+	/// 起きているボールと平面の接触を解決する
+	/// </summary>
+	void SolvePlanes();
+	/// <summary>
+	/// 起きているボールと静的なAABBの接触を解決する
+	/// </summary>
+	void SolveAABBs();
+	/// <summary>
+	/// 1ステップで動いた軌跡のカプセルで箱との衝突を調べ、すり抜けていれば最初に当たる位置まで戻して反射させる
+	/// </summary>
+	/// <param name="index">ボールの番号</param>
+	/// <param name="start">このステップで動く前の位置</param>
+	void SweepAABBs(uint32_t index, const Vector3ex& start);
+	/// <summary>
+	/// 起きているボールと地形の接触を解決する
+	/// </summary>
+	void SolveHeightfield();
+	/// <summary>
+	/// 起きているボールと符号付き距離のボリュームの接触を解決する
+	/// </summary>
+	void SolveSdfVolume();
+	/// <summary>
+	/// 動かない相手との接触を解決する（押し出して、向かっている時だけ反射）
+	/// </summary>
+	void ResolveStaticContact(Ball& ball, const Vector3ex& normal, float depth) const;
+	/// <summary>
+	/// 静止時間を更新してスリープさせる
+	/// </summary>
+	void UpdateSleep(float deltaTime);
+
+	std::vector<Ball> bodies_;
+	std::vector<float> sleepTimers_;		// 静止が続いている時間
+	std::vector<Vector3ex> previousPositions_;	// このステップで積分する前の位置（すり抜けの判定用）
+	std::vector<uint8_t> sleeping_;			// スリープ中なら1
+	std::vector<uint32_t> awakeBodies_;		// 起きているボールの番号
+	bool awakeListDirty_ = false;
+
+	std::vector<uint32_t> sweepOrder_;		// 起きているボールをx軸方向のスイープ用に並べた番号（毎ステップ前の並びから挿入ソート）
+	std::vector<uint32_t> sleepingOrder_;	// 眠っているボールをmin.xの順に並べた番号（眠っている間は動かないので、眠る・起きる時だけ並べ直す）
+	std::vector<float> sleepingMinX_;		// sleepingOrder_の順のmin.x（二分探索用）
+	float maxSleepingWidthX_ = 0.0f;		// 眠っているボールのx方向の幅の最大（重なりうる範囲を決める）
+	std::vector<Plane> planes_;
+	std::vector<AABB> aabbs_;
+	std::vector<uint32_t> aabbOrder_;		// min.xの順に並べたAABBの番号
+	float maxAabbWidthX_ = 0.0f;			// AABBのx方向の幅の最大（ボールと重なりうる範囲を決める）
+	const Heightfield* heightfield_ = nullptr;
+	const SdfVolume* sdfVolume_ = nullptr;
+	std::vector<Contact> contacts_;
+};
@@ -0,0 +1,16 @@
+#pragma once
+#include "Vector3ex.h"
+#include <cstdint>
+
+/// <summary>
+/// スラブ判定用に前処理した線分（半直線）
+/// 方向の逆数と符号を持っておき、たくさんのAABBに対して使い回す
+/// </summary>
+struct PreparedSegment final
+{
+	Vector3ex origin;			//!< 始点
+	Vector3ex inverseDiff;		//!< 差分の逆数（0の成分は±inf）
+	uint32_t sign[3];			//!< 逆数が負なら1（手前の面がmax側になる）
+	float tMin;					//!< tの下限
+	float tMax;					//!< tの上限（線分なら1、半直線ならinf）
+};
@@ -0,0 +1,312 @@
+#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+
+namespace
+{
+	constexpr uint32_t kThreadCapacity = 1 << 14;	// スレッドごとに1フレームで溜められるイベント数（2の累乗）
+	constexpr size_t kCounterCount = static_cast<size_t>(ProfileCounter::Count);
+
+	const char* const kCounterNames[kCounterCount] = { "LinesSubmitted", "MatrixMultiplies", "CollisionTests", "ImpostorsSubmitted" };
+
+	struct ZoneRecord
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+		uint32_t depth;
+	};
+
+	/// <summary>
+	/// スレッド専用のバッファ（書くのは持ち主のスレッドだけ、読むのはEndFrameだけ）
+	/// </summary>
+	struct ThreadBuffer
+	{
+		std::atomic<uint32_t> head{ 0 };	// 書き込み位置（持ち主が進める）
+		std::atomic<uint32_t> tail{ 0 };	// 読み出し位置（EndFrameが進める）
+		std::atomic<uint64_t> counters[kCounterCount] = {};
+		std::atomic<uint64_t> dropped{ 0 };
+		uint32_t threadId = 0;
+		uint32_t depth = 0;
+		ZoneRecord records[kThreadCapacity];
+	};
+
+	/// <summary>
+	/// 全スレッドのバッファ（登録時だけロックする）
+	/// </summary>
+	struct ThreadRegistry
+	{
+		std::mutex mutex;
+		std::vector<std::unique_ptr<ThreadBuffer>> buffers;
+	};
+
+	ThreadRegistry& GetRegistry()
+	{
+		static ThreadRegistry registry;
+		return registry;
+	}
+
+	ThreadBuffer& GetThreadBuffer()
+	{
+		thread_local ThreadBuffer* buffer = nullptr;
+		if (buffer == nullptr)
+		{
+			ThreadRegistry& registry = GetRegistry();
+			std::lock_guard<std::mutex> lock(registry.mutex);
+			registry.buffers.push_back(std::make_unique<ThreadBuffer>());
+			buffer = registry.buffers.back().get();
+			buffer->threadId = static_cast<uint32_t>(registry.buffers.size() - 1);
+		}
+		return *buffer;
+	}
+
+	uint64_t NowNanoseconds()
+	{
+		return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+	}
+}
+
+uint32_t ProfileEnter()
+{
+	return GetThreadBuffer().depth++;
+}
+
+void ProfileLeave(const char* name, uint64_t start, uint64_t end, uint32_t depth)
+{
+	ThreadBuffer& buffer = GetThreadBuffer();
+	buffer.depth = depth;
+
+	const uint32_t head = buffer.head.load(std::memory_order_relaxed);
+	if (head - buffer.tail.load(std::memory_order_acquire) >= kThreadCapacity)
+	{
+		// 回収が追いつかない時は捨てて数だけ残す
+		buffer.dropped.store(buffer.dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+		return;
+	}
+	buffer.records[head & (kThreadCapacity - 1)] = { name, start, end, depth };
+	buffer.head.store(head + 1, std::memory_order_release);
+}
+
+void ProfileCount(ProfileCounter counter, uint64_t value)
+{
+	// 書き込むのは持ち主のスレッドだけなので、読み書きを分けても失われない
+	std::atomic<uint64_t>& slot = GetThreadBuffer().counters[static_cast<size_t>(counter)];
+	slot.store(slot.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+}
+
+Profiler& Profiler::Get()
+{
+	static Profiler profiler;
+	return profiler;
+}
+
+Profiler::Profiler()
+	: counterStats_{}, counterHistory_{}, counterTotals_{}, frameHistory_{}, counterSamples_{}
+{
+	for (size_t i = 0; i < kCounterCount; ++i)
+	{
+		counterStats_[i].name = kCounterNames[i];
+	}
+	startTick_ = ProfileNow();
+	startNanoseconds_ = NowNanoseconds();
+	lastFrameTick_ = startTick_;
+	// steady_clockならナノ秒そのもの
+	ticksPerSecond_ = 1e9;
+#if MT_PROFILE_RDTSC
+	// rdtscは2msだけ回して仮の周波数を求め、EndFrameで起動からの経過を使って計り直す
+	while (NowNanoseconds() - startNanoseconds_ < 2000000)
+	{
+	}
+	ticksPerSecond_ = static_cast<double>(ProfileNow() - startTick_) * 1e9 / static_cast<double>(NowNanoseconds() - startNanoseconds_);
+#endif
+}
+
+void Profiler::Calibrate()
+{
+#if MT_PROFILE_RDTSC
+	// 起動からの経過で周波数を求める（10ms以上経っていれば十分な精度になる）
+	const uint64_t elapsedNanoseconds = NowNanoseconds() - startNanoseconds_;
+	if (elapsedNanoseconds >= 10000000)
+	{
+		ticksPerSecond_ = static_cast<double>(ProfileNow() - startTick_) * 1e9 / static_cast<double>(elapsedNanoseconds);
+	}
+#endif
+}
+
+Profiler::ZoneHistory& Profiler::FindZone(const char* name, uint32_t depth)
+{
+	for (ZoneHistory& zone : zones_)
+	{
+		if (zone.depth == depth && (zone.name == name || std::strcmp(zone.name, name) == 0))
+		{
+			return zone;
+		}
+	}
+	ZoneHistory zone{};
+	zone.name = name;
+	zone.depth = depth;
+	zone.firstStart = UINT64_MAX;
+	zones_.push_back(zone);
+	return zones_.back();
+}
+
+void Profiler::EndFrame()
+{
+	Calibrate();
+	const uint64_t now = ProfileNow();
+	const double msPerTick = 1000.0 / ticksPerSecond_;
+
+	for (ZoneHistory& zone : zones_)
+	{
+		zone.calls = 0;
+		zone.ticks = 0;
+		zone.firstStart = UINT64_MAX;
+	}
+
+	// 全スレッドのバッファを回収する
+	uint64_t counterValues[kCounterCount] = {};
+	{
+		ThreadRegistry& registry = GetRegistry();
+		std::lock_guard<std::mutex> registryLock(registry.mutex);
+		std::lock_guard<std::mutex> traceLock(traceMutex_);
+		if (trace_.empty())
+		{
+			trace_.resize(kMaxTraceEvents);
+		}
+
+		uint64_t dropped = 0;
+		for (const std::unique_ptr<ThreadBuffer>& buffer : registry.buffers)
+		{
+			const uint32_t head = buffer->head.load(std::memory_order_acquire);
+			uint32_t tail = buffer->tail.load(std::memory_order_relaxed);
+			for (; tail != head; ++tail)
+			{
+				const ZoneRecord& record = buffer->records[tail & (kThreadCapacity - 1)];
+				ZoneHistory& zone = FindZone(record.name, record.depth);
+				++zone.calls;
+				zone.ticks += record.end - record.start;
+				zone.firstStart = std::min(zone.firstStart, record.start);
+
+				trace_[traceHead_ % kMaxTraceEvents] = { record.name, record.start, record.end, buffer->threadId, record.depth };
+				++traceHead_;
+			}
+			buffer->tail.store(tail, std::memory_order_release);
+
+			for (size_t i = 0; i < kCounterCount; ++i)
+			{
+				counterValues[i] += buffer->counters[i].load(std::memory_order_relaxed);
+			}
+			dropped += buffer->dropped.load(std::memory_order_relaxed);
+		}
+		dropped_ = dropped;
+	}
+
+	// 履歴を更新する
+	frameMs_ = static_cast<float>(static_cast<double>(now - lastFrameTick_) * msPerTick);
+	lastFrameTick_ = now;
+	frameHistory_[historyIndex_] = frameMs_;
+	++frameCount_;
+	const size_t samples = std::min(frameCount_, kHistory);
+
+	float frameSum = 0.0f;
+	for (size_t i = 0; i < samples; ++i)
+	{
+		frameSum += frameHistory_[i];
+	}
+	averageFrameMs_ = frameSum / static_cast<float>(samples);
+
+	CounterSample& sample = counterSamples_[historyIndex_];
+	sample.tick = now;
+	for (size_t i = 0; i < kCounterCount; ++i)
+	{
+		const uint64_t value = counterValues[i] - counterTotals_[i];
+		counterTotals_[i] = counterValues[i];
+		counterHistory_[i][historyIndex_] = value;
+		sample.values[i] = value;
+
+		uint64_t sum = 0;
+		for (size_t j = 0; j < samples; ++j)
+		{
+			sum += counterHistory_[i][j];
+		}
+		counterStats_[i].last = value;
+		counterStats_[i].average = static_cast<float>(sum) / static_cast<float>(samples);
+	}
+
+	// このフレームで始まった順に並べると、親の下に子が並ぶ
+	std::stable_sort(zones_.begin(), zones_.end(), [](const ZoneHistory& a, const ZoneHistory& b) { return a.firstStart < b.firstStart; });
+
+	zoneStats_.clear();
+	for (ZoneHistory& zone : zones_)
+	{
+		const float ms = static_cast<float>(static_cast<double>(zone.ticks) * msPerTick);
+		zone.history[historyIndex_] = ms;
+
+		ProfileZoneStats stats{ zone.name, zone.depth, zone.calls, ms, 0.0f, 0.0f };
+		for (size_t i = 0; i < samples; ++i)
+		{
+			stats.averageMs += zone.history[i];
+			stats.maxMs = std::max(stats.maxMs, zone.history[i]);
+		}
+		stats.averageMs /= static_cast<float>(samples);
+		zoneStats_.push_back(stats);
+	}
+
+	historyIndex_ = (historyIndex_ + 1) % kHistory;
+}
+
+bool Profiler::ExportChromeTrace(const char* path)
+{
+	std::FILE* file = nullptr;
+#ifdef _MSC_VER
+	if (fopen_s(&file, path, "wb") != 0)
+	{
+		file = nullptr;
+	}
+#else
+	file = std::fopen(path, "wb");
+#endif
+	if (file == nullptr)
+	{
+		return false;
+	}
+
+	std::lock_guard<std::mutex> lock(traceMutex_);
+	const double microsecondsPerTick = 1e6 / ticksPerSecond_;
+	auto toMicroseconds = [&](uint64_t tick) { return static_cast<double>(tick - startTick_) * microsecondsPerTick; };
+
+	std::fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+	bool first = true;
+
+	// 完了イベント（ph:X）として書き出す
+	const size_t count = std::min(traceHead_, kMaxTraceEvents);
+	for (size_t i = traceHead_ - count; i < traceHead_; ++i)
+	{
+		const TraceEvent& event = trace_[i % kMaxTraceEvents];
+		std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+			first ? "" : ",\n", event.name, event.threadId, toMicroseconds(event.start), static_cast<double>(event.end - event.start) * microsecondsPerTick);
+		first = false;
+	}
+
+	// カウンタ（ph:C）はフレームごとの値
+	const size_t samples = std::min(frameCount_, kHistory);
+	for (size_t s = 0; s < samples; ++s)
+	{
+		const CounterSample& sample = counterSamples_[(historyIndex_ + kHistory - samples + s) % kHistory];
+		for (size_t i = 0; i < kCounterCount; ++i)
+		{
+			std::fprintf(file, "%s{\"name\":\"%s\",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"value\":%llu}}",
+				first ? "" : ",\n", kCounterNames[i], toMicroseconds(sample.tick), static_cast<unsigned long long>(sample.values[i]));
+			first = false;
+		}
+	}
+
+	std::fprintf(file, "\n]}\n");
+	const bool ok = std::ferror(file) == 0;
+	std::fclose(file);
+	return ok;
+}
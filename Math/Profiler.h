@@ -0,0 +1,219 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// 出荷ビルドではMT_SHIPPINGを定義すると、計測マクロは全て空になる
+#if defined(MT_SHIPPING)
+#define MT_PROFILE_ENABLED 0
+#else
+#define MT_PROFILE_ENABLED 1
+#endif
+
+// x86ではrdtsc、それ以外はsteady_clockで時間を測る
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define MT_PROFILE_RDTSC 1
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define MT_PROFILE_RDTSC 1
+#else
+#include <chrono>
+#define MT_PROFILE_RDTSC 0
+#endif
+
+/// <summary>
+/// フレームごとに集計するカウンタ
+/// </summary>
+enum class ProfileCounter : uint32_t
+{
+	LinesSubmitted,		// DrawLineの呼び出し数
+	MatrixMultiplies,	// 4x4行列の乗算
+	CollisionTests,		// IsCollisionの呼び出し数
+	ImpostorsSubmitted,	// DrawSpheresで円として描いた球の数
+	Count,
+};
+
+/// <summary>
+/// 現在のティック（rdtscなら周波数はProfiler::GetTicksPerSecondで求める）
+/// </summary>
+inline uint64_t ProfileNow()
+{
+#if MT_PROFILE_RDTSC
+	return __rdtsc();
+#else
+	return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/// <summary>
+/// ゾーンに入る（スレッドごとの深さを返す）
+/// </summary>
+uint32_t ProfileEnter();
+/// <summary>
+/// ゾーンを出て、スレッドのバッファに記録する
+/// </summary>
+void ProfileLeave(const char* name, uint64_t start, uint64_t end, uint32_t depth);
+/// <summary>
+/// カウンタを加算する（スレッドごとに持つのでロックしない）
+/// </summary>
+void ProfileCount(ProfileCounter counter, uint64_t value);
+
+/// <summary>
+/// スコープの間を計測するゾーン
+/// </summary>
+class ProfileZone final
+{
+public:
+	explicit ProfileZone(const char* name)
+		: name_(name), depth_(ProfileEnter()), start_(ProfileNow())
+	{
+	}
+	~ProfileZone() { ProfileLeave(name_, start_, ProfileNow(), depth_); }
+
+	ProfileZone(const ProfileZone&) = delete;
+	ProfileZone& operator=(const ProfileZone&) = delete;
+
+private:
+	const char* name_;
+	uint32_t depth_;
+	uint64_t start_;
+};
+
+#if MT_PROFILE_ENABLED
+#define MT_PROFILE_CONCAT_INNER(a, b) a##b
+#define MT_PROFILE_CONCAT(a, b) MT_PROFILE_CONCAT_INNER(a, b)
+/// スコープの終わりまでを計測する（nameは文字列リテラル）
+#define PROFILE_SCOPE(name) ProfileZone MT_PROFILE_CONCAT(profileZone, __LINE__)(name)
+/// カウンタを加算する
+#define PROFILE_COUNT(counter, value) ProfileCount(counter, value)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#define PROFILE_COUNT(counter, value) ((void)0)
+#endif
+
+/// <summary>
+/// 計測したゾーンの集計（直近のフレームの平均と最大）
+/// </summary>
+struct ProfileZoneStats final
+{
+	const char* name;
+	uint32_t depth;			// 入れ子の深さ（表示の字下げ用）
+	uint32_t calls;			// 直前のフレームの呼び出し回数
+	float lastMs;			// 直前のフレームの合計時間
+	float averageMs;		// 直近kHistoryフレームの平均
+	float maxMs;			// 直近kHistoryフレームの最大
+};
+
+/// <summary>
+/// カウンタの集計
+/// </summary>
+struct ProfileCounterStats final
+{
+	const char* name;
+	uint64_t last;			// 直前のフレームの値
+	float average;			// 直近kHistoryフレームの平均
+};
+
+/// <summary>
+/// フレーム内の階層的なプロファイラ
+/// 各スレッドは自分専用のリングバッファに書き込み、EndFrameでメインスレッドがまとめて回収する
+/// </summary>
+class Profiler final
+{
+public:
+	static constexpr size_t kHistory = 120;				// 平均を取るフレーム数
+	static constexpr size_t kMaxTraceEvents = 1 << 16;	// トレース出力用に残すイベント数
+
+	static Profiler& Get();
+
+	/// <summary>
+	/// フレームの終わりに呼ぶ（全スレッドのイベントを回収して集計する）
+	/// </summary>
+	void EndFrame();
+
+	/// <summary>
+	/// 直近のイベントをChrome trace形式（chrome://tracing、Perfetto）で書き出す
+	/// </summary>
+	/// <param name="path">出力先</param>
+	/// <returns>書き出せたらtrue</returns>
+	bool ExportChromeTrace(const char* path);
+
+	const std::vector<ProfileZoneStats>& GetZoneStats() const { return zoneStats_; }
+	const ProfileCounterStats* GetCounterStats() const { return counterStats_; }
+	float GetFrameMs() const { return frameMs_; }
+	float GetAverageFrameMs() const { return averageFrameMs_; }
+	/// <summary>
+	/// バッファが一杯で捨てたイベントの数
+	/// </summary>
+	uint64_t GetDroppedCount() const { return dropped_; }
+	/// <summary>
+	/// 1秒あたりのティック数
+	/// </summary>
+	double GetTicksPerSecond() const { return ticksPerSecond_; }
+
+private:
+	Profiler();
+
+	/// <summary>
+	/// トレースに残すイベント
+	/// </summary>
+	struct TraceEvent
+	{
+		const char* name;
+		uint64_t start;
+		uint64_t end;
+		uint32_t threadId;
+		uint32_t depth;
+	};
+
+	/// <summary>
+	/// ゾーンごとの履歴
+	/// </summary>
+	struct ZoneHistory
+	{
+		const char* name;
+		uint32_t depth;
+		uint32_t calls;
+		uint64_t ticks;			// このフレームの合計
+		uint64_t firstStart;	// このフレームで最初に始まったティック（表示順に使う）
+		float history[kHistory];
+	};
+
+	void Calibrate();
+	ZoneHistory& FindZone(const char* name, uint32_t depth);
+
+	std::vector<ZoneHistory> zones_;
+	std::vector<ProfileZoneStats> zoneStats_;
+	ProfileCounterStats counterStats_[static_cast<size_t>(ProfileCounter::Count)];
+	uint64_t counterHistory_[static_cast<size_t>(ProfileCounter::Count)][kHistory];
+	uint64_t counterTotals_[static_cast<size_t>(ProfileCounter::Count)];	// 前のフレームまでの累計
+
+	float frameHistory_[kHistory];
+	size_t historyIndex_ = 0;
+	size_t frameCount_ = 0;
+	float frameMs_ = 0.0f;
+	float averageFrameMs_ = 0.0f;
+	uint64_t lastFrameTick_;
+	uint64_t dropped_ = 0;
+
+	// ティックと実時間の対応（rdtscの周波数を求める）
+	uint64_t startTick_;
+	uint64_t startNanoseconds_;
+	double ticksPerSecond_;
+
+	/// <summary>
+	/// フレーム終わりのカウンタの値（トレース出力用）
+	/// </summary>
+	struct CounterSample
+	{
+		uint64_t tick;
+		uint64_t values[static_cast<size_t>(ProfileCounter::Count)];
+	};
+	CounterSample counterSamples_[kHistory];
+
+	std::vector<TraceEvent> trace_;		// リングバッファとして使う
+	size_t traceHead_ = 0;
+	std::mutex traceMutex_;
+};
@@ -1,9 +1,9 @@
 #pragma once
-#include "Vector3.h"
+#include "Vector3ex.h"
 
 //半直線
 struct Ray final
 {
-	Vector3 origin;		//始点
-	Vector3 diff;		//終点からの差分
+	Vector3ex origin;		//始点
+	Vector3ex diff;		//終点からの差分
 };
@@ -0,0 +1,200 @@
+#include "RayPacket.h"
+#include "SimdFloat.h"
+
+template<int N>
+RayPacket<N> MakeRayPacket(const Ray* rays, float tMax)
+{
+	RayPacket<N> packet;
+	for (int i = 0; i < N; ++i)
+	{
+		packet.originX[i] = rays[i].origin.x;
+		packet.originY[i] = rays[i].origin.y;
+		packet.originZ[i] = rays[i].origin.z;
+		packet.directionX[i] = rays[i].diff.x;
+		packet.directionY[i] = rays[i].diff.y;
+		packet.directionZ[i] = rays[i].diff.z;
+		packet.tMax[i] = tMax;
+	}
+	return packet;
+}
+
+template<int N>
+RayPacketHit<N> MakeRayPacketHit(const RayPacket<N>& packet)
+{
+	RayPacketHit<N> hit;
+	for (int i = 0; i < N; ++i)
+	{
+		hit.t[i] = packet.tMax[i];
+		hit.primitiveId[i] = -1;
+	}
+	return hit;
+}
+
+template<int N>
+void IntersectSpheres(const RayPacket<N>& packet, const Sphere* spheres, size_t count, int32_t firstId, RayPacketHit<N>& hit)
+{
+	using Float = typename SimdTraits<N>::Float;
+	using Int = typename SimdTraits<N>::Int;
+
+	const Float ox = Float::LoadAligned(packet.originX);
+	const Float oy = Float::LoadAligned(packet.originY);
+	const Float oz = Float::LoadAligned(packet.originZ);
+	const Float dx = Float::LoadAligned(packet.directionX);
+	const Float dy = Float::LoadAligned(packet.directionY);
+	const Float dz = Float::LoadAligned(packet.directionZ);
+	const Float zero = Float::Zero();
+
+	// 方向の長さの2乗はどの球でも同じ
+	const Float a = dx * dx + dy * dy + dz * dz;
+	const Float inverseA = Float::Set1(1.0f) / a;
+
+	Float bestT = Float::LoadAligned(hit.t);
+	Int bestId = Int::Load(hit.primitiveId);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Sphere& sphere = spheres[i];
+
+		// |o + t*d - c|^2 = r^2 を解く（bは半分にした係数）
+		const Float ocx = ox - Float::Set1(sphere.center.x);
+		const Float ocy = oy - Float::Set1(sphere.center.y);
+		const Float ocz = oz - Float::Set1(sphere.center.z);
+		const Float b = ocx * dx + ocy * dy + ocz * dz;
+		const Float c = ocx * ocx + ocy * ocy + ocz * ocz - Float::Set1(sphere.radius * sphere.radius);
+		const Float discriminant = b * b - a * c;
+
+		const Float root = Sqrt(Max(discriminant, zero));
+		const Float tNear = (-b - root) * inverseA;
+		const Float tFar = (-b + root) * inverseA;
+		// 始点が球の内側なら出ていく側の交点を使う
+		const Float t = Select(tNear >= zero, tNear, tFar);
+
+		const Float mask = (discriminant >= zero) & (t >= zero) & (t < bestT);
+		if (mask.MoveMask() == 0)
+		{
+			continue;
+		}
+		bestT = Select(mask, t, bestT);
+		bestId = Select(mask, Int::Set1(firstId + static_cast<int32_t>(i)), bestId);
+	}
+
+	bestT.StoreAligned(hit.t);
+	bestId.Store(hit.primitiveId);
+}
+
+template<int N>
+void IntersectAABBs(const RayPacket<N>& packet, const AABB* aabbs, size_t count, int32_t firstId, RayPacketHit<N>& hit)
+{
+	using Float = typename SimdTraits<N>::Float;
+	using Int = typename SimdTraits<N>::Int;
+
+	const Float ox = Float::LoadAligned(packet.originX);
+	const Float oy = Float::LoadAligned(packet.originY);
+	const Float oz = Float::LoadAligned(packet.originZ);
+
+	// 逆数と符号はパケットごとに1回だけ求める（0の成分は±infになる）
+	const Float one = Float::Set1(1.0f);
+	const Float inverseX = one / Float::LoadAligned(packet.directionX);
+	const Float inverseY = one / Float::LoadAligned(packet.directionY);
+	const Float inverseZ = one / Float::LoadAligned(packet.directionZ);
+	const Float zero = Float::Zero();
+	const Float negativeX = inverseX < zero;
+	const Float negativeY = inverseY < zero;
+	const Float negativeZ = inverseZ < zero;
+
+	Float bestT = Float::LoadAligned(hit.t);
+	Int bestId = Int::Load(hit.primitiveId);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const AABB& aabb = aabbs[i];
+		const Float minX = Float::Set1(aabb.min.x);
+		const Float maxX = Float::Set1(aabb.max.x);
+		const Float minY = Float::Set1(aabb.min.y);
+		const Float maxY = Float::Set1(aabb.max.y);
+		const Float minZ = Float::Set1(aabb.min.z);
+		const Float maxZ = Float::Set1(aabb.max.z);
+
+		// 方向の符号で手前と奥の面を選ぶので、軸ごとのmin/max比較が要らない
+		const Float nearX = (Select(negativeX, maxX, minX) - ox) * inverseX;
+		const Float farX = (Select(negativeX, minX, maxX) - ox) * inverseX;
+		const Float nearY = (Select(negativeY, maxY, minY) - oy) * inverseY;
+		const Float farY = (Select(negativeY, minY, maxY) - oy) * inverseY;
+		const Float nearZ = (Select(negativeZ, maxZ, minZ) - oz) * inverseZ;
+		const Float farZ = (Select(negativeZ, minZ, maxZ) - oz) * inverseZ;
+
+		// 始点がスラブ面上で方向が0だと0*inf=NaNになるが、
+		// maxps/minpsはNaNの時に第2引数を返すので、NaNを第1引数に置けばその軸は制限しない
+		Float tEnter = Max(nearX, zero);
+		tEnter = Max(nearY, tEnter);
+		tEnter = Max(nearZ, tEnter);
+		Float tExit = Min(farX, bestT);
+		tExit = Min(farY, tExit);
+		tExit = Min(farZ, tExit);
+
+		const Float mask = tEnter <= tExit;
+		if (mask.MoveMask() == 0)
+		{
+			continue;
+		}
+		bestT = Select(mask, tEnter, bestT);
+		bestId = Select(mask, Int::Set1(firstId + static_cast<int32_t>(i)), bestId);
+	}
+
+	bestT.StoreAligned(hit.t);
+	bestId.Store(hit.primitiveId);
+}
+
+template<int N>
+void IntersectPlanes(const RayPacket<N>& packet, const Plane* planes, size_t count, int32_t firstId, RayPacketHit<N>& hit)
+{
+	using Float = typename SimdTraits<N>::Float;
+	using Int = typename SimdTraits<N>::Int;
+
+	const Float ox = Float::LoadAligned(packet.originX);
+	const Float oy = Float::LoadAligned(packet.originY);
+	const Float oz = Float::LoadAligned(packet.originZ);
+	const Float dx = Float::LoadAligned(packet.directionX);
+	const Float dy = Float::LoadAligned(packet.directionY);
+	const Float dz = Float::LoadAligned(packet.directionZ);
+	const Float zero = Float::Zero();
+	const Float epsilon = Float::Set1(1e-6f);
+
+	Float bestT = Float::LoadAligned(hit.t);
+	Int bestId = Int::Load(hit.primitiveId);
+
+	for (size_t i = 0; i < count; ++i)
+	{
+		const Plane& plane = planes[i];
+		const Float nx = Float::Set1(plane.normal.x);
+		const Float ny = Float::Set1(plane.normal.y);
+		const Float nz = Float::Set1(plane.normal.z);
+
+		// 法線と方向が垂直なら平行なので当たらない
+		const Float dot = nx * dx + ny * dy + nz * dz;
+		const Float t = (Float::Set1(plane.distance) - (nx * ox + ny * oy + nz * oz)) / dot;
+
+		const Float mask = (Abs(dot) >= epsilon) & (t >= zero) & (t < bestT);
+		if (mask.MoveMask() == 0)
+		{
+			continue;
+		}
+		bestT = Select(mask, t, bestT);
+		bestId = Select(mask, Int::Set1(firstId + static_cast<int32_t>(i)), bestId);
+	}
+
+	bestT.StoreAligned(hit.t);
+	bestId.Store(hit.primitiveId);
+}
+
+// 4本と8本だけを実体化する
+template RayPacket<4> MakeRayPacket<4>(const Ray*, float);
+template RayPacket<8> MakeRayPacket<8>(const Ray*, float);
+template RayPacketHit<4> MakeRayPacketHit<4>(const RayPacket<4>&);
+template RayPacketHit<8> MakeRayPacketHit<8>(const RayPacket<8>&);
+template void IntersectSpheres<4>(const RayPacket<4>&, const Sphere*, size_t, int32_t, RayPacketHit<4>&);
+template void IntersectSpheres<8>(const RayPacket<8>&, const Sphere*, size_t, int32_t, RayPacketHit<8>&);
+template void IntersectAABBs<4>(const RayPacket<4>&, const AABB*, size_t, int32_t, RayPacketHit<4>&);
+template void IntersectAABBs<8>(const RayPacket<8>&, const AABB*, size_t, int32_t, RayPacketHit<8>&);
+template void IntersectPlanes<4>(const RayPacket<4>&, const Plane*, size_t, int32_t, RayPacketHit<4>&);
+template void IntersectPlanes<8>(const RayPacket<8>&, const Plane*, size_t, int32_t, RayPacketHit<8>&);
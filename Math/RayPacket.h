@@ -0,0 +1,90 @@
+#pragma once
+#include "AABB.h"
+#include "Plane.h"
+#include "Ray.h"
+#include "Sphereh.h"
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// N本の半直線をSoA（成分ごとの配列）で並べたもの
+/// 近い方向を向いた光線をまとめると、1命令でN本分の判定ができる
+/// </summary>
+template<int N>
+struct alignas(N * sizeof(float)) RayPacket final
+{
+	static_assert(N == 4 || N == 8, "RayPacketは4本か8本");
+
+	float originX[N];		// 始点
+	float originY[N];
+	float originZ[N];
+	float directionX[N];	// 方向（正規化は不要）
+	float directionY[N];
+	float directionZ[N];
+	float tMax[N];			// 判定を打ち切る距離（tはdirectionの長さ単位）
+};
+
+/// <summary>
+/// レーンごとの最も近い交点
+/// </summary>
+template<int N>
+struct alignas(N * sizeof(float)) RayPacketHit final
+{
+	float t[N];					// 交点までのt（当たらなければtMaxのまま）
+	int32_t primitiveId[N];		// 当たった図形の番号（当たらなければ-1）
+};
+
+using RayPacket4 = RayPacket<4>;
+using RayPacket8 = RayPacket<8>;
+using RayPacketHit4 = RayPacketHit<4>;
+using RayPacketHit8 = RayPacketHit<8>;
+
+/// <summary>
+/// 半直線の配列からパケットを作る
+/// </summary>
+/// <param name="rays">N本の半直線</param>
+/// <param name="tMax">判定を打ち切る距離</param>
+/// <returns></returns>
+template<int N>
+RayPacket<N> MakeRayPacket(const Ray* rays, float tMax);
+
+/// <summary>
+/// 交点を未ヒットの状態で初期化する
+/// </summary>
+/// <param name="packet">パケット</param>
+/// <returns></returns>
+template<int N>
+RayPacketHit<N> MakeRayPacketHit(const RayPacket<N>& packet);
+
+/// <summary>
+/// パケットと球の配列の判定（より近い交点があればhitを更新する）
+/// </summary>
+/// <param name="packet">パケット</param>
+/// <param name="spheres">球の配列</param>
+/// <param name="count">球の数</param>
+/// <param name="firstId">spheres[0]の番号</param>
+/// <param name="hit">交点</param>
+template<int N>
+void IntersectSpheres(const RayPacket<N>& packet, const Sphere* spheres, size_t count, int32_t firstId, RayPacketHit<N>& hit);
+
+/// <summary>
+/// パケットとAABBの配列の判定（始点がAABBの内側ならt=0で当たる）
+/// </summary>
+/// <param name="packet">パケット</param>
+/// <param name="aabbs">AABBの配列</param>
+/// <param name="count">AABBの数</param>
+/// <param name="firstId">aabbs[0]の番号</param>
+/// <param name="hit">交点</param>
+template<int N>
+void IntersectAABBs(const RayPacket<N>& packet, const AABB* aabbs, size_t count, int32_t firstId, RayPacketHit<N>& hit);
+
+/// <summary>
+/// パケットと平面の配列の判定
+/// </summary>
+/// <param name="packet">パケット</param>
+/// <param name="planes">平面の配列</param>
+/// <param name="count">平面の数</param>
+/// <param name="firstId">planes[0]の番号</param>
+/// <param name="hit">交点</param>
+template<int N>
+void IntersectPlanes(const RayPacket<N>& packet, const Plane* planes, size_t count, int32_t firstId, RayPacketHit<N>& hit);
@@ -0,0 +1,122 @@
+#include "SceneGraph.h"
+#include "MathFunction.h"
+
+namespace
+{
+	MathFunction Func;
+
+	bool Equals(const Vector3ex& a, const Vector3ex& b)
+	{
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+}
+
+uint32_t SceneGraph::AddNode(uint32_t parent, const Transform& local)
+{
+	const uint32_t index = static_cast<uint32_t>(parents_.size());
+	// 親が先に並んでいることを前提に1回の走査で伝播する
+	assert(parent == kNoParent || parent < index);
+
+	parents_.push_back(parent);
+	locals_.push_back(local);
+	localMatrices_.push_back(Func.MakeIdentity());
+	worldMatrices_.push_back(Func.MakeIdentity());
+	dirty_.push_back(0);
+	updated_.push_back(0);
+	MarkDirty(index);
+	return index;
+}
+
+void SceneGraph::SetLocal(uint32_t index, const Transform& local)
+{
+	Transform& current = locals_[index];
+	if (Equals(current.scale, local.scale) && Equals(current.rotate, local.rotate) && Equals(current.translate, local.translate))
+	{
+		return;
+	}
+	current = local;
+	MarkDirty(index);
+}
+
+void SceneGraph::SetScale(uint32_t index, const Vector3ex& scale)
+{
+	if (Equals(locals_[index].scale, scale))
+	{
+		return;
+	}
+	locals_[index].scale = scale;
+	MarkDirty(index);
+}
+
+void SceneGraph::SetRotate(uint32_t index, const Vector3ex& rotate)
+{
+	if (Equals(locals_[index].rotate, rotate))
+	{
+		return;
+	}
+	locals_[index].rotate = rotate;
+	MarkDirty(index);
+}
+
+void SceneGraph::SetTranslate(uint32_t index, const Vector3ex& translate)
+{
+	if (Equals(locals_[index].translate, translate))
+	{
+		return;
+	}
+	locals_[index].translate = translate;
+	MarkDirty(index);
+}
+
+void SceneGraph::MarkDirty(uint32_t index)
+{
+	dirty_[index] = 1;
+	if (index < firstDirty_)
+	{
+		firstDirty_ = index;
+	}
+}
+
+void SceneGraph::Update()
+{
+	// 前回の更新フラグを消す（前回更新したノードが無ければ何もしない）
+	if (updatedCount_ != 0)
+	{
+		std::fill(updated_.begin(), updated_.end(), static_cast<uint8_t>(0));
+		updatedCount_ = 0;
+	}
+
+	const size_t count = parents_.size();
+	if (firstDirty_ >= count)
+	{
+		return;
+	}
+
+	// 変更されたノードより前は変わらないので、そこから後ろだけをなめる
+	for (size_t i = firstDirty_; i < count; ++i)
+	{
+		const uint32_t parent = parents_[i];
+		const bool parentUpdated = parent != kNoParent && updated_[parent] != 0;
+		if (dirty_[i] == 0 && !parentUpdated)
+		{
+			continue;
+		}
+
+		if (dirty_[i] != 0)
+		{
+			const Transform& local = locals_[i];
+			localMatrices_[i] = Func.MakeAffineMatrix(local.scale, local.rotate, local.translate);
+			dirty_[i] = 0;
+		}
+		worldMatrices_[i] = parent == kNoParent ? localMatrices_[i] : Func.Multiply(localMatrices_[i], worldMatrices_[parent]);
+		updated_[i] = 1;
+		++updatedCount_;
+	}
+	firstDirty_ = count;
+}
+
+Vector3ex SceneGraph::GetWorldPosition(uint32_t index) const
+{
+	const Matrix4x4ex& world = worldMatrices_[index];
+	return { world.m[3][0], world.m[3][1], world.m[3][2] };
+}
@@ -0,0 +1,83 @@
+#pragma once
+#include "Matrix4x4ex.h"
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/// <summary>
+/// ローカルのSRT（拡縮・回転・移動）
+/// </summary>
+struct Transform final
+{
+	Vector3ex scale = { 1.0f, 1.0f, 1.0f };	// 拡縮
+	Vector3ex rotate = { 0.0f, 0.0f, 0.0f };	// 回転（ラジアン、MakeAffineMatrixと同じXYZ順）
+	Vector3ex translate = { 0.0f, 0.0f, 0.0f };	// 移動
+};
+
+/// <summary>
+/// 番号で親を参照する平たいシーングラフ
+/// 親は必ず子より前に追加されるので、配列の先頭から1回なめるだけで親から子へ伝播できる
+/// 変更されたノードとその子孫だけワールド行列を計算し直す
+/// </summary>
+class SceneGraph final
+{
+public:
+	static constexpr uint32_t kNoParent = UINT32_MAX;
+
+	/// <summary>
+	/// ノードを追加する
+	/// </summary>
+	/// <param name="parent">親の番号（既に追加されているノードかkNoParent）</param>
+	/// <param name="local">ローカルのSRT</param>
+	/// <returns>ノードの番号</returns>
+	uint32_t AddNode(uint32_t parent = kNoParent, const Transform& local = {});
+
+	/// <summary>
+	/// ローカルのSRTを設定する（値が変わった時だけ更新対象にする）
+	/// </summary>
+	/// <param name="index">ノードの番号</param>
+	/// <param name="local">ローカルのSRT</param>
+	void SetLocal(uint32_t index, const Transform& local);
+	void SetScale(uint32_t index, const Vector3ex& scale);
+	void SetRotate(uint32_t index, const Vector3ex& rotate);
+	void SetTranslate(uint32_t index, const Vector3ex& translate);
+
+	/// <summary>
+	/// 変更されたノードとその子孫のワールド行列を計算し直す
+	/// </summary>
+	void Update();
+
+	const Transform& GetLocal(uint32_t index) const { return locals_[index]; }
+	const Matrix4x4ex& GetLocalMatrix(uint32_t index) const { return localMatrices_[index]; }
+	const Matrix4x4ex& GetWorldMatrix(uint32_t index) const { return worldMatrices_[index]; }
+	/// <summary>
+	/// ワールド座標での位置（ワールド行列の移動成分）
+	/// </summary>
+	Vector3ex GetWorldPosition(uint32_t index) const;
+	uint32_t GetParent(uint32_t index) const { return parents_[index]; }
+	size_t GetNodeCount() const { return parents_.size(); }
+	/// <summary>
+	/// 直前のUpdateでワールド行列が変わったか
+	/// </summary>
+	bool WasUpdated(uint32_t index) const { return updated_[index] != 0; }
+	/// <summary>
+	/// 直前のUpdateで計算し直したノードの数
+	/// </summary>
+	size_t GetUpdatedCount() const { return updatedCount_; }
+
+private:
+	/// <summary>
+	/// ノードを更新対象にする
+	/// </summary>
+	void MarkDirty(uint32_t index);
+
+	std::vector<uint32_t> parents_;
+	std::vector<Transform> locals_;
+	std::vector<Matrix4x4ex> localMatrices_;
+	std::vector<Matrix4x4ex> worldMatrices_;
+	std::vector<uint8_t> dirty_;		// ローカルが変わったら1
+	std::vector<uint8_t> updated_;		// 直前のUpdateでワールド行列が変わったら1
+	size_t firstDirty_ = 0;				// 最も前にある変更されたノード（無ければノード数）
+	size_t updatedCount_ = 0;
+};
@@ -0,0 +1,479 @@
+#include "SdfVolume.h"
+#include "MathFunction.h"
+#include "SimdFloat.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <cmath>
+
+namespace
+{
+	MathFunction Func;
+
+	constexpr float kFarDistance = 1e30f;	// 焼く前の距離（8つ足してもfloatの範囲に収まる大きさ）
+
+	/// <summary>
+	/// 2次元の外積（yz平面）
+	/// </summary>
+	float CrossYZ(float ay, float az, float by, float bz)
+	{
+		return ay * bz - az * by;
+	}
+
+	/// <summary>
+	/// 3重線形補間と、その格子座標での勾配
+	/// cornersはx、y、zを1ビットずつ持つ番号の順（0が(0,0,0)、7が(1,1,1)）
+	/// </summary>
+	template<class T>
+	T Trilinear(const T (&corners)[8], T tx, T ty, T tz, T& gradientX, T& gradientY, T& gradientZ)
+	{
+		// x方向に補間
+		const T c00 = corners[0] + (corners[1] - corners[0]) * tx;
+		const T c10 = corners[2] + (corners[3] - corners[2]) * tx;
+		const T c01 = corners[4] + (corners[5] - corners[4]) * tx;
+		const T c11 = corners[6] + (corners[7] - corners[6]) * tx;
+		// y方向に補間
+		const T c0 = c00 + (c10 - c00) * ty;
+		const T c1 = c01 + (c11 - c01) * ty;
+
+		// x方向の差をy、zで補間したものがx方向の勾配
+		const T e00 = corners[1] - corners[0];
+		const T e10 = corners[3] - corners[2];
+		const T e01 = corners[5] - corners[4];
+		const T e11 = corners[7] - corners[6];
+		const T e0 = e00 + (e10 - e00) * ty;
+		const T e1 = e01 + (e11 - e01) * ty;
+		gradientX = e0 + (e1 - e0) * tz;
+		const T f0 = c10 - c00;
+		const T f1 = c11 - c01;
+		gradientY = f0 + (f1 - f0) * tz;
+		gradientZ = c1 - c0;
+		return c0 + (c1 - c0) * tz;
+	}
+}
+
+SdfVolume::SdfVolume(uint32_t sampleCountX, uint32_t sampleCountY, uint32_t sampleCountZ, float cellSize, const Vector3ex& origin)
+	: sampleCountX_(sampleCountX), sampleCountY_(sampleCountY), sampleCountZ_(sampleCountZ),
+	cellSize_(cellSize), inverseCellSize_(1.0f / cellSize), origin_(origin)
+{
+	assert(sampleCountX >= 2 && sampleCountY >= 2 && sampleCountZ >= 2 && cellSize > 0.0f);
+	const size_t sampleCount = static_cast<size_t>(sampleCountX_) * sampleCountY_ * sampleCountZ_;
+	// CollideBatchは格子点の番号をfloatで計算するので、誤差なく表せる数までにする
+	assert(sampleCount <= (size_t(1) << 24));
+	distances_.assign(sampleCount, kFarDistance);
+}
+
+SdfVolume SdfVolume::FromTriangles(std::span<const Triangle> triangles, float cellSize, float margin, bool isClosed)
+{
+	assert(!triangles.empty());
+	Vector3ex low = triangles[0].vertices[0];
+	Vector3ex high = low;
+	for (const Triangle& triangle : triangles)
+	{
+		for (const Vector3ex& vertex : triangle.vertices)
+		{
+			low = { std::min(low.x, vertex.x), std::min(low.y, vertex.y), std::min(low.z, vertex.z) };
+			high = { std::max(high.x, vertex.x), std::max(high.y, vertex.y), std::max(high.z, vertex.z) };
+		}
+	}
+	low = low - Vector3ex{ margin, margin, margin };
+	high = high + Vector3ex{ margin, margin, margin };
+
+	auto sampleCount = [cellSize](float extent) {
+		return std::max(static_cast<uint32_t>(std::ceil(extent / cellSize)) + 1, 2u);
+	};
+	SdfVolume volume(sampleCount(high.x - low.x), sampleCount(high.y - low.y), sampleCount(high.z - low.z), cellSize, low);
+	volume.Bake(triangles, isClosed);
+	return volume;
+}
+
+void SdfVolume::Bake(std::span<const Triangle> triangles, bool isClosed)
+{
+	const size_t sampleCount = distances_.size();
+	std::vector<int32_t> nearest(sampleCount, -1);		// 最も近い三角形の番号
+	std::vector<Vector3ex> nearestPoints(sampleCount);		// その三角形上の最も近い点
+	std::vector<float> distancesSquared(sampleCount, kFarDistance);
+
+	// 三角形の範囲を1セル広げた格子点だけ、正確な距離を求める
+	const uint32_t maxIndex[3] = { sampleCountX_ - 1, sampleCountY_ - 1, sampleCountZ_ - 1 };
+	auto toCell = [this](float value, float origin, uint32_t maxCell, float offset) {
+		const float cell = std::floor((value - origin) * inverseCellSize_) + offset;
+		return static_cast<uint32_t>(std::clamp(cell, 0.0f, static_cast<float>(maxCell)));
+	};
+	for (size_t t = 0; t < triangles.size(); ++t)
+	{
+		const Triangle& triangle = triangles[t];
+		const Vector3ex& a = triangle.vertices[0];
+		const Vector3ex& b = triangle.vertices[1];
+		const Vector3ex& c = triangle.vertices[2];
+		const uint32_t x0 = toCell(std::min({ a.x, b.x, c.x }), origin_.x, maxIndex[0], -1.0f);
+		const uint32_t y0 = toCell(std::min({ a.y, b.y, c.y }), origin_.y, maxIndex[1], -1.0f);
+		const uint32_t z0 = toCell(std::min({ a.z, b.z, c.z }), origin_.z, maxIndex[2], -1.0f);
+		const uint32_t x1 = toCell(std::max({ a.x, b.x, c.x }), origin_.x, maxIndex[0], 2.0f);
+		const uint32_t y1 = toCell(std::max({ a.y, b.y, c.y }), origin_.y, maxIndex[1], 2.0f);
+		const uint32_t z1 = toCell(std::max({ a.z, b.z, c.z }), origin_.z, maxIndex[2], 2.0f);
+		for (uint32_t iz = z0; iz <= z1; ++iz)
+		{
+			for (uint32_t iy = y0; iy <= y1; ++iy)
+			{
+				for (uint32_t ix = x0; ix <= x1; ++ix)
+				{
+					const Vector3ex position = GetSamplePosition(ix, iy, iz);
+					const Vector3ex closest = Func.ClosestPoint(position, triangle);
+					const Vector3ex delta = position - closest;
+					const float distanceSquared = Func.Dot(delta, delta);
+					const size_t index = Index(ix, iy, iz);
+					if (distanceSquared < distancesSquared[index])
+					{
+						distancesSquared[index] = distanceSquared;
+						nearest[index] = static_cast<int32_t>(t);
+						nearestPoints[index] = closest;
+					}
+				}
+			}
+		}
+	}
+
+	// ジャンプフラッディング：歩幅を半分にしながら、26近傍の持つ最も近い点を比べて受け取る
+	// 比べるのは近傍が持つ点までの距離（本当の距離以上）なので、最後に歩幅1をもう1回かけて誤差を減らす
+	std::vector<int32_t> nextNearest(sampleCount);
+	std::vector<Vector3ex> nextPoints(sampleCount);
+	std::vector<float> nextDistancesSquared(sampleCount);
+	auto pass = [&](int32_t step) {
+		for (uint32_t iz = 0; iz < sampleCountZ_; ++iz)
+		{
+			for (uint32_t iy = 0; iy < sampleCountY_; ++iy)
+			{
+				for (uint32_t ix = 0; ix < sampleCountX_; ++ix)
+				{
+					const size_t index = Index(ix, iy, iz);
+					const Vector3ex position = GetSamplePosition(ix, iy, iz);
+					int32_t bestTriangle = nearest[index];
+					Vector3ex bestPoint = nearestPoints[index];
+					float bestDistanceSquared = distancesSquared[index];
+					for (int32_t dz = -step; dz <= step; dz += step)
+					{
+						const int64_t nz = static_cast<int64_t>(iz) + dz;
+						if (nz < 0 || nz > maxIndex[2])
+						{
+							continue;
+						}
+						for (int32_t dy = -step; dy <= step; dy += step)
+						{
+							const int64_t ny = static_cast<int64_t>(iy) + dy;
+							if (ny < 0 || ny > maxIndex[1])
+							{
+								continue;
+							}
+							for (int32_t dx = -step; dx <= step; dx += step)
+							{
+								const int64_t nx = static_cast<int64_t>(ix) + dx;
+								if (nx < 0 || nx > maxIndex[0])
+								{
+									continue;
+								}
+								const size_t neighbor = Index(static_cast<uint32_t>(nx), static_cast<uint32_t>(ny), static_cast<uint32_t>(nz));
+								if (nearest[neighbor] < 0 || nearest[neighbor] == bestTriangle)
+								{
+									continue;
+								}
+								const Vector3ex delta = position - nearestPoints[neighbor];
+								const float distanceSquared = Func.Dot(delta, delta);
+								if (distanceSquared < bestDistanceSquared)
+								{
+									bestDistanceSquared = distanceSquared;
+									bestTriangle = nearest[neighbor];
+									bestPoint = nearestPoints[neighbor];
+								}
+							}
+						}
+					}
+					nextNearest[index] = bestTriangle;
+					nextPoints[index] = bestPoint;
+					nextDistancesSquared[index] = bestDistanceSquared;
+				}
+			}
+		}
+		nearest.swap(nextNearest);
+		nearestPoints.swap(nextPoints);
+		distancesSquared.swap(nextDistancesSquared);
+	};
+	const uint32_t longest = std::max({ sampleCountX_, sampleCountY_, sampleCountZ_ });
+	for (uint32_t step = std::bit_floor(std::max(longest / 2, 1u)); step >= 1; step /= 2)
+	{
+		pass(static_cast<int32_t>(step));
+	}
+	pass(1);
+
+	// 伝わった三角形との正確な距離を求める
+	for (uint32_t iz = 0; iz < sampleCountZ_; ++iz)
+	{
+		for (uint32_t iy = 0; iy < sampleCountY_; ++iy)
+		{
+			for (uint32_t ix = 0; ix < sampleCountX_; ++ix)
+			{
+				const size_t index = Index(ix, iy, iz);
+				if (nearest[index] < 0)
+				{
+					distances_[index] = kFarDistance;
+					continue;
+				}
+				const Vector3ex position = GetSamplePosition(ix, iy, iz);
+				const Vector3ex closest = Func.ClosestPoint(position, triangles[static_cast<size_t>(nearest[index])]);
+				distances_[index] = Func.Length(position - closest);
+			}
+		}
+	}
+	if (!isClosed)
+	{
+		return;
+	}
+
+	// 符号：格子点の並ぶx方向の直線ごとに三角形との交点を集め、手前にある交点の数が奇数なら内側
+	// 直線が辺や頂点をちょうど通ると二重に数えるので、直線を少しずらす
+	const float jitterY = cellSize_ * 1.23e-3f;
+	const float jitterZ = cellSize_ * 0.77e-3f;
+	std::vector<std::vector<float>> crossings(static_cast<size_t>(sampleCountY_) * sampleCountZ_);
+	for (const Triangle& triangle : triangles)
+	{
+		const Vector3ex& a = triangle.vertices[0];
+		const Vector3ex& b = triangle.vertices[1];
+		const Vector3ex& c = triangle.vertices[2];
+		const float area = CrossYZ(b.y - a.y, b.z - a.z, c.y - a.y, c.z - a.z);
+		if (area == 0.0f)
+		{
+			continue;	// x方向から見て潰れている三角形とは交わらない
+		}
+		const uint32_t y0 = toCell(std::min({ a.y, b.y, c.y }) - jitterY, origin_.y, maxIndex[1], 0.0f);
+		const uint32_t z0 = toCell(std::min({ a.z, b.z, c.z }) - jitterZ, origin_.z, maxIndex[2], 0.0f);
+		const uint32_t y1 = toCell(std::max({ a.y, b.y, c.y }) - jitterY, origin_.y, maxIndex[1], 1.0f);
+		const uint32_t z1 = toCell(std::max({ a.z, b.z, c.z }) - jitterZ, origin_.z, maxIndex[2], 1.0f);
+		for (uint32_t iz = z0; iz <= z1; ++iz)
+		{
+			const float pz = origin_.z + static_cast<float>(iz) * cellSize_ + jitterZ;
+			for (uint32_t iy = y0; iy <= y1; ++iy)
+			{
+				const float py = origin_.y + static_cast<float>(iy) * cellSize_ + jitterY;
+				// yz平面での重心座標
+				const float u = CrossYZ(c.y - b.y, c.z - b.z, py - b.y, pz - b.z) / area;
+				const float v = CrossYZ(a.y - c.y, a.z - c.z, py - c.y, pz - c.z) / area;
+				const float w = 1.0f - u - v;
+				if (u < 0.0f || v < 0.0f || w < 0.0f)
+				{
+					continue;
+				}
+				crossings[static_cast<size_t>(iz) * sampleCountY_ + iy].push_back(u * a.x + v * b.x + w * c.x);
+			}
+		}
+	}
+	for (uint32_t iz = 0; iz < sampleCountZ_; ++iz)
+	{
+		for (uint32_t iy = 0; iy < sampleCountY_; ++iy)
+		{
+			std::vector<float>& row = crossings[static_cast<size_t>(iz) * sampleCountY_ + iy];
+			std::sort(row.begin(), row.end());
+			size_t passed = 0;
+			for (uint32_t ix = 0; ix < sampleCountX_; ++ix)
+			{
+				const float x = origin_.x + static_cast<float>(ix) * cellSize_;
+				while (passed < row.size() && row[passed] < x)
+				{
+					++passed;
+				}
+				if (passed % 2 == 1)
+				{
+					distances_[Index(ix, iy, iz)] = -distances_[Index(ix, iy, iz)];
+				}
+			}
+		}
+	}
+}
+
+void SdfVolume::SetDistances(const float* distances)
+{
+	std::copy(distances, distances + distances_.size(), distances_.begin());
+}
+
+float SdfVolume::Sample(const Vector3ex& point) const
+{
+	Vector3ex gradient;
+	return SampleWithGradient(point, gradient);
+}
+
+Vector3ex SdfVolume::SampleNormal(const Vector3ex& point) const
+{
+	Vector3ex gradient;
+	SampleWithGradient(point, gradient);
+	const float length = Func.Length(gradient);
+	return length > 0.0f ? gradient / length : Vector3ex{ 0.0f, 1.0f, 0.0f };
+}
+
+bool SdfVolume::Collide(const Vector3ex& center, float radius, Vector3ex& normal, float& depth) const
+{
+	Vector3ex gradient;
+	const float distance = SampleWithGradient(center, gradient);
+	if (!(distance < radius))
+	{
+		return false;
+	}
+	// 周りの格子点が全て同じ距離だと向きが決まらない（焼く前の遠い格子点など）
+	const float length = Func.Length(gradient);
+	if (!(length > 0.0f))
+	{
+		return false;
+	}
+	normal = gradient / length;
+	depth = radius - distance;
+	return true;
+}
+
+size_t SdfVolume::CollideBatch(const BallSoA& balls, std::vector<Contact>& contacts) const
+{
+	const size_t before = contacts.size();
+	const size_t count = balls.GetCount();
+	const size_t simdCount = count - count % Float8::kWidth;
+
+	const uint32_t strideY = sampleCountX_;
+	const uint32_t strideZ = sampleCountX_ * sampleCountY_;
+	const uint32_t offsets[8] = { 0, 1, strideY, strideY + 1, strideZ, strideZ + 1, strideZ + strideY, strideZ + strideY + 1 };
+	const Float8 originX = Float8::Set1(origin_.x);
+	const Float8 originY = Float8::Set1(origin_.y);
+	const Float8 originZ = Float8::Set1(origin_.z);
+	const Float8 inverseCell = Float8::Set1(inverseCellSize_);
+	const Float8 cellSize = Float8::Set1(cellSize_);
+	const Float8 zero = Float8::Zero();
+	const Float8 maxX = Float8::Set1(static_cast<float>(sampleCountX_ - 1));
+	const Float8 maxY = Float8::Set1(static_cast<float>(sampleCountY_ - 1));
+	const Float8 maxZ = Float8::Set1(static_cast<float>(sampleCountZ_ - 1));
+	const Float8 maxCellX = Float8::Set1(static_cast<float>(sampleCountX_ - 2));
+	const Float8 maxCellY = Float8::Set1(static_cast<float>(sampleCountY_ - 2));
+	const Float8 maxCellZ = Float8::Set1(static_cast<float>(sampleCountZ_ - 2));
+	const Float8 strideYf = Float8::Set1(static_cast<float>(strideY));
+	const Float8 strideZf = Float8::Set1(static_cast<float>(strideZ));
+
+	alignas(32) int32_t baseIndex[8];
+	alignas(32) float corners[8][8];
+	alignas(32) float gradientX[8];
+	alignas(32) float gradientY[8];
+	alignas(32) float gradientZ[8];
+	alignas(32) float depths[8];
+	for (size_t i = 0; i < simdCount; i += Float8::kWidth)
+	{
+		// 格子座標に直し、範囲外は範囲の端に寄せる
+		const Float8 gx = (Float8::Load(balls.positionX.data() + i) - originX) * inverseCell;
+		const Float8 gy = (Float8::Load(balls.positionY.data() + i) - originY) * inverseCell;
+		const Float8 gz = (Float8::Load(balls.positionZ.data() + i) - originZ) * inverseCell;
+		const Float8 cx = Min(Max(gx, zero), maxX);
+		const Float8 cy = Min(Max(gy, zero), maxY);
+		const Float8 cz = Min(Max(gz, zero), maxZ);
+		const Float8 ox = gx - cx;
+		const Float8 oy = gy - cy;
+		const Float8 oz = gz - cz;
+		const Float8 outside = Sqrt(ox * ox + oy * oy + oz * oz) * cellSize;
+
+		// 寄せた座標は0以上なので切り捨てが床関数になる（最後の格子点は1つ手前のセルに入れる）
+		const Float8 fx = Min(ToFloat(TruncateToInt(cx)), maxCellX);
+		const Float8 fy = Min(ToFloat(TruncateToInt(cy)), maxCellY);
+		const Float8 fz = Min(ToFloat(TruncateToInt(cz)), maxCellZ);
+		TruncateToInt(fx + fy * strideYf + fz * strideZf).Store(baseIndex);
+		for (int lane = 0; lane < Float8::kWidth; ++lane)
+		{
+			const float* base = distances_.data() + baseIndex[lane];
+			for (int corner = 0; corner < 8; ++corner)
+			{
+				corners[corner][lane] = base[offsets[corner]];
+			}
+		}
+		const Float8 values[8] =
+		{
+			Float8::LoadAligned(corners[0]), Float8::LoadAligned(corners[1]), Float8::LoadAligned(corners[2]), Float8::LoadAligned(corners[3]),
+			Float8::LoadAligned(corners[4]), Float8::LoadAligned(corners[5]), Float8::LoadAligned(corners[6]), Float8::LoadAligned(corners[7]),
+		};
+		Float8 dx;
+		Float8 dy;
+		Float8 dz;
+		const Float8 distance = Trilinear(values, cx - fx, cy - fy, cz - fz, dx, dy, dz) + outside;
+		const Float8 radius = Float8::Load(balls.radius.data() + i);
+		const Float8 length = Sqrt(dx * dx + dy * dy + dz * dz);
+		const int hitMask = ((distance < radius) & (length > zero)).MoveMask();
+		if (hitMask == 0)
+		{
+			continue;
+		}
+		const Float8 inverseLength = Float8::Set1(1.0f) / Max(length, Float8::Set1(1e-30f));
+		(dx * inverseLength).StoreAligned(gradientX);
+		(dy * inverseLength).StoreAligned(gradientY);
+		(dz * inverseLength).StoreAligned(gradientZ);
+		(radius - distance).StoreAligned(depths);
+		for (int lane = 0; lane < Float8::kWidth; ++lane)
+		{
+			if ((hitMask >> lane) & 1)
+			{
+				contacts.push_back({ static_cast<uint32_t>(i + lane), 0, ContactTarget::SdfVolume,
+					{ gradientX[lane], gradientY[lane], gradientZ[lane] }, depths[lane] });
+			}
+		}
+	}
+	for (size_t i = simdCount; i < count; ++i)
+	{
+		Vector3ex normal;
+		float depth = 0.0f;
+		if (Collide(balls.GetPosition(i), balls.radius[i], normal, depth))
+		{
+			contacts.push_back({ static_cast<uint32_t>(i), 0, ContactTarget::SdfVolume, normal, depth });
+		}
+	}
+	return contacts.size() - before;
+}
+
+AABB SdfVolume::GetBounds() const
+{
+	return
+	{
+		origin_,
+		origin_ + Vector3ex{ static_cast<float>(sampleCountX_ - 1) * cellSize_, static_cast<float>(sampleCountY_ - 1) * cellSize_, static_cast<float>(sampleCountZ_ - 1) * cellSize_ },
+	};
+}
+
+Vector3ex SdfVolume::GetSamplePosition(uint32_t ix, uint32_t iy, uint32_t iz) const
+{
+	return
+	{
+		origin_.x + static_cast<float>(ix) * cellSize_,
+		origin_.y + static_cast<float>(iy) * cellSize_,
+		origin_.z + static_cast<float>(iz) * cellSize_,
+	};
+}
+
+float SdfVolume::SampleWithGradient(const Vector3ex& point, Vector3ex& gradient) const
+{
+	// CollideBatchと同じ順で計算する（同じ点なら同じ結果になる）
+	const float gx = (point.x - origin_.x) * inverseCellSize_;
+	const float gy = (point.y - origin_.y) * inverseCellSize_;
+	const float gz = (point.z - origin_.z) * inverseCellSize_;
+	const float cx = std::min(std::max(gx, 0.0f), static_cast<float>(sampleCountX_ - 1));
+	const float cy = std::min(std::max(gy, 0.0f), static_cast<float>(sampleCountY_ - 1));
+	const float cz = std::min(std::max(gz, 0.0f), static_cast<float>(sampleCountZ_ - 1));
+	const float ox = gx - cx;
+	const float oy = gy - cy;
+	const float oz = gz - cz;
+	const float outside = std::sqrt(ox * ox + oy * oy + oz * oz) * cellSize_;
+
+	const uint32_t ix = std::min(static_cast<uint32_t>(cx), sampleCountX_ - 2);
+	const uint32_t iy = std::min(static_cast<uint32_t>(cy), sampleCountY_ - 2);
+	const uint32_t iz = std::min(static_cast<uint32_t>(cz), sampleCountZ_ - 2);
+	const size_t strideY = sampleCountX_;
+	const size_t strideZ = static_cast<size_t>(sampleCountX_) * sampleCountY_;
+	const float* base = distances_.data() + Index(ix, iy, iz);
+	const float corners[8] =
+	{
+		base[0], base[1], base[strideY], base[strideY + 1],
+		base[strideZ], base[strideZ + 1], base[strideZ + strideY], base[strideZ + strideY + 1],
+	};
+	float dx = 0.0f;
+	float dy = 0.0f;
+	float dz = 0.0f;
+	const float distance = Trilinear(corners, cx - static_cast<float>(ix), cy - static_cast<float>(iy), cz - static_cast<float>(iz), dx, dy, dz);
+	gradient = { dx, dy, dz };
+	return distance + outside;
+}
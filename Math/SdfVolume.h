@@ -0,0 +1,110 @@
+#pragma once
+#include "AABB.h"
+#include "BallSoA.h"
+#include "Contact.h"
+#include "Triangle.h"
+#include "Vector3ex.h"
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+/// <summary>
+/// 等間隔の3次元格子に符号付き距離を持つ静的な形（内側が負）
+/// 格子点(ix, iy, iz)のワールド座標は origin + (ix, iy, iz) * cellSize
+/// 距離は格子点の間を3重線形補間し、法線はその勾配から求めるので、球との判定は形の複雑さによらず一定時間
+/// </summary>
+class SdfVolume final
+{
+public:
+	/// <summary>
+	/// 全ての格子点が遠い（十分大きな距離の）ボリュームを作る（格子点は2^24個まで）
+	/// </summary>
+	/// <param name="sampleCountX">x方向の格子点の数（2以上）</param>
+	/// <param name="sampleCountY">y方向の格子点の数（2以上）</param>
+	/// <param name="sampleCountZ">z方向の格子点の数（2以上）</param>
+	/// <param name="cellSize">格子の間隔</param>
+	/// <param name="origin">格子点(0, 0, 0)の位置</param>
+	SdfVolume(uint32_t sampleCountX, uint32_t sampleCountY, uint32_t sampleCountZ, float cellSize, const Vector3ex& origin = {});
+
+	/// <summary>
+	/// 三角形の範囲をmarginだけ広げた格子を作って焼き込む
+	/// </summary>
+	/// <param name="triangles">三角形</param>
+	/// <param name="cellSize">格子の間隔</param>
+	/// <param name="margin">三角形の範囲の外側に取る余白</param>
+	/// <param name="isClosed">閉じたメッシュならtrue（内側を負にする、falseなら符号なしの距離）</param>
+	static SdfVolume FromTriangles(std::span<const Triangle> triangles, float cellSize, float margin, bool isClosed);
+
+	/// <summary>
+	/// 三角形までの距離を焼き込む
+	/// 三角形の近くの格子点だけ正確な距離を求め、残りはジャンプフラッディングで最も近い三角形を伝える
+	/// 符号はx方向の直線と三角形の交差回数の偶奇で決める（閉じていないメッシュではisClosedをfalseにすること）
+	/// </summary>
+	/// <param name="triangles">三角形</param>
+	/// <param name="isClosed">閉じたメッシュならtrue</param>
+	void Bake(std::span<const Triangle> triangles, bool isClosed);
+
+	float GetDistance(uint32_t ix, uint32_t iy, uint32_t iz) const { return distances_[Index(ix, iy, iz)]; }
+	/// <summary>
+	/// 距離をまとめて書き換える（x、y、zの順に並べた配列、事前に焼いたデータの読み込み用）
+	/// </summary>
+	void SetDistances(const float* distances);
+	const float* GetDistances() const { return distances_.data(); }
+
+	/// <summary>
+	/// 点での符号付き距離（範囲外は範囲の端の距離に端までの距離を足す）
+	/// </summary>
+	float Sample(const Vector3ex& point) const;
+	/// <summary>
+	/// 点での距離の勾配（正規化済み、形から離れる向き）
+	/// </summary>
+	Vector3ex SampleNormal(const Vector3ex& point) const;
+
+	/// <summary>
+	/// 球との接触を調べる（8つの格子点を読むだけなので、元の三角形の数によらない）
+	/// </summary>
+	/// <param name="center">球の中心</param>
+	/// <param name="radius">球の半径</param>
+	/// <param name="normal">接触法線（形から球へ向く）</param>
+	/// <param name="depth">めり込み量</param>
+	/// <returns>接触していればtrue</returns>
+	bool Collide(const Vector3ex& center, float radius, Vector3ex& normal, float& depth) const;
+	/// <summary>
+	/// ボールを8個ずつまとめて調べ、接触したものをcontactsに追加する（bodyIndexはballsの番号）
+	/// </summary>
+	/// <returns>接触の数</returns>
+	size_t CollideBatch(const BallSoA& balls, std::vector<Contact>& contacts) const;
+
+	/// <summary>
+	/// 格子の範囲
+	/// </summary>
+	AABB GetBounds() const;
+	uint32_t GetSampleCountX() const { return sampleCountX_; }
+	uint32_t GetSampleCountY() const { return sampleCountY_; }
+	uint32_t GetSampleCountZ() const { return sampleCountZ_; }
+	float GetCellSize() const { return cellSize_; }
+	const Vector3ex& GetOrigin() const { return origin_; }
+
+private:
+	size_t Index(uint32_t ix, uint32_t iy, uint32_t iz) const
+	{
+		return (static_cast<size_t>(iz) * sampleCountY_ + iy) * sampleCountX_ + ix;
+	}
+	/// <summary>
+	/// 格子点のワールド座標
+	/// </summary>
+	Vector3ex GetSamplePosition(uint32_t ix, uint32_t iy, uint32_t iz) const;
+	/// <summary>
+	/// 点を含むセルの距離と勾配を求める（範囲外の点は範囲内に寄せ、寄せた距離を足す）
+	/// </summary>
+	float SampleWithGradient(const Vector3ex& point, Vector3ex& gradient) const;
+
+	uint32_t sampleCountX_;
+	uint32_t sampleCountY_;
+	uint32_t sampleCountZ_;
+	float cellSize_;
+	float inverseCellSize_;
+	Vector3ex origin_;
+	std::vector<float> distances_;
+};
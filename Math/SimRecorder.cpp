@@ -0,0 +1,522 @@
+#include "SimRecorder.h"
+#include <algorithm>
+#include <bit>
+#include <cassert>
+#include <chrono>
+#include <cstddef>
+#include <cstring>
+
+namespace
+{
+	constexpr char kRecordMagic[4] = { 'M', 'T', 'R', 'C' };
+	constexpr char kIndexMagic[4] = { 'M', 'T', 'I', 'X' };
+	constexpr uint32_t kRecordVersion = 2;
+	constexpr size_t kMaskBits = 32;	// writtenMaskの1要素のビット数
+
+	// 記録の形式は元の構造体の並びと同じにしてあり、RecordStepはメンバーごとに詰め直さずにまとめて写す
+	static_assert(offsetof(Ball, position) == offsetof(RecordedBody, position) && offsetof(Ball, velocity) == offsetof(RecordedBody, velocity),
+		"Ballの先頭は記録するボールと同じ並びであること");
+	static_assert(sizeof(Contact) == sizeof(RecordedContact) &&
+		offsetof(Contact, otherIndex) == offsetof(RecordedContact, otherIndex) && offsetof(Contact, target) == offsetof(RecordedContact, target) &&
+		offsetof(Contact, normal) == offsetof(RecordedContact, normal) && offsetof(Contact, depth) == offsetof(RecordedContact, depth),
+		"Contactは記録する接触と同じ並びであること");
+
+	std::FILE* OpenForWrite(const char* path)
+	{
+		std::FILE* file = nullptr;
+#ifdef _MSC_VER
+		if (fopen_s(&file, path, "wb") != 0)
+		{
+			return nullptr;
+		}
+#else
+		file = std::fopen(path, "wb");
+#endif
+		return file;
+	}
+
+	/// <summary>
+	/// フレームが持つwrittenMaskの要素の数（キーフレームは持たない）
+	/// </summary>
+	size_t GetMaskWordCount(const RecordFrameHeader& frameHeader)
+	{
+		return frameHeader.writtenBodyCount == frameHeader.bodyCount ? 0 : (size_t(frameHeader.bodyCount) + kMaskBits - 1) / kMaskBits;
+	}
+
+	/// <summary>
+	/// offsetに正しいフレームがあるか（ファイルに収まり、境界が揃い、数とバイト数が合い、writtenMaskのビットの数が書いたボールの数と同じ）
+	/// 壊れたファイルや別のファイルを開いてもファイルの外を読まないように、使う前に全て調べる
+	/// </summary>
+	bool IsValidFrame(const uint8_t* data, size_t size, uint64_t offset)
+	{
+		if (offset % alignof(RecordFrameHeader) != 0 || size < sizeof(RecordFrameHeader) || offset > size - sizeof(RecordFrameHeader))
+		{
+			return false;
+		}
+		RecordFrameHeader frameHeader{};
+		std::memcpy(&frameHeader, data + offset, sizeof(frameHeader));
+		if (frameHeader.writtenBodyCount > frameHeader.bodyCount)
+		{
+			return false;
+		}
+		// 32ビットの数同士の積なので64ビットなら溢れない
+		const size_t maskWords = GetMaskWordCount(frameHeader);
+		const uint64_t expectedSize = sizeof(RecordFrameHeader) + uint64_t(maskWords) * sizeof(uint32_t) +
+			uint64_t(frameHeader.writtenBodyCount) * sizeof(RecordedBody) +
+			uint64_t(frameHeader.contactCount) * sizeof(RecordedContact);
+		if (frameHeader.byteSize != expectedSize || frameHeader.byteSize > size - offset)
+		{
+			return false;
+		}
+
+		// ボールの数より後ろのビットが立っていれば、再生で状態の配列の外に書いてしまう
+		const uint8_t* mask = data + offset + sizeof(RecordFrameHeader);
+		uint64_t bitCount = 0;
+		for (size_t word = 0; word < maskWords; ++word)
+		{
+			uint32_t bits = 0;
+			std::memcpy(&bits, mask + word * sizeof(uint32_t), sizeof(bits));
+			const size_t validBits = std::min<size_t>(kMaskBits, frameHeader.bodyCount - word * kMaskBits);
+			if (validBits < kMaskBits && (bits >> validBits) != 0)
+			{
+				return false;
+			}
+			bitCount += static_cast<uint64_t>(std::popcount(bits));
+		}
+		return maskWords == 0 || bitCount == frameHeader.writtenBodyCount;
+	}
+}
+
+SimRecorder::~SimRecorder()
+{
+	Close();
+}
+
+bool SimRecorder::Open(const char* path, float deltaTime, size_t ringCapacity, uint32_t keyframeInterval)
+{
+	Close();
+
+	file_ = OpenForWrite(path);
+	if (file_ == nullptr)
+	{
+		return false;
+	}
+
+	RecordFileHeader header{};
+	std::memcpy(header.magic, kRecordMagic, sizeof(header.magic));
+	header.version = kRecordVersion;
+	header.headerSize = sizeof(RecordFileHeader);
+	header.deltaTime = deltaTime;
+	std::fwrite(&header, sizeof(header), 1, file_);
+
+	// マスクで折り返せるように2のべき乗にする
+	size_t capacity = 1;
+	while (capacity < ringCapacity)
+	{
+		capacity <<= 1;
+	}
+	ring_.assign(capacity, 0);
+	ringMask_ = capacity - 1;
+	head_.store(0);
+	tail_.store(0);
+	stopRequested_.store(false);
+
+	frameOffsets_.clear();
+	frameOffsets_.reserve(size_t(1) << 16);
+	fileOffset_ = sizeof(RecordFileHeader);
+	stallCount_ = 0;
+
+	previousAwake_.clear();
+	recordedBodyCount_ = 0;
+	keyframeInterval_ = std::max<uint32_t>(keyframeInterval, 1);
+	framesSinceKeyframe_ = 0;
+	needsKeyframe_ = true;
+
+	flusher_ = std::thread(&SimRecorder::FlushLoop, this);
+	return true;
+}
+
+void SimRecorder::RecordStep(uint32_t stepIndex, const Ball* bodies, size_t bodyCount, const uint32_t* awakeBodies, size_t awakeCount,
+	const Contact* contacts, size_t contactCount)
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	// 最初、ボールの数が変わった時、フレームを落とした後、一定の間隔ごとは全て書く
+	// それ以外は今起きているボールと、直前のフレームで起きていたボール（眠ったステップの最後の状態を残すため）だけを書く
+	// 眠っているボールは動かないので、調べるのは起きているボールの番号だけ
+	// ほとんどが起きている時は、ビットを作る手間が全てを写す手間と変わらないので全て書く
+	const size_t maskWords = (bodyCount + kMaskBits - 1) / kMaskBits;
+	size_t writtenCount = bodyCount;
+	if (awakeBodies != nullptr && !needsKeyframe_ && bodyCount == recordedBodyCount_ && framesSinceKeyframe_ + 1 < keyframeInterval_ &&
+		previousAwake_.size() + awakeCount < bodyCount)
+	{
+		// どちらも昇順なので、重なりを除いた数は並べて数える
+		const uint32_t* previous = previousAwake_.data();
+		const size_t previousCount = previousAwake_.size();
+		size_t p = 0;
+		size_t c = 0;
+		writtenCount = 0;
+		while (p < previousCount && c < awakeCount)
+		{
+			const uint32_t previousIndex = previous[p];
+			const uint32_t awakeIndex = awakeBodies[c];
+			p += previousIndex <= awakeIndex ? 1 : 0;
+			c += awakeIndex <= previousIndex ? 1 : 0;
+			++writtenCount;
+		}
+		writtenCount += (previousCount - p) + (awakeCount - c);
+
+		writtenMask_.assign(maskWords, 0);
+		uint32_t* mask = writtenMask_.data();
+		for (size_t i = 0; i < previousCount; ++i)
+		{
+			mask[previous[i] / kMaskBits] |= 1u << (previous[i] % kMaskBits);
+		}
+		for (size_t i = 0; i < awakeCount; ++i)
+		{
+			assert(awakeBodies[i] < bodyCount);
+			mask[awakeBodies[i] / kMaskBits] |= 1u << (awakeBodies[i] % kMaskBits);
+		}
+	}
+	if (awakeBodies != nullptr)
+	{
+		previousAwake_.assign(awakeBodies, awakeBodies + awakeCount);
+	}
+	const bool isKeyframe = writtenCount == bodyCount;
+	const size_t maskBytes = isKeyframe ? 0 : maskWords * sizeof(uint32_t);
+
+	const size_t frameSize = sizeof(RecordFrameHeader) + maskBytes + sizeof(RecordedBody) * writtenCount + sizeof(RecordedContact) * contactCount;
+	// リングより大きいフレームは書けない（次のフレームは差分の元が無いのでキーフレームにする）
+	if (frameSize > ring_.size())
+	{
+		needsKeyframe_ = true;
+		return;
+	}
+
+	WaitForSpace(frameSize);
+
+	// 折り返さない時はリングへ直接組み立てる（コピーが1回で済む）、折り返す時だけ作業領域で組み立てて2回に分けて写す
+	const size_t start = static_cast<size_t>(head_.load(std::memory_order_relaxed)) & ringMask_;
+	const bool contiguous = start + frameSize <= ring_.size();
+	if (!contiguous && staging_.size() < frameSize)
+	{
+		// 作業領域はフレームサイズが最大を更新した時だけ伸びる
+		staging_.resize(frameSize);
+	}
+	uint8_t* cursor = contiguous ? ring_.data() + start : staging_.data();
+
+	RecordFrameHeader frameHeader{};
+	frameHeader.stepIndex = stepIndex;
+	frameHeader.bodyCount = static_cast<uint32_t>(bodyCount);
+	frameHeader.writtenBodyCount = static_cast<uint32_t>(writtenCount);
+	frameHeader.contactCount = static_cast<uint32_t>(contactCount);
+	frameHeader.byteSize = static_cast<uint32_t>(frameSize);
+	std::memcpy(cursor, &frameHeader, sizeof(frameHeader));
+	cursor += sizeof(frameHeader);
+
+	// ボールは先頭の位置と速度だけ、接触は配列ごと写す
+	if (isKeyframe)
+	{
+		for (size_t i = 0; i < bodyCount; ++i)
+		{
+			std::memcpy(cursor, &bodies[i], sizeof(RecordedBody));
+			cursor += sizeof(RecordedBody);
+		}
+	}
+	else
+	{
+		std::memcpy(cursor, writtenMask_.data(), maskBytes);
+		cursor += maskBytes;
+		for (size_t word = 0; word < maskWords; ++word)
+		{
+			for (uint32_t bits = writtenMask_[word]; bits != 0; bits &= bits - 1)
+			{
+				std::memcpy(cursor, &bodies[word * kMaskBits + static_cast<size_t>(std::countr_zero(bits))], sizeof(RecordedBody));
+				cursor += sizeof(RecordedBody);
+			}
+		}
+	}
+	if (contactCount > 0)
+	{
+		std::memcpy(cursor, contacts, sizeof(RecordedContact) * contactCount);
+	}
+
+	if (!contiguous)
+	{
+		const size_t firstPart = ring_.size() - start;
+		std::memcpy(ring_.data() + start, staging_.data(), firstPart);
+		std::memcpy(ring_.data(), staging_.data() + firstPart, frameSize - firstPart);
+	}
+	Publish(frameSize);
+
+	frameOffsets_.push_back(fileOffset_);
+	fileOffset_ += frameSize;
+
+	recordedBodyCount_ = bodyCount;
+	framesSinceKeyframe_ = isKeyframe ? 0 : framesSinceKeyframe_ + 1;
+	needsKeyframe_ = false;
+}
+
+void SimRecorder::WaitForSpace(size_t size)
+{
+	const uint64_t head = head_.load(std::memory_order_relaxed);
+
+	// 空きが足りない間は書き込みスレッドを起こして待つ
+	if (ring_.size() - static_cast<size_t>(head - tail_.load(std::memory_order_acquire)) < size)
+	{
+		++stallCount_;
+		do
+		{
+			wakeCondition_.notify_one();
+			std::this_thread::yield();
+		} while (ring_.size() - static_cast<size_t>(head - tail_.load(std::memory_order_acquire)) < size);
+	}
+}
+
+void SimRecorder::Publish(size_t size)
+{
+	const uint64_t head = head_.load(std::memory_order_relaxed);
+	head_.store(head + size, std::memory_order_release);
+
+	// 半分以上溜まったら書き込みスレッドを起こす（それ以外はタイムアウトで拾う）
+	if (head + size - tail_.load(std::memory_order_relaxed) >= ring_.size() / 2)
+	{
+		wakeCondition_.notify_one();
+	}
+}
+
+void SimRecorder::FlushLoop()
+{
+	for (;;)
+	{
+		const uint64_t tail = tail_.load(std::memory_order_relaxed);
+		const uint64_t head = head_.load(std::memory_order_acquire);
+
+		if (head == tail)
+		{
+			if (stopRequested_.load(std::memory_order_acquire))
+			{
+				break;
+			}
+			std::unique_lock<std::mutex> lock(wakeMutex_);
+			wakeCondition_.wait_for(lock, std::chrono::milliseconds(4));
+			continue;
+		}
+
+		// 連続している範囲ごとに書き出す
+		const size_t start = static_cast<size_t>(tail) & ringMask_;
+		const size_t available = static_cast<size_t>(head - tail);
+		const size_t firstPart = std::min(available, ring_.size() - start);
+		std::fwrite(ring_.data() + start, 1, firstPart, file_);
+		if (available > firstPart)
+		{
+			std::fwrite(ring_.data(), 1, available - firstPart, file_);
+		}
+
+		tail_.store(head, std::memory_order_release);
+	}
+}
+
+void SimRecorder::Close()
+{
+	if (file_ == nullptr)
+	{
+		return;
+	}
+
+	// 書き込みスレッドに残りを吐き出させて止める
+	stopRequested_.store(true, std::memory_order_release);
+	wakeCondition_.notify_one();
+	if (flusher_.joinable())
+	{
+		flusher_.join();
+	}
+
+	// 索引をuint64_tの境界に揃える
+	const uint64_t padding = (8 - (fileOffset_ & 7)) & 7;
+	const uint8_t zeros[8] = {};
+	std::fwrite(zeros, 1, static_cast<size_t>(padding), file_);
+
+	RecordFileFooter footer{};
+	footer.indexOffset = fileOffset_ + padding;
+	footer.frameCount = frameOffsets_.size();
+	std::memcpy(footer.magic, kIndexMagic, sizeof(footer.magic));
+	std::fwrite(frameOffsets_.data(), sizeof(uint64_t), frameOffsets_.size(), file_);
+	std::fwrite(&footer, sizeof(footer), 1, file_);
+
+	std::fclose(file_);
+	file_ = nullptr;
+	ring_.clear();
+	ring_.shrink_to_fit();
+}
+
+bool SimReplayer::Open(const char* path)
+{
+	Close();
+
+	if (!file_.Open(path))
+	{
+		return false;
+	}
+
+	const uint8_t* data = file_.GetData();
+	const size_t size = file_.GetSize();
+
+	RecordFileHeader header{};
+	if (size < sizeof(header))
+	{
+		Close();
+		return false;
+	}
+	std::memcpy(&header, data, sizeof(header));
+	if (std::memcmp(header.magic, kRecordMagic, sizeof(header.magic)) != 0 || header.version != kRecordVersion ||
+		header.headerSize < sizeof(header) || header.headerSize > size || header.headerSize % alignof(RecordFrameHeader) != 0)
+	{
+		Close();
+		return false;
+	}
+	deltaTime_ = header.deltaTime;
+
+	// フッターがあれば索引をそのまま使う
+	bool hasIndex = false;
+	if (size >= sizeof(header) + sizeof(RecordFileFooter))
+	{
+		RecordFileFooter footer{};
+		std::memcpy(&footer, data + size - sizeof(footer), sizeof(footer));
+		// 足し算が溢れないように、索引の長さはファイルの残りから逆算して比べる
+		const uint64_t indexBytes = size - sizeof(footer);
+		hasIndex = std::memcmp(footer.magic, kIndexMagic, sizeof(footer.magic)) == 0 &&
+			footer.indexOffset % sizeof(uint64_t) == 0 &&
+			footer.indexOffset >= header.headerSize && footer.indexOffset <= indexBytes &&
+			footer.frameCount == (indexBytes - footer.indexOffset) / sizeof(uint64_t) &&
+			(indexBytes - footer.indexOffset) % sizeof(uint64_t) == 0;
+		if (hasIndex)
+		{
+			// 索引の各位置がフレームを指しているか一度だけ調べ、GetFrameでは調べない
+			const uint64_t* offsets = reinterpret_cast<const uint64_t*>(data + footer.indexOffset);
+			for (uint64_t i = 0; i < footer.frameCount && hasIndex; ++i)
+			{
+				hasIndex = offsets[i] >= header.headerSize && offsets[i] < footer.indexOffset &&
+					IsValidFrame(data, static_cast<size_t>(footer.indexOffset), offsets[i]);
+			}
+		}
+		if (hasIndex)
+		{
+			frameOffsets_ = reinterpret_cast<const uint64_t*>(data + footer.indexOffset);
+			frameCount_ = static_cast<size_t>(footer.frameCount);
+		}
+	}
+
+	// 途中で終了したファイルや索引が壊れたファイルは、フレームを辿って索引を作る（壊れたフレームの手前まで）
+	if (!hasIndex)
+	{
+		rebuiltOffsets_.clear();
+		size_t offset = header.headerSize;
+		while (IsValidFrame(data, size, offset))
+		{
+			RecordFrameHeader frameHeader{};
+			std::memcpy(&frameHeader, data + offset, sizeof(frameHeader));
+			rebuiltOffsets_.push_back(offset);
+			offset += frameHeader.byteSize;
+		}
+		frameOffsets_ = rebuiltOffsets_.data();
+		frameCount_ = rebuiltOffsets_.size();
+	}
+
+	// 差分のフレームは直前と同じ数のボールにしか当てられないので、最初のフレームやボールの数が変わるフレームが
+	// キーフレームでなければ、そこから後は使わない
+	keyframes_.clear();
+	uint32_t bodyCount = 0;
+	for (size_t i = 0; i < frameCount_; ++i)
+	{
+		RecordFrameHeader frameHeader{};
+		std::memcpy(&frameHeader, data + frameOffsets_[i], sizeof(frameHeader));
+		const bool isKeyframe = frameHeader.writtenBodyCount == frameHeader.bodyCount;
+		if (!isKeyframe && (i == 0 || frameHeader.bodyCount != bodyCount))
+		{
+			frameCount_ = i;
+			break;
+		}
+		if (isKeyframe)
+		{
+			keyframes_.push_back(i);
+		}
+		bodyCount = frameHeader.bodyCount;
+	}
+	return true;
+}
+
+void SimReplayer::Close()
+{
+	file_.Close();
+	frameOffsets_ = nullptr;
+	rebuiltOffsets_.clear();
+	keyframes_.clear();
+	frameCount_ = 0;
+	deltaTime_ = 0.0f;
+	bodies_.clear();
+	currentFrame_ = SIZE_MAX;
+}
+
+RecordedFrameView SimReplayer::GetFrame(size_t frameIndex)
+{
+	assert(frameIndex < frameCount_);
+	if (frameIndex >= frameCount_)
+	{
+		return {};
+	}
+
+	// 手前のキーフレームから当てていく（直前に取り出したフレームがその間にあれば、その次から）
+	// 最初のフレームはキーフレームなので、手前のキーフレームは必ずある
+	size_t first = *(std::upper_bound(keyframes_.begin(), keyframes_.end(), frameIndex) - 1);
+	if (currentFrame_ != SIZE_MAX && currentFrame_ >= first && currentFrame_ <= frameIndex)
+	{
+		first = currentFrame_ + 1;
+	}
+	for (size_t i = first; i <= frameIndex; ++i)
+	{
+		ApplyFrame(i);
+	}
+	currentFrame_ = frameIndex;
+
+	// 各レコードは4バイト境界に並んでいて、Openで範囲も数も確かめてあるのでそのまま参照できる
+	const uint8_t* frame = file_.GetData() + frameOffsets_[frameIndex];
+	RecordedFrameView view{};
+	view.header = reinterpret_cast<const RecordFrameHeader*>(frame);
+	view.bodies = bodies_.data();
+	view.contacts = reinterpret_cast<const RecordedContact*>(frame + sizeof(RecordFrameHeader) +
+		GetMaskWordCount(*view.header) * sizeof(uint32_t) + sizeof(RecordedBody) * view.header->writtenBodyCount);
+	return view;
+}
+
+void SimReplayer::ApplyFrame(size_t frameIndex)
+{
+	const uint8_t* frame = file_.GetData() + frameOffsets_[frameIndex];
+	RecordFrameHeader frameHeader{};
+	std::memcpy(&frameHeader, frame, sizeof(frameHeader));
+	const uint8_t* cursor = frame + sizeof(RecordFrameHeader);
+
+	if (frameHeader.writtenBodyCount == frameHeader.bodyCount)
+	{
+		bodies_.resize(frameHeader.bodyCount);
+		std::memcpy(bodies_.data(), cursor, sizeof(RecordedBody) * frameHeader.bodyCount);
+		return;
+	}
+
+	// ボールの数はキーフレームと同じで、ビットの数と書いたボールの数が合うことはOpenで確かめてある
+	const size_t maskWords = GetMaskWordCount(frameHeader);
+	const uint8_t* written = cursor + maskWords * sizeof(uint32_t);
+	for (size_t word = 0; word < maskWords; ++word)
+	{
+		uint32_t bits = 0;
+		std::memcpy(&bits, cursor + word * sizeof(uint32_t), sizeof(bits));
+		for (; bits != 0; bits &= bits - 1)
+		{
+			std::memcpy(&bodies_[word * kMaskBits + static_cast<size_t>(std::countr_zero(bits))], written, sizeof(RecordedBody));
+			written += sizeof(RecordedBody);
+		}
+	}
+}
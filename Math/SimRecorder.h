@@ -0,0 +1,222 @@
+#pragma once
+#include "Ball.h"
+#include "Contact.h"
+#include "MappedFile.h"
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*----------記録ファイルのフォーマット----------*/
+// [RecordFileHeader]
+// [RecordFrameHeader][uint32_t writtenMask[]][RecordedBody * writtenBodyCount][RecordedContact * contactCount] ... フレームの数だけ追記
+// [uint64_t frameOffsets[frameCount]][RecordFileFooter]                                                     ... Close時に書き込む索引
+// 全てのボールを書いたフレームがキーフレームで、writtenMaskを持たない
+// それ以外のフレームは、書いたボールのビットを立てたwrittenMask（(bodyCount + 31) / 32個）の後に、書いたボールだけを番号順に並べる
+// 書かれていないボールは眠っていて動いていないので、再生時は前のフレームの状態をそのまま使う
+
+/// <summary>
+/// 記録ファイルのヘッダー
+/// </summary>
+struct RecordFileHeader final
+{
+	char magic[4];			// "MTRC"
+	uint32_t version;		// フォーマットのバージョン
+	uint32_t headerSize;	// ヘッダーのバイト数
+	float deltaTime;		// 1ステップの時間
+};
+
+/// <summary>
+/// 1ステップ分のヘッダー
+/// </summary>
+struct RecordFrameHeader final
+{
+	uint32_t stepIndex;			// ステップ番号
+	uint32_t bodyCount;			// ボールの数
+	uint32_t writtenBodyCount;	// このフレームに書いたボールの数（bodyCountと同じならキーフレーム）
+	uint32_t contactCount;		// 接触の数
+	uint32_t byteSize;		// このヘッダーを含むフレーム全体のバイト数
+};
+
+/// <summary>
+/// 記録されたボールの状態
+/// </summary>
+struct RecordedBody final
+{
+	float position[3];	// 位置
+	float velocity[3];	// 速度
+};
+
+/// <summary>
+/// 記録された接触
+/// </summary>
+struct RecordedContact final
+{
+	uint32_t bodyIndex;		// ボールの番号
+	uint32_t otherIndex;	// 接触相手の番号
+	uint32_t target;		// ContactTargetの値
+	float normal[3];		// 接触法線
+	float depth;			// めり込み量
+};
+
+/// <summary>
+/// 記録ファイルのフッター（索引の位置）
+/// </summary>
+struct RecordFileFooter final
+{
+	uint64_t indexOffset;	// 索引の先頭位置
+	uint64_t frameCount;	// フレームの数
+	char magic[4];			// "MTIX"
+	uint32_t reserved;		// 予約
+};
+
+/// <summary>
+/// シミュレーションを追記型のバイナリファイルに記録するクラス
+/// RecordStepはリングバッファへコピーするだけで、ファイルへの書き込みはバックグラウンドのスレッドが行う
+/// 眠っているボールは毎フレームは書かず、起きているボールと、一定の間隔で全てのボールを書くキーフレームだけを記録する
+/// </summary>
+class SimRecorder final
+{
+public:
+	SimRecorder() = default;
+	~SimRecorder();
+
+	SimRecorder(const SimRecorder&) = delete;
+	SimRecorder& operator=(const SimRecorder&) = delete;
+
+	/// <summary>
+	/// 記録を開始する
+	/// </summary>
+	/// <param name="path">出力ファイル</param>
+	/// <param name="deltaTime">1ステップの時間</param>
+	/// <param name="ringCapacity">リングバッファのバイト数（2のべき乗に切り上げる）</param>
+	/// <param name="keyframeInterval">全てのボールを書くフレームの間隔（再生で任意のフレームへ飛ぶ時に辿るフレームの数の上限）</param>
+	/// <returns>成功したらtrue</returns>
+	bool Open(const char* path, float deltaTime, size_t ringCapacity = size_t(4) << 20, uint32_t keyframeInterval = 300);
+	/// <summary>
+	/// 1ステップ分の状態を記録する
+	/// </summary>
+	/// <param name="stepIndex">ステップ番号</param>
+	/// <param name="bodies">ボールの配列</param>
+	/// <param name="bodyCount">ボールの数</param>
+	/// <param name="awakeBodies">このステップで動いたボールの番号（昇順、PhysicsWorld::GetAwakeBodies、nullptrなら全て書く）</param>
+	/// <param name="awakeCount">awakeBodiesの数</param>
+	/// <param name="contacts">接触の配列</param>
+	/// <param name="contactCount">接触の数</param>
+	void RecordStep(uint32_t stepIndex, const Ball* bodies, size_t bodyCount, const uint32_t* awakeBodies, size_t awakeCount,
+		const Contact* contacts, size_t contactCount);
+	/// <summary>
+	/// 残りを書き出して索引を付け、ファイルを閉じる
+	/// </summary>
+	void Close();
+
+	bool IsRecording() const { return file_ != nullptr; }
+	uint64_t GetFrameCount() const { return frameOffsets_.size(); }
+	/// <summary>
+	/// リングバッファが満杯で待たされた回数
+	/// </summary>
+	uint64_t GetStallCount() const { return stallCount_; }
+
+private:
+	/// <summary>
+	/// 書き込みスレッドの処理
+	/// </summary>
+	void FlushLoop();
+	/// <summary>
+	/// リングバッファにsizeバイトの空きができるまで待つ
+	/// </summary>
+	void WaitForSpace(size_t size);
+	/// <summary>
+	/// 書き込んだsizeバイトを書き込みスレッドに渡す
+	/// </summary>
+	void Publish(size_t size);
+
+	std::FILE* file_ = nullptr;
+
+	// リングバッファ（書き込み側と読み出し側が1つずつ）
+	std::vector<uint8_t> ring_;
+	size_t ringMask_ = 0;
+	std::atomic<uint64_t> head_{ 0 };	// 書き込んだ総バイト数
+	std::atomic<uint64_t> tail_{ 0 };	// ファイルへ書き出した総バイト数
+
+	std::thread flusher_;
+	std::mutex wakeMutex_;
+	std::condition_variable wakeCondition_;
+	std::atomic<bool> stopRequested_{ false };
+
+	std::vector<uint8_t> staging_;			// リングの末尾で折り返すフレームを組み立てる作業領域
+	std::vector<uint64_t> frameOffsets_;	// 各フレームのファイル上の位置
+	uint64_t fileOffset_ = 0;				// 次のフレームのファイル上の位置
+	uint64_t stallCount_ = 0;
+
+	// 差分の記録
+	std::vector<uint32_t> previousAwake_;	// 直前のフレームで起きていたボールの番号
+	std::vector<uint32_t> writtenMask_;		// このフレームで書くボールのビット（今と直前のどちらかで起きていた）
+	size_t recordedBodyCount_ = 0;			// 直前のフレームのボールの数
+	uint32_t keyframeInterval_ = 0;
+	uint32_t framesSinceKeyframe_ = 0;
+	bool needsKeyframe_ = true;				// 次のフレームを必ずキーフレームにするか（最初のフレームと、フレームを落とした後）
+};
+
+/// <summary>
+/// 再生用に取り出した1ステップ分の状態
+/// </summary>
+struct RecordedFrameView final
+{
+	const RecordFrameHeader* header;	// ヘッダー
+	const RecordedBody* bodies;			// 全てのボールの状態（書かれていないボールは前のフレームから引き継いだもの、次のGetFrameまで有効）
+	const RecordedContact* contacts;	// 接触の配列
+};
+
+/// <summary>
+/// 記録ファイルをメモリマップして任意のステップを取り出すクラス
+/// </summary>
+class SimReplayer final
+{
+public:
+	/// <summary>
+	/// 記録ファイルを開く
+	/// ヘッダーと索引の全てのフレームの位置、数、バイト数がファイルに収まるか、書いたボールのビットと数が合うかをここで確かめる
+	/// 最初のフレームとボールの数が変わるフレームはキーフレームでなければならず、そうでないフレームから後は使わない
+	/// フッターが無い（記録中に終了した）か索引が壊れている場合は、フレームを走査して壊れたフレームの手前まで索引を作り直す
+	/// </summary>
+	/// <param name="path">記録ファイル</param>
+	/// <returns>成功したらtrue</returns>
+	bool Open(const char* path);
+	/// <summary>
+	/// ファイルを閉じる
+	/// </summary>
+	void Close();
+
+	/// <summary>
+	/// 指定したフレームを取り出す
+	/// 直前に取り出したフレームの次なら差分を1つ当てるだけ、それ以外は手前のキーフレームから辿る
+	/// </summary>
+	/// <param name="frameIndex">フレーム番号</param>
+	/// <returns>範囲外なら全てnullptr</returns>
+	RecordedFrameView GetFrame(size_t frameIndex);
+
+	bool IsOpen() const { return file_.IsOpen(); }
+	size_t GetFrameCount() const { return frameCount_; }
+	float GetDeltaTime() const { return deltaTime_; }
+
+private:
+	/// <summary>
+	/// フレームの書かれたボールを今の状態に上書きする
+	/// </summary>
+	void ApplyFrame(size_t frameIndex);
+
+	MappedFile file_;
+	const uint64_t* frameOffsets_ = nullptr;	// ファイル内の索引
+	std::vector<uint64_t> rebuiltOffsets_;		// 索引が無い場合に作り直したもの
+	std::vector<size_t> keyframes_;				// キーフレームの番号（昇順）
+	size_t frameCount_ = 0;
+	float deltaTime_ = 0.0f;
+
+	std::vector<RecordedBody> bodies_;			// 最後に取り出したフレームの全てのボールの状態
+	size_t currentFrame_ = SIZE_MAX;			// bodies_がどのフレームの状態か（SIZE_MAXなら無し）
+};
@@ -0,0 +1,376 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <immintrin.h>
+
+// x64はSSE2が必ず使えるので、4レーンはSSEで実装する
+// 8レーンは/arch:AVX（-mavx）の時だけAVXを使い、それ以外はSSEを2本並べる
+#if defined(__AVX__)
+#define MT_SIMD_AVX 1
+#else
+#define MT_SIMD_AVX 0
+#endif
+
+/// <summary>
+/// 4レーンのfloat
+/// </summary>
+struct Float4 final
+{
+	static constexpr int kWidth = 4;
+	__m128 v;
+
+	static Float4 Zero() { return { _mm_setzero_ps() }; }
+	static Float4 Set1(float value) { return { _mm_set1_ps(value) }; }
+	static Float4 Load(const float* p) { return { _mm_loadu_ps(p) }; }
+	static Float4 LoadAligned(const float* p) { return { _mm_load_ps(p) }; }
+	void Store(float* p) const { _mm_storeu_ps(p, v); }
+	void StoreAligned(float* p) const { _mm_store_ps(p, v); }
+	/// <summary>
+	/// 比較結果のマスクを各レーン1ビットに詰める
+	/// </summary>
+	int MoveMask() const { return _mm_movemask_ps(v); }
+};
+
+inline Float4 operator+(Float4 a, Float4 b) { return { _mm_add_ps(a.v, b.v) }; }
+inline Float4 operator-(Float4 a, Float4 b) { return { _mm_sub_ps(a.v, b.v) }; }
+inline Float4 operator*(Float4 a, Float4 b) { return { _mm_mul_ps(a.v, b.v) }; }
+inline Float4 operator/(Float4 a, Float4 b) { return { _mm_div_ps(a.v, b.v) }; }
+inline Float4 operator-(Float4 a) { return { _mm_xor_ps(a.v, _mm_set1_ps(-0.0f)) }; }
+inline Float4 operator&(Float4 a, Float4 b) { return { _mm_and_ps(a.v, b.v) }; }
+inline Float4 operator|(Float4 a, Float4 b) { return { _mm_or_ps(a.v, b.v) }; }
+inline Float4 operator<(Float4 a, Float4 b) { return { _mm_cmplt_ps(a.v, b.v) }; }
+inline Float4 operator<=(Float4 a, Float4 b) { return { _mm_cmple_ps(a.v, b.v) }; }
+inline Float4 operator>(Float4 a, Float4 b) { return { _mm_cmpgt_ps(a.v, b.v) }; }
+inline Float4 operator>=(Float4 a, Float4 b) { return { _mm_cmpge_ps(a.v, b.v) }; }
+inline Float4 operator==(Float4 a, Float4 b) { return { _mm_cmpeq_ps(a.v, b.v) }; }
+inline Float4 operator!=(Float4 a, Float4 b) { return { _mm_cmpneq_ps(a.v, b.v) }; }
+/// <summary>
+/// NaNのレーンはbを返す（maxps/minpsの仕様）
+/// </summary>
+inline Float4 Min(Float4 a, Float4 b) { return { _mm_min_ps(a.v, b.v) }; }
+inline Float4 Max(Float4 a, Float4 b) { return { _mm_max_ps(a.v, b.v) }; }
+inline Float4 Sqrt(Float4 a) { return { _mm_sqrt_ps(a.v) }; }
+inline Float4 Abs(Float4 a) { return { _mm_andnot_ps(_mm_set1_ps(-0.0f), a.v) }; }
+/// <summary>
+/// マスクが立っているレーンはa、それ以外はb
+/// </summary>
+inline Float4 Select(Float4 mask, Float4 a, Float4 b) { return { _mm_or_ps(_mm_and_ps(mask.v, a.v), _mm_andnot_ps(mask.v, b.v)) }; }
+
+/// <summary>
+/// 4レーンのint32（マスクや番号の選択用）
+/// </summary>
+struct Int4 final
+{
+	__m128i v;
+
+	static Int4 Set1(int32_t value) { return { _mm_set1_epi32(value) }; }
+	static Int4 Load(const int32_t* p) { return { _mm_loadu_si128(reinterpret_cast<const __m128i*>(p)) }; }
+	void Store(int32_t* p) const { _mm_storeu_si128(reinterpret_cast<__m128i*>(p), v); }
+};
+
+inline Int4 Select(Float4 mask, Int4 a, Int4 b)
+{
+	__m128i m = _mm_castps_si128(mask.v);
+	return { _mm_or_si128(_mm_and_si128(m, a.v), _mm_andnot_si128(m, b.v)) };
+}
+/// <summary>
+/// 0方向に切り捨てて整数にする（0以上なら床関数と同じ）
+/// </summary>
+inline Int4 TruncateToInt(Float4 a) { return { _mm_cvttps_epi32(a.v) }; }
+inline Float4 ToFloat(Int4 a) { return { _mm_cvtepi32_ps(a.v) }; }
+
+#if MT_SIMD_AVX
+
+/// <summary>
+/// 8レーンのfloat（AVX）
+/// </summary>
+struct Float8 final
+{
+	static constexpr int kWidth = 8;
+	__m256 v;
+
+	static Float8 Zero() { return { _mm256_setzero_ps() }; }
+	static Float8 Set1(float value) { return { _mm256_set1_ps(value) }; }
+	static Float8 Load(const float* p) { return { _mm256_loadu_ps(p) }; }
+	static Float8 LoadAligned(const float* p) { return { _mm256_load_ps(p) }; }
+	void Store(float* p) const { _mm256_storeu_ps(p, v); }
+	void StoreAligned(float* p) const { _mm256_store_ps(p, v); }
+	int MoveMask() const { return _mm256_movemask_ps(v); }
+};
+
+inline Float8 operator+(Float8 a, Float8 b) { return { _mm256_add_ps(a.v, b.v) }; }
+inline Float8 operator-(Float8 a, Float8 b) { return { _mm256_sub_ps(a.v, b.v) }; }
+inline Float8 operator*(Float8 a, Float8 b) { return { _mm256_mul_ps(a.v, b.v) }; }
+inline Float8 operator/(Float8 a, Float8 b) { return { _mm256_div_ps(a.v, b.v) }; }
+inline Float8 operator-(Float8 a) { return { _mm256_xor_ps(a.v, _mm256_set1_ps(-0.0f)) }; }
+inline Float8 operator&(Float8 a, Float8 b) { return { _mm256_and_ps(a.v, b.v) }; }
+inline Float8 operator|(Float8 a, Float8 b) { return { _mm256_or_ps(a.v, b.v) }; }
+inline Float8 operator<(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LT_OQ) }; }
+inline Float8 operator<=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_LE_OQ) }; }
+inline Float8 operator>(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GT_OQ) }; }
+inline Float8 operator>=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_GE_OQ) }; }
+inline Float8 operator==(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_EQ_OQ) }; }
+inline Float8 operator!=(Float8 a, Float8 b) { return { _mm256_cmp_ps(a.v, b.v, _CMP_NEQ_UQ) }; }
+inline Float8 Min(Float8 a, Float8 b) { return { _mm256_min_ps(a.v, b.v) }; }
+inline Float8 Max(Float8 a, Float8 b) { return { _mm256_max_ps(a.v, b.v) }; }
+inline Float8 Sqrt(Float8 a) { return { _mm256_sqrt_ps(a.v) }; }
+inline Float8 Abs(Float8 a) { return { _mm256_andnot_ps(_mm256_set1_ps(-0.0f), a.v) }; }
+inline Float8 Select(Float8 mask, Float8 a, Float8 b) { return { _mm256_blendv_ps(b.v, a.v, mask.v) }; }
+/// <summary>
+/// 下位4レーンと上位4レーンを組み合わせる／取り出す
+/// </summary>
+inline Float8 Combine(Float4 lo, Float4 hi) { return { _mm256_insertf128_ps(_mm256_castps128_ps256(lo.v), hi.v, 1) }; }
+inline Float4 Low(Float8 a) { return { _mm256_castps256_ps128(a.v) }; }
+inline Float4 High(Float8 a) { return { _mm256_extractf128_ps(a.v, 1) }; }
+
+/// <summary>
+/// 8レーンのint32（AVXには整数演算が無いのでビット演算だけfloatで行う）
+/// </summary>
+struct Int8 final
+{
+	__m256i v;
+
+	static Int8 Set1(int32_t value) { return { _mm256_set1_epi32(value) }; }
+	static Int8 Load(const int32_t* p) { return { _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)) }; }
+	void Store(int32_t* p) const { _mm256_storeu_si256(reinterpret_cast<__m256i*>(p), v); }
+};
+
+inline Int8 Select(Float8 mask, Int8 a, Int8 b)
+{
+	return { _mm256_castps_si256(_mm256_blendv_ps(_mm256_castsi256_ps(b.v), _mm256_castsi256_ps(a.v), mask.v)) };
+}
+inline Int8 TruncateToInt(Float8 a) { return { _mm256_cvttps_epi32(a.v) }; }
+inline Float8 ToFloat(Int8 a) { return { _mm256_cvtepi32_ps(a.v) }; }
+
+#else
+
+/// <summary>
+/// 8レーンのfloat（AVXが無い場合はSSEを2本並べる）
+/// </summary>
+struct Float8 final
+{
+	static constexpr int kWidth = 8;
+	Float4 lo;
+	Float4 hi;
+
+	static Float8 Zero() { return { Float4::Zero(), Float4::Zero() }; }
+	static Float8 Set1(float value) { return { Float4::Set1(value), Float4::Set1(value) }; }
+	static Float8 Load(const float* p) { return { Float4::Load(p), Float4::Load(p + 4) }; }
+	static Float8 LoadAligned(const float* p) { return { Float4::LoadAligned(p), Float4::LoadAligned(p + 4) }; }
+	void Store(float* p) const { lo.Store(p); hi.Store(p + 4); }
+	void StoreAligned(float* p) const { lo.StoreAligned(p); hi.StoreAligned(p + 4); }
+	int MoveMask() const { return lo.MoveMask() | (hi.MoveMask() << 4); }
+};
+
+inline Float8 operator+(Float8 a, Float8 b) { return { a.lo + b.lo, a.hi + b.hi }; }
+inline Float8 operator-(Float8 a, Float8 b) { return { a.lo - b.lo, a.hi - b.hi }; }
+inline Float8 operator*(Float8 a, Float8 b) { return { a.lo * b.lo, a.hi * b.hi }; }
+inline Float8 operator/(Float8 a, Float8 b) { return { a.lo / b.lo, a.hi / b.hi }; }
+inline Float8 operator-(Float8 a) { return { -a.lo, -a.hi }; }
+inline Float8 operator&(Float8 a, Float8 b) { return { a.lo & b.lo, a.hi & b.hi }; }
+inline Float8 operator|(Float8 a, Float8 b) { return { a.lo | b.lo, a.hi | b.hi }; }
+inline Float8 operator<(Float8 a, Float8 b) { return { a.lo < b.lo, a.hi < b.hi }; }
+inline Float8 operator<=(Float8 a, Float8 b) { return { a.lo <= b.lo, a.hi <= b.hi }; }
+inline Float8 operator>(Float8 a, Float8 b) { return { a.lo > b.lo, a.hi > b.hi }; }
+inline Float8 operator>=(Float8 a, Float8 b) { return { a.lo >= b.lo, a.hi >= b.hi }; }
+inline Float8 operator==(Float8 a, Float8 b) { return { a.lo == b.lo, a.hi == b.hi }; }
+inline Float8 operator!=(Float8 a, Float8 b) { return { a.lo != b.lo, a.hi != b.hi }; }
+inline Float8 Min(Float8 a, Float8 b) { return { Min(a.lo, b.lo), Min(a.hi, b.hi) }; }
+inline Float8 Max(Float8 a, Float8 b) { return { Max(a.lo, b.lo), Max(a.hi, b.hi) }; }
+inline Float8 Sqrt(Float8 a) { return { Sqrt(a.lo), Sqrt(a.hi) }; }
+inline Float8 Abs(Float8 a) { return { Abs(a.lo), Abs(a.hi) }; }
+inline Float8 Select(Float8 mask, Float8 a, Float8 b) { return { Select(mask.lo, a.lo, b.lo), Select(mask.hi, a.hi, b.hi) }; }
+inline Float8 Combine(Float4 lo, Float4 hi) { return { lo, hi }; }
+inline Float4 Low(Float8 a) { return a.lo; }
+inline Float4 High(Float8 a) { return a.hi; }
+
+struct Int8 final
+{
+	Int4 lo;
+	Int4 hi;
+
+	static Int8 Set1(int32_t value) { return { Int4::Set1(value), Int4::Set1(value) }; }
+	static Int8 Load(const int32_t* p) { return { Int4::Load(p), Int4::Load(p + 4) }; }
+	void Store(int32_t* p) const { lo.Store(p); hi.Store(p + 4); }
+};
+
+inline Int8 Select(Float8 mask, Int8 a, Int8 b) { return { Select(mask.lo, a.lo, b.lo), Select(mask.hi, a.hi, b.hi) }; }
+inline Int8 TruncateToInt(Float8 a) { return { TruncateToInt(a.lo), TruncateToInt(a.hi) }; }
+inline Float8 ToFloat(Int8 a) { return { ToFloat(a.lo), ToFloat(a.hi) }; }
+
+#endif
+
+/*----------16ビットの値との変換（詰めて保存したデータ用）----------*/
+
+// F16Cの半精度変換はAVXと同じ世代から使える（MSVCは/arch:AVXで有効、GCCとClangは-mf16cが必要）
+#if defined(__F16C__) || (defined(_MSC_VER) && defined(__AVX__))
+#define MT_SIMD_F16C 1
+#else
+#define MT_SIMD_F16C 0
+#endif
+
+/// <summary>
+/// 半精度浮動小数点をfloatにする（非正規化数、無限大、NaNもそのまま移す）
+/// </summary>
+inline float HalfToFloat(uint16_t half)
+{
+#if MT_SIMD_F16C
+	return _mm_cvtss_f32(_mm_cvtph_ps(_mm_cvtsi32_si128(half)));
+#else
+	constexpr uint32_t kShiftedExponent = 0x7C00u << 13;
+	uint32_t bits = (half & 0x7FFFu) << 13;
+	const uint32_t exponent = bits & kShiftedExponent;
+	bits += (127u - 15u) << 23;
+	if (exponent == kShiftedExponent)
+	{
+		bits += (128u - 16u) << 23;	// 無限大とNaN
+	}
+	else if (exponent == 0)
+	{
+		// 非正規化数は指数を1つ足してから暗黙の1の分を引く
+		bits += 1u << 23;
+		bits = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) - std::bit_cast<float>(113u << 23));
+	}
+	return std::bit_cast<float>(bits | (static_cast<uint32_t>(half & 0x8000u) << 16));
+#endif
+}
+
+/// <summary>
+/// floatを半精度浮動小数点にする（最も近い値に丸め、範囲外は無限大）
+/// </summary>
+inline uint16_t FloatToHalf(float value)
+{
+#if MT_SIMD_F16C
+	return static_cast<uint16_t>(_mm_cvtsi128_si32(_mm_cvtps_ph(_mm_set_ss(value), _MM_FROUND_TO_NEAREST_INT)));
+#else
+	uint32_t bits = std::bit_cast<uint32_t>(value);
+	const uint32_t sign = (bits >> 16) & 0x8000u;
+	bits &= 0x7FFFFFFFu;
+	uint32_t half;
+	if (bits >= (127u + 16u) << 23)
+	{
+		half = bits > (255u << 23) ? 0x7E00u : 0x7C00u;
+	}
+	else if (bits < (113u << 23))
+	{
+		// 非正規化数になる範囲は、仮数の位置が揃う大きさを足して足し算に丸めさせる
+		const uint32_t magic = ((127u - 15u) + (23u - 10u) + 1u) << 23;
+		half = std::bit_cast<uint32_t>(std::bit_cast<float>(bits) + std::bit_cast<float>(magic)) - magic;
+	}
+	else
+	{
+		// 切り捨てる13ビットに0.5未満を足し、残る最下位ビットが奇数なら1足して偶数丸めにする
+		const uint32_t odd = (bits >> 13) & 1u;
+		bits += ((15u - 127u) << 23) + 0xFFFu + odd;
+		half = bits >> 13;
+	}
+	return static_cast<uint16_t>(half | sign);
+#endif
+}
+
+/// <summary>
+/// 各レーンの下位16ビットの半精度浮動小数点をfloatにする（F16Cが無い時にSSE2で同じ結果を出す）
+/// </summary>
+inline Float4 HalfToFloat(Int4 halves)
+{
+	const __m128i exponentMantissa = _mm_and_si128(halves.v, _mm_set1_epi32(0x7FFF));
+	const __m128i sign = _mm_slli_epi32(_mm_xor_si128(halves.v, exponentMantissa), 16);
+	// 指数と仮数をfloatの位置にずらして2^112を掛けると、指数の差と非正規化数がまとめて直る
+	const __m128 scaled = _mm_mul_ps(_mm_castsi128_ps(_mm_slli_epi32(exponentMantissa, 13)), _mm_castsi128_ps(_mm_set1_epi32((254 - 15) << 23)));
+	// 無限大とNaNは指数を全て1にする
+	const __m128i isInfNan = _mm_cmpgt_epi32(exponentMantissa, _mm_set1_epi32(0x7BFF));
+	const __m128i infNanExponent = _mm_and_si128(isInfNan, _mm_set1_epi32(255 << 23));
+	return { _mm_or_ps(scaled, _mm_castsi128_ps(_mm_or_si128(sign, infNanExponent))) };
+}
+
+/// <summary>
+/// floatを最も近い半精度浮動小数点にし、符号拡張したint32で返す（そのまま_mm_packs_epi32で詰められる）
+/// </summary>
+inline Int4 FloatToHalf(Float4 value)
+{
+	const __m128 signMask = _mm_castsi128_ps(_mm_set1_epi32(static_cast<int32_t>(0x80000000u)));
+	const __m128 justSign = _mm_and_ps(signMask, value.v);
+	const __m128 absolute = _mm_xor_ps(value.v, justSign);
+	const __m128i bits = _mm_castps_si128(absolute);
+
+	// 範囲外は無限大、NaNは静かなNaN
+	const __m128i isNan = _mm_castps_si128(_mm_cmpunord_ps(absolute, absolute));
+	const __m128i isRegular = _mm_cmpgt_epi32(_mm_set1_epi32((127 + 16) << 23), bits);
+	const __m128i infNan = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7C00));
+
+	// 非正規化数になる範囲は、仮数の位置が揃う大きさを足して足し算に丸めさせる
+	const __m128i subnormalMagic = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+	const __m128i isSubnormal = _mm_cmpgt_epi32(_mm_set1_epi32((127 - 14) << 23), bits);
+	const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absolute, _mm_castsi128_ps(subnormalMagic))), subnormalMagic);
+
+	// 正規化数は切り捨てる13ビットに0.5未満を足し、残る最下位ビットが奇数なら1足して偶数丸めにする
+	const __m128i odd = _mm_srai_epi32(_mm_slli_epi32(bits, 31 - 13), 31);
+	const __m128i rounded = _mm_sub_epi32(_mm_add_epi32(bits, _mm_set1_epi32(0xFFF - ((127 - 15) << 23))), odd);
+	const __m128i normal = _mm_srli_epi32(rounded, 13);
+
+	const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+	const __m128i joined = _mm_or_si128(_mm_and_si128(isRegular, finite), _mm_andnot_si128(isRegular, infNan));
+	return { _mm_or_si128(joined, _mm_srai_epi32(_mm_castps_si128(justSign), 16)) };
+}
+
+/// <summary>
+/// 16ビット符号なし整数8個を0〜65535のfloatにする
+/// </summary>
+inline Float8 LoadUint16(const uint16_t* p)
+{
+	const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+	const __m128i zero = _mm_setzero_si128();
+	return Combine({ _mm_cvtepi32_ps(_mm_unpacklo_epi16(raw, zero)) }, { _mm_cvtepi32_ps(_mm_unpackhi_epi16(raw, zero)) });
+}
+
+/// <summary>
+/// 最も近い整数に丸め、0〜65535に収めて8個書き込む（NaNは0）
+/// </summary>
+inline void StoreUint16(Float8 value, uint16_t* p)
+{
+	const Float8 clamped = Min(Max(value, Float8::Zero()), Float8::Set1(65535.0f));
+	// SSE2には符号なしの飽和パックが無いので、32768ずらして符号付きでパックしてから最上位ビットを戻す
+	const __m128i bias = _mm_set1_epi32(32768);
+	const __m128i lo = _mm_sub_epi32(_mm_cvtps_epi32(Low(clamped).v), bias);
+	const __m128i hi = _mm_sub_epi32(_mm_cvtps_epi32(High(clamped).v), bias);
+	const __m128i packed = _mm_xor_si128(_mm_packs_epi32(lo, hi), _mm_set1_epi16(static_cast<int16_t>(-32768)));
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), packed);
+}
+
+/// <summary>
+/// 半精度浮動小数点8個をfloatにする
+/// </summary>
+inline Float8 LoadHalf(const uint16_t* p)
+{
+	const __m128i raw = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+#if MT_SIMD_F16C && MT_SIMD_AVX
+	return { _mm256_cvtph_ps(raw) };
+#elif MT_SIMD_F16C
+	return { { _mm_cvtph_ps(raw) }, { _mm_cvtph_ps(_mm_unpackhi_epi64(raw, raw)) } };
+#else
+	const __m128i zero = _mm_setzero_si128();
+	return Combine(HalfToFloat(Int4{ _mm_unpacklo_epi16(raw, zero) }), HalfToFloat(Int4{ _mm_unpackhi_epi16(raw, zero) }));
+#endif
+}
+
+/// <summary>
+/// 最も近い半精度浮動小数点に丸めて8個書き込む
+/// </summary>
+inline void StoreHalf(Float8 value, uint16_t* p)
+{
+#if MT_SIMD_F16C && MT_SIMD_AVX
+	const __m128i packed = _mm256_cvtps_ph(value.v, _MM_FROUND_TO_NEAREST_INT);
+#elif MT_SIMD_F16C
+	const __m128i packed = _mm_unpacklo_epi64(_mm_cvtps_ph(value.lo.v, _MM_FROUND_TO_NEAREST_INT), _mm_cvtps_ph(value.hi.v, _MM_FROUND_TO_NEAREST_INT));
+#else
+	const __m128i packed = _mm_packs_epi32(FloatToHalf(Low(value)).v, FloatToHalf(High(value)).v);
+#endif
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(p), packed);
+}
+
+/// <summary>
+/// レーン数からSIMD型を選ぶ
+/// </summary>
+template<int N> struct SimdTraits;
+template<> struct SimdTraits<4> { using Float = Float4; using Int = Int4; };
+template<> struct SimdTraits<8> { using Float = Float8; using Int = Int8; };
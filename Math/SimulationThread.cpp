@@ -0,0 +1,166 @@
+#include "SimulationThread.h"
+#include "Profiler.h"
+#include <chrono>
+#include <utility>
+
+SimCommand SimCommand::MakeResetBody(uint32_t index, const Vector3ex& position, const Vector3ex& velocity)
+{
+	SimCommand command;
+	command.type = SimCommandType::ResetBody;
+	command.index = index;
+	command.position = position;
+	command.velocity = velocity;
+	return command;
+}
+
+SimCommand SimCommand::MakeSetPlane(uint32_t index, const Plane& plane)
+{
+	SimCommand command;
+	command.type = SimCommandType::SetPlane;
+	command.index = index;
+	command.plane = plane;
+	return command;
+}
+
+SimCommand SimCommand::MakeSetHeightfield(const Heightfield* heightfield)
+{
+	SimCommand command;
+	command.type = SimCommandType::SetHeightfield;
+	command.heightfield = heightfield;
+	return command;
+}
+
+SimCommand SimCommand::MakeSetIntegrator(IntegratorType integrator)
+{
+	SimCommand command;
+	command.type = SimCommandType::SetIntegrator;
+	command.integrator = integrator;
+	return command;
+}
+
+SimulationThread::SimulationThread(PhysicsWorld world)
+	: world_(std::move(world))
+{
+	// 最初のWaitの前でも描画できるように、初期状態を両面に入れておく
+	for (SimSnapshot& snapshot : snapshots_)
+	{
+		snapshot.bodies.assign(world_.GetBodies(), world_.GetBodies() + world_.GetBodyCount());
+		snapshot.awakeBodies.assign(world_.GetAwakeBodies().begin(), world_.GetAwakeBodies().end());
+		snapshot.awakeCount = world_.GetAwakeCount();
+	}
+	worker_ = std::thread(&SimulationThread::WorkerLoop, this);
+}
+
+SimulationThread::~SimulationThread()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopRequested_ = true;
+	}
+	kickCondition_.notify_one();
+	if (worker_.joinable())
+	{
+		worker_.join();
+	}
+}
+
+void SimulationThread::Kick(float deltaTime)
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		pendingDeltaTime_ = deltaTime;
+		++kickedCount_;
+	}
+	kickCondition_.notify_one();
+}
+
+void SimulationThread::Wait()
+{
+	PROFILE_SCOPE("SimulationWait");
+	const auto start = std::chrono::steady_clock::now();
+	uint64_t completed = 0;
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		doneCondition_.wait(lock, [this] { return completedCount_ == kickedCount_; });
+		completed = completedCount_;
+	}
+	lastWaitMs_ = std::chrono::duration<float, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	// n回目のKickの結果はn & 1の面に書かれている（一度もKickしていなければ初期状態のまま）
+	frontIndex_ = static_cast<size_t>(completed & 1);
+}
+
+void SimulationThread::WorkerLoop()
+{
+	uint64_t frameIndex = 0;
+	for (;;)
+	{
+		float deltaTime = 0.0f;
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			kickCondition_.wait(lock, [this] { return stopRequested_ || kickedCount_ != completedCount_; });
+			if (stopRequested_)
+			{
+				return;
+			}
+			deltaTime = pendingDeltaTime_;
+			frameIndex = kickedCount_;
+		}
+
+		{
+			PROFILE_SCOPE("Physics");
+
+			ApplyCommands();
+			if (deltaTime > 0.0f)
+			{
+				world_.Step(deltaTime);
+			}
+
+			// 描画側が読んでいない方の面に書く（容量は使い回す）
+			SimSnapshot& snapshot = snapshots_[frameIndex & 1];
+			snapshot.frameIndex = frameIndex;
+			snapshot.stepped = deltaTime > 0.0f;
+			snapshot.bodies.assign(world_.GetBodies(), world_.GetBodies() + world_.GetBodyCount());
+			snapshot.awakeBodies.assign(world_.GetAwakeBodies().begin(), world_.GetAwakeBodies().end());
+			const std::vector<Contact>& contacts = world_.GetContacts();
+			if (snapshot.stepped)
+			{
+				snapshot.contacts.assign(contacts.begin(), contacts.end());
+			}
+			else
+			{
+				snapshot.contacts.clear();
+			}
+			snapshot.awakeCount = world_.GetAwakeCount();
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			completedCount_ = frameIndex;
+		}
+		doneCondition_.notify_one();
+	}
+}
+
+void SimulationThread::ApplyCommands()
+{
+	SimCommand command;
+	while (commands_.TryPop(command))
+	{
+		switch (command.type)
+		{
+		case SimCommandType::ResetBody:
+			world_.ResetBody(command.index, command.position, command.velocity);
+			break;
+		case SimCommandType::SetPlane:
+			world_.SetPlane(command.index, command.plane);
+			break;
+		case SimCommandType::SetHeightfield:
+			world_.SetHeightfield(command.heightfield);
+			break;
+		case SimCommandType::SetIntegrator:
+			world_.integrator = command.integrator;
+			break;
+		}
+	}
+}
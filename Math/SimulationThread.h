@@ -0,0 +1,122 @@
+#pragma once
+#include "PhysicsWorld.h"
+#include "SpscQueue.h"
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// <summary>
+/// UIからシミュレーションへ送る命令の種類
+/// </summary>
+enum class SimCommandType : uint32_t
+{
+	ResetBody,		// ボールの位置と速度を設定する
+	SetPlane,		// 平面を変更する
+	SetHeightfield,	// 地形を差し替える
+	SetIntegrator,	// 積分法を変える
+};
+
+/// <summary>
+/// UIからシミュレーションへ送る命令（使う項目は種類ごとに異なる）
+/// </summary>
+struct SimCommand final
+{
+	SimCommandType type = SimCommandType::ResetBody;
+	uint32_t index = 0;						// ボールまたは平面の番号
+	Vector3ex position;						// ResetBody: 位置
+	Vector3ex velocity;						// ResetBody: 速度
+	Plane plane{};							// SetPlane: 平面
+	const Heightfield* heightfield = nullptr;	// SetHeightfield: 地形（nullptrで外す）
+	IntegratorType integrator = IntegratorType::SemiImplicitEuler;	// SetIntegrator: 積分法
+
+	static SimCommand MakeResetBody(uint32_t index, const Vector3ex& position, const Vector3ex& velocity);
+	static SimCommand MakeSetPlane(uint32_t index, const Plane& plane);
+	static SimCommand MakeSetHeightfield(const Heightfield* heightfield);
+	static SimCommand MakeSetIntegrator(IntegratorType integrator);
+};
+
+/// <summary>
+/// 描画に使うシミュレーションの状態（1ステップ分）
+/// </summary>
+struct SimSnapshot final
+{
+	uint64_t frameIndex = 0;		// 何回目のKickの結果か
+	bool stepped = false;			// このKickでステップを進めたか
+	std::vector<Ball> bodies;		// ボール
+	std::vector<Contact> contacts;	// このステップで見つかった接触
+	std::vector<uint32_t> awakeBodies;	// 起きているボールの番号（記録で眠っているボールを省くため）
+	size_t awakeCount = 0;			// 起きているボールの数
+};
+
+/// <summary>
+/// 物理シミュレーションを別スレッドで進めるクラス
+/// メインスレッドがフレームNを描画している間に、ワーカーがフレームN+1のステップを進める
+/// 状態は2面のスナップショットで受け渡し、UIの操作はロックしないキューで送る
+/// </summary>
+class SimulationThread final
+{
+public:
+	static constexpr size_t kCommandCapacity = 256;	// 1フレームに送れる命令の数
+
+	/// <summary>
+	/// ワールドを受け取ってワーカーを起動する（以降はワールドに直接触れないこと）
+	/// </summary>
+	explicit SimulationThread(PhysicsWorld world);
+	~SimulationThread();
+
+	SimulationThread(const SimulationThread&) = delete;
+	SimulationThread& operator=(const SimulationThread&) = delete;
+
+	/// <summary>
+	/// 命令を送る（次のKickでステップの前に適用される）
+	/// </summary>
+	/// <returns>キューが満杯ならfalse</returns>
+	bool Push(const SimCommand& command) { return commands_.TryPush(command); }
+
+	/// <summary>
+	/// 次のステップを始めさせてすぐ戻る（前のKickはWaitで待っておくこと）
+	/// </summary>
+	/// <param name="deltaTime">進める時間（0なら命令の適用だけ行う）</param>
+	void Kick(float deltaTime);
+	/// <summary>
+	/// 直前のKickが終わるのを待ち、その結果を描画側のスナップショットにする
+	/// </summary>
+	void Wait();
+
+	/// <summary>
+	/// 描画側のスナップショット（次のWaitまで書き換わらない）
+	/// </summary>
+	const SimSnapshot& GetSnapshot() const { return snapshots_[frontIndex_]; }
+	/// <summary>
+	/// 直前のWaitで待たされた時間（ミリ秒、描画がシミュレーションより速いと増える）
+	/// </summary>
+	float GetLastWaitMs() const { return lastWaitMs_; }
+
+private:
+	/// <summary>
+	/// ワーカースレッドの処理
+	/// </summary>
+	void WorkerLoop();
+	/// <summary>
+	/// キューの命令をワールドに適用する
+	/// </summary>
+	void ApplyCommands();
+
+	PhysicsWorld world_;	// ワーカーだけが触る
+	SpscQueue<SimCommand, kCommandCapacity> commands_;
+	SimSnapshot snapshots_[2];
+	size_t frontIndex_ = 0;		// 描画側が読んでいる面
+
+	std::thread worker_;
+	std::mutex mutex_;
+	std::condition_variable kickCondition_;
+	std::condition_variable doneCondition_;
+	uint64_t kickedCount_ = 0;		// Kickした回数
+	uint64_t completedCount_ = 0;	// ワーカーが終えた回数
+	float pendingDeltaTime_ = 0.0f;
+	bool stopRequested_ = false;
+	float lastWaitMs_ = 0.0f;
+};
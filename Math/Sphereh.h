@@ -1,9 +1,25 @@
 #pragma once
 #include "Vector3ex.h"
+#include <cmath>
 
 //球
 struct Sphere final
 {
 	Vector3ex center;	//!<中心点
 	float radius;	//!<半径
-};
\ No newline at end of file
+
+	/// <summary>
+	/// サポート写像（direction方向に最も遠い表面上の点）
+	/// </summary>
+	/// <param name="direction">方向（正規化は不要）</param>
+	/// <returns></returns>
+	Vector3ex Support(const Vector3ex& direction) const
+	{
+		float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+		if (length == 0.0f)
+		{
+			return center;
+		}
+		return center + direction * (radius / length);
+	}
+};
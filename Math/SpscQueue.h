@@ -0,0 +1,68 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// <summary>
+/// 書き込み側と読み出し側が1スレッドずつのロックしない固定長キュー
+/// </summary>
+/// <typeparam name="T">要素（コピーできる型）</typeparam>
+/// <typeparam name="Capacity">容量（2のべき乗）</typeparam>
+template<class T, size_t Capacity>
+class SpscQueue final
+{
+	static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0, "Capacityは2のべき乗にすること");
+
+public:
+	SpscQueue() = default;
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue& operator=(const SpscQueue&) = delete;
+
+	/// <summary>
+	/// 末尾に積む（書き込み側のスレッドだけが呼ぶ）
+	/// </summary>
+	/// <returns>満杯ならfalse</returns>
+	bool TryPush(const T& value)
+	{
+		const uint64_t head = head_.load(std::memory_order_relaxed);
+		if (head - tail_.load(std::memory_order_acquire) >= Capacity)
+		{
+			return false;
+		}
+		items_[head & (Capacity - 1)] = value;
+		head_.store(head + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// 先頭を取り出す（読み出し側のスレッドだけが呼ぶ）
+	/// </summary>
+	/// <returns>空ならfalse</returns>
+	bool TryPop(T& value)
+	{
+		const uint64_t tail = tail_.load(std::memory_order_relaxed);
+		if (tail == head_.load(std::memory_order_acquire))
+		{
+			return false;
+		}
+		value = items_[tail & (Capacity - 1)];
+		tail_.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/// <summary>
+	/// 積まれている数（もう一方のスレッドが動いている間は目安）
+	/// </summary>
+	size_t GetSize() const
+	{
+		// 先に読み出し側を読めば、後から読んだheadを追い越すことはない
+		const uint64_t tail = tail_.load(std::memory_order_acquire);
+		return static_cast<size_t>(head_.load(std::memory_order_acquire) - tail);
+	}
+
+private:
+	T items_[Capacity]{};
+	std::atomic<uint64_t> head_{ 0 };	// 積んだ総数
+	std::atomic<uint64_t> tail_{ 0 };	// 取り出した総数
+};
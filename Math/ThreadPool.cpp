@@ -0,0 +1,102 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(uint32_t threadCount)
+{
+	if (threadCount == 0)
+	{
+		threadCount = std::max(1u, std::thread::hardware_concurrency());
+	}
+	workers_.reserve(threadCount - 1);
+	for (uint32_t i = 1; i < threadCount; ++i)
+	{
+		workers_.emplace_back(&ThreadPool::WorkerLoop, this, static_cast<size_t>(i));
+	}
+}
+
+ThreadPool::~ThreadPool()
+{
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		stopRequested_ = true;
+	}
+	startCondition_.notify_all();
+	for (std::thread& worker : workers_)
+	{
+		worker.join();
+	}
+}
+
+void ThreadPool::Run(size_t count, size_t minBatch, Function function, void* context)
+{
+	if (count == 0)
+	{
+		return;
+	}
+
+	// 区間の数はスレッドの数までで、1つの区間がminBatch未満にならないようにする
+	minBatch = std::max<size_t>(minBatch, 1);
+	const size_t sliceCount = std::min<size_t>(GetThreadCount(), (count + minBatch - 1) / minBatch);
+	if (sliceCount <= 1)
+	{
+		function(context, 0, count);
+		return;
+	}
+
+	{
+		std::lock_guard<std::mutex> lock(mutex_);
+		function_ = function;
+		context_ = context;
+		count_ = count;
+		sliceCount_ = sliceCount;
+		pendingCount_ = workers_.size();
+		++generation_;
+	}
+	startCondition_.notify_all();
+
+	RunSlice(0);
+
+	std::unique_lock<std::mutex> lock(mutex_);
+	doneCondition_.wait(lock, [this] { return pendingCount_ == 0; });
+}
+
+void ThreadPool::WorkerLoop(size_t slice)
+{
+	uint64_t seenGeneration = 0;
+	for (;;)
+	{
+		{
+			std::unique_lock<std::mutex> lock(mutex_);
+			startCondition_.wait(lock, [&] { return stopRequested_ || generation_ != seenGeneration; });
+			if (stopRequested_)
+			{
+				return;
+			}
+			seenGeneration = generation_;
+		}
+
+		// 区間の数がスレッドより少ない時は、受け持つ区間の無いワーカーは終わったことだけ伝える
+		RunSlice(slice);
+
+		bool isLast = false;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			isLast = --pendingCount_ == 0;
+		}
+		if (isLast)
+		{
+			doneCondition_.notify_one();
+		}
+	}
+}
+
+void ThreadPool::RunSlice(size_t slice) const
+{
+	if (slice >= sliceCount_)
+	{
+		return;
+	}
+	const size_t begin = count_ * slice / sliceCount_;
+	const size_t end = count_ * (slice + 1) / sliceCount_;
+	function_(context_, begin, end);
+}
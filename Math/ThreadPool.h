@@ -0,0 +1,77 @@
+#pragma once
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+/// <summary>
+/// 同じ処理を範囲で分け合って実行する常駐スレッドの集まり
+/// ParallelForのたびにスレッドを作らないので、1フレームに何十回も呼ぶ処理（拘束の色ごとの解決など）に使う
+/// 範囲は呼び出し元を含むスレッドの数で等分し、各スレッドが連続した区間を1つずつ受け持つ
+/// </summary>
+class ThreadPool final
+{
+public:
+	/// <summary>
+	/// スレッドを起動する
+	/// </summary>
+	/// <param name="threadCount">呼び出し元を含むスレッドの数（0ならハードウェアのスレッド数）</param>
+	explicit ThreadPool(uint32_t threadCount = 0);
+	~ThreadPool();
+
+	ThreadPool(const ThreadPool&) = delete;
+	ThreadPool& operator=(const ThreadPool&) = delete;
+
+	/// <summary>
+	/// 呼び出し元を含むスレッドの数
+	/// </summary>
+	uint32_t GetThreadCount() const { return static_cast<uint32_t>(workers_.size()) + 1; }
+
+	/// <summary>
+	/// 0からcount-1までを区間に分けてbody(begin, end)を並列に呼び、全て終わるまで待つ
+	/// </summary>
+	/// <param name="count">数</param>
+	/// <param name="minBatch">1つの区間の最小の大きさ（小さい範囲は分けずに呼び出し元だけで実行する）</param>
+	/// <param name="body">区間の処理</param>
+	template<class Body>
+	void ParallelFor(size_t count, size_t minBatch, Body&& body)
+	{
+		using BodyType = std::remove_reference_t<Body>;
+		auto invoke = [](void* context, size_t begin, size_t end) { (*static_cast<BodyType*>(context))(begin, end); };
+		Run(count, minBatch, invoke, const_cast<void*>(static_cast<const void*>(&body)));
+	}
+
+private:
+	using Function = void (*)(void* context, size_t begin, size_t end);
+
+	/// <summary>
+	/// 区間に分けて実行する（ParallelForの実体）
+	/// </summary>
+	void Run(size_t count, size_t minBatch, Function function, void* context);
+	/// <summary>
+	/// ワーカースレッドの処理
+	/// </summary>
+	/// <param name="slice">受け持つ区間の番号（呼び出し元が0）</param>
+	void WorkerLoop(size_t slice);
+	/// <summary>
+	/// slice番目の区間を実行する
+	/// </summary>
+	void RunSlice(size_t slice) const;
+
+	std::vector<std::thread> workers_;
+	std::mutex mutex_;
+	std::condition_variable startCondition_;
+	std::condition_variable doneCondition_;
+	uint64_t generation_ = 0;		// 仕事を渡した回数（ワーカーはこれが変わったら起きる）
+	size_t pendingCount_ = 0;		// 今の仕事をまだ終えていないワーカーの数
+	bool stopRequested_ = false;
+
+	// 今の仕事（generation_を進める前にロックの中で書く）
+	Function function_ = nullptr;
+	void* context_ = nullptr;
+	size_t count_ = 0;
+	size_t sliceCount_ = 0;
+};
@@ -5,4 +5,25 @@
 struct Triangle final
 {
 	Vector3ex vertices[3];	//!< 頂点
-};
\ No newline at end of file
+
+	/// <summary>
+	/// サポート写像（direction方向に最も遠い頂点）
+	/// </summary>
+	/// <param name="direction">方向</param>
+	/// <returns></returns>
+	Vector3ex Support(const Vector3ex& direction) const
+	{
+		int best = 0;
+		float bestDot = vertices[0].x * direction.x + vertices[0].y * direction.y + vertices[0].z * direction.z;
+		for (int i = 1; i < 3; ++i)
+		{
+			float dot = vertices[i].x * direction.x + vertices[i].y * direction.y + vertices[i].z * direction.z;
+			if (dot > bestDot)
+			{
+				bestDot = dot;
+				best = i;
+			}
+		}
+		return vertices[best];
+	}
+};
@@ -0,0 +1,56 @@
+#pragma once
+#include "Triangle.h"
+#include <cstddef>
+#include <vector>
+
+/// <summary>
+/// 三角形を成分ごとの配列で持つ（頂点iのx成分はx[i][三角形番号]）
+/// 多数の三角形へ同じ判定をかける時に、成分をまとめてSIMDで読める
+/// </summary>
+struct TriangleSoA final
+{
+	std::vector<float> x[3];
+	std::vector<float> y[3];
+	std::vector<float> z[3];
+
+	/// <summary>
+	/// 三角形の数を変える（増えた分は0になる）
+	/// </summary>
+	void Resize(size_t count)
+	{
+		for (int v = 0; v < 3; ++v)
+		{
+			x[v].resize(count);
+			y[v].resize(count);
+			z[v].resize(count);
+		}
+	}
+
+	size_t GetCount() const { return x[0].size(); }
+
+	/// <summary>
+	/// i番目の三角形を取り出す
+	/// </summary>
+	Triangle Get(size_t i) const
+	{
+		Triangle triangle;
+		for (int v = 0; v < 3; ++v)
+		{
+			triangle.vertices[v] = Vector3ex(x[v][i], y[v][i], z[v][i]);
+		}
+		return triangle;
+	}
+
+	/// <summary>
+	/// i番目の三角形を書き込む
+	/// </summary>
+	void Set(size_t i, const Triangle& triangle)
+	{
+		for (int v = 0; v < 3; ++v)
+		{
+			x[v][i] = triangle.vertices[v].x;
+			y[v][i] = triangle.vertices[v].y;
+			z[v][i] = triangle.vertices[v].z;
+		}
+	}
+};
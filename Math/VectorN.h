@@ -0,0 +1,223 @@
+#pragma once
+#include <cmath>
+#include <cstddef>
+#include <immintrin.h>
+#include <type_traits>
+
+/// <summary>
+/// 要素数を固定したベクトル（T v[N]だけを持ち、Vector3exやVector4と同じ並び）
+/// 演算はすべて下の関数で1回だけ実装し、float3/float4はSSEで特殊化する
+/// </summary>
+template<class T, int N>
+struct Vector final
+{
+	static_assert(N >= 2 && N <= 4, "Vectorは2～4要素");
+
+	T v[N];
+
+	T& operator[](int i) { return v[i]; }
+	const T& operator[](int i) const { return v[i]; }
+};
+
+using Vector2f = Vector<float, 2>;
+using Vector3f = Vector<float, 3>;
+using Vector4f = Vector<float, 4>;
+using Vector2d = Vector<double, 2>;
+using Vector3d = Vector<double, 3>;
+using Vector4d = Vector<double, 4>;
+
+static_assert(std::is_trivially_copyable_v<Vector3f> && std::is_standard_layout_v<Vector3f>, "Vector3fは配列と同じ並び");
+static_assert(sizeof(Vector3f) == sizeof(float) * 3, "Vector3fに詰め物があってはいけない");
+static_assert(sizeof(Vector4f) == sizeof(float) * 4, "Vector4fに詰め物があってはいけない");
+
+/// <summary>
+/// SSEの読み書き（float3は12バイトしかないので、8バイト+4バイトで読む）
+/// </summary>
+namespace VectorSimd
+{
+	inline __m128 Load(const Vector<float, 3>& a)
+	{
+		__m128 xy = _mm_castpd_ps(_mm_load_sd(reinterpret_cast<const double*>(a.v)));
+		__m128 z = _mm_load_ss(a.v + 2);
+		return _mm_movelh_ps(xy, z);
+	}
+	inline __m128 Load(const Vector<float, 4>& a) { return _mm_loadu_ps(a.v); }
+
+	inline void Store(Vector<float, 3>& out, __m128 value)
+	{
+		_mm_store_sd(reinterpret_cast<double*>(out.v), _mm_castps_pd(value));
+		_mm_store_ss(out.v + 2, _mm_movehl_ps(value, value));
+	}
+	inline void Store(Vector<float, 4>& out, __m128 value) { _mm_storeu_ps(out.v, value); }
+
+	/// <summary>
+	/// 全レーンの和を全レーンに入れる
+	/// </summary>
+	inline __m128 HorizontalSum(__m128 value)
+	{
+		__m128 shuffled = _mm_shuffle_ps(value, value, _MM_SHUFFLE(2, 3, 0, 1));
+		__m128 sums = _mm_add_ps(value, shuffled);
+		shuffled = _mm_movehl_ps(shuffled, sums);
+		return _mm_add_ss(sums, shuffled);
+	}
+
+	template<class T, int N>
+	constexpr bool kEnabled = std::is_same_v<T, float> && (N == 3 || N == 4);
+}
+
+template<class T, int N>
+inline Vector<T, N> operator+(const Vector<T, N>& a, const Vector<T, N>& b)
+{
+	Vector<T, N> result;
+	if constexpr (VectorSimd::kEnabled<T, N>)
+	{
+		VectorSimd::Store(result, _mm_add_ps(VectorSimd::Load(a), VectorSimd::Load(b)));
+	}
+	else
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			result.v[i] = a.v[i] + b.v[i];
+		}
+	}
+	return result;
+}
+
+template<class T, int N>
+inline Vector<T, N> operator-(const Vector<T, N>& a, const Vector<T, N>& b)
+{
+	Vector<T, N> result;
+	if constexpr (VectorSimd::kEnabled<T, N>)
+	{
+		VectorSimd::Store(result, _mm_sub_ps(VectorSimd::Load(a), VectorSimd::Load(b)));
+	}
+	else
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			result.v[i] = a.v[i] - b.v[i];
+		}
+	}
+	return result;
+}
+
+template<class T, int N>
+inline Vector<T, N> operator*(const Vector<T, N>& a, T s)
+{
+	Vector<T, N> result;
+	if constexpr (VectorSimd::kEnabled<T, N>)
+	{
+		VectorSimd::Store(result, _mm_mul_ps(VectorSimd::Load(a), _mm_set1_ps(s)));
+	}
+	else
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			result.v[i] = a.v[i] * s;
+		}
+	}
+	return result;
+}
+
+template<class T, int N>
+inline Vector<T, N> operator*(T s, const Vector<T, N>& a)
+{
+	return a * s;
+}
+
+/// <summary>
+/// 内積
+/// </summary>
+template<class T, int N>
+inline T Dot(const Vector<T, N>& a, const Vector<T, N>& b)
+{
+	if constexpr (VectorSimd::kEnabled<T, N>)
+	{
+		// float3は4レーン目が0なので、4要素と同じ計算で済む
+		return _mm_cvtss_f32(VectorSimd::HorizontalSum(_mm_mul_ps(VectorSimd::Load(a), VectorSimd::Load(b))));
+	}
+	else
+	{
+		T result = a.v[0] * b.v[0];
+		for (int i = 1; i < N; ++i)
+		{
+			result += a.v[i] * b.v[i];
+		}
+		return result;
+	}
+}
+
+/// <summary>
+/// 長さ
+/// </summary>
+template<class T, int N>
+inline T Length(const Vector<T, N>& a)
+{
+	return std::sqrt(Dot(a, a));
+}
+
+/// <summary>
+/// 正規化（長さ0ならゼロベクトル）
+/// </summary>
+template<class T, int N>
+inline Vector<T, N> Normalize(const Vector<T, N>& a)
+{
+	const T length = Length(a);
+	if (length == T(0))
+	{
+		return Vector<T, N>{};
+	}
+	Vector<T, N> result;
+	if constexpr (VectorSimd::kEnabled<T, N>)
+	{
+		VectorSimd::Store(result, _mm_div_ps(VectorSimd::Load(a), _mm_set1_ps(length)));
+	}
+	else
+	{
+		for (int i = 0; i < N; ++i)
+		{
+			result.v[i] = a.v[i] / length;
+		}
+	}
+	return result;
+}
+
+/// <summary>
+/// 外積（3要素のみ）
+/// </summary>
+template<class T>
+inline Vector<T, 3> Cross(const Vector<T, 3>& a, const Vector<T, 3>& b)
+{
+	Vector<T, 3> result;
+	if constexpr (std::is_same_v<T, float>)
+	{
+		// (a.yzx * b.zxy) - (a.zxy * b.yzx)
+		const __m128 va = VectorSimd::Load(a);
+		const __m128 vb = VectorSimd::Load(b);
+		const __m128 aYzx = _mm_shuffle_ps(va, va, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 bYzx = _mm_shuffle_ps(vb, vb, _MM_SHUFFLE(3, 0, 2, 1));
+		const __m128 c = _mm_sub_ps(_mm_mul_ps(va, bYzx), _mm_mul_ps(aYzx, vb));
+		VectorSimd::Store(result, _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1)));
+	}
+	else
+	{
+		result.v[0] = a.v[1] * b.v[2] - a.v[2] * b.v[1];
+		result.v[1] = a.v[2] * b.v[0] - a.v[0] * b.v[2];
+		result.v[2] = a.v[0] * b.v[1] - a.v[1] * b.v[0];
+	}
+	return result;
+}
+
+/// <summary>
+/// 要素の型を変える（floatとdoubleの行き来）
+/// </summary>
+template<class To, class From, int N>
+inline Vector<To, N> Convert(const Vector<From, N>& a)
+{
+	Vector<To, N> result;
+	for (int i = 0; i < N; ++i)
+	{
+		result.v[i] = static_cast<To>(a.v[i]);
+	}
+	return result;
+}
@@ -1,12 +1,22 @@
 #include <Novice.h>
 #include <imgui.h>
+#include "Math/ClothSolver.h"
+#include "Math/FrameArena.h"
+#include "Math/GridRenderer.h"
 #include "Math/MathFunction.h"
+#include "Math/PhysicsWorld.h"
+#include "Math/Profiler.h"
+#include "Math/SceneGraph.h"
+#include "Math/SimRecorder.h"
+#include "Math/SimulationThread.h"
+#include <cmath>
+#include <utility>
 
 static const int kWindowWidth = 1280;
 static const int kWindowHeight = 720;
 
 // TransformNormal関数（ベクトル変換）
-Vector3ex TransformNormal(Vector3ex& v, Matrix4x4ex& m) {
+Vector3ex TransformNormal(const Vector3ex& v, const Matrix4x4ex& m) {
 	Vector3ex result{
 		v.x * m.m[0][0] + v.y * m.m[1][0] + v.z * m.m[2][0],  // x
 		v.x * m.m[0][1] + v.y * m.m[1][1] + v.z * m.m[2][1],  // y
@@ -36,6 +46,16 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	// デルタタイム
 	float deltaTime = 1.0f / 60.0f;
 
+	// シミュレーションの記録と再生
+	const char* kRecordPath = "simulation.mtrec";
+#if MT_PROFILE_ENABLED
+	const char* kTracePath = "profile_trace.json";
+#endif
+	SimRecorder recorder;
+	SimReplayer replayer;
+	uint32_t stepIndex = 0;
+	int replayFrame = 0;
+
 	MathFunction Func;
 
 	Plane plane{};
@@ -53,6 +73,51 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 	Sphere sphere = { .center{ball.position.x, ball.position.y, ball.position.z}, .radius{ball.radius} };
 
+	// 物理シミュレーション
+	PhysicsWorld world;
+	world.restitution = 0.8f; // 反発係数
+	const uint32_t ballIndex = world.AddBody(ball);
+	const uint32_t planeIndex = world.AddPlane(plane);
+
+	// 積分法の選択（ImGuiのコンボ）
+	int integratorIndex = static_cast<int>(IntegratorType::SemiImplicitEuler);
+	const char* integratorNames[static_cast<int>(IntegratorType::Count)] = {};
+	for (int i = 0; i < static_cast<int>(IntegratorType::Count); ++i)
+	{
+		integratorNames[i] = GetIntegratorName(static_cast<IntegratorType>(i));
+	}
+
+	// 地形（高さの凹凸を持つ格子、オンにするとボールが転がる）
+	Heightfield terrain(257, 257, 0.05f, { -6.4f, -0.6f, -6.4f });
+	for (uint32_t iz = 0; iz < terrain.GetSampleCountZ(); ++iz)
+	{
+		for (uint32_t ix = 0; ix < terrain.GetSampleCountX(); ++ix)
+		{
+			terrain.SetHeight(ix, iz, std::sin(float(ix) * 0.08f) * std::cos(float(iz) * 0.06f) * 0.4f);
+		}
+	}
+	bool isTerrainEnabled = false;
+
+	// 上の2隅を留めた布（ボールと平面に当たる、メインスレッドで進める）
+	ClothSolver cloth;
+	{
+		constexpr uint32_t kClothSide = 40;
+		const uint32_t first = cloth.AddCloth({ -0.6f, 2.2f, -0.6f }, { 1.2f, 0.0f, 0.0f }, { 0.0f, 0.0f, 1.2f }, kClothSide, kClothSide, 0.01f);
+		cloth.SetInverseMass(first, 0.0f);
+		cloth.SetInverseMass(first + kClothSide - 1, 0.0f);
+	}
+	const uint32_t clothPlane = cloth.AddPlane(plane);
+	const uint32_t clothBall = cloth.AddSphere(sphere);
+	bool isClothEnabled = false;
+
+	// 回転できる箱（ボールと重なると赤くなる）
+	Vector3ex obbCenter = { -0.8f, 0.6f, 0.0f };
+	Vector3ex obbRotate = { 0.0f, 0.4f, 0.3f };
+	Vector3ex obbSize = { 0.5f, 0.2f, 0.3f };
+
+	// 以降のワールドはシミュレーションスレッドが持ち、UIの操作は命令で送る
+	SimulationThread simulation(std::move(world));
+
 	Vector3ex abc = { -0.2f, 0.9f, -0.3f };
 
 	Vector3ex translate{};
@@ -61,6 +126,17 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	Vector3ex cameraTranslate = { 0.0f, 1.9f, -6.49f };
 	Vector3ex cameraRotate = { 0.26f, 0.0f, 0.0f };
 
+	// 変換はシーングラフで管理し、変わったノードだけ行列を計算し直す
+	SceneGraph scene;
+	const uint32_t worldNode = scene.AddNode(SceneGraph::kNoParent, { .rotate{ rotate }, .translate{ translate } });
+	const uint32_t cameraNode = scene.AddNode(SceneGraph::kNoParent, { .rotate{ cameraRotate }, .translate{ cameraTranslate } });
+	const uint32_t planeNode = scene.AddNode(SceneGraph::kNoParent, { .rotate{ planeRotate } });
+	const uint32_t ballNode = scene.AddNode(SceneGraph::kNoParent, { .translate{ sphere.center } });
+	Matrix4x4ex viewProjectionMatrix{};
+
+	// グリッドはカメラが動いた時だけ変換し直す
+	GridRenderer grid;
+
 	// 透視投影行列を作成
 	Matrix4x4ex projectionMatrix = Func.MakePerspectiveFovMatrix(0.45f, float(kWindowWidth) / float(kWindowHeight), 0.1f, 100.0f);
 	// ViewportMatrixビューポート変換行列を作成
@@ -71,48 +147,65 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	{
 		// フレームの開始
 		Novice::BeginFrame();
+		// 前のフレームの一時メモリを捨てる
+		FrameArena::GetFrame().Reset();
 
-		// キー入力を受け取る
-		memcpy(preKeys, keys, 256);
-		Novice::GetHitKeyStateAll(keys);
+		// 前のフレームの間に進めたステップを受け取る（このフレームはこの状態を描画する）
+		simulation.Wait();
+		const SimSnapshot& snapshot = simulation.GetSnapshot();
 
-		// マウス入力を取得
-		POINT mousePosition;
-		GetCursorPos(&mousePosition);
+		// 記録中ならこのステップの状態を積む
+		if (snapshot.stepped)
+		{
+			recorder.RecordStep(stepIndex++, snapshot.bodies.data(), snapshot.bodies.size(), snapshot.awakeBodies.data(), snapshot.awakeBodies.size(),
+				snapshot.contacts.data(), snapshot.contacts.size());
+		}
 
 		///
 		/// ↓更新処理ここから
 		///
 
-		// マウスドラッグによる回転制御
-		if (Novice::IsPressMouse(1))
 		{
-			if (!isDragging)
+			PROFILE_SCOPE("Input");
+
+			// キー入力を受け取る
+			memcpy(preKeys, keys, 256);
+			Novice::GetHitKeyStateAll(keys);
+
+			// マウス入力を取得
+			POINT mousePosition;
+			GetCursorPos(&mousePosition);
+
+			// マウスドラッグによる回転制御
+			if (Novice::IsPressMouse(1))
 			{
-				isDragging = true;
-				prevMouseX = mousePosition.x;
-				prevMouseY = mousePosition.y;
+				if (!isDragging)
+				{
+					isDragging = true;
+					prevMouseX = mousePosition.x;
+					prevMouseY = mousePosition.y;
+				}
+				else
+				{
+					int deltaX = mousePosition.x - prevMouseX;
+					int deltaY = mousePosition.y - prevMouseY;
+					rotate.y += deltaX * 0.01f; // 水平方向の回転
+					rotate.x += deltaY * 0.01f; // 垂直方向の回転
+					prevMouseX = mousePosition.x;
+					prevMouseY = mousePosition.y;
+				}
 			}
 			else
 			{
-				int deltaX = mousePosition.x - prevMouseX;
-				int deltaY = mousePosition.y - prevMouseY;
-				rotate.y += deltaX * 0.01f; // 水平方向の回転
-				rotate.x += deltaY * 0.01f; // 垂直方向の回転
-				prevMouseX = mousePosition.x;
-				prevMouseY = mousePosition.y;
+				isDragging = false;
 			}
-		}
-		else
-		{
-			isDragging = false;
-		}
 
-		// マウスホイールで前後移動
-		int wheel = Novice::GetWheel();
-		if (wheel != 0)
-		{
-			cameraTranslate.z += wheel * 0.01f; // ホイールの回転方向に応じて前後移動
+			// マウスホイールで前後移動
+			int wheel = Novice::GetWheel();
+			if (wheel != 0)
+			{
+				cameraTranslate.z += wheel * 0.01f; // ホイールの回転方向に応じて前後移動
+			}
 		}
 
 		ImGui::Begin("Control Window");
@@ -125,58 +218,144 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 			isActive = false; // 動きを停止
 			// 初期位置にリセット
 			sphere.center = { 0.8f, 1.2f, 0.3f };
-			ball.velocity = { 0.0f, 0.0f, 0.0f };
+			simulation.Push(SimCommand::MakeResetBody(ballIndex, sphere.center, { 0.0f, 0.0f, 0.0f }));
+			stepIndex = 0;
 		}
 		// 平面の回転角度を調整するUIを追加
 		ImGui::DragFloat3("Plane.Rotate", &planeRotate.x, 0.01f);
 		ImGui::DragFloat("Plane.Distance", &plane.distance, 0.01f);
-		ImGui::End();
-
-		// 反発係数
-		float restitution = 0.8f;
-
-		// 反発を実装
-		if (isActive)
+		if (ImGui::Checkbox("Terrain", &isTerrainEnabled))
 		{
-			ball.velocity += ball.acceleration * deltaTime;
-			sphere.center += ball.velocity * deltaTime;
+			simulation.Push(SimCommand::MakeSetHeightfield(isTerrainEnabled ? &terrain : nullptr));
+		}
+		ImGui::Checkbox("Cloth", &isClothEnabled);
+		ImGui::DragFloat3("OBB.Center", &obbCenter.x, 0.01f);
+		ImGui::DragFloat3("OBB.Rotate", &obbRotate.x, 0.01f);
+		ImGui::DragFloat3("OBB.Size", &obbSize.x, 0.01f, 0.0f, 10.0f);
+		if (ImGui::Combo("Integrator", &integratorIndex, integratorNames, static_cast<int>(IntegratorType::Count)))
+		{
+			simulation.Push(SimCommand::MakeSetIntegrator(static_cast<IntegratorType>(integratorIndex)));
+		}
+		ImGui::Text("Awake: %zu / %zu", snapshot.awakeCount, snapshot.bodies.size());
+		ImGui::Text("SimulationWait: %.2f ms", simulation.GetLastWaitMs());
+		{
+			const FrameArena& frameArena = FrameArena::GetFrame();
+			ImGui::Text("FrameArena: %zu KB (peak %zu KB / %zu KB)", frameArena.GetLastFrameBytes() / 1024, frameArena.GetHighWaterMark() / 1024, frameArena.GetCapacity() / 1024);
+		}
 
-			// 平面との衝突判定
-			float distanceToPlane = Func.Dot(plane.normal, sphere.center) - plane.distance;
-			if (distanceToPlane < sphere.radius)
+#if MT_PROFILE_ENABLED
+		// フレーム内の内訳（直近のフレームの平均と最大）
+		if (ImGui::CollapsingHeader("Profiler"))
+		{
+			const Profiler& profiler = Profiler::Get();
+			ImGui::Text("Frame: %.2f ms (avg %.2f ms)", profiler.GetFrameMs(), profiler.GetAverageFrameMs());
+			for (const ProfileZoneStats& zone : profiler.GetZoneStats())
 			{
-				// 反射処理
-				Vector3ex reflected = Func.Reflect(ball.velocity, plane.normal);
-				ball.velocity = reflected * restitution;
+				ImGui::Text("%*s%s: %.3f ms (avg %.3f, max %.3f) x%u", static_cast<int>(zone.depth * 2), "", zone.name, zone.lastMs, zone.averageMs, zone.maxMs, zone.calls);
+			}
+			const ProfileCounterStats* counters = profiler.GetCounterStats();
+			for (size_t i = 0; i < static_cast<size_t>(ProfileCounter::Count); ++i)
+			{
+				ImGui::Text("%s: %llu (avg %.1f)", counters[i].name, static_cast<unsigned long long>(counters[i].last), counters[i].average);
+			}
+			if (ImGui::Button("Export Trace"))
+			{
+				Profiler::Get().ExportChromeTrace(kTracePath);
+			}
+		}
+#endif
 
-				// 衝突面から少し離す
-				sphere.center = sphere.center + plane.normal * (sphere.radius - distanceToPlane);
+		// 記録と再生
+		if (!recorder.IsRecording())
+		{
+			if (ImGui::Button("Record"))
+			{
+				replayer.Close();
+				recorder.Open(kRecordPath, deltaTime);
+			}
+		}
+		else
+		{
+			if (ImGui::Button("Stop Record"))
+			{
+				recorder.Close();
+			}
+			ImGui::Text("Recorded: %llu steps", static_cast<unsigned long long>(recorder.GetFrameCount()));
+		}
+		if (!replayer.IsOpen())
+		{
+			if (!recorder.IsRecording() && ImGui::Button("Replay"))
+			{
+				isActive = false;
+				replayFrame = 0;
+				replayer.Open(kRecordPath);
+			}
+		}
+		else
+		{
+			if (ImGui::Button("Stop Replay"))
+			{
+				replayer.Close();
+			}
+			else if (replayer.GetFrameCount() > 0)
+			{
+				ImGui::SliderInt("Replay.Frame", &replayFrame, 0, static_cast<int>(replayer.GetFrameCount()) - 1);
+			}
+		}
+		ImGui::End();
 
-				// 新しい位置を計算して平面外に移動
-				distanceToPlane = Func.Dot(plane.normal, sphere.center) - plane.distance;
-				sphere.center += plane.normal * (sphere.radius - distanceToPlane);
+		sphere.center = snapshot.bodies[ballIndex].position;
 
-				// 新しい位置を計算して平面外に移動
-				distanceToPlane = Func.Dot(plane.normal, sphere.center) - plane.distance;
-				sphere.center += plane.normal * (sphere.radius - distanceToPlane);
+		// 再生中は記録された位置を表示する
+		if (replayer.IsOpen() && replayer.GetFrameCount() > 0)
+		{
+			const RecordedFrameView frame = replayer.GetFrame(static_cast<size_t>(replayFrame));
+			if (frame.header != nullptr && frame.header->bodyCount > 0)
+			{
+				sphere.center = { frame.bodies[0].position[0], frame.bodies[0].position[1], frame.bodies[0].position[2] };
 			}
 		}
 
-		// 各種行列の計算
-		Matrix4x4ex worldMatrix = Func.MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, rotate, translate);
-		Matrix4x4ex cameraMatrix = Func.MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, cameraRotate, cameraTranslate);
-		Matrix4x4ex viewWorldMatrix = Func.Inverse(worldMatrix);
-		Matrix4x4ex viewCameraMatrix = Func.Inverse(cameraMatrix);
-		Matrix4x4ex viewProjectionMatrix = Func.Multiply(viewWorldMatrix, Func.Multiply(viewCameraMatrix, projectionMatrix));
+		{
+			PROFILE_SCOPE("Matrices");
+
+			// 各種行列の計算（値が変わったノードだけ計算し直す）
+			scene.SetRotate(worldNode, rotate);
+			scene.SetTranslate(worldNode, translate);
+			scene.SetRotate(cameraNode, cameraRotate);
+			scene.SetTranslate(cameraNode, cameraTranslate);
+			scene.SetRotate(planeNode, planeRotate);
+			scene.SetTranslate(ballNode, sphere.center);
+			scene.Update();
+
+			if (scene.WasUpdated(worldNode) || scene.WasUpdated(cameraNode))
+			{
+				Matrix4x4ex viewWorldMatrix = Func.Inverse(scene.GetWorldMatrix(worldNode));
+				Matrix4x4ex viewCameraMatrix = Func.Inverse(scene.GetWorldMatrix(cameraNode));
+				viewProjectionMatrix = Func.Multiply(viewWorldMatrix, Func.Multiply(viewCameraMatrix, projectionMatrix));
+			}
 
-		Matrix4x4ex rotationXMatrix = Func.MakeRotateXMatrix(planeRotate.x);
-		Matrix4x4ex rotationYMatrix = Func.MakeRotateYMatrix(planeRotate.y);
-		Matrix4x4ex rotationZMatrix = Func.MakeRotateZMatrix(planeRotate.z);
-		Matrix4x4ex rotationMatrix = Func.Multiply(Func.Multiply(rotationXMatrix, rotationYMatrix), rotationZMatrix);
+			// 平面の回転が変わった時だけ法線を計算し直す
+			if (scene.WasUpdated(planeNode))
+			{
+				plane.normal = TransformNormal(abc, scene.GetWorldMatrix(planeNode));
+				plane.normal = Func.Normalize(plane.normal);
+			}
+		}
+		sphere.center = scene.GetWorldPosition(ballNode);
 
+		if (isClothEnabled && isActive)
+		{
+			cloth.SetPlane(clothPlane, plane);
+			cloth.SetSphere(clothBall, sphere);
+			cloth.Step(deltaTime);
+		}
 
-		plane.normal = TransformNormal(abc, rotationMatrix);
-		plane.normal = Func.Normalize(plane.normal);
+		// 平面が回転・移動したら眠っているボールを起こす
+		simulation.Push(SimCommand::MakeSetPlane(planeIndex, plane));
+
+		// 次のステップはこのフレームの描画と並行して進める（反発を実装、静止したボールはスリープして計算を省く）
+		simulation.Kick(isActive ? deltaTime : 0.0f);
 
 		///
 		/// ↑更新処理ここまで
@@ -186,10 +365,39 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 		/// ↓描画処理ここから
 		///
 
-		// Gridを描画
-		Func.DrawGrid(viewProjectionMatrix, viewportMatrix);
-		Func.DrawPlane(plane, viewProjectionMatrix, viewportMatrix, WHITE);
-		Func.DrawSphere(sphere, viewProjectionMatrix, viewportMatrix, ball.color);
+		{
+			PROFILE_SCOPE("Draw");
+
+			// Gridを描画
+			{
+				PROFILE_SCOPE("DrawGrid");
+				grid.Draw(viewProjectionMatrix, viewportMatrix);
+			}
+			if (isTerrainEnabled)
+			{
+				PROFILE_SCOPE("DrawHeightfield");
+				Func.DrawHeightfield(terrain, viewProjectionMatrix, viewportMatrix, 0x808080FF);
+			}
+			if (isClothEnabled)
+			{
+				PROFILE_SCOPE("DrawCloth");
+				Func.DrawParticleEdges(cloth.GetParticles(), cloth.GetEdgeIndices(), viewProjectionMatrix, viewportMatrix, 0xC0C0FFFF);
+			}
+			{
+				PROFILE_SCOPE("DrawPlane");
+				Func.DrawPlane(plane, viewProjectionMatrix, viewportMatrix, WHITE);
+			}
+			{
+				PROFILE_SCOPE("DrawOBB");
+				const OBB obb = Func.MakeOBB(obbCenter, obbRotate, obbSize);
+				Func.DrawOBB(obb, viewProjectionMatrix, viewportMatrix, Func.IsCollision(obb, sphere) ? RED : WHITE);
+			}
+			{
+				PROFILE_SCOPE("DrawSphere");
+				// 画面上で小さい間は円1つで描き、近づいて大きくなったら分割して描く
+				Func.DrawSpheres(std::span<const Sphere>(&sphere, 1), viewProjectionMatrix, viewportMatrix, ball.color);
+			}
+		}
 
 		///
 		/// ↑描画処理ここまで
@@ -197,6 +405,9 @@ int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 
 		// フレームの終了
 		Novice::EndFrame();
+#if MT_PROFILE_ENABLED
+		Profiler::Get().EndFrame();
+#endif
 
 		// ESCキーが押されたらループを抜ける
 		if (preKeys[DIK_ESCAPE] == 0 && keys[DIK_ESCAPE] != 0)